@@ -128,16 +128,19 @@ void Config::_resetMessage()
 
 bool Config::handleEvent( eq::EventICommand command )
 {
-    const eq::Event& event = command.get< eq::Event >();
     switch( command.getEventType( ))
     {
         case eq::Event::KEY_PRESS:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             if( _handleKeyEvent( event.keyPress ))
                 return true;
             break;
+        }
 
         case eq::Event::CHANNEL_POINTER_BUTTON_PRESS:
         {
+            const eq::Event& event = command.get< eq::Event >();
             const lunchbox::UUID& viewID = event.context.view.identifier;
             _frameData.setCurrentViewID( viewID );
             if( viewID == lunchbox::UUID::ZERO )
@@ -165,6 +168,8 @@ bool Config::handleEvent( eq::EventICommand command )
         }
 
         case eq::Event::CHANNEL_POINTER_BUTTON_RELEASE:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             if( event.pointerButtonRelease.buttons == eq::PTR_BUTTON_NONE
                 && event.pointerButtonRelease.button  == eq::PTR_BUTTON1 )
             {
@@ -172,8 +177,11 @@ bool Config::handleEvent( eq::EventICommand command )
                 _spinX = event.pointerButtonRelease.dy;
             }
             return true;
+        }
 
         case eq::Event::CHANNEL_POINTER_MOTION:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             if( event.pointerMotion.buttons == eq::PTR_BUTTON1 )
             {
                 _spinX = 0;
@@ -199,6 +207,7 @@ bool Config::handleEvent( eq::EventICommand command )
                 return true;
             }
             break;
+        }
 
         default:
             break;
@@ -613,6 +613,9 @@ void Channel::_drawModel( const Model* scene )
 
     state.setProjectionModelViewMatrix( projection * view * model );
     state.setRange( &getRange().start);
+    // the threshold in pixels, as a fraction of the [-1,1] NDC height
+    state.setLODThreshold( frameData.getLODThreshold() * 2.f /
+                           float( getPixelViewport().h ));
 
     const eq::Pipe* pipe = getPipe();
     const GLuint program = state.getProgram( pipe );
@@ -167,6 +167,8 @@ void Config::_loadModels()
 
             if( _initData.useInvertedFaces() )
                 model->useInvertedFaces();
+            if( _initData.useCompactVertices( ))
+                model->useCompactVertices();
 
             if( !model->readFromFile( filename.c_str( )))
             {
@@ -645,6 +647,14 @@ bool Config::_handleKeyEvent( const eq::KeyEvent& event )
             _frameData.adjustQuality( .1f );
             return true;
 
+        case 'b':
+            _frameData.adjustLODThreshold( -1.f );
+            return true;
+
+        case 'B':
+            _frameData.adjustLODThreshold( 1.f );
+            return true;
+
         case 'c':
         case 'C':
             _switchCanvas();
@@ -57,6 +57,7 @@ static const std::string _help(
     std::string( "\t\td:                         Toggle color demo mode\n" ) +
     std::string( "\t\ti:                         Toggle usage of idle anti-aliasing\n" ) +
     std::string( "\t\tq, Q:                      Adjust non-idle image quality\n" ) +
+    std::string( "\t\tb, B:                      Adjust level of detail error, 0 (default) disables LOD\n" ) +
     std::string( "\t\tn:                         Toggle navigation mode (trackball, walk)\n" ) +
     std::string( "\t\tr:                         Switch rendering mode (display list, VBO, immediate)\n" ) +
     std::string( "\t\tu:                         Toggle image compression\n" ) +
@@ -40,6 +40,7 @@ FrameData::FrameData()
         , _renderMode( mesh::RENDER_MODE_DISPLAY_LIST )
         , _colorMode( COLOR_MODEL )
         , _quality( 1.0f )
+        , _lodThreshold( 0.f )
         , _ortho( false )
         , _statistics( false )
         , _help( false )
@@ -58,7 +59,8 @@ void FrameData::serialize( co::DataOStream& os, const uint64_t dirtyBits )
     if( dirtyBits & DIRTY_CAMERA )
         os << _position << _rotation << _modelRotation;
     if( dirtyBits & DIRTY_FLAGS )
-        os << _modelID << _renderMode << _colorMode << _quality << _ortho
+        os << _modelID << _renderMode << _colorMode << _quality
+           << _lodThreshold << _ortho
            << _statistics << _help << _wireframe << _pilotMode << _idle
            << _compression;
     if( dirtyBits & DIRTY_VIEW )
@@ -73,7 +75,8 @@ void FrameData::deserialize( co::DataIStream& is, const uint64_t dirtyBits )
     if( dirtyBits & DIRTY_CAMERA )
         is >> _position >> _rotation >> _modelRotation;
     if( dirtyBits & DIRTY_FLAGS )
-        is >> _modelID >> _renderMode >> _colorMode >> _quality >> _ortho
+        is >> _modelID >> _renderMode >> _colorMode >> _quality
+           >> _lodThreshold >> _ortho
            >> _statistics >> _help >> _wireframe >> _pilotMode >> _idle
            >> _compression;
     if( dirtyBits & DIRTY_VIEW )
@@ -151,6 +154,16 @@ void FrameData::adjustQuality( const float delta )
     LBINFO << "Set non-idle image quality to " << _quality << std::endl;
 }
 
+void FrameData::adjustLODThreshold( const float delta )
+{
+    _lodThreshold += delta;
+    _lodThreshold = LB_MAX( _lodThreshold, 0.f );
+    _lodThreshold = LB_MIN( _lodThreshold, 16.f );
+    setDirty( DIRTY_FLAGS );
+    LBINFO << "Set level of detail error to " << _lodThreshold << " pixels"
+           << std::endl;
+}
+
 void FrameData::togglePilotMode()
 {
     _pilotMode = !_pilotMode;
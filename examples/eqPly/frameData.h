@@ -65,6 +65,7 @@ namespace eqPly
         void toggleWireframe();
         void toggleColorMode();
         void adjustQuality( const float delta );
+        void adjustLODThreshold( const float delta );
         void togglePilotMode();
         void toggleRenderMode();
         void toggleCompression();
@@ -72,6 +73,7 @@ namespace eqPly
         eq::uint128_t getModelID() const { return _modelID; }
         ColorMode getColorMode() const { return _colorMode; }
         float getQuality() const { return _quality; }
+        float getLODThreshold() const { return _lodThreshold; }
         bool useOrtho() const { return _ortho; }
         bool useStatistics() const { return _statistics; }
         bool showHelp() const { return _help; }
@@ -139,6 +141,7 @@ namespace eqPly
         mesh::RenderMode _renderMode;
         ColorMode        _colorMode;
         float            _quality;
+        float            _lodThreshold; //!< tolerated LOD error in pixels
         bool             _ortho;
         bool             _statistics;
         bool             _help;
@@ -54,6 +54,7 @@ InitData::InitData()
 #endif
         , _useGLSL( false )
         , _invFaces( false )
+        , _compact( false )
         , _logo( true )
         , _roi ( true )
 {}
@@ -66,13 +67,13 @@ InitData::~InitData()
 void InitData::getInstanceData( co::DataOStream& os )
 {
     os << _frameDataID << _windowSystem << _renderMode << _useGLSL << _invFaces
-       << _logo << _roi;
+       << _compact << _logo << _roi;
 }
 
 void InitData::applyInstanceData( co::DataIStream& is )
 {
     is >> _frameDataID >> _windowSystem >> _renderMode >> _useGLSL >> _invFaces
-       >> _logo >> _roi;
+       >> _compact >> _logo >> _roi;
     LBASSERT( _frameDataID != eq::UUID::ZERO );
 }
 
@@ -48,6 +48,7 @@ namespace eqPly
         mesh::RenderMode   getRenderMode() const    { return _renderMode; }
         bool               useGLSL() const          { return _useGLSL; }
         bool               useInvertedFaces() const { return _invFaces; }
+        bool               useCompactVertices() const { return _compact; }
         bool               showLogo() const         { return _logo; }
         bool               useROI() const           { return _roi; }
 
@@ -61,6 +62,7 @@ namespace eqPly
             { _renderMode = renderMode; }
         void enableGLSL()          { _useGLSL  = true; }
         void enableInvertedFaces() { _invFaces = true; }
+        void enableCompactVertices() { _compact = true; }
         void disableLogo()         { _logo     = false; }
         void disableROI()          { _roi      = false; }
 
@@ -70,6 +72,7 @@ namespace eqPly
         mesh::RenderMode _renderMode;
         bool             _useGLSL;
         bool             _invFaces;
+        bool             _compact;
         bool             _logo;
         bool             _roi;
     };
@@ -74,6 +74,8 @@ const LocalInitData& LocalInitData::operator = ( const LocalInitData& from )
         enableGLSL();
     if( from.useInvertedFaces( ))
         enableInvertedFaces();
+    if( from.useCompactVertices( ))
+        enableCompactVertices();
     if( !from.showLogo( ))
         disableLogo();
     if( !from.useROI( ))
@@ -129,6 +131,9 @@ void LocalInitData::parseArguments( const int argc, char** argv )
         TCLAP::SwitchArg invFacesArg( "i", "invertFaces",
                              "Invert faces (valid during binary file creation)",
                                     command, false );
+        TCLAP::SwitchArg compactArg( "k", "compact",
+                         "Use quantized, compact vertex storage for the models",
+                                     command, false );
         TCLAP::ValueArg<std::string> pathArg( "a", "cameraPath",
                                         "File containing camera path animation",
                                               false, "", "string", command );
@@ -190,6 +195,8 @@ void LocalInitData::parseArguments( const int argc, char** argv )
             enableGLSL();
         if( invFacesArg.isSet() )
             enableInvertedFaces();
+        if( compactArg.isSet( ))
+            enableCompactVertices();
         if( overlayArg.isSet( ))
             disableLogo();
         if( roiArg.isSet( ))
@@ -132,7 +132,10 @@ namespace mesh
     const Index             LEAF_SIZE( 21845 );
     
     // binary mesh file version, increment if changing the file format
-    const unsigned short    FILE_VERSION ( 0x0116 );
+    const unsigned short    FILE_VERSION ( 0x0119 );
+
+    // alignment of the vertex data in the binary mesh file
+    const size_t            FILE_ALIGNMENT( 16 );
 
     // enumeration for the sort axis
     enum Axis
@@ -67,6 +67,8 @@ namespace mesh
 
         virtual const VertexBufferBase* getLeft() const { return 0; }
         virtual const VertexBufferBase* getRight() const { return 0; }
+        virtual const VertexBufferBase* getLOD() const { return 0; }
+        virtual float getLODError() const { return 0.f; }
 
         virtual const BoundingSphere& updateBoundingSphere() = 0;
 
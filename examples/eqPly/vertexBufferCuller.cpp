@@ -0,0 +1,231 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "vertexBufferCuller.h"
+#include "vertexBufferBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mesh
+{
+namespace
+{
+// ordered visibility of a node, the minimum over all planes is the result
+enum Visibility
+{
+    VISIBILITY_NONE,
+    VISIBILITY_PARTIAL,
+    VISIBILITY_FULL
+};
+
+// nodes tested per thread and block, and the minimum to test in parallel
+const ssize_t _blockSize = 256;
+const ssize_t _parallelSize = 4096;
+}
+
+/*  Flatten the given kd-tree, to be called whenever it changes.  */
+void VertexBufferCuller::setup( const VertexBufferBase& root )
+{
+    _nodes.clear();
+    _skip.clear();
+    _x.clear();
+    _y.clear();
+    _z.clear();
+    _radius.clear();
+    _rangeStart.clear();
+    _rangeEnd.clear();
+    _lods.clear();
+    _lodError.clear();
+    _lodsBelow.clear();
+
+    _flatten( root );
+}
+
+/*  Append the node and its subtree in depth-first order, returns if the
+    subtree has any simplified mesh.  */
+bool VertexBufferCuller::_flatten( const VertexBufferBase& node )
+{
+    const size_t index = _nodes.size();
+    const BoundingSphere& sphere = node.getBoundingSphere();
+
+    _nodes.push_back( &node );
+    _skip.push_back( 0 );
+    _x.push_back( sphere.x( ));
+    _y.push_back( sphere.y( ));
+    _z.push_back( sphere.z( ));
+    _radius.push_back( sphere.w( ));
+    _rangeStart.push_back( node.getRange()[0] );
+    _rangeEnd.push_back( node.getRange()[1] );
+    _lods.push_back( node.getLOD( ));
+    _lodError.push_back( node.getLODError( ));
+    _lodsBelow.push_back( false );
+
+    bool lodsBelow = false;
+    if( node.getLeft( ))
+        lodsBelow = _flatten( *node.getLeft( ));
+    if( node.getRight( ))
+        lodsBelow = _flatten( *node.getRight( )) || lodsBelow;
+
+    _skip[ index ] = _nodes.size();
+    _lodsBelow[ index ] = lodsBelow;
+    return lodsBelow || node.getLOD() != 0;
+}
+
+/*  Append the nodes to draw for the given view and range.  */
+void VertexBufferCuller::cull( const Matrix4f& projectionModelView,
+                               const Range& range,
+                               const bool useFrustumCulling,
+                               const float lodThreshold,
+                               DrawList& drawList ) const
+{
+    const Matrix4f& pmv = projectionModelView;
+    const ssize_t nNodes = ssize_t( _nodes.size( ));
+    std::vector< uint8_t > visibility( nNodes, VISIBILITY_FULL );
+
+    if( useFrustumCulling && nNodes > 0 )
+    {
+        // normalized left, right, bottom, top, near and far planes
+        float planes[6][4];
+        for( size_t i = 0; i < 3; ++i )
+            for( size_t j = 0; j < 4; ++j )
+            {
+                planes[ i * 2 ][j]     = pmv( 3, j ) + pmv( i, j );
+                planes[ i * 2 + 1 ][j] = pmv( 3, j ) - pmv( i, j );
+            }
+        for( size_t i = 0; i < 6; ++i )
+        {
+            const float length = sqrtf( planes[i][0] * planes[i][0] +
+                                        planes[i][1] * planes[i][1] +
+                                        planes[i][2] * planes[i][2] );
+            for( size_t j = 0; j < 4; ++j )
+                planes[i][j] /= length;
+        }
+
+        // test all nodes, one plane at a time over a block of nodes
+        const float* x = &_x[0];
+        const float* y = &_y[0];
+        const float* z = &_z[0];
+        const float* radius = &_radius[0];
+        uint8_t* result = &visibility[0];
+
+#pragma omp parallel for if( nNodes > _parallelSize )
+        for( ssize_t i = 0; i < nNodes; i += _blockSize )
+        {
+            const ssize_t end = std::min( i + _blockSize, nNodes );
+            for( size_t p = 0; p < 6; ++p )
+            {
+                const float* plane = planes[p];
+                for( ssize_t j = i; j < end; ++j )
+                {
+                    const float distance = plane[0] * x[j] + plane[1] * y[j] +
+                                           plane[2] * z[j] + plane[3];
+                    const uint8_t test = distance < -radius[j] ?
+                                             VISIBILITY_NONE :
+                                         distance < radius[j] ?
+                                             VISIBILITY_PARTIAL :
+                                             VISIBILITY_FULL;
+                    result[j] = std::min( result[j], test );
+                }
+            }
+        }
+    }
+
+    // An object-space error e at the sphere center c projects to at most
+    // e * |row1| / w in NDC, with w = row3 . ( c, 1 ) reduced by the radius
+    // towards the viewer. For orthographic projections w is one.
+    const float yScale = sqrtf( pmv( 1, 0 ) * pmv( 1, 0 ) +
+                                pmv( 1, 1 ) * pmv( 1, 1 ) +
+                                pmv( 1, 2 ) * pmv( 1, 2 ));
+    const float wScale = sqrtf( pmv( 3, 0 ) * pmv( 3, 0 ) +
+                                pmv( 3, 1 ) * pmv( 3, 1 ) +
+                                pmv( 3, 2 ) * pmv( 3, 2 ));
+
+    // collect the nodes to draw, skipping subtrees as the visibility allows
+    for( size_t i = 0; i < size_t( nNodes ); )
+    {
+        const size_t skip = _skip[i];
+
+        // completely out of range check
+        if( _rangeStart[i] >= range[1] || _rangeEnd[i] < range[0] )
+        {
+            i = skip;
+            continue;
+        }
+
+        // draw the simplified subtree if it is precise enough on screen
+        if( lodThreshold > 0.f && _lods[i] &&
+            visibility[i] != VISIBILITY_NONE &&
+            _rangeStart[i] >= range[0] && _rangeEnd[i] < range[1] )
+        {
+            const float w = pmv( 3, 0 ) * _x[i] + pmv( 3, 1 ) * _y[i] +
+                            pmv( 3, 2 ) * _z[i] + pmv( 3, 3 ) -
+                            wScale * _radius[i];
+            if( w > 0.f && _lodError[i] * yScale <= lodThreshold * w )
+            {
+                drawList.push_back( _lods[i] );
+                i = skip;
+                continue;
+            }
+        }
+
+        switch( visibility[i] )
+        {
+            case VISIBILITY_FULL:
+                // if fully visible and fully in range, draw it unless the
+                // children may replace parts of it by their simplified meshes
+                if( _rangeStart[i] >= range[0] && _rangeEnd[i] < range[1] &&
+                    !( lodThreshold > 0.f && _lodsBelow[i] ))
+                {
+                    drawList.push_back( _nodes[i] );
+                    i = skip;
+                    break;
+                }
+                // partial range or LODs below, fall through to the children
+
+            case VISIBILITY_PARTIAL:
+                if( skip == i + 1 ) // leaf
+                {
+                    if( _rangeStart[i] >= range[0] )
+                        drawList.push_back( _nodes[i] );
+                    // else drop, to be drawn by 'previous' channel
+                    i = skip;
+                }
+                else
+                    ++i; // continue with children
+                break;
+
+            case VISIBILITY_NONE:
+            default:
+                i = skip;
+                break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,87 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of Eyescale Software GmbH nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef MESH_VERTEXBUFFERCULLER_H
+#define MESH_VERTEXBUFFERCULLER_H
+
+
+#include "typedefs.h"
+#include <vector>
+
+
+namespace mesh 
+{
+    // defined elsewhere
+    class VertexBufferBase;
+
+    /*  The kd-tree nodes to draw, in rendering order.  */
+    typedef std::vector< const VertexBufferBase* > DrawList;
+
+    /*  Culls a kd-tree against a view frustum and range into a draw list.
+
+        The tree is flattened into arrays of node attributes, which are all
+        tested against the frustum planes in parallel before the draw list is
+        assembled. Subtrees whose simplified mesh deviates by less than the
+        given threshold on screen are replaced by it. Culling needs no OpenGL
+        context.  */
+    class VertexBufferCuller
+    {
+    public:
+        /*  Flatten the given kd-tree, to be called whenever it changes.  */
+        void setup( const VertexBufferBase& root );
+
+        /*  Append the nodes to draw for the given view and range. The LOD
+            threshold is the tolerated error in normalized device coordinates,
+            0 always draws the full resolution.  */
+        void cull( const Matrix4f& projectionModelView, const Range& range,
+                   const bool useFrustumCulling, const float lodThreshold,
+                   DrawList& drawList ) const;
+
+        size_t getNumberOfNodes() const { return _nodes.size(); }
+
+    private:
+        // the nodes in depth-first order, each subtree ends before _skip
+        std::vector< const VertexBufferBase* > _nodes;
+        std::vector< size_t > _skip;
+        std::vector< float >  _x;
+        std::vector< float >  _y;
+        std::vector< float >  _z;
+        std::vector< float >  _radius;
+        std::vector< float >  _rangeStart;
+        std::vector< float >  _rangeEnd;
+        std::vector< const VertexBufferBase* > _lods;
+        std::vector< float >  _lodError;
+        std::vector< bool >   _lodsBelow; // children have simplified meshes
+
+        bool _flatten( const VertexBufferBase& node );
+    };
+}
+
+
+#endif // MESH_VERTEXBUFFERCULLER_H
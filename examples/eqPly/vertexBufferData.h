@@ -38,6 +38,80 @@
 
 namespace mesh 
 {    
+    /*  An array owning its elements or referencing a memory mapped file.  */
+    template< class T > class DataArray
+    {
+    public:
+        DataArray() : _mapped( 0 ), _size( 0 ) {}
+
+        size_t size() const { return _mapped ? _size : _vector.size(); }
+        bool empty() const { return size() == 0; }
+        bool isMapped() const { return _mapped != 0; }
+
+        const T* getData() const
+            { return _mapped ? _mapped : _vector.empty() ? 0 : &_vector[0]; }
+
+        const T& operator[]( const size_t i ) const
+        {
+            MESHASSERT( i < size( ));
+            return _mapped ? _mapped[i] : _vector[i];
+        }
+
+        T& operator[]( const size_t i )
+        {
+            MESHASSERT( !_mapped );
+            return _vector[i];
+        }
+
+        void clear()
+        {
+            _vector.clear();
+            _mapped = 0;
+            _size = 0;
+        }
+
+        void resize( const size_t size )
+        {
+            MESHASSERT( !_mapped );
+            _vector.resize( size );
+        }
+
+        void push_back( const T& value )
+        {
+            MESHASSERT( !_mapped );
+            _vector.push_back( value );
+        }
+
+        /*  Reference size elements of the given mapped memory.  */
+        void map( const T* data, const size_t size )
+        {
+            _vector.clear();
+            _mapped = size > 0 ? data : 0;
+            _size = size;
+        }
+
+    private:
+        std::vector< T > _vector;
+        const T*         _mapped;
+        size_t           _size;
+    };
+
+    /*  A vertex of the compact layout. The position is quantized relative to
+        the bounding box of its leaf, the normal is octahedron encoded.  */
+    struct CompactVertex
+    {
+        int16_t position[3];
+        int8_t  normal[2];
+    };
+
+    /*  The interleaved buffer object vertex of the compact layout, with the
+        normal decoded for the fixed function pipeline.  */
+    struct CompactGLVertex
+    {
+        int16_t position[4];
+        int8_t  normal[4];
+    };
+
     /** Holds the final kd-tree data, sorted and reindexed.  */
     class VertexBufferData
     {
@@ -48,6 +122,7 @@ namespace mesh
             colors.clear();
             normals.clear();
             indices.clear();
+            compactVertices.clear();
         }
         
         /*  Write the vectors' sizes and contents to the given stream.  */
@@ -57,49 +132,87 @@ namespace mesh
             writeVector( os, colors );
             writeVector( os, normals );
             writeVector( os, indices );
+            writeVector( os, compactVertices );
         }
         
-        /*  Read the vectors' sizes and contents from the given MMF address.  */
-        void fromMemory( char** addr )
+        /*  Reference the vectors' contents at the given MMF address.  */
+        void fromMemory( char** addr, const char* end )
         {
             clear();
-            readVector( addr, vertices );
-            readVector( addr, colors );
-            readVector( addr, normals );
-            readVector( addr, indices );
+            mapVector( addr, end, vertices );
+            mapVector( addr, end, colors );
+            mapVector( addr, end, normals );
+            mapVector( addr, end, indices );
+            mapVector( addr, end, compactVertices );
+        }
+
+        /*  @return true if the data references a memory mapped file.  */
+        bool isMapped() const
+            { return vertices.isMapped() || indices.isMapped() ||
+                     compactVertices.isMapped(); }
+
+        /*  @return true if the vertices use the compact layout.  */
+        bool isCompact() const { return !compactVertices.empty(); }
+
+        /*  @return the buffer object memory needed to render all vertices.  */
+        size_t getBufferObjectSize() const
+        {
+            const size_t vertexSize = isCompact() ?
+                compactVertices.size() * sizeof( CompactGLVertex ) :
+                vertices.size() * sizeof( Vertex ) +
+                normals.size() * sizeof( Normal );
+            return vertexSize + colors.size() * sizeof( Color ) +
+                   indices.size() * sizeof( ShortIndex );
         }
         
-        std::vector< Vertex >       vertices;
-        std::vector< Color >        colors;
-        std::vector< Normal >       normals;
-        std::vector< ShortIndex >   indices;
+        DataArray< Vertex >       vertices;
+        DataArray< Color >        colors;
+        DataArray< Normal >       normals;
+        DataArray< ShortIndex >   indices;
+        // replaces vertices and normals in the compact layout
+        DataArray< CompactVertex > compactVertices;
         
     private:
         /*  Helper function to write a vector to output stream.  */
         template< class T >
-        void writeVector( std::ostream& os, std::vector< T >& v )
+        void writeVector( std::ostream& os, const DataArray< T >& v )
         {
-            size_t length = v.size();
+            uint64_t length = v.size();
             os.write( reinterpret_cast< char* >( &length ), 
-                      sizeof( size_t ) );
+                      sizeof( uint64_t ) );
+
+            // align the data for direct use from the mapped file
+            static const char padding[ FILE_ALIGNMENT ] = { 0 };
+            const size_t offset = size_t( os.tellp( )) % FILE_ALIGNMENT;
+            if( offset > 0 )
+                os.write( padding, FILE_ALIGNMENT - offset );
+
             if( length > 0 )
-                os.write( reinterpret_cast< char* >( &v[0] ), 
+                os.write( reinterpret_cast< const char* >( v.getData( )),
                           length * sizeof( T ) );
         }
         
-        /*  Helper function to read a vector from the MMF address.  */
+        /*  Helper function to reference a vector at the MMF address.  */
         template< class T >
-        void readVector( char** addr, std::vector< T >& v )
+        void mapVector( char** addr, const char* end, DataArray< T >& v )
         {
-            size_t length;
+            uint64_t length;
+            if( *addr + sizeof( uint64_t ) > end )
+                throw MeshException( "Error reading binary file. Data "
+                                     "exceeds the file size." );
             memRead( reinterpret_cast< char* >( &length ), addr, 
-                     sizeof( size_t ) );
-            if( length > 0 )
-            {
-                v.resize( length );
-                memRead( reinterpret_cast< char* >( &v[0] ), addr, 
-                         length * sizeof( T ) );
-            }
+                     sizeof( uint64_t ) );
+
+            const size_t offset = reinterpret_cast< size_t >( *addr ) %
+                                  FILE_ALIGNMENT;
+            if( offset > 0 )
+                *addr += FILE_ALIGNMENT - offset;
+
+            if( length > uint64_t( end - *addr ) / sizeof( T ))
+                throw MeshException( "Error reading binary file. Data "
+                                     "exceeds the file size." );
+            v.map( reinterpret_cast< const T* >( *addr ), size_t( length ));
+            *addr += length * sizeof( T );
         }
     };
     
@@ -36,6 +36,29 @@
 
 namespace eqPly 
 {
+namespace
+{
+template< class T >
+void _write( co::DataOStream& os, const mesh::DataArray< T >& array )
+{
+    const uint64_t size = array.size();
+    os << size;
+    if( size > 0 )
+        os << co::Array< T >( const_cast< T* >( array.getData( )),
+                             size_t( size ));
+}
+
+template< class T >
+void _read( co::DataIStream& is, mesh::DataArray< T >& array )
+{
+    uint64_t size = 0;
+    is >> size;
+    array.clear();
+    array.resize( size_t( size ));
+    if( size > 0 )
+        is >> co::Array< T >( &array[0], size_t( size ));
+}
+}
 
 VertexBufferDist::VertexBufferDist()
         : _root( 0 )
@@ -125,7 +148,10 @@ mesh::VertexBufferRoot* VertexBufferDist::loadModel( co::NodePtr master,
     }
 
     _unmapTree();
-    return const_cast< mesh::VertexBufferRoot* >( _root );
+    mesh::VertexBufferRoot* root =
+        const_cast< mesh::VertexBufferRoot* >( _root );
+    root->_culler.setup( *root );
+    return root;
 }
 
 void VertexBufferDist::_unmapTree()
@@ -155,8 +181,23 @@ void VertexBufferDist::getInstanceData( co::DataOStream& os )
             LBASSERT( _root );
             const mesh::VertexBufferData& data = _root->_data;
             
-            os << data.vertices << data.colors << data.normals << data.indices 
-               << _root->_name;
+            _write( os, data.vertices );
+            _write( os, data.colors );
+            _write( os, data.normals );
+            _write( os, data.indices );
+            _write( os, data.compactVertices );
+            os << _root->_name;
+        }
+
+        const mesh::VertexBufferNode* node =
+            static_cast< const mesh::VertexBufferNode* >( _node );
+        const mesh::VertexBufferLeaf* lod = node->_lod;
+        os << bool( lod != 0 );
+        if( lod )
+        {
+            os << node->_lodError;
+            _writeLeaf( os, lod );
+            os << lod->_boundingSphere << lod->_range;
         }
     }
     else
@@ -167,9 +208,7 @@ void VertexBufferDist::getInstanceData( co::DataOStream& os )
         const mesh::VertexBufferLeaf* leaf = 
             static_cast< const mesh::VertexBufferLeaf* >( _node );
 
-        os << leaf->_boundingBox[0] << leaf->_boundingBox[1]
-           << uint64_t( leaf->_vertexStart ) << uint64_t( leaf->_indexStart )
-           << uint64_t( leaf->_indexLength ) << leaf->_vertexLength;
+        _writeLeaf( os, leaf );
     }
 
     os << _node->_boundingSphere << _node->_range;
@@ -192,8 +231,12 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
             mesh::VertexBufferRoot* root = new mesh::VertexBufferRoot;
             mesh::VertexBufferData& data = root->_data;
 
-            is >> data.vertices >> data.colors >> data.normals >> data.indices
-               >> root->_name;
+            _read( is, data.vertices );
+            _read( is, data.colors );
+            _read( is, data.normals );
+            _read( is, data.indices );
+            _read( is, data.compactVertices );
+            is >> root->_name;
 
             node  = root;
             _root = root;
@@ -204,6 +247,18 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
             node = new mesh::VertexBufferNode;
         }
 
+        bool hasLOD = false;
+        is >> hasLOD;
+        if( hasLOD )
+        {
+            mesh::VertexBufferData& data =
+                const_cast< mesh::VertexBufferData& >( _root->_data );
+            node->_lod = new mesh::VertexBufferLeaf( data );
+            is >> node->_lodError;
+            _readLeaf( is, node->_lod );
+            is >> node->_lod->_boundingSphere >> node->_lod->_range;
+        }
+
         base   = node;
         _left  = new VertexBufferDist( _root, 0 );
         _right = new VertexBufferDist( _root, 0 );
@@ -227,13 +282,7 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
             const_cast< mesh::VertexBufferData& >( _root->_data );
         mesh::VertexBufferLeaf* leaf = new mesh::VertexBufferLeaf( data );
 
-        uint64_t i1, i2, i3;
-        is >> leaf->_boundingBox[0] >> leaf->_boundingBox[1]
-           >> i1 >> i2 >> i3 >> leaf->_vertexLength;
-        leaf->_vertexStart = size_t( i1 );
-        leaf->_indexStart = size_t( i2 );
-        leaf->_indexLength = size_t( i3 );
-
+        _readLeaf( is, leaf );
         base = leaf;
     }
 
@@ -243,4 +292,23 @@ void VertexBufferDist::applyInstanceData( co::DataIStream& is )
     _node = base;
 }
 
+void VertexBufferDist::_writeLeaf( co::DataOStream& os,
+                                   const mesh::VertexBufferLeaf* leaf )
+{
+    os << leaf->_boundingBox[0] << leaf->_boundingBox[1]
+       << uint64_t( leaf->_vertexStart ) << uint64_t( leaf->_indexStart )
+       << uint64_t( leaf->_indexLength ) << leaf->_vertexLength;
+}
+
+void VertexBufferDist::_readLeaf( co::DataIStream& is,
+                                  mesh::VertexBufferLeaf* leaf )
+{
+    uint64_t i1, i2, i3;
+    is >> leaf->_boundingBox[0] >> leaf->_boundingBox[1]
+       >> i1 >> i2 >> i3 >> leaf->_vertexLength;
+    leaf->_vertexStart = size_t( i1 );
+    leaf->_indexStart = size_t( i2 );
+    leaf->_indexLength = size_t( i3 );
+}
+
 }
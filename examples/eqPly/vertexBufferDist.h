@@ -67,6 +67,10 @@ namespace eqPly
         bool _isRoot;
 
         void _unmapTree();
+        static void _writeLeaf( co::DataOStream& os,
+                                const mesh::VertexBufferLeaf* leaf );
+        static void _readLeaf( co::DataIStream& is,
+                               mesh::VertexBufferLeaf* leaf );
     };
 }
 
@@ -32,10 +32,60 @@
 #include "vertexBufferData.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <map>
 
 namespace mesh
 {
+namespace
+{
+// range of the quantized position and normal components
+const float _positionRange = 32767.f;
+const float _normalRange = 127.f;
+
+inline float _sign( const float value ) { return value < 0.f ? -1.f : 1.f; }
+
+inline int8_t _quantizeNormal( const float value )
+{
+    return int8_t( floorf( std::max( -1.f, std::min( value, 1.f )) *
+                           _normalRange + .5f ));
+}
+
+/*  Project the normal onto the octahedron and unfold the lower half.  */
+void _encodeNormal( const Normal& normal, int8_t* encoded )
+{
+    const float length = fabsf( normal.x( )) + fabsf( normal.y( )) +
+                         fabsf( normal.z( ));
+    float u = length > 0.f ? normal.x() / length : 0.f;
+    float v = length > 0.f ? normal.y() / length : 0.f;
+    if( normal.z() < 0.f )
+    {
+        const float folded = ( 1.f - fabsf( v )) * _sign( u );
+        v = ( 1.f - fabsf( u )) * _sign( v );
+        u = folded;
+    }
+    encoded[0] = _quantizeNormal( u );
+    encoded[1] = _quantizeNormal( v );
+}
+
+Normal _decodeNormal( const int8_t* encoded )
+{
+    float u = float( encoded[0] ) / _normalRange;
+    float v = float( encoded[1] ) / _normalRange;
+    const float z = 1.f - fabsf( u ) - fabsf( v );
+    if( z < 0.f )
+    {
+        const float unfolded = ( 1.f - fabsf( v )) * _sign( u );
+        v = ( 1.f - fabsf( u )) * _sign( v );
+        u = unfolded;
+    }
+    Normal normal( u, v, z );
+    normal.normalize();
+    return normal;
+}
+}
 
 /*  Finish partial setup - sort, reindex and merge into global data.  */
 void VertexBufferLeaf::setupTree( VertexData& data, const Index start,
@@ -82,6 +132,118 @@ void VertexBufferLeaf::setupTree( VertexData& data, const Index start,
 }
 
 
+/*  Sort and reindex the triangles into the presized global index data.  */
+void VertexBufferLeaf::setupIndices( VertexData& data, const Index start,
+                                     const Index length,
+                                     VertexBufferData& globalData )
+{
+    data.sort( start, length, AXIS_X );
+    _indexStart = start * 3;
+    _indexLength = length * 3;
+    _vertexLength = 0;
+
+    // sort the references (vertex, position) to find all uses of each vertex
+    typedef std::pair< Index, Index > Reference;
+    std::vector< Reference > references( _indexLength );
+    for( Index i = 0; i < _indexLength; ++i )
+        references[i] = Reference( data.triangles[ start + i / 3 ][ i % 3 ],
+                                   i );
+    std::sort( references.begin(), references.end( ));
+
+    // new indices are assigned in order of the first use of each vertex
+    std::vector< Reference > firstUses; // (position, first reference)
+    for( Index i = 0; i < _indexLength; ++i )
+        if( i == 0 || references[i].first != references[i-1].first )
+            firstUses.push_back( Reference( references[i].second, i ));
+    std::sort( firstUses.begin(), firstUses.end( ));
+
+    for( std::vector< Reference >::const_iterator i = firstUses.begin();
+         i != firstUses.end(); ++i )
+    {
+        const Index vertex = references[ i->second ].first;
+        for( Index j = i->second;
+             j < _indexLength && references[j].first == vertex; ++j )
+        {
+            globalData.indices[ _indexStart + references[j].second ] =
+                _vertexLength;
+        }
+        ++_vertexLength;
+        // assert number of vertices does not exceed SmallIndex range
+        MESHASSERT( _vertexLength );
+    }
+}
+
+
+/*  Copy the vertex data of the reindexed triangles into the global data.  */
+void VertexBufferLeaf::setupVertices( const VertexData& data,
+                                      VertexBufferData& globalData )
+{
+    const bool hasColors = ( data.colors.size() > 0 );
+    const Index start = _indexStart / 3;
+
+    // indices are ascending on first use, copy each vertex only once
+    Index next = 0;
+    for( Index i = 0; i < _indexLength; ++i )
+    {
+        const Index index = globalData.indices[ _indexStart + i ];
+        if( index != next )
+            continue;
+
+        const Index vertex = data.triangles[ start + i / 3 ][ i % 3 ];
+        globalData.vertices[ _vertexStart + index ] = data.vertices[ vertex ];
+        if( hasColors )
+            globalData.colors[ _vertexStart + index ] = data.colors[ vertex ];
+        globalData.normals[ _vertexStart + index ] = data.normals[ vertex ];
+        ++next;
+    }
+    MESHASSERT( next == _vertexLength );
+
+#ifndef NDEBUG
+    MESHINFO << "setupTree" << "( " << _indexStart << ", " << _indexLength
+             << "; start " << _vertexStart << ", " << _vertexLength
+             << " vertices)." << std::endl;
+#endif
+}
+
+
+/*  The frame of the quantized positions: the center of the bounding box and
+    one uniform scale, which keeps the normals valid under the dequantizing
+    transformation.  */
+void VertexBufferLeaf::getQuantization( Vertex& center, float& scale ) const
+{
+    center = ( _boundingBox[0] + _boundingBox[1] ) * .5f;
+    const Vertex size = _boundingBox[1] - _boundingBox[0];
+    scale = std::max( std::max( size.x(), size.y( )), size.z( )) * .5f /
+            _positionRange;
+    if( scale <= 0.f )
+        scale = 1.f;
+}
+
+
+/*  Encode the vertices and normals of the leaf into the compact layout.  */
+void VertexBufferLeaf::setupCompactVertices( VertexBufferData& globalData )
+    const
+{
+    Vertex center;
+    float scale;
+    getQuantization( center, scale );
+
+    for( Index i = _vertexStart; i < _vertexStart + _vertexLength; ++i )
+    {
+        CompactVertex& compact = globalData.compactVertices[i];
+        const Vertex& vertex = globalData.vertices[i];
+        for( size_t j = 0; j < 3; ++j )
+        {
+            const float position = ( vertex[j] - center[j] ) / scale;
+            compact.position[j] = int16_t( floorf(
+                std::max( -_positionRange, std::min( position,
+                                                     _positionRange )) + .5f ));
+        }
+        _encodeNormal( globalData.normals[i], compact.normal );
+    }
+}
+
+
 /*  Compute the bounding sphere of the leaf's indexed vertices.  */
 const BoundingSphere& VertexBufferLeaf::updateBoundingSphere()
 {
@@ -214,15 +376,41 @@ void VertexBufferLeaf::setupRendering( VertexBufferState& state,
         
         if( data[VERTEX_OBJECT] == state.INVALID )
             data[VERTEX_OBJECT] = state.newBufferObject( charThis + 0 );
-        glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
-        glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Vertex ),
-                        &_globalData.vertices[_vertexStart], GL_STATIC_DRAW );
-        
         if( data[NORMAL_OBJECT] == state.INVALID )
             data[NORMAL_OBJECT] = state.newBufferObject( charThis + 1 );
-        glBindBuffer( GL_ARRAY_BUFFER, data[NORMAL_OBJECT] );
-        glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
-                        &_globalData.normals[_vertexStart], GL_STATIC_DRAW );
+
+        if( _globalData.isCompact( ))
+        {
+            // interleave the quantized positions with the decoded normals,
+            // the normal buffer stays unused
+            std::vector< CompactGLVertex > vertices( _vertexLength );
+            for( Index i = 0; i < _vertexLength; ++i )
+            {
+                const CompactVertex& compact =
+                    _globalData.compactVertices[ _vertexStart + i ];
+                const Normal normal = _decodeNormal( compact.normal );
+                for( size_t j = 0; j < 3; ++j )
+                {
+                    vertices[i].position[j] = compact.position[j];
+                    vertices[i].normal[j] = _quantizeNormal( normal[j] );
+                }
+                vertices[i].position[3] = 0;
+                vertices[i].normal[3] = 0;
+            }
+            glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
+            glBufferData( GL_ARRAY_BUFFER,
+                          _vertexLength * sizeof( CompactGLVertex ),
+                          &vertices[0], GL_STATIC_DRAW );
+        }
+        else
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, data[VERTEX_OBJECT] );
+            glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Vertex ),
+                          &_globalData.vertices[_vertexStart], GL_STATIC_DRAW );
+            glBindBuffer( GL_ARRAY_BUFFER, data[NORMAL_OBJECT] );
+            glBufferData( GL_ARRAY_BUFFER, _vertexLength * sizeof( Normal ),
+                          &_globalData.normals[_vertexStart], GL_STATIC_DRAW );
+        }
         
         if( data[COLOR_OBJECT] == state.INVALID )
             data[COLOR_OBJECT] = state.newBufferObject( charThis + 2 );
@@ -301,11 +489,35 @@ void VertexBufferLeaf::renderBufferObject( VertexBufferState& state ) const
         glBindBuffer( GL_ARRAY_BUFFER, buffers[COLOR_OBJECT] );
         glColorPointer( 4, GL_UNSIGNED_BYTE, 0, 0 );
     }
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffers[INDEX_OBJECT] );
+
+    if( _globalData.isCompact( ))
+    {
+        // dequantize the positions, GL_NORMALIZE is enabled by the root
+        Vertex center;
+        float scale;
+        getQuantization( center, scale );
+
+        const GLsizei stride = sizeof( CompactGLVertex );
+        const char* normals = reinterpret_cast< const char* >(
+            offsetof( CompactGLVertex, normal ));
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[VERTEX_OBJECT] );
+        glNormalPointer( GL_BYTE, stride, normals );
+        glVertexPointer( 3, GL_SHORT, stride, 0 );
+
+        glPushMatrix();
+        glTranslatef( center.x(), center.y(), center.z( ));
+        glScalef( scale, scale, scale );
+        glDrawElements( GL_TRIANGLES, GLsizei( _indexLength ),
+                        GL_UNSIGNED_SHORT, 0 );
+        glPopMatrix();
+        return;
+    }
+
     glBindBuffer( GL_ARRAY_BUFFER, buffers[NORMAL_OBJECT] );
     glNormalPointer( GL_FLOAT, 0, 0 );
     glBindBuffer( GL_ARRAY_BUFFER, buffers[VERTEX_OBJECT] );
     glVertexPointer( 3, GL_FLOAT, 0, 0 );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffers[INDEX_OBJECT] );
     glDrawElements( GL_TRIANGLES, GLsizei( _indexLength ), GL_UNSIGNED_SHORT, 0 );
 }
 
@@ -331,12 +543,28 @@ void VertexBufferLeaf::renderDisplayList( VertexBufferState& state ) const
 inline
 void VertexBufferLeaf::renderImmediate( VertexBufferState& state ) const
 {
+    const bool compact = _globalData.isCompact();
+    Vertex center;
+    float scale = 1.f;
+    if( compact )
+        getQuantization( center, scale );
+
     glBegin( GL_TRIANGLES );  
     for( Index offset = 0; offset < _indexLength; ++offset )
     {
         const Index i =_vertexStart + _globalData.indices[_indexStart + offset];
         if( state.useColors() )
             glColor4ubv( &_globalData.colors[i][0] );
+        if( compact )
+        {
+            const CompactVertex& vertex = _globalData.compactVertices[i];
+            const Normal normal = _decodeNormal( vertex.normal );
+            glNormal3fv( &normal[0] );
+            glVertex3f( center.x() + vertex.position[0] * scale,
+                        center.y() + vertex.position[1] * scale,
+                        center.z() + vertex.position[2] * scale );
+            continue;
+        }
         glNormal3fv( &_globalData.normals[i][0] );
         glVertex3fv( &_globalData.vertices[i][0] );
     }
@@ -355,36 +583,53 @@ void VertexBufferLeaf::renderImmediate( VertexBufferState& state ) const
 /*  Read leaf node from memory.  */
 void VertexBufferLeaf::fromMemory( char** addr, VertexBufferData& globalData )
 {
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    uint64_t nodeType;
+    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( uint64_t ));
     if( nodeType != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected a leaf "
                              "node, but found something else instead." );
     VertexBufferBase::fromMemory( addr, globalData );
     memRead( reinterpret_cast< char* >( &_boundingBox ), addr, 
              sizeof( BoundingBox ) );
-    memRead( reinterpret_cast< char* >( &_vertexStart ), addr, 
-             sizeof( Index ) );
+
+    // indices are stored with 64 bits independent of the architecture
+    uint64_t index;
+    memRead( reinterpret_cast< char* >( &index ), addr, sizeof( uint64_t ));
+    _vertexStart = Index( index );
     memRead( reinterpret_cast< char* >( &_vertexLength ), addr, 
              sizeof( ShortIndex ) );
-    memRead( reinterpret_cast< char* >( &_indexStart ), addr, 
-             sizeof( Index ) );
-    memRead( reinterpret_cast< char* >( &_indexLength ), addr, 
-             sizeof( Index ) );
+    memRead( reinterpret_cast< char* >( &index ), addr, sizeof( uint64_t ));
+    _indexStart = Index( index );
+    memRead( reinterpret_cast< char* >( &index ), addr, sizeof( uint64_t ));
+    _indexLength = Index( index );
+
+    const size_t nVertices = globalData.isCompact() ?
+                             globalData.compactVertices.size() :
+                             globalData.vertices.size();
+    if( _vertexStart + _vertexLength > nVertices ||
+        _indexStart + _indexLength > globalData.indices.size( ))
+    {
+        throw MeshException( "Error reading binary file. Leaf node "
+                             "references data outside of the file." );
+    }
 }
 
 
 /*  Write leaf node to output stream.  */
 void VertexBufferLeaf::toStream( std::ostream& os )
 {
-    size_t nodeType = LEAF_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ));
+    uint64_t nodeType = LEAF_TYPE;
+    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( uint64_t ));
     VertexBufferBase::toStream( os );
     os.write( reinterpret_cast< char* >( &_boundingBox ), sizeof( BoundingBox));
-    os.write( reinterpret_cast< char* >( &_vertexStart ), sizeof( Index ));
+
+    uint64_t index = _vertexStart;
+    os.write( reinterpret_cast< char* >( &index ), sizeof( uint64_t ));
     os.write( reinterpret_cast< char* >( &_vertexLength ),sizeof( ShortIndex ));
-    os.write( reinterpret_cast< char* >( &_indexStart ), sizeof( Index ));
-    os.write( reinterpret_cast< char* >( &_indexLength ), sizeof( Index ));
+    index = _indexStart;
+    os.write( reinterpret_cast< char* >( &index ), sizeof( uint64_t ));
+    index = _indexLength;
+    os.write( reinterpret_cast< char* >( &index ), sizeof( uint64_t ));
 }
 
 }
@@ -64,18 +64,25 @@ namespace mesh
         virtual void updateRange();
         
     private:
+        void setupIndices( VertexData& data, const Index start,
+                           const Index length, VertexBufferData& globalData );
+        void setupVertices( const VertexData& data,
+                            VertexBufferData& globalData );
+        void setupCompactVertices( VertexBufferData& globalData ) const;
+        void getQuantization( Vertex& center, float& scale ) const;
         void setupRendering( VertexBufferState& state, GLuint* data ) const;
         void renderImmediate( VertexBufferState& state ) const;
         void renderDisplayList( VertexBufferState& state ) const;
         void renderBufferObject( VertexBufferState& state ) const;
         
-        VertexBufferData&   _globalData;
+        const VertexBufferData& _globalData;
         BoundingBox         _boundingBox;
         Index               _vertexStart;
         Index               _indexStart;
         Index               _indexLength;
         ShortIndex          _vertexLength;
         friend class eqPly::VertexBufferDist;
+        friend class VertexBufferNode;
     };
     
     
@@ -29,9 +29,13 @@
 
 
 #include "vertexBufferNode.h"
+#include "vertexBufferData.h"
 #include "vertexBufferLeaf.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <set>
 
 namespace mesh
@@ -42,8 +46,10 @@ VertexBufferNode::~VertexBufferNode()
 {
     delete _left;
     delete _right;
+    delete _lod;
     _left = 0;
     _right = 0;
+    _lod = 0;
 }
 
 inline static bool _subdivide( const Index length, const size_t depth )
@@ -101,6 +107,453 @@ void VertexBufferNode::setupTree( VertexData& data, const Index start,
 }
 
 
+/*  The setup of one subtree, i.e., a range of triangles and its node.  */
+struct VertexBufferNode::SetupTask
+{
+    VertexBufferBase* node;
+    Index start;
+    Index length;
+    Axis axis;
+    size_t depth;
+    bool leaf;
+};
+
+/*  Minimum number of independent subtrees to set up in parallel.  */
+static const size_t _nParallelTasks = 64;
+
+/*  Number of subtrees below which the splits run one after another, letting
+    each partition of the large upper levels use all threads by itself.  */
+static const size_t _nSerialTasks = 4;
+
+/*  Set up the kd-tree, constructing independent subtrees in parallel.  */
+void VertexBufferNode::setupTreeParallel( VertexData& data, const Axis axis,
+                                          VertexBufferData& globalData )
+{
+    const Index length = data.triangles.size();
+    globalData.clear();
+    globalData.indices.resize( length * 3 );
+
+    // split the upper levels until there are enough independent subtrees
+    const SetupTask root = { this, 0, length, axis, 0, false };
+    SetupTasks tasks( 1, root );
+    bool split = true;
+    while( split && tasks.size() < _nParallelTasks )
+    {
+        SetupTasks children( tasks.size() * 2 );
+        if( tasks.size() < _nSerialTasks )
+        {
+            for( size_t i = 0; i < tasks.size(); ++i )
+                _splitTask( data, tasks[i], globalData, &children[ i * 2 ] );
+        }
+        else
+        {
+#pragma omp parallel for schedule( dynamic )
+            for( ssize_t i = 0; i < ssize_t( tasks.size( )); ++i )
+                _splitTask( data, tasks[i], globalData, &children[ i * 2 ] );
+        }
+
+        tasks.clear();
+        split = false;
+        for( SetupTasks::const_iterator i = children.begin();
+             i != children.end(); ++i )
+        {
+            if( !i->node )
+                continue;
+            tasks.push_back( *i );
+            split = split || !i->leaf;
+        }
+    }
+
+    // sort and reindex the triangles of all subtrees
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( tasks.size( )); ++i )
+        _setupSubtree( data, tasks[i], globalData );
+
+    // place the vertices of each leaf after the ones of its predecessor
+    Leaves leaves;
+    _collectLeaves( leaves );
+
+    Index vertexStart = 0;
+    for( Leaves::const_iterator i = leaves.begin(); i != leaves.end(); ++i )
+    {
+        (*i)->_vertexStart = vertexStart;
+        vertexStart += (*i)->_vertexLength;
+    }
+
+    globalData.vertices.resize( vertexStart );
+    globalData.normals.resize( vertexStart );
+    if( !data.colors.empty( ))
+        globalData.colors.resize( vertexStart );
+
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+        leaves[i]->setupVertices( data, globalData );
+}
+
+
+/*  Split one subtree into its two children, or pass a leaf through.  */
+void VertexBufferNode::_splitTask( VertexData& data, const SetupTask& task,
+                                   VertexBufferData& globalData,
+                                   SetupTask* children )
+{
+    if( task.leaf )
+    {
+        children[0] = task;
+        children[1].node = 0;
+        return;
+    }
+
+    static_cast< VertexBufferNode* >( task.node )->_setupNode(
+        data, task.start, task.length, task.axis, task.depth, globalData,
+        children );
+}
+
+
+/*  Partition the triangles at the median and create the child nodes.  */
+void VertexBufferNode::_setupNode( VertexData& data, const Index start,
+                                   const Index length, const Axis axis,
+                                   const size_t depth,
+                                   VertexBufferData& globalData,
+                                   SetupTask* children )
+{
+    // the leaves sort their triangles, which is all the order needed
+    data.partition( start, length, axis );
+    const Index median = start + ( length / 2 );
+
+    const Index leftLength    = length / 2;
+    const bool  subdivideLeft = _subdivide( leftLength, depth );
+    if( subdivideLeft )
+        _left = new VertexBufferNode;
+    else
+        _left = new VertexBufferLeaf( globalData );
+
+    const Index rightLength    = ( length + 1 ) / 2;
+    const bool  subdivideRight = _subdivide( rightLength, depth );
+    if( subdivideRight )
+        _right = new VertexBufferNode;
+    else
+        _right = new VertexBufferLeaf( globalData );
+
+    // move to next axis and continue contruction in the child nodes
+    const Axis newAxisLeft  = subdivideLeft ?
+                        data.getLongestAxis( start , leftLength  ) : AXIS_X;
+    const Axis newAxisRight = subdivideRight ?
+                        data.getLongestAxis( median, rightLength ) : AXIS_X;
+
+    const SetupTask left = { _left, start, leftLength, newAxisLeft, depth + 1,
+                             !subdivideLeft };
+    const SetupTask right = { _right, median, rightLength, newAxisRight,
+                              depth + 1, !subdivideRight };
+    children[0] = left;
+    children[1] = right;
+}
+
+
+/*  Set up a subtree recursively in the calling thread.  */
+void VertexBufferNode::_setupSubtree( VertexData& data, const SetupTask& task,
+                                      VertexBufferData& globalData )
+{
+    if( task.leaf )
+    {
+        static_cast< VertexBufferLeaf* >( task.node )->setupIndices(
+            data, task.start, task.length, globalData );
+        return;
+    }
+
+    SetupTask children[2];
+    static_cast< VertexBufferNode* >( task.node )->_setupNode(
+        data, task.start, task.length, task.axis, task.depth, globalData,
+        children );
+    _setupSubtree( data, children[0], globalData );
+    _setupSubtree( data, children[1], globalData );
+}
+
+
+/*  Append all leaves of this subtree in rendering order.  */
+void VertexBufferNode::_collectLeaves( Leaves& leaves )
+{
+    VertexBufferBase* children[2] = { _left, _right };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( children[i]->getLeft( ))
+            static_cast< VertexBufferNode* >( children[i] )->_collectLeaves(
+                leaves );
+        else
+            leaves.push_back( static_cast< VertexBufferLeaf* >( children[i] ));
+    }
+}
+
+
+/*  Grid resolution per axis of the vertex clustering, keeps the number of
+    clusters within the ShortIndex range.  */
+static const uint32_t _lodGrid = 32;
+
+/*  Create the simplified meshes of this subtree, bottom-up. Each node
+    clusters the vertices of its children's simplified meshes or leaves on a
+    regular grid, and is only used if it reduces the triangle count. Without
+    an own simplified mesh, the error is the one of the meshes passed on as
+    input to the parent.  */
+void VertexBufferNode::setupLOD( VertexBufferData& globalData )
+{
+    delete _lod;
+    _lod = 0;
+
+    VertexBufferBase* children[2] = { _left, _right };
+    float childError = 0.f;
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( !children[i]->getLeft( ))
+            continue;
+        VertexBufferNode* child = static_cast< VertexBufferNode* >(
+            children[i] );
+        child->setupLOD( globalData );
+        childError = std::max( childError, child->_lodError );
+    }
+    _lodError = childError;
+
+    Leaves inputs;
+    _collectLODInput( inputs );
+
+    // bounding box and triangle count of the input
+    BoundingBox box;
+    box[0] = Vertex( std::numeric_limits< float >::max( ));
+    box[1] = Vertex( -std::numeric_limits< float >::max( ));
+    Index nIndices = 0;
+    for( Leaves::const_iterator i = inputs.begin(); i != inputs.end(); ++i )
+    {
+        const VertexBufferLeaf* leaf = *i;
+        for( size_t j = 0; j < 2; ++j )
+            for( size_t k = 0; k < 3; ++k )
+            {
+                box[0][k] = std::min( box[0][k], leaf->_boundingBox[j][k] );
+                box[1][k] = std::max( box[1][k], leaf->_boundingBox[j][k] );
+            }
+        nIndices += leaf->_indexLength;
+    }
+
+    const Vertex size = box[1] - box[0];
+    const float cellSize = std::max( std::max( size.x(), size.y( )),
+                                     size.z( )) / _lodGrid;
+    if( cellSize <= 0.f )
+        return;
+
+    // cluster the vertices, accumulating position, normal and color
+    const bool hasColors = !globalData.colors.empty();
+    std::vector< int32_t > clusters( _lodGrid * _lodGrid * _lodGrid, -1 );
+    std::vector< Vertex > positions;
+    std::vector< Normal > normals;
+    std::vector< Vector4f > colors;
+    std::vector< float > weights;
+    std::vector< ShortIndex > indices;
+    indices.reserve( nIndices );
+
+    for( Leaves::const_iterator i = inputs.begin(); i != inputs.end(); ++i )
+    {
+        const VertexBufferLeaf* leaf = *i;
+        for( Index j = 0; j < leaf->_indexLength; ++j )
+        {
+            const Index index = leaf->_vertexStart +
+                globalData.indices[ leaf->_indexStart + j ];
+            const Vertex& vertex = globalData.vertices[ index ];
+
+            uint32_t cell[3];
+            for( size_t k = 0; k < 3; ++k )
+                cell[k] = std::min( uint32_t(( vertex[k] - box[0][k] ) /
+                                             cellSize ), _lodGrid - 1 );
+            int32_t& cluster = clusters[ cell[0] + _lodGrid *
+                                         ( cell[1] + _lodGrid * cell[2] )];
+            if( cluster < 0 )
+            {
+                cluster = int32_t( positions.size( ));
+                positions.push_back( Vertex( 0.f ));
+                normals.push_back( Normal( 0.f ));
+                colors.push_back( Vector4f( 0.f ));
+                weights.push_back( 0.f );
+            }
+
+            positions[ cluster ] += vertex;
+            normals[ cluster ] += globalData.normals[ index ];
+            if( hasColors )
+                for( size_t k = 0; k < 4; ++k )
+                    colors[ cluster ][k] += globalData.colors[ index ][k];
+            weights[ cluster ] += 1.f;
+            indices.push_back( ShortIndex( cluster ));
+        }
+    }
+
+    // remove collapsed and duplicate triangles, keeping their orientation by
+    // rotating the smallest index first and packing them into one key each
+    std::vector< uint64_t > triangles;
+    for( size_t i = 0; i < indices.size(); i += 3 )
+    {
+        ShortIndex a = indices[i];
+        ShortIndex b = indices[i+1];
+        ShortIndex c = indices[i+2];
+        if( a == b || b == c || a == c )
+            continue;
+        while( a > b || a > c )
+        {
+            const ShortIndex first = a;
+            a = b;
+            b = c;
+            c = first;
+        }
+        triangles.push_back( uint64_t( a ) << 32 | uint64_t( b ) << 16 | c );
+    }
+    std::sort( triangles.begin(), triangles.end( ));
+    triangles.erase( std::unique( triangles.begin(), triangles.end( )),
+                     triangles.end( ));
+
+    if( triangles.empty() || triangles.size() * 3 * 2 > nIndices )
+        return; // not worth it
+
+    _lod = new VertexBufferLeaf( globalData );
+    _lod->_vertexStart = globalData.vertices.size();
+    _lod->_vertexLength = ShortIndex( positions.size( ));
+    _lod->_indexStart = globalData.indices.size();
+    _lod->_indexLength = triangles.size() * 3;
+    MESHASSERT( _lod->_vertexLength == positions.size( ));
+
+    for( size_t i = 0; i < positions.size(); ++i )
+    {
+        globalData.vertices.push_back( positions[i] / weights[i] );
+        Normal normal = normals[i];
+        normal.normalize();
+        globalData.normals.push_back( normal );
+        if( hasColors )
+        {
+            Color color;
+            for( size_t k = 0; k < 4; ++k )
+                color[k] = uint8_t( colors[i][k] / weights[i] + .5f );
+            globalData.colors.push_back( color );
+        }
+    }
+    for( size_t i = 0; i < triangles.size(); ++i )
+    {
+        globalData.indices.push_back( ShortIndex( triangles[i] >> 32 ));
+        globalData.indices.push_back( ShortIndex( triangles[i] >> 16 ));
+        globalData.indices.push_back( ShortIndex( triangles[i] ));
+    }
+
+    // a cluster moves its vertices by at most the cell diagonal
+    _lodError = childError + cellSize * sqrtf( 3.f );
+    _lod->updateBoundingSphere();
+    _lod->_range[0] = _range[0];
+    _lod->_range[1] = _range[1];
+}
+
+
+/*  Append the meshes to simplify: the simplified meshes of the children if
+    available, their leaves otherwise.  */
+void VertexBufferNode::_collectLODInput( Leaves& inputs ) const
+{
+    const VertexBufferBase* children[2] = { _left, _right };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        if( !children[i]->getLeft( ))
+        {
+            inputs.push_back( const_cast< VertexBufferLeaf* >(
+                static_cast< const VertexBufferLeaf* >( children[i] )));
+            continue;
+        }
+
+        const VertexBufferNode* child =
+            static_cast< const VertexBufferNode* >( children[i] );
+        if( child->_lod )
+            inputs.push_back( child->_lod );
+        else
+            child->_collectLODInput( inputs );
+    }
+}
+
+
+/*  Verify the error of all simplified meshes of this subtree: each cluster
+    vertex is the average of input vertices within its error of the full
+    resolution mesh, and has to be that close to one of its vertices.  */
+size_t VertexBufferNode::countLODErrors() const
+{
+    size_t nErrors = 0;
+    const VertexBufferBase* children[2] = { _left, _right };
+    for( size_t i = 0; i < 2; ++i )
+        if( children[i]->getLeft( ))
+            nErrors += static_cast< const VertexBufferNode* >(
+                children[i] )->countLODErrors();
+
+    if( !_lod )
+        return nErrors;
+
+    // allow for the rounding of the accumulated cluster positions
+    const float distance = _lodError * 1.0001f;
+    const VertexBufferData& globalData = _lod->_globalData;
+    const ssize_t nVertices = ssize_t( _lod->_vertexLength );
+
+#pragma omp parallel for reduction( +: nErrors )
+    for( ssize_t i = 0; i < nVertices; ++i )
+    {
+        const Vertex& vertex = globalData.vertices[ _lod->_vertexStart + i ];
+        if( !_hasVertexNear( *this, vertex, distance, globalData ))
+            ++nErrors;
+    }
+    return nErrors;
+}
+
+
+/*  Test if any full resolution vertex of the subtree is within the distance
+    of the point, descending only into the bounding spheres in reach.  */
+bool VertexBufferNode::_hasVertexNear( const VertexBufferBase& node,
+                                       const Vertex& point,
+                                       const float distance,
+                                       const VertexBufferData& globalData )
+{
+    const BoundingSphere& sphere = node.getBoundingSphere();
+    const Vertex center( sphere.array );
+    if( ( center - point ).length() > sphere.w() + distance )
+        return false;
+
+    if( node.getLeft( ))
+        return _hasVertexNear( *node.getLeft(), point, distance, globalData ) ||
+               _hasVertexNear( *node.getRight(), point, distance, globalData );
+
+    const VertexBufferLeaf& leaf = static_cast< const VertexBufferLeaf& >(
+        node );
+    for( Index i = 0; i < leaf._vertexLength; ++i )
+    {
+        const Vertex& vertex = globalData.vertices[ leaf._vertexStart + i ];
+        if( ( vertex - point ).length() <= distance )
+            return true;
+    }
+    return false;
+}
+
+
+/*  Encode the vertices of all leaves and simplified meshes into the compact
+    layout, each relative to its own bounding box.  */
+void VertexBufferNode::setupCompactVertices( VertexBufferData& globalData )
+{
+    Leaves leaves;
+    _collectLeaves( leaves );
+    _collectLODs( leaves );
+
+#pragma omp parallel for schedule( dynamic )
+    for( ssize_t i = 0; i < ssize_t( leaves.size( )); ++i )
+        leaves[i]->setupCompactVertices( globalData );
+}
+
+
+/*  Append the simplified meshes of this subtree.  */
+void VertexBufferNode::_collectLODs( Leaves& lods )
+{
+    if( _lod )
+        lods.push_back( _lod );
+
+    VertexBufferBase* children[2] = { _left, _right };
+    for( size_t i = 0; i < 2; ++i )
+        if( children[i]->getLeft( ))
+            static_cast< VertexBufferNode* >( children[i] )->_collectLODs(
+                lods );
+}
+
+
 /*  Compute the bounding sphere from the children's bounding spheres.  */
 const BoundingSphere& VertexBufferNode::updateBoundingSphere()
 {
@@ -165,19 +618,30 @@ void VertexBufferNode::draw( VertexBufferState& state ) const
 void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
 {
     // read node itself   
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    uint64_t nodeType;
+    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( uint64_t ));
     if( nodeType != NODE_TYPE )
         throw MeshException( "Error reading binary file. Expected a regular "
                              "node, but found something else instead." );
     VertexBufferBase::fromMemory( addr, globalData );
+
+    // read the simplified mesh, if any
+    uint64_t hasLOD;
+    memRead( reinterpret_cast< char* >( &hasLOD ), addr, sizeof( uint64_t ));
+    if( hasLOD )
+    {
+        memRead( reinterpret_cast< char* >( &_lodError ), addr,
+                 sizeof( float ));
+        _lod = new VertexBufferLeaf( globalData );
+        _lod->fromMemory( addr, globalData );
+    }
     
     // read left child (peek ahead)
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( uint64_t ));
     if( nodeType != NODE_TYPE && nodeType != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected either a "
                              "regular or a leaf node, but found neither." );
-    *addr -= sizeof( size_t );
+    *addr -= sizeof( uint64_t );
     if( nodeType == NODE_TYPE )
         _left = new VertexBufferNode;
     else
@@ -185,11 +649,11 @@ void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
     static_cast< VertexBufferNode* >( _left )->fromMemory( addr, globalData );
     
     // read right child (peek ahead)
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( uint64_t ));
     if( nodeType != NODE_TYPE && nodeType != LEAF_TYPE )
         throw MeshException( "Error reading binary file. Expected either a "
                              "regular or a leaf node, but found neither." );
-    *addr -= sizeof( size_t );
+    *addr -= sizeof( uint64_t );
     if( nodeType == NODE_TYPE )
         _right = new VertexBufferNode;
     else
@@ -201,9 +665,17 @@ void VertexBufferNode::fromMemory( char** addr, VertexBufferData& globalData )
 /*  Write node to output stream and continue with remaining nodes.  */
 void VertexBufferNode::toStream( std::ostream& os )
 {
-    size_t nodeType = NODE_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
+    uint64_t nodeType = NODE_TYPE;
+    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( uint64_t ));
     VertexBufferBase::toStream( os );
+
+    uint64_t hasLOD = _lod ? 1 : 0;
+    os.write( reinterpret_cast< char* >( &hasLOD ), sizeof( uint64_t ));
+    if( _lod )
+    {
+        os.write( reinterpret_cast< char* >( &_lodError ), sizeof( float ));
+        _lod->toStream( os );
+    }
     static_cast< VertexBufferNode* >( _left )->toStream( os );
     static_cast< VertexBufferNode* >( _right )->toStream( os );
 }
@@ -36,14 +36,18 @@
 
 
 #include "vertexBufferBase.h"
+#include <vector>
 
 namespace mesh 
 {
+    class VertexBufferLeaf;
+
     /*  The class for regular (non-leaf) kd-tree nodes.  */
     class VertexBufferNode : public VertexBufferBase
     {
     public:
-        VertexBufferNode() : _left( 0 ), _right( 0 ) {}
+        VertexBufferNode() : _left( 0 ), _right( 0 ), _lod( 0 ),
+                             _lodError( 0.f ) {}
         virtual ~VertexBufferNode();
 
         virtual void draw( VertexBufferState& state ) const;
@@ -53,6 +57,14 @@ namespace mesh
         virtual const VertexBufferBase* getLeft() const { return _left; }
         virtual const VertexBufferBase* getRight() const { return _right; }
 
+        /*  The simplified mesh of this subtree, or 0.  */
+        virtual const VertexBufferBase* getLOD() const { return _lod; }
+        /*  The maximum object-space deviation of the simplified mesh.  */
+        virtual float getLODError() const { return _lodError; }
+        /*  The number of simplified mesh vertices in this subtree which are
+            farther than their error from the full resolution mesh.  */
+        size_t countLODErrors() const;
+
     protected:
         virtual void toStream( std::ostream& os );
         virtual void fromMemory( char** addr, VertexBufferData& globalData );
@@ -64,9 +76,36 @@ namespace mesh
         virtual const BoundingSphere& updateBoundingSphere();
         virtual void updateRange();
 
+        void setupTreeParallel( VertexData& data, const Axis axis,
+                                VertexBufferData& globalData );
+        void setupLOD( VertexBufferData& globalData );
+        void setupCompactVertices( VertexBufferData& globalData );
+
     private:
+        struct SetupTask;
+        typedef std::vector< SetupTask > SetupTasks;
+        typedef std::vector< VertexBufferLeaf* > Leaves;
+
+        void _setupNode( VertexData& data, const Index start,
+                         const Index length, const Axis axis,
+                         const size_t depth, VertexBufferData& globalData,
+                         SetupTask* children );
+        static void _splitTask( VertexData& data, const SetupTask& task,
+                                VertexBufferData& globalData,
+                                SetupTask* children );
+        static void _setupSubtree( VertexData& data, const SetupTask& task,
+                                   VertexBufferData& globalData );
+        void _collectLeaves( Leaves& leaves );
+        void _collectLODInput( Leaves& inputs ) const;
+        void _collectLODs( Leaves& lods );
+        static bool _hasVertexNear( const VertexBufferBase& node,
+                                    const Vertex& point, const float distance,
+                                    const VertexBufferData& globalData );
+
         VertexBufferBase*   _left;
         VertexBufferBase*   _right;
+        VertexBufferLeaf*   _lod;
+        float               _lodError;
         friend class eqPly::VertexBufferDist;
     };
 }
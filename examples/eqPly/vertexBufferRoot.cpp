@@ -31,19 +31,54 @@
 #include "vertexBufferRoot.h"
 #include "vertexBufferState.h"
 #include "vertexData.h"
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#ifndef _WIN32
+#ifdef _WIN32
+#   include <process.h>
+#   define getpid _getpid
+#else
 #   include <sys/mman.h>
+#   include <unistd.h>
 #endif
 
 namespace mesh
 {
 
-typedef vmml::frustum_culler< float >  FrustumCuller;
+namespace
+{
+/*  The header of the binary kd-tree file.  */
+struct FileHeader
+{
+    uint32_t magic;      // FILE_MAGIC
+    uint32_t version;    // FILE_VERSION
+    uint32_t byteOrder;  // FILE_BYTE_ORDER as written by the creator
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t treeOffset; // the vertex data is between header and tree
+    uint64_t treeSize;
+    uint64_t treeChecksum;
+};
+
+const uint32_t FILE_MAGIC = 0x45715079; // 'EqPy'
+const uint32_t FILE_BYTE_ORDER = 0x01020304;
+
+/*  FNV-1a hash of the given memory.  */
+uint64_t _checksum( const char* data, const size_t size )
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for( size_t i = 0; i < size; ++i )
+    {
+        hash ^= uint8_t( data[i] );
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+}
 
 /*  Determine number of bits used by the current architecture.  */
 size_t getArchitectureBits();
@@ -52,11 +87,37 @@ bool isArchitectureLittleEndian();
 /*  Construct architecture dependent file name.  */
 std::string getArchitectureFilename( const std::string& filename );
 
-/*  Begin kd-tree setup, go through full range starting with x axis.  */
+/*  Destructor, releases the binary file mapping.  */
+VertexBufferRoot::~VertexBufferRoot()
+{
+    _data.clear();
+    _unmap();
+}
+
+/*  Begin kd-tree setup, go through full range starting with longest axis.  */
 void VertexBufferRoot::setupTree( VertexData& data )
 {
     // data is VertexData, _data is VertexBufferData
     _data.clear();
+    _unmap();
+
+    const Axis axis = data.getLongestAxis( 0, data.triangles.size() );
+
+    VertexBufferNode::setupTreeParallel( data, axis, _data );
+    VertexBufferNode::updateBoundingSphere();
+    VertexBufferNode::updateRange();
+    VertexBufferNode::setupLOD( _data );
+    if( _compact )
+        _setupCompactVertices();
+    _culler.setup( *this );
+}
+
+/*  Single-threaded kd-tree setup, the reference for setupTree().  */
+void VertexBufferRoot::setupTreeSerial( VertexData& data )
+{
+    // data is VertexData, _data is VertexBufferData
+    _data.clear();
+    _unmap();
 
     const Axis axis = data.getLongestAxis( 0, data.triangles.size() );
 
@@ -64,6 +125,10 @@ void VertexBufferRoot::setupTree( VertexData& data )
                                  axis, 0, _data );
     VertexBufferNode::updateBoundingSphere();
     VertexBufferNode::updateRange();
+    VertexBufferNode::setupLOD( _data );
+    if( _compact )
+        _setupCompactVertices();
+    _culler.setup( *this );
 
 #if 0
     // re-test all points to be in the bounding sphere
@@ -82,101 +147,45 @@ void VertexBufferRoot::setupTree( VertexData& data )
 #endif
 }
 
+/*  Replace the vertices and normals by their compact encoding.  */
+void VertexBufferRoot::_setupCompactVertices()
+{
+    _data.compactVertices.resize( _data.vertices.size( ));
+    VertexBufferNode::setupCompactVertices( _data );
+    _data.vertices.clear();
+    _data.normals.clear();
+}
+
 // #define LOGCULL
 void VertexBufferRoot::cullDraw( VertexBufferState& state ) const
 {
-    _beginRendering( state );
-    
-#ifdef LOGCULL
-    size_t verticesRendered = 0;
-    size_t verticesOverlap  = 0;
-#endif
-
-    const Range& range = state.getRange();
-    FrustumCuller culler;
-    culler.setup( state.getProjectionModelViewMatrix( ));
-
-    // start with root node
-    std::vector< const mesh::VertexBufferBase* > candidates;
-    candidates.push_back( this );
+    DrawList drawList;
+    _culler.cull( state.getProjectionModelViewMatrix(), state.getRange(),
+                  state.useFrustumCulling(), state.getLODThreshold(),
+                  drawList );
 
-    while( !candidates.empty() )
+    _beginRendering( state );
+    for( DrawList::const_iterator i = drawList.begin(); i != drawList.end();
+         ++i )
     {
         if( state.stopRendering( ))
-            return;
-
-        const mesh::VertexBufferBase* treeNode = candidates.back();
-        candidates.pop_back();
-            
-        // completely out of range check
-        if( treeNode->getRange()[0] >= range[1] ||
-            treeNode->getRange()[1] < range[0] )
-        {
-            continue;
-        }
-
-        // bounding sphere view frustum culling
-        const vmml::Visibility visibility = state.useFrustumCulling() ?
-                            culler.test_sphere( treeNode->getBoundingSphere( )) :
-                            vmml::VISIBILITY_FULL;
-        switch( visibility )
-        {
-            case vmml::VISIBILITY_FULL:
-                // if fully visible and fully in range, render it
-                if( treeNode->getRange()[0] >= range[0] && 
-                    treeNode->getRange()[1] <  range[1] )
-                {
-                    treeNode->draw( state );
-                    //treeNode->drawBoundingSphere( state );
-#ifdef LOGCULL
-                    verticesRendered += treeNode->getNumberOfVertices();
-#endif
-                    break;
-                }
-                // partial range, fall through to partial visibility
-
-            case vmml::VISIBILITY_PARTIAL:
-            {
-                const mesh::VertexBufferBase* left  = treeNode->getLeft();
-                const mesh::VertexBufferBase* right = treeNode->getRight();
-            
-                if( !left && !right )
-                {
-                    if( treeNode->getRange()[0] >= range[0] )
-                    {
-                        treeNode->draw( state );
-                        //treeNode->drawBoundingSphere( state );
-#ifdef LOGCULL
-                        verticesRendered += treeNode->getNumberOfVertices();
-                        if( visibility == vmml::VISIBILITY_PARTIAL )
-                            verticesOverlap  += treeNode->getNumberOfVertices();
-#endif
-                    }
-                    // else drop, to be drawn by 'previous' channel
-                }
-                else
-                {
-                    if( left )
-                        candidates.push_back( left );
-                    if( right )
-                        candidates.push_back( right );
-                }
-                break;
-            }
-            case vmml::VISIBILITY_NONE:
-                // do nothing
-                break;
-        }
+            break;
+        (*i)->draw( state );
+        //(*i)->drawBoundingSphere( state );
     }
-    
     _endRendering( state );
 
 #ifdef LOGCULL
-    const size_t verticesTotal = model->getNumberOfVertices();
+    size_t verticesRendered = 0;
+    for( DrawList::const_iterator i = drawList.begin(); i != drawList.end();
+         ++i )
+    {
+        verticesRendered += (*i)->getNumberOfVertices();
+    }
+    const size_t verticesTotal = getNumberOfVertices();
     MESHINFO
         << getName() << " rendered " << verticesRendered * 100 / verticesTotal
-        << "% of model, overlap <= " << verticesOverlap * 100 / verticesTotal
-        << "%" << std::endl;
+        << "% of model in " << drawList.size() << " nodes" << std::endl;
 #endif    
 }
 
@@ -194,6 +203,10 @@ void VertexBufferRoot::_beginRendering( VertexBufferState& state ) const
         glEnableClientState( GL_NORMAL_ARRAY );
         if( state.useColors() )
             glEnableClientState( GL_COLOR_ARRAY );
+        // the leaves scale the quantized positions, and the normals with them
+        glPushAttrib( GL_ENABLE_BIT );
+        if( _data.isCompact( ))
+            glEnable( GL_NORMALIZE );
 #endif
     case RENDER_MODE_DISPLAY_LIST:
     case RENDER_MODE_IMMEDIATE:
@@ -222,6 +235,7 @@ void VertexBufferRoot::_endRendering( VertexBufferState& state ) const
 #define glewGetContext state.glewGetContext
         glBindBuffer( GL_ARRAY_BUFFER_ARB, 0);
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+        glPopAttrib();
         glPopClientAttrib();
     }
 #endif
@@ -284,6 +298,9 @@ bool VertexBufferRoot::_constructFromPly( const std::string& filename )
 
 bool VertexBufferRoot::_readBinary( std::string filename )
 {
+    _data.clear();
+    _unmap();
+
 #ifdef WIN32
 
     // replace dir delimiters since '\' is often used as escape char
@@ -300,6 +317,9 @@ bool VertexBufferRoot::_readBinary( std::string filename )
     MESHINFO << "Reading cached binary representation." << std::endl;
     
     // create a file mapping
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ))
+        size.QuadPart = 0;
     HANDLE map = CreateFileMapping( file, 0, PAGE_READONLY, 0, 0, 
                                     filename.c_str( ));
     CloseHandle( file );
@@ -311,33 +331,19 @@ bool VertexBufferRoot::_readBinary( std::string filename )
     }
     
     // get a view of the mapping
-    char* addr   = static_cast< char* >( MapViewOfFile( map, FILE_MAP_READ, 0, 
-                                                        0, 0 ) );
-    bool  result = false;
-
-    if( addr )
-    {
-        try
-        {
-            fromMemory( addr );
-            result = true;
-        }
-        catch( const std::exception& e )
-        {
-            MESHERROR << "Unable to read binary file, an exception occured:  "
-                      << e.what() << std::endl;
-        }
-        UnmapViewOfFile( addr );
-    }
-    else
+    char* addr = static_cast< char* >( MapViewOfFile( map, FILE_MAP_READ, 0, 
+                                                      0, 0 ) );
+    if( !addr )
     {
         MESHERROR << "Unable to read binary file, memory mapping failed."
                   << std::endl;
+        CloseHandle( map );
         return false;
     }
 
-    CloseHandle( map );
-    return result;
+    _mapAddress = addr;
+    _mapSize = size_t( size.QuadPart );
+    _mapHandle = map;
     
 #else
     // try to open binary file
@@ -350,38 +356,69 @@ bool VertexBufferRoot::_readBinary( std::string filename )
     fstat( fd, &status );
     
     // create memory mapped file
-    char* addr   = static_cast< char* >( mmap( 0, status.st_size, PROT_READ, 
-                                               MAP_SHARED, fd, 0 ) );
-    bool  result = false;
-    if( addr != MAP_FAILED )
-    {
-        try
-        {
-            fromMemory( addr );
-            result = true;
-        }
-        catch( const std::exception& e )
-        {
-            MESHERROR << "Unable to read binary file, an exception occured:  "
-                      << e.what() << std::endl;
-        }
-        munmap( addr, status.st_size );
-    }
-    else
+    char* addr = static_cast< char* >( mmap( 0, status.st_size, PROT_READ, 
+                                             MAP_SHARED, fd, 0 ) );
+    close( fd );
+    if( addr == MAP_FAILED )
     {
         MESHERROR << "Unable to read binary file, memory mapping failed."
                   << std::endl;
+        return false;
     }
-    
-    close( fd );
-    return result;
+
+    // leaves are paged in when first drawn, don't read ahead the whole model
+    madvise( addr, status.st_size, MADV_RANDOM );
+    _mapAddress = addr;
+    _mapSize = status.st_size;
+#endif
+
+    // the vertex data references the mapping until the root is destroyed
+    try
+    {
+        fromMemory( _mapAddress, _mapSize );
+        return true;
+    }
+    catch( const std::exception& e )
+    {
+        MESHERROR << "Unable to read binary file, an exception occured:  "
+                  << e.what() << std::endl;
+    }
+
+    _data.clear();
+    _unmap();
+    return false;
+}
+
+/*  Release the binary file mapping.  */
+void VertexBufferRoot::_unmap()
+{
+    MESHASSERT( !_data.isMapped( ));
+    if( !_mapAddress )
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile( _mapAddress );
+    CloseHandle( _mapHandle );
+#else
+    munmap( _mapAddress, _mapSize );
 #endif
+    _mapAddress = 0;
+    _mapSize = 0;
+    _mapHandle = 0;
+}
+
+/*  The compact layout is cached in its own file, next to the default one.  */
+std::string VertexBufferRoot::getCacheFilename( const std::string& filename )
+    const
+{
+    return getArchitectureFilename( _compact ? filename + ".compact" :
+                                               filename );
 }
 
 /*  Read binary kd-tree representation, construct from ply if unavailable.  */
 bool VertexBufferRoot::readFromFile( const std::string& filename )
 {
-    if( _readBinary( getArchitectureFilename( filename )))
+    if( _readBinary( getCacheFilename( filename )))
     {
         _name = filename;
         return true;
@@ -394,12 +431,17 @@ bool VertexBufferRoot::readFromFile( const std::string& filename )
     return false;
 }
 
-/*  Write binary representation of the kd-tree to file.  */
+/*  Write binary representation of the kd-tree to file. The file is written
+    under a temporary name and renamed into place, other processes keep their
+    mapping of the previous file intact.  */
 bool VertexBufferRoot::writeToFile( const std::string& filename )
 {
     bool result = false;
-    
-    std::ofstream output( getArchitectureFilename( filename ).c_str(), 
+    const std::string cacheFilename = getCacheFilename( filename );
+    std::ostringstream tmpFilename;
+    tmpFilename << cacheFilename << '.' << getpid() << ".tmp";
+
+    std::ofstream output( tmpFilename.str().c_str(),
                           std::ios::out | std::ios::binary );
     if( output )
     {
@@ -408,6 +450,7 @@ bool VertexBufferRoot::writeToFile( const std::string& filename )
         try
         {
             toStream( output );
+            output.close();
             result = true;
         }
         catch( const std::exception& e )
@@ -415,45 +458,106 @@ bool VertexBufferRoot::writeToFile( const std::string& filename )
             MESHERROR << "Unable to write binary file, an exception "
                       << "occured:  " << e.what() << std::endl;
         }
-        output.close();
     }
     else
     {
         MESHERROR << "Unable to create binary file." << std::endl;
     }
-    
+
+    if( result )
+    {
+#ifdef _WIN32
+        // rename does not replace existing files
+        ::remove( cacheFilename.c_str( ));
+#endif
+        if( ::rename( tmpFilename.str().c_str(), cacheFilename.c_str( )) != 0 )
+        {
+            MESHERROR << "Unable to rename binary file to " << cacheFilename
+                      << std::endl;
+            result = false;
+        }
+    }
+    if( !result )
+        ::remove( tmpFilename.str().c_str( ));
     return result;
 }
 
 
 /*  Read root node from memory and continue with other nodes.  */
-void VertexBufferRoot::fromMemory( char* start )
+void VertexBufferRoot::fromMemory( char* start, const size_t size )
 {
-    char** addr = &start;
-    size_t version;
-    memRead( reinterpret_cast< char* >( &version ), addr, sizeof( size_t ) );
-    if( version != FILE_VERSION )
+    FileHeader header;
+    if( size < sizeof( FileHeader ))
+        throw MeshException( "Error reading binary file. File is too small "
+                             "for the file header." );
+    memcpy( &header, start, sizeof( FileHeader ));
+
+    if( header.magic != FILE_MAGIC )
+        throw MeshException( "Error reading binary file. File is not an "
+                             "eqPly kd-tree." );
+    if( header.byteOrder != FILE_BYTE_ORDER )
+        throw MeshException( "Error reading binary file. File was written "
+                             "with a different byte order." );
+    if( header.version != FILE_VERSION )
         throw MeshException( "Error reading binary file. Version in file "
                              "does not match the expected version." );
-    size_t nodeType;
-    memRead( reinterpret_cast< char* >( &nodeType ), addr, sizeof( size_t ) );
+    if( header.fileSize != size || header.treeOffset > size ||
+        header.treeSize > size - header.treeOffset )
+    {
+        throw MeshException( "Error reading binary file. File size does "
+                             "not match the file header." );
+    }
+
+    // only the tree is verified, the vertex data is paged in lazily
+    char* tree = start + header.treeOffset;
+    if( _checksum( tree, size_t( header.treeSize )) != header.treeChecksum )
+        throw MeshException( "Error reading binary file. Checksum of the "
+                             "kd-tree does not match." );
+
+    char* addr = start + sizeof( FileHeader );
+    _data.fromMemory( &addr, tree );
+
+    addr = tree;
+    uint64_t nodeType;
+    memRead( reinterpret_cast< char* >( &nodeType ), &addr, sizeof( uint64_t ));
     if( nodeType != ROOT_TYPE )
         throw MeshException( "Error reading binary file. Expected the root "
                              "node, but found something else instead." );
-    _data.fromMemory( addr );
-    VertexBufferNode::fromMemory( addr, _data );
+    VertexBufferNode::fromMemory( &addr, _data );
+    _culler.setup( *this );
 }
 
 
 /*  Write root node to output stream and continue with other nodes.  */
 void VertexBufferRoot::toStream( std:: ostream& os )
 {
-    size_t version = FILE_VERSION;
-    os.write( reinterpret_cast< char* >( &version ), sizeof( size_t ) );
-    size_t nodeType = ROOT_TYPE;
-    os.write( reinterpret_cast< char* >( &nodeType ), sizeof( size_t ) );
+    FileHeader header;
+    memset( &header, 0, sizeof( FileHeader ));
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.byteOrder = FILE_BYTE_ORDER;
+
+    const std::streampos start = os.tellp();
+    os.write( reinterpret_cast< char* >( &header ), sizeof( FileHeader ));
     _data.toStream( os );
-    VertexBufferNode::toStream( os );
+    header.treeOffset = uint64_t( os.tellp() - start );
+
+    std::ostringstream tree;
+    uint64_t nodeType = ROOT_TYPE;
+    tree.write( reinterpret_cast< char* >( &nodeType ), sizeof( uint64_t ));
+    VertexBufferNode::toStream( tree );
+
+    const std::string& treeData = tree.str();
+    header.treeSize = treeData.size();
+    header.treeChecksum = _checksum( treeData.data(), treeData.size( ));
+    os.write( treeData.data(), treeData.size( ));
+
+    // rewrite header with the final layout
+    const std::streampos end = os.tellp();
+    header.fileSize = uint64_t( end - start );
+    os.seekp( start );
+    os.write( reinterpret_cast< char* >( &header ), sizeof( FileHeader ));
+    os.seekp( end );
 }
 
 }
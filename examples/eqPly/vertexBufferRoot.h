@@ -32,6 +32,7 @@
 #define MESH_VERTEXBUFFERROOT_H
 
 #include "vertexBufferNode.h"
+#include "vertexBufferCuller.h"
 #include "vertexBufferData.h"
 
 namespace mesh 
@@ -40,35 +41,54 @@ namespace mesh
     class VertexBufferRoot : public VertexBufferNode
     {
     public:
-        VertexBufferRoot() : VertexBufferNode(), _invertFaces(false) {}
+        VertexBufferRoot() : VertexBufferNode(), _invertFaces(false),
+                             _compact( false ), _mapAddress( 0 ),
+                             _mapSize( 0 ), _mapHandle( 0 ) {}
+        virtual ~VertexBufferRoot();
 
         virtual void cullDraw( VertexBufferState& state ) const;
         virtual void draw( VertexBufferState& state ) const;
         
         void setupTree( VertexData& data );
+        void setupTreeSerial( VertexData& data );
         bool writeToFile( const std::string& filename );
         bool readFromFile( const std::string& filename );
         bool hasColors() const { return _data.colors.size() > 0; }
 
         void useInvertedFaces() { _invertFaces = true; }
+        /*  Quantize the vertex data when building, cached separately.  */
+        void useCompactVertices() { _compact = true; }
+        /*  The binary cache written and read for the given model file.  */
+        std::string getCacheFilename( const std::string& filename ) const;
 
         const std::string& getName() const { return _name; }
+        const VertexBufferCuller& getCuller() const { return _culler; }
+        const VertexBufferData& getData() const { return _data; }
 
     protected:
         virtual void toStream( std::ostream& os );
-        virtual void fromMemory( char* start );
+        virtual void fromMemory( char* start, const size_t size );
         
     private:
         bool _constructFromPly( const std::string& filename );
         bool _readBinary( std::string filename );
+        void _unmap();
+        void _setupCompactVertices();
 
         void _beginRendering( VertexBufferState& state ) const;
         void _endRendering( VertexBufferState& state ) const;
 
         VertexBufferData _data;
+        VertexBufferCuller _culler;
         bool             _invertFaces;
+        bool             _compact;
         std::string      _name;
 
+        // the binary file mapping referenced by _data
+        char*            _mapAddress;
+        size_t           _mapSize;
+        void*            _mapHandle;
+
         friend class eqPly::VertexBufferDist;
     };
     
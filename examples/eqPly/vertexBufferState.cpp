@@ -33,6 +33,7 @@ namespace mesh
 {
 VertexBufferState::VertexBufferState( const GLEWContext* glewContext ) 
         : _pmvMatrix( Matrix4f::IDENTITY )
+        , _lodThreshold( 0.f )
         , _glewContext( glewContext )
         , _renderMode( RENDER_MODE_DISPLAY_LIST )
         , _useColors( false )
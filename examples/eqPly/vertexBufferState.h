@@ -67,6 +67,11 @@ namespace mesh
         void setRange( const Range& range ) { _range = range; }
         const Range& getRange() const { return _range; }
 
+        /*  The tolerated LOD error in normalized device coordinates.  */
+        void setLODThreshold( const float threshold )
+            { _lodThreshold = threshold; }
+        float getLODThreshold() const { return _lodThreshold; }
+
         void resetRegion();
         void updateRegion( const BoundingBox& box );
         virtual void declareRegion( const Vector4f& region ) {}
@@ -86,6 +91,7 @@ namespace mesh
         
         Matrix4f      _pmvMatrix; //!< projection * modelView matrix
         Range         _range; //!< normalized [0,1] part of the model to draw
+        float         _lodThreshold; //!< tolerated LOD error, 0 for none
         const GLEWContext* const _glewContext;
         RenderMode    _renderMode;
         Vector4f      _region; //!< normalized x1 y1 x2 y2 region from cullDraw 
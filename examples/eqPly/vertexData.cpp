@@ -36,8 +36,10 @@
 #if (( __GNUC__ > 4 ) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 4)) )
 #  include <parallel/algorithm>
 using __gnu_parallel::sort;
+using __gnu_parallel::nth_element;
 #else
 using std::sort;
+using std::nth_element;
 #endif
 
 
@@ -408,7 +410,11 @@ struct _TriangleSort
             axis = ( axis + 1 ) % 3;
         }
         while( axis != _axis );
-        
+
+        // break ties by the vertex indices for a reproducible order
+        for( size_t i = 0; i < 3; ++i )
+            if( t1[i] != t2[i] )
+                return t1[i] < t2[i];
         return false;
     }
     
@@ -426,3 +432,17 @@ void VertexData::sort( const Index start, const Index length, const Axis axis )
     ::sort( triangles.begin() + start, triangles.begin() + start + length,
             _TriangleSort( *this, axis ) );
 }
+
+/*  Partition the index data from start to start + length along the given
+    axis, placing the triangles smaller than the median in the first half.  */
+void VertexData::partition( const Index start, const Index length,
+                            const Axis axis )
+{
+    MESHASSERT( length > 0 );
+    MESHASSERT( start + length <= triangles.size() );
+
+    ::nth_element( triangles.begin() + start,
+                   triangles.begin() + start + length / 2,
+                   triangles.begin() + start + length,
+                   _TriangleSort( *this, axis ) );
+}
@@ -49,6 +49,8 @@ namespace mesh
 
         bool readPlyFile( const std::string& file );
         void sort( const Index start, const Index length, const Axis axis );
+        void partition( const Index start, const Index length,
+                        const Axis axis );
         void scale( const float baseSize = 2.0f );
         void calculateNormals();
         void calculateBoundingBox();
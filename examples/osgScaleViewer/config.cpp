@@ -172,19 +172,23 @@ bool Config::handleEvent( eq::EventICommand command )
 {
     const float moveSpeed = .1f;
 
-    const eq::Event& event = command.get< eq::Event >();
     switch( command.getEventType( ))
     {
         // set mMoveDirection to a null vector after a key is released
         // so that the updating of the camera position stops
         case eq::Event::KEY_RELEASE:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             if ( event.keyPress.key >= 261 &&
                  event.keyPress.key <= 266 )
                 _moveDirection = eq::Vector3f( 0, 0, 0 );
-        break;
+            break;
+        }
 
         // change mMoveDirection when the appropriate key is pressed
         case eq::Event::KEY_PRESS:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             switch ( event.keyPress.key )
             {
                 case eq::KC_LEFT:
@@ -219,9 +223,12 @@ bool Config::handleEvent( eq::EventICommand command )
                     _frameData.toggleStatistics();
             }
             break;
+        }
 
         // turn left and right, up and down with mouse pointer
         case eq::Event::CHANNEL_POINTER_MOTION:
+        {
+            const eq::Event& event = command.get< eq::Event >();
             if ( event.pointerMotion.buttons == eq::PTR_BUTTON1 &&
                  event.pointerMotion.x <= event.context.pvp.w &&
                  event.pointerMotion.x >= 0 &&
@@ -233,6 +240,7 @@ bool Config::handleEvent( eq::EventICommand command )
                 return true;
             }
             break;
+        }
     }
 
     // let Equalizer handle any events we don't handle ourselves here, like the
@@ -51,13 +51,20 @@
 #include <co/connectionDescription.h>
 #include <co/exception.h>
 #include <co/objectICommand.h>
-#include <co/queueSlave.h>
+#include <lunchbox/clock.h>
 #include <lunchbox/rng.h>
 #include <lunchbox/scopedMutex.h>
 
+#include <algorithm>
 #include <bitset>
+#include <map>
 #include <set>
 
+#include "detail/activePixels.h"
+#include "detail/compressorSelector.h"
+#include "detail/imageBands.h"
+#include "detail/statisticsBatch.h"
+#include "detail/workerPool.h"
 #include "detail/channel.ipp"
 
 namespace eq
@@ -126,6 +133,9 @@ void Channel::attach( const UUID& id, const uint32_t instanceID )
     registerCommand( fabric::CMD_CHANNEL_DELETE_TRANSFER_CONTEXT,
                      CmdFunc( this,&Channel::_cmdDeleteTransferContext ),
                      transferQ );
+    registerCommand( fabric::CMD_CHANNEL_DECOMPRESS_SAMPLE,
+                     CmdFunc( this, &Channel::_cmdDecompressSample ),
+                     commandQ );
 }
 
 co::CommandQueue* Channel::getPipeThreadQueue()
@@ -338,7 +348,10 @@ void Channel::addStatistic( Event& event )
         Statistics& statistics = _impl->statistics.data[ index ].data;
         statistics.push_back( event.statistic );
     }
-    processEvent( event );
+
+    // batched statistics are sent with the frame finish
+    if( getConfig()->getIAttribute( Config::IATTR_STATISTICS_BATCH ) != ON )
+        processEvent( event );
 }
 
 //---------------------------------------------------------------------------
@@ -496,13 +509,6 @@ const View* Channel::getView() const
     return pipe->getView( getContext().view );
 }
 
-co::QueueSlave* Channel::_getQueue( const UUID& queueID )
-{
-    LB_TS_THREAD( _pipeThread );
-    Pipe* pipe = getPipe();
-    return pipe->getQueue( queueID );
-}
-
 View* Channel::getNativeView()
 {
     LB_TS_THREAD( _pipeThread );
@@ -919,6 +925,15 @@ struct IdleData
     std::string name;
 };
 
+struct PoolData
+{
+    PoolData() : hitRate( 0.f ), nSamples( 0 ), residentSize( 0 ) {}
+    float hitRate;
+    uint32_t nSamples;
+    uint32_t residentSize; // KB
+    std::string name;
+};
+
 static bool _compare( const Statistic& stat1, const Statistic& stat2 )
 { return stat1.type < stat2.type; }
 
@@ -961,6 +976,7 @@ void Channel::drawStatistics()
 
     std::map< uint32_t, EntityData > entities;
     std::map< uint32_t, IdleData >   idles;
+    std::map< uint32_t, PoolData >   pools;
 
     for( std::vector< eq::FrameStatistics >::iterator i = statistics.begin();
          i != statistics.end(); ++i )
@@ -991,6 +1007,17 @@ void Channel::drawStatistics()
                     continue;
                   }
 
+                  case Statistic::NODE_PIXEL_POOL:
+                  {
+                    PoolData& data = pools[ id ];
+                    data.name = stat.resourceName;
+                    data.hitRate += stat.ratio;
+                    data.residentSize = LB_MAX( data.residentSize,
+                                                stat.plugins[0] );
+                    ++data.nSamples;
+                    continue;
+                  }
+
                   case Statistic::WINDOW_FPS:
                     continue;
 
@@ -1073,6 +1100,8 @@ void Channel::drawStatistics()
                 {
                   case Statistic::PIPE_IDLE:
                   case Statistic::WINDOW_FPS:
+                  case Statistic::NODE_PIXEL_POOL:
+                  case Statistic::CHANNEL_TILES:
                     continue;
 
                   case Statistic::CHANNEL_ASYNC_READBACK:
@@ -1109,6 +1138,7 @@ void Channel::drawStatistics()
                   case Statistic::CONFIG_WAIT_FINISH_FRAME:
                   case Statistic::CHANNEL_FRAME_WAIT_READY:
                   case Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN:
+                  case Statistic::CHANNEL_TILES_WAIT:
                     y1 -= SPACE;
                     y2 += SPACE;
                     break;
@@ -1241,6 +1271,20 @@ void Channel::drawStatistics()
         text << " " << data.name << ":" << data.idle / data.nIdle << "%";
     }
 
+    if( !pools.empty( ))
+        text << ", Pixel pool:";
+
+    for( std::map< uint32_t, PoolData >::const_iterator i = pools.begin();
+         i != pools.end(); ++i )
+    {
+        const PoolData& data = i->second;
+        LBASSERT( data.nSamples > 0 );
+
+        text << " " << data.name << ":"
+             << unsigned( 100.f * data.hitRate / data.nSamples ) << "% "
+             << ( data.residentSize >> 10 ) << "MB";
+    }
+
     font->draw( text.str( ));
 
     //----- Legend
@@ -1384,7 +1428,8 @@ private:
 typedef lunchbox::RefPtr< detail::RBStat > RBStatPtr;
 
 void Channel::_frameTiles( RenderContext& context, const bool isLocal,
-                           const UUID& queueID, const uint32_t tasks,
+                           const std::vector< UUID >& queueIDs,
+                           const uint32_t tasks,
                            const co::ObjectVersions& frames )
 {
     _setRenderContext( context );
@@ -1398,19 +1443,41 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
         stat = new detail::RBStat( this );
     }
 
+    // accumulate with sub-millisecond precision, tiles may be fast to render
+    lunchbox::Clock clock;
     int64_t startTime = getConfig()->getTime();
-    int64_t clearTime = 0;
-    int64_t drawTime = 0;
-    int64_t readbackTime = 0;
+    float clearTime = 0.f;
+    float drawTime = 0.f;
+    float readbackTime = 0.f;
     bool hasAsyncReadback = false;
 
-    co::QueueSlave* queue = _getQueue( queueID );
-    LBASSERT( queue );
-    for( ;; )
+    uint32_t nTiles = 0;
+
+    // The queues are processed in order: the tiles of this channel first, then
+    // the tiles of the other channels. All queues are shared with the other
+    // channels of this node, which take over tiles prefetched by this channel
+    // once they are idle.
+    Node* node = getNode();
+    const int32_t prefetch = getIAttribute( IATTR_TILE_PREFETCH );
+    std::vector< UUID >::const_iterator queueID = queueIDs.begin();
+    while( queueID != queueIDs.end( ))
     {
-        co::ObjectICommand tileCmd = queue->pop();
+        const int64_t waitStart = getConfig()->getTime();
+        co::ObjectICommand tileCmd = node->popTile( *queueID, prefetch );
+        const int64_t waitEnd = getConfig()->getTime();
+        if( waitEnd > waitStart )
+        {
+            ChannelStatistics event( Statistic::CHANNEL_TILES_WAIT, this );
+            event.event.statistic.startTime = waitStart;
+            event.event.statistic.endTime = waitEnd;
+        }
+
         if( !tileCmd.isValid( ))
-            break;
+        {
+            ++queueID;
+            continue;
+        }
+        ++nTiles;
 
         const Tile& tile = tileCmd.get< Tile >();
         context.apply( tile );
@@ -1425,21 +1492,21 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
 
         if( tasks & fabric::TASK_CLEAR )
         {
-            const int64_t time = getConfig()->getTime();
+            const float time = clock.getTimef();
             frameClear( context.frameID );
-            clearTime += getConfig()->getTime() - time;
+            clearTime += clock.getTimef() - time;
         }
 
         if( tasks & fabric::TASK_DRAW )
         {
-            const int64_t time = getConfig()->getTime();
+            const float time = clock.getTimef();
             frameDraw( context.frameID );
-            drawTime += getConfig()->getTime() - time;
+            drawTime += clock.getTimef() - time;
         }
 
         if( tasks & fabric::TASK_READBACK )
         {
-            const int64_t time = getConfig()->getTime();
+            const float time = clock.getTimef();
             const Frames& outFrames = getOutputFrames();
             const size_t nFrames = outFrames.size();
 
@@ -1452,7 +1519,7 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
             }
 
             frameReadback( context.frameID );
-            readbackTime += getConfig()->getTime() - time;
+            readbackTime += clock.getTimef() - time;
 
             for( size_t i = 0; i < nFrames; ++i )
             {
@@ -1472,11 +1539,20 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
         }
     }
 
+    const int64_t endTime = getConfig()->getTime();
+    if( nTiles > 0 )
+    {
+        ChannelStatistics event( Statistic::CHANNEL_TILES, this );
+        event.event.statistic.startTime = startTime;
+        event.event.statistic.endTime = LB_MAX( endTime, startTime + 1 );
+        event.event.statistic.ratio = float( nTiles );
+    }
+
     if( tasks & fabric::TASK_CLEAR )
     {
         ChannelStatistics event( Statistic::CHANNEL_CLEAR, this );
         event.event.statistic.startTime = startTime;
-        startTime += clearTime;
+        startTime += int64_t( clearTime + .5f );
         event.event.statistic.endTime = startTime;
     }
 
@@ -1484,14 +1560,14 @@ void Channel::_frameTiles( RenderContext& context, const bool isLocal,
     {
         ChannelStatistics event( Statistic::CHANNEL_DRAW, this );
         event.event.statistic.startTime = startTime;
-        startTime += drawTime;
+        startTime += int64_t( drawTime + .5f );
         event.event.statistic.endTime = startTime;
     }
 
     if( tasks & fabric::TASK_READBACK )
     {
         stat->event.event.statistic.startTime = startTime;
-        startTime += readbackTime;
+        startTime += int64_t( readbackTime + .5f );
         stat->event.event.statistic.endTime = startTime;
 
         _setReady( hasAsyncReadback, stat.get( ));
@@ -1520,6 +1596,14 @@ void Channel::_unrefFrame( const uint32_t frameNumber )
     send( getServer(), fabric::CMD_CHANNEL_FRAME_FINISH_REPLY )
             << stats.region << frameNumber << stats.data;
 
+    if( !stats.data.empty() &&
+        getConfig()->getIAttribute( Config::IATTR_STATISTICS_BATCH ) == ON )
+    {
+        EventOCommand event( getConfig()->sendEvent( Event::STATISTICS ));
+        event << getSerial();
+        detail::StatisticsBatch::write( event, stats.data );
+    }
+
     stats.data.clear();
     stats.region = Viewport::FULL;
 
@@ -1647,182 +1731,256 @@ void Channel::_asyncTransmit( FrameDataPtr frame, const uint32_t frameNumber,
                               const uint32_t taskID )
 {
     LBASSERT( nodes.size() == netNodes.size( ));
-    std::vector< uint128_t >::const_iterator j = netNodes.begin();
-    for( std::vector< uint128_t >::const_iterator i = nodes.begin();
-         i != nodes.end(); ++i, ++j )
-    {
-        _refFrame( frameNumber );
-
-        LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Start transmit frame data " << frame
-                                        << " receiver " << *i << " on " << *j
-                                        << std::endl;
-        send( getLocalNode(), fabric::CMD_CHANNEL_FRAME_TRANSMIT_IMAGE )
-                << co::ObjectVersion( frame ) << *i << *j << image
-                << frameNumber << taskID;
-    }
+    if( nodes.empty( ))
+        return;
+
+    _refFrame( frameNumber );
+
+    LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Start transmit frame data " << frame
+                                    << " to " << nodes.size() << " receivers"
+                                    << std::endl;
+    send( getLocalNode(), fabric::CMD_CHANNEL_FRAME_TRANSMIT_IMAGE )
+            << co::ObjectVersion( frame ) << nodes << netNodes << image
+            << frameNumber << taskID;
 }
 
-void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
-                              const uint128_t& nodeID,
-                              const uint128_t& netNodeID,
-                              const uint64_t imageIndex,
-                              const uint32_t frameNumber,
-                              const uint32_t taskID )
+namespace
 {
-    LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit" << std::endl;
-    FrameDataPtr frameData = getNode()->getFrameData( frameDataVersion );
-    LBASSERT( frameData );
+static const Frame::Buffer _buffers[] = { Frame::BUFFER_COLOR,
+                                          Frame::BUFFER_DEPTH };
 
-    if( frameData->getBuffers() == 0 )
-    {
-        LBWARN << "No buffers for frame data" << std::endl;
-        return;
-    }
+/** One receiver of a transmitted image. */
+struct TransmitReceiver
+{
+    TransmitReceiver() : hasToken( false ) {}
 
-    ChannelStatistics transmitEvent( Statistic::CHANNEL_FRAME_TRANSMIT, this,
-                                     frameNumber );
-    transmitEvent.event.statistic.task = taskID;
+    uint128_t nodeID;
+    uint128_t netNodeID;
+    co::NodePtr toNode;
+    co::ConnectionPtr connection;
+    co::LocalNode::SendToken token;
+    bool hasToken;
+};
+typedef std::vector< TransmitReceiver > TransmitReceivers;
 
-    const Images& images = frameData->getImages();
-    Image* image = images[ imageIndex ];
-    LBASSERT( images.size() > imageIndex );
+bool _compareNetNodes( const TransmitReceiver& a, const TransmitReceiver& b )
+{
+    return a.netNodeID < b.netNodeID;
+}
 
-    if( image->getStorageType() == Frame::TYPE_TEXTURE )
+/** The receivers and the compression settings of the bands of one image. */
+struct TransmitContext
+{
+    TransmitContext() : channel( 0 ), selector( 0 ), frameNumber( 0 )
+                      , taskID( 0 )
     {
-        LBWARN << "Can't transmit image of type TEXTURE" << std::endl;
-        LBUNIMPLEMENTED;
-        return;
+        compressors[0] = compressors[1] = EQ_COMPRESSOR_NONE;
+        adaptive[0] = adaptive[1] = false;
     }
 
-    co::LocalNodePtr localNode = getLocalNode();
-    co::NodePtr toNode = localNode->connect( netNodeID );
-    if( !toNode || !toNode->isReachable( ))
-    {
-        LBWARN << "Can't connect node " << netNodeID
-               << " to send image data" << std::endl;
-        return;
-    }
+    Channel* channel;
+    detail::CompressorSelector* selector;
+    co::ObjectVersion frameDataVersion;
+    uint128_t netNodeID; //!< link the compressors are selected for
+    uint32_t frameNumber;
+    uint32_t taskID;
+    uint32_t compressors[2]; //!< per buffer
+    bool adaptive[2]; //!< compressor chosen by the selector
+    FrameData::ImageBand band; //!< the image the bands are assembled into
+    TransmitReceivers receivers;
+};
 
-    co::ConnectionPtr connection = toNode->getConnection();
-    co::ConstConnectionDescriptionPtr description =connection->getDescription();
+/** The compressed or packed data of one image or band for all receivers. */
+struct TransmitData
+{
+    TransmitData() : image( 0 ), buffers( Frame::BUFFER_NONE ), size( 0 ) {}
 
-    // use compression on links up to 2 GBit/s
-    const bool useCompression = ( description->bandwidth <= 262144 );
+    void clear()
+    {
+        image = 0;
+        pixelDatas.clear();
+        packedDatas.clear();
+        compressed.clear();
+        qualities.clear();
+        buffers = Frame::BUFFER_NONE;
+        size = 0;
+    }
 
+    const Image* image;
+    lunchbox::Bufferb packedPixels[2];
     std::vector< const PixelData* > pixelDatas;
+    std::vector< const lunchbox::Bufferb* > packedDatas;
+    std::vector< bool > compressed;
     std::vector< float > qualities;
+    uint32_t buffers;
+    uint64_t size;
+};
 
-    uint32_t commandBuffers = Frame::BUFFER_NONE;
-    uint64_t imageDataSize = 0;
-
-
+/** Compress, or pack the active pixels of, one image or band. */
+void _compressImage( Image* image, const TransmitContext& context,
+                     TransmitData& data )
+{
+    data.clear();
+    data.image = image;
+
+    bool useCompression = false;
+    for( unsigned j = 0; j < 2; ++j )
+        useCompression |= ( context.compressors[j] != EQ_COMPRESSOR_NONE );
+
+    // send only the active pixels of sparse, uncompressed sort-last images
+    const detail::ActivePixels& activePixels = image->getActivePixels();
+    uint64_t rawSize( 0 );
+    lunchbox::Clock clock;
+    ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS,
+                                     context.channel, context.frameNumber,
+                                     useCompression ? AUTO : OFF );
+    compressEvent.event.statistic.task = context.taskID;
+    compressEvent.event.statistic.ratio = 1.0f;
+    compressEvent.event.statistic.plugins[0] = EQ_COMPRESSOR_NONE;
+    compressEvent.event.statistic.plugins[1] = EQ_COMPRESSOR_NONE;
+
+    // for each image attachment
+    for( unsigned j = 0; j < 2; ++j )
     {
-        uint64_t rawSize( 0 );
-        ChannelStatistics compressEvent( Statistic::CHANNEL_FRAME_COMPRESS,
-                                         this, frameNumber,
-                                         useCompression ? AUTO : OFF );
-        compressEvent.event.statistic.task = taskID;
-        compressEvent.event.statistic.ratio = 1.0f;
-        compressEvent.event.statistic.plugins[0] = EQ_COMPRESSOR_NONE;
-        compressEvent.event.statistic.plugins[1] = EQ_COMPRESSOR_NONE;
-
-        // Prepare image pixel data
-        Frame::Buffer buffers[] = {Frame::BUFFER_COLOR,Frame::BUFFER_DEPTH};
-
-        // for each image attachment
-        for( unsigned j = 0; j < 2; ++j )
+        Frame::Buffer buffer = _buffers[j];
+        if( !image->hasPixelData( buffer ))
+            continue;
+
+        // format, type, nChunks, compressor name
+        data.size += sizeof( FrameData::ImageHeader );
+        const uint64_t bufferSize = image->getPixelDataSize( buffer );
+        const uint64_t headerSize = data.size;
+
+        // compressed data of a previous transmission is reused as is
+        const PixelData* pixels = &image->getPixelData( buffer );
+        const bool sample = !pixels->isCompressed;
+        uint32_t name = context.compressors[j];
+        clock.reset();
+        if( name != EQ_COMPRESSOR_NONE && !pixels->isCompressed )
         {
-            Frame::Buffer buffer = buffers[j];
-            if( image->hasPixelData( buffer ))
+            image->useCompressor( buffer, name );
+            pixels = &image->compressPixelData( buffer );
+            name = pixels->compressorName;
+        }
+        const bool isCompressed = name != EQ_COMPRESSOR_NONE &&
+                                  pixels->isCompressed;
+        data.pixelDatas.push_back( pixels );
+        data.packedDatas.push_back( 0 );
+        data.compressed.push_back( isCompressed );
+        data.qualities.push_back( image->getQuality( buffer ));
+
+        if( !isCompressed && activePixels.isSparse() &&
+            pixels->pvp.w == int32_t( activePixels.getWidth( )) &&
+            pixels->pvp.h == int32_t( activePixels.getHeight( )))
+        {
+            lunchbox::Bufferb& packed = data.packedPixels[j];
+            packed.resize( activePixels.getNPixels() * pixels->pixelSize );
+            activePixels.pack(
+                reinterpret_cast< const uint8_t* >( pixels->pixels ),
+                pixels->pixelSize, packed.getData( ));
+            data.packedDatas.back() = &packed;
+
+            data.size += 2 * sizeof( uint64_t );
+            data.size += activePixels.getDataSize();
+            data.size += packed.getSize();
+        }
+        else if( isCompressed )
+        {
+            const uint32_t nElements =
+                uint32_t( pixels->compressedSize.size( ));
+            for( uint32_t k = 0 ; k < nElements; ++k )
             {
-                // format, type, nChunks, compressor name
-                imageDataSize += sizeof( FrameData::ImageHeader );
-
-                const PixelData& data = useCompression ?
-                    image->compressPixelData( buffer ) :
-                    image->getPixelData( buffer );
-                pixelDatas.push_back( &data );
-                qualities.push_back( image->getQuality( buffer ));
-
-                if( data.isCompressed )
-                {
-                    const uint32_t nElements =
-                        uint32_t( data.compressedSize.size( ));
-                    for( uint32_t k = 0 ; k < nElements; ++k )
-                    {
-                        imageDataSize += sizeof( uint64_t );
-                        imageDataSize += data.compressedSize[ k ];
-                    }
-                    compressEvent.event.statistic.plugins[j] =
-                        data.compressorName;
-                }
-                else
-                {
-                    imageDataSize += sizeof( uint64_t );
-                    imageDataSize += image->getPixelDataSize( buffer );
-                }
-
-                commandBuffers |= buffer;
-                rawSize += image->getPixelDataSize( buffer );
+                data.size += sizeof( uint64_t );
+                data.size += pixels->compressedSize[ k ];
             }
+            compressEvent.event.statistic.plugins[j] = pixels->compressorName;
+        }
+        else
+        {
+            data.size += sizeof( uint64_t );
+            data.size += bufferSize;
         }
 
-        if( rawSize > 0 )
-            compressEvent.event.statistic.ratio =
-            static_cast< float >( imageDataSize ) /
-            static_cast< float >( rawSize );
+        if( sample && context.adaptive[j] )
+        {
+            context.selector->addCompressSample( context.netNodeID, buffer,
+                                   isCompressed ? name : EQ_COMPRESSOR_NONE,
+                                   bufferSize, data.size - headerSize,
+                                   clock.getTimef(), context.frameNumber );
+        }
+
+        data.buffers |= buffer;
+        rawSize += bufferSize;
     }
 
-    if( pixelDatas.empty( ))
-        return;
+    if( rawSize > 0 )
+        compressEvent.event.statistic.ratio =
+            static_cast< float >( data.size ) / static_cast< float >( rawSize );
+}
 
-    // send image pixel data command
-    co::LocalNode::SendToken token;
-    if( getIAttribute( IATTR_HINT_SENDTOKEN ) == ON )
-    {
-        ChannelStatistics waitEvent( Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
-                                     this, frameNumber );
-        waitEvent.event.statistic.task = taskID;
-        token = getLocalNode()->acquireSendToken( toNode );
-    }
+/** Send the data of one image or band to one receiver. */
+void _sendImage( const TransmitData& data, const TransmitContext& context,
+                 const TransmitReceiver& receiver )
+{
+    const Image* image = data.image;
     LBASSERT( image->getPixelViewport().isValid( ));
 
+    co::ConnectionPtr connection = receiver.connection;
     co::ObjectOCommand command( co::Connections( 1, connection ),
                                 fabric::CMD_NODE_FRAMEDATA_TRANSMIT,
-                                co::COMMANDTYPE_OBJECT, nodeID,
+                                co::COMMANDTYPE_OBJECT, receiver.nodeID,
                                 EQ_INSTANCE_ALL );
-    command << frameDataVersion << image->getPixelViewport() << image->getZoom()
-            << commandBuffers << frameNumber << image->getAlphaUsage();
-    command.sendHeader( imageDataSize );
+    command << context.frameDataVersion << image->getPixelViewport()
+            << image->getZoom() << data.buffers << context.frameNumber
+            << image->getAlphaUsage() << context.band
+            << context.channel->getID();
+    command.sendHeader( data.size );
 
 #ifndef NDEBUG
     size_t sentBytes = 0;
 #endif
 
-    for( uint32_t j=0; j < pixelDatas.size(); ++j )
+    const detail::ActivePixels& activePixels = image->getActivePixels();
+    for( uint32_t j=0; j < data.pixelDatas.size(); ++j )
     {
 #ifndef NDEBUG
         sentBytes += sizeof( FrameData::ImageHeader );
 #endif
-        const PixelData* data = pixelDatas[j];
+        const PixelData* pixels = data.pixelDatas[j];
+        const lunchbox::Bufferb* packed = data.packedDatas[j];
+        const bool compressed = data.compressed[j];
         const FrameData::ImageHeader header =
-              { data->internalFormat, data->externalFormat,
-                data->pixelSize, data->pvp,
-                useCompression ? data->compressorName : EQ_COMPRESSOR_NONE,
-                data->compressorFlags,
-                data->isCompressed ? uint32_t( data->compressedSize.size()) : 1,
-                qualities[ j ] };
+              { pixels->internalFormat, pixels->externalFormat,
+                pixels->pixelSize, pixels->pvp,
+                compressed ? pixels->compressorName : EQ_COMPRESSOR_NONE,
+                pixels->compressorFlags,
+                compressed ? uint32_t( pixels->compressedSize.size( )) :
+                             packed ? 2 : 1,
+                data.qualities[ j ] };
 
         connection->send( &header, sizeof( header ), true );
 
-        if( data->isCompressed )
+        if( packed ) // active pixel spans, packed active pixels
+        {
+            const uint64_t spansSize = activePixels.getDataSize();
+            const uint64_t dataSize = packed->getSize();
+            connection->send( &spansSize, sizeof( spansSize ), true );
+            connection->send( activePixels.getData(), spansSize, true );
+            connection->send( &dataSize, sizeof( dataSize ), true );
+            if( dataSize > 0 )
+                connection->send( packed->getData(), dataSize, true );
+#ifndef NDEBUG
+            sentBytes += 2 * sizeof( uint64_t ) + spansSize + dataSize;
+#endif
+        }
+        else if( compressed )
         {
-            for( uint32_t k = 0 ; k < data->compressedSize.size(); ++k )
+            for( uint32_t k = 0 ; k < pixels->compressedSize.size(); ++k )
             {
-                const uint64_t dataSize = data->compressedSize[k];
+                const uint64_t dataSize = pixels->compressedSize[k];
                 connection->send( &dataSize, sizeof( dataSize ), true );
                 if( dataSize > 0 )
-                    connection->send( data->compressedData[k],
+                    connection->send( pixels->compressedData[k],
                                       dataSize, true );
 #ifndef NDEBUG
                 sentBytes += sizeof( dataSize ) + dataSize;
@@ -1831,21 +1989,232 @@ void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
         }
         else
         {
-            const uint64_t dataSize = data->pvp.getArea() *
-                data->pixelSize;
+            const uint64_t dataSize = pixels->pvp.getArea() *
+                                      pixels->pixelSize;
             connection->send( &dataSize, sizeof( dataSize ), true );
-            connection->send( data->pixels, dataSize, true );
+            connection->send( pixels->pixels, dataSize, true );
 #ifndef NDEBUG
             sentBytes += sizeof( dataSize ) + dataSize;
 #endif
         }
     }
 #ifndef NDEBUG
-    LBASSERTINFO( sentBytes == imageDataSize,
-        sentBytes << " != " << imageDataSize );
+    LBASSERTINFO( sentBytes == data.size, sentBytes << " != " << data.size );
 #endif
+}
+
+/** Send the data of one image or band to all receivers. */
+void _sendImage( const TransmitData& data, const TransmitContext& context )
+{
+    if( data.pixelDatas.empty( ))
+        return;
+
+    for( TransmitReceivers::const_iterator i = context.receivers.begin();
+         i != context.receivers.end(); ++i )
+    {
+        _sendImage( data, context, *i );
+    }
+}
+
+/**
+ * Acquire the send tokens of all receivers, held for all bands. The tokens are
+ * acquired in node order, so that concurrent senders do not deadlock.
+ */
+void _acquireSendTokens( TransmitContext& context )
+{
+    Channel* channel = context.channel;
+    if( channel->getIAttribute( Channel::IATTR_HINT_SENDTOKEN ) != ON )
+        return;
+
+    ChannelStatistics waitEvent( Statistic::CHANNEL_FRAME_WAIT_SENDTOKEN,
+                                 channel, context.frameNumber );
+    waitEvent.event.statistic.task = context.taskID;
+
+    co::LocalNodePtr localNode = channel->getLocalNode();
+    TransmitReceivers& receivers = context.receivers;
+    std::sort( receivers.begin(), receivers.end(), _compareNetNodes );
+    for( size_t i = 0; i < receivers.size(); ++i )
+    {
+        TransmitReceiver& receiver = receivers[i];
+        if( i > 0 && receivers[ i - 1 ].netNodeID == receiver.netNodeID )
+            continue; // one token per node
+        receiver.token = localNode->acquireSendToken( receiver.toNode );
+        receiver.hasToken = true;
+    }
+}
+
+void _releaseSendTokens( TransmitContext& context )
+{
+    co::LocalNodePtr localNode = context.channel->getLocalNode();
+    for( TransmitReceivers::iterator i = context.receivers.begin();
+         i != context.receivers.end(); ++i )
+    {
+        if( i->hasToken )
+            localNode->releaseSendToken( i->token );
+    }
+}
+
+/** Compresses the next band while the current band is sent. */
+class TransmitTask : public detail::WorkerPool::Task
+{
+public:
+    TransmitTask( const TransmitContext& context, Image& next,
+                  TransmitData& nextData, const TransmitData& current )
+        : _context( context ), _next( next ), _nextData( nextData )
+        , _current( current )
+    {}
+
+    virtual void execute( const size_t index )
+    {
+        if( index == 0 )
+            _compressImage( &_next, _context, _nextData );
+        else
+            _sendImage( _current, _context );
+    }
+
+private:
+    const TransmitContext& _context;
+    Image& _next;
+    TransmitData& _nextData;
+    const TransmitData& _current;
+};
+}
+
+void Channel::_transmitImage( const co::ObjectVersion& frameDataVersion,
+                              const std::vector< uint128_t >& nodes,
+                              const std::vector< uint128_t >& netNodes,
+                              const uint64_t imageIndex,
+                              const uint32_t frameNumber,
+                              const uint32_t taskID )
+{
+    LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit" << std::endl;
+    FrameDataPtr frameData = getNode()->getFrameData( frameDataVersion );
+    LBASSERT( frameData );
+
+    if( frameData->getBuffers() == 0 )
+    {
+        LBWARN << "No buffers for frame data" << std::endl;
+        return;
+    }
+
+    ChannelStatistics transmitEvent( Statistic::CHANNEL_FRAME_TRANSMIT, this,
+                                     frameNumber );
+    transmitEvent.event.statistic.task = taskID;
+
+    const Images& images = frameData->getImages();
+    Image* image = images[ imageIndex ];
+    LBASSERT( images.size() > imageIndex );
+
+    if( image->getStorageType() == Frame::TYPE_TEXTURE )
+    {
+        LBWARN << "Can't transmit image of type TEXTURE" << std::endl;
+        LBUNIMPLEMENTED;
+        return;
+    }
+
+    TransmitContext context;
+    context.channel = this;
+    context.selector = &_impl->compressorSelector;
+    context.frameDataVersion = frameDataVersion;
+    context.frameNumber = frameNumber;
+    context.taskID = taskID;
+
+    LBASSERT( nodes.size() == netNodes.size( ));
+    co::LocalNodePtr localNode = getLocalNode();
+    for( size_t i = 0; i < nodes.size() && i < netNodes.size(); ++i )
+    {
+        TransmitReceiver receiver;
+        receiver.toNode = localNode->connect( netNodes[i] );
+        if( !receiver.toNode || !receiver.toNode->isReachable( ))
+        {
+            LBWARN << "Can't connect node " << netNodes[i]
+                   << " to send image data" << std::endl;
+            continue;
+        }
+        receiver.nodeID = nodes[i];
+        receiver.netNodeID = netNodes[i];
+        receiver.connection = receiver.toNode->getConnection();
+        context.receivers.push_back( receiver );
+    }
+    if( context.receivers.empty( ))
+        return;
+
+    // The image is compressed once for all receivers. Select the compressors
+    // with the lowest estimated latency on the slowest receiver link, which
+    // bounds the time until all receivers have the image.
+    TransmitReceivers::const_iterator slowest = context.receivers.begin();
+    co::ConstConnectionDescriptionPtr description =
+        slowest->connection->getDescription();
+    for( TransmitReceivers::const_iterator i = slowest + 1;
+         i != context.receivers.end(); ++i )
+    {
+        co::ConstConnectionDescriptionPtr candidate =
+            i->connection->getDescription();
+        if( candidate->bandwidth < description->bandwidth )
+        {
+            slowest = i;
+            description = candidate;
+        }
+    }
+    context.netNodeID = slowest->netNodeID;
+    for( unsigned j = 0; j < 2; ++j )
+    {
+        const Frame::Buffer buffer = _buffers[j];
+        if( !image->hasPixelData( buffer ))
+            continue;
+
+        const uint32_t name = frameData->getCompressor( buffer );
+        context.adaptive[j] = ( name == EQ_COMPRESSOR_AUTO );
+        context.compressors[j] = context.adaptive[j] ?
+            _impl->compressorSelector.choose( context.netNodeID, *image,
+                                              buffer, frameNumber,
+                                              description->bandwidth ) : name;
+    }
 
-    getLocalNode()->releaseSendToken( token );
+    // Large, compressed images are sent in bands. The next band is compressed
+    // while the current one is sent, and the receivers decompress each band on
+    // arrival and assemble the bands into one image. Uncompressed and zoomed
+    // images are sent whole, see bands::getNBands().
+    const uint32_t nBands = detail::bands::getNBands( *image,
+                                                      context.compressors );
+    context.band.index = imageIndex;
+    context.band.pvp = image->getPixelViewport();
+    context.band.nBands = nBands;
+    if( nBands <= 1 )
+    {
+        TransmitData data;
+        _compressImage( image, context, data );
+        _acquireSendTokens( context );
+        _sendImage( data, context );
+    }
+    else
+    {
+        const int32_t height = image->getPixelViewport().h;
+        const int32_t rows = ( height + nBands - 1 ) / nBands;
+        Image* bands = _impl->transmitBands;
+        TransmitData datas[2];
+        unsigned current = 0;
+
+        detail::bands::setBand( *image, bands[ current ], 0,
+                                LB_MIN( rows, height ));
+        _compressImage( &bands[ current ], context, datas[ current ] );
+        _acquireSendTokens( context );
+
+        for( int32_t y = rows; y < height; y += rows )
+        {
+            const unsigned next = 1 - current;
+            detail::bands::setBand( *image, bands[ next ], y,
+                                    LB_MIN( rows, height - y ));
+
+            TransmitTask task( context, bands[ next ], datas[ next ],
+                               datas[ current ] );
+            detail::WorkerPool::getShared().execute( task, 2 );
+            current = next;
+        }
+        _sendImage( datas[ current ], context );
+    }
+
+    _releaseSendTokens( context );
 }
 
 void Channel::_setReady( const bool async, detail::RBStat* stat )
@@ -1943,6 +2312,7 @@ bool Channel::_cmdConfigInit( co::ICommand& cmd )
 
     LBLOG( LOG_INIT ) << "TASK channel config init " << command << std::endl;
 
+    _impl->renderContexts.clear(); // see server::Channel::configInit
     const Config* config = getConfig();
     changeLatency( config->getLatency( ));
 
@@ -1998,7 +2368,7 @@ bool Channel::_cmdFrameStart( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
 
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
     const uint128_t version = command.get< uint128_t >();
     const uint32_t frameNumber = command.get< uint32_t >();
 
@@ -2027,7 +2397,7 @@ bool Channel::_cmdFrameFinish( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
 
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
     const uint32_t frameNumber = command.get< uint32_t >();
 
     LBLOG( LOG_TASKS ) << "TASK frame finish " << getName() <<  " " << command
@@ -2046,7 +2416,7 @@ bool Channel::_cmdFrameClear( co::ICommand& cmd )
     LBASSERT( _impl->state == STATE_RUNNING );
 
     co::ObjectICommand command( cmd );
-    RenderContext context  = command.get< RenderContext >();
+    RenderContext context  = _impl->getRenderContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK clear " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -2062,7 +2432,7 @@ bool Channel::_cmdFrameClear( co::ICommand& cmd )
 bool Channel::_cmdFrameDraw( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context  = command.get< RenderContext >();
+    RenderContext context  = _impl->getRenderContext( command );
     const bool finish = command.get< bool >();
 
     LBLOG( LOG_TASKS ) << "TASK draw " << getName() <<  " " << command
@@ -2104,7 +2474,7 @@ bool Channel::_cmdFrameDrawFinish( co::ICommand& cmd )
 bool Channel::_cmdFrameAssemble( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
     const co::ObjectVersions frames = command.get< co::ObjectVersions >();
 
     LBLOG( LOG_TASKS | LOG_ASSEMBLY )
@@ -2132,7 +2502,7 @@ bool Channel::_cmdFrameAssemble( co::ICommand& cmd )
 bool Channel::_cmdFrameReadback( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
     const co::ObjectVersions frames = command.get< co::ObjectVersions >();
 
     LBLOG( LOG_TASKS | LOG_ASSEMBLY ) << "TASK readback " << getName() <<  " "
@@ -2193,17 +2563,19 @@ bool Channel::_cmdFrameTransmitImage( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
     const co::ObjectVersion frameData = command.get< co::ObjectVersion >();
-    const uint128_t nodeID = command.get< uint128_t >();
-    const uint128_t netNodeID = command.get< uint128_t >();
+    const std::vector< uint128_t > nodes =
+                                      command.get< std::vector< uint128_t > >();
+    const std::vector< uint128_t > netNodes =
+                                      command.get< std::vector< uint128_t > >();
     const uint64_t imageIndex = command.get< uint64_t >();
     const uint32_t frameNumber = command.get< uint32_t >();
     const uint32_t taskID = command.get< uint32_t >();
 
     LBLOG( LOG_TASKS|LOG_ASSEMBLY ) << "Transmit " << command << " frame data "
-                                    << frameData << " receiver " << nodeID
-                                    << " on " << netNodeID << std::endl;
+                                    << frameData << " to " << nodes.size()
+                                    << " receivers" << std::endl;
 
-    _transmitImage( frameData, nodeID, netNodeID, imageIndex, frameNumber,
+    _transmitImage( frameData, nodes, netNodes, imageIndex, frameNumber,
                     taskID );
     _unrefFrame( frameNumber );
     return true;
@@ -2241,7 +2613,7 @@ bool Channel::_cmdFrameSetReadyNode( co::ICommand& cmd )
 bool Channel::_cmdFrameViewStart( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK view start " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -2256,7 +2628,7 @@ bool Channel::_cmdFrameViewStart( co::ICommand& cmd )
 bool Channel::_cmdFrameViewFinish( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
 
     LBLOG( LOG_TASKS ) << "TASK view finish " << getName() <<  " " << command
                        << " " << context << std::endl;
@@ -2280,19 +2652,33 @@ bool Channel::_cmdStopFrame( co::ICommand& cmd )
     return true;
 }
 
+bool Channel::_cmdDecompressSample( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+    const uint128_t node = command.get< uint128_t >();
+    const Frame::Buffer buffer = Frame::Buffer( command.get< uint32_t >( ));
+    const uint32_t name = command.get< uint32_t >();
+    const uint64_t rawSize = command.get< uint64_t >();
+    const float time = command.get< float >();
+
+    _impl->compressorSelector.addDecompressSample( node, buffer, name, rawSize,
+                                                   time );
+    return true;
+}
+
 bool Channel::_cmdFrameTiles( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
-    RenderContext context = command.get< RenderContext >();
+    RenderContext context = _impl->getRenderContext( command );
     const bool isLocal = command.get< bool >();
-    const UUID& queueID = command.get< UUID >();
+    const std::vector< UUID > queueIDs = command.get< std::vector< UUID > >();
     const uint32_t tasks = command.get< uint32_t >();
     const co::ObjectVersions frames = command.get< co::ObjectVersions >();
 
     LBLOG( LOG_TASKS ) << "TASK channel frame tiles " << getName() <<  " "
                        << command << " " << context << std::endl;
 
-    _frameTiles( context, isLocal, queueID, tasks, frames );
+    _frameTiles( context, isLocal, queueIDs, tasks, frames );
     return true;
 }
 
@@ -340,6 +340,11 @@ namespace detail { class Channel; struct RBStat; }
          * transform the event into an config event to be send to the
          * application using Config::sendEvent().
          *
+         * If the config attribute IATTR_STATISTICS_BATCH is ON, the
+         * statistics of the channel are not passed to this method as
+         * Event::STATISTIC. They are sent to the application batched per
+         * frame as Event::STATISTICS.
+         *
          * @param event the received event.
          * @return true when the event was handled, false if not.
          * @version 1.0
@@ -575,7 +580,8 @@ namespace detail { class Channel; struct RBStat; }
 
         /** Tile render loop. */
         void _frameTiles( RenderContext& context, const bool isLocal,
-                          const UUID& queueID, const uint32_t tasks,
+                          const std::vector< UUID >& queueIDs,
+                          const uint32_t tasks,
                           const co::ObjectVersions& frames );
 
         /** Reference the frame for an async operation. */
@@ -584,10 +590,10 @@ namespace detail { class Channel; struct RBStat; }
         /** Check for and send frame finish reply. */
         void _unrefFrame( const uint32_t frameNumber );
 
-        /** Transmit one image of a frame to one node. */
+        /** Transmit one image of a frame to all receiving nodes. */
         void _transmitImage( const co::ObjectVersion& frameDataVersion,
-                             const uint128_t& nodeID,
-                             const uint128_t& netNodeID,
+                             const std::vector< uint128_t >& nodes,
+                             const std::vector< uint128_t >& netNodes,
                              const uint64_t imageIndex,
                              const uint32_t frameNumber,
                              const uint32_t taskID );
@@ -618,9 +624,6 @@ namespace detail { class Channel; struct RBStat; }
                         const std::vector< uint128_t >& nodes,
                         const std::vector< uint128_t >& netNodes );
 
-        /** Get the channel's current input queue. */
-        co::QueueSlave* _getQueue( const UUID& queueID );
-
         void _setOutputFrames( const co::ObjectVersions& frames );
         void _resetOutputFrames();
 
@@ -645,6 +648,7 @@ namespace detail { class Channel; struct RBStat; }
         bool _cmdStopFrame( co::ICommand& command );
         bool _cmdFrameTiles( co::ICommand& command );
         bool _cmdDeleteTransferContext( co::ICommand& command );
+        bool _cmdDecompressSample( co::ICommand& command );
 
         LB_TS_VAR( _pipeThread );
     };
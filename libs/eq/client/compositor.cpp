@@ -34,6 +34,9 @@
 #include "server.h"
 #include "window.h"
 #include "windowSystem.h"
+#include "detail/activePixels.h"
+#include "detail/compositorKernels.h"
+#include "detail/compositorTiles.h"
 
 #include <eq/util/accum.h>
 #include <eq/util/frameBufferObject.h>
@@ -71,8 +74,15 @@ static const char* depthDBKey  = shaderDBKey + 2;
 // Image used for CPU-based assembly
 static lunchbox::PerThread< Image > _resultImage;
 
-static bool _useCPUAssembly( const Frames& frames, Channel* channel,
-                             const bool blendAlpha = false )
+// Staging buffers covering the channel for streaming CPU assembly
+struct StreamingBuffers
+{
+    lunchbox::Bufferb color;
+    lunchbox::Bufferb depth;
+};
+static lunchbox::PerThread< StreamingBuffers > _streamingBuffers;
+
+static bool _hasCPUAssemblyFrames( const Frames& frames, const bool blendAlpha )
 {
     // It doesn't make sense to use CPU-assembly for only one frame
     if( frames.size() < 2 )
@@ -99,7 +109,13 @@ static bool _useCPUAssembly( const Frames& frames, Channel* channel,
         if( frame->getBuffers() == desiredBuffers )
             ++nFrames;
     }
-    if( nFrames < 2 )
+    return nFrames > 1;
+}
+
+static bool _useCPUAssembly( const Frames& frames, Channel* channel,
+                             const bool blendAlpha = false )
+{
+    if( !_hasCPUAssemblyFrames( frames, blendAlpha ))
         return false;
 
     // Now wait for all images to be ready and test if our assumption was
@@ -165,6 +181,10 @@ static bool _useCPUAssembly( const Frames& frames, Channel* channel,
 
                     case EQ_COMPRESSOR_DATATYPE_RGBA:
                     case EQ_COMPRESSOR_DATATYPE_BGRA:
+                    case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+                    case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+                    case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+                    case EQ_COMPRESSOR_DATATYPE_BGRA32F:
                         break;
 
                     default:
@@ -216,7 +236,11 @@ uint32_t Compositor::assembleFrames( const Frames& frames,
         return 0;
 
     if( _useCPUAssembly( frames, channel ))
+    {
+        if( _useStreamingAssembly( frames ))
+            return assembleFramesStreaming( frames, channel );
         return assembleFramesCPU( frames, channel );
+    }
 
     // else
     return assembleFramesUnsorted( frames, channel, accum );
@@ -427,26 +451,34 @@ uint32_t Compositor::assembleFramesUnsorted( const Frames& frames,
 class Compositor::WaitHandle
 {
 public:
-    WaitHandle( const Frames& frames, Channel* ch )
-            : left( frames ), channel( ch ), processed( 0 ) {}
+    WaitHandle( const Frames& frames, Channel* ch, const bool waitImages )
+            : left( frames ), received( waitImages ? frames.size() : 0, 0 )
+            , channel( ch ), processed( 0 ), images( waitImages ) {}
     ~WaitHandle()
         {
             // de-register the monitor on eventual left-overs on error/exception
             for( FramesCIter i = left.begin(); i != left.end(); ++i )
-                (*i)->removeListener( monitor );
+            {
+                if( images )
+                    (*i)->getFrameData()->removeImageListener( monitor );
+                else
+                    (*i)->removeListener( monitor );
+            }
             left.clear();
         }
 
     lunchbox::Monitor< uint32_t > monitor;
     Frames left;
+    std::vector< size_t > received; //!< returned images of each left frame
     Channel* const channel;
     uint32_t processed;
+    const bool images; //!< monitor counts received images, not ready frames
 };
 
 Compositor::WaitHandle* Compositor::startWaitFrames( const Frames& frames,
                                                      Channel* channel )
 {
-    WaitHandle* handle = new WaitHandle( frames, channel );
+    WaitHandle* handle = new WaitHandle( frames, channel, false );
     for( FramesCIter i = frames.begin(); i != frames.end(); ++i )
         (*i)->addListener( handle->monitor );
 
@@ -461,20 +493,96 @@ Frame* Compositor::waitFrame( WaitHandle* handle )
         return 0;
     }
 
+    ++handle->processed;
+    _wait( handle, handle->processed );
+
+    for( FramesIter i = handle->left.begin(); i != handle->left.end(); ++i )
+    {
+        Frame* frame = *i;
+        if( !frame->isReady( ))
+            continue;
+
+        frame->removeListener( handle->monitor );
+        handle->left.erase( i );
+        return frame;
+    }
+
+    LBASSERTINFO( false, "Unreachable code" );
+    delete handle;
+    return 0;
+}
+
+Compositor::WaitHandle* Compositor::startWaitImages( const Frames& frames,
+                                                     Channel* channel )
+{
+    WaitHandle* handle = new WaitHandle( frames, channel, true );
+    for( FramesCIter i = frames.begin(); i != frames.end(); ++i )
+        (*i)->getFrameData()->addImageListener( handle->monitor );
+
+    return handle;
+}
+
+Frame* Compositor::waitImages( WaitHandle* handle, Images& images )
+{
+    LBASSERT( handle->images );
+    images.clear();
+
+    while( !handle->left.empty( ))
+    {
+        // sample before scanning, images arriving meanwhile end the next wait
+        const uint32_t value = handle->monitor.get();
+
+        size_t i = 0;
+        while( i < handle->left.size( ))
+        {
+            Frame* frame = handle->left[ i ];
+            Images received;
+            const bool ready =
+                frame->getFrameData()->getReceivedImages( received );
+
+            size_t& nReturned = handle->received[ i ];
+            if( received.size() > nReturned )
+            {
+                images.assign( received.begin() + nReturned, received.end( ));
+                nReturned = received.size();
+            }
+
+            if( ready )
+            {
+                frame->getFrameData()->removeImageListener( handle->monitor );
+                handle->left.erase( handle->left.begin() + i );
+                handle->received.erase( handle->received.begin() + i );
+            }
+            else
+                ++i;
+
+            if( !images.empty( ))
+                return frame;
+        }
+
+        if( !handle->left.empty( ))
+            _wait( handle, value + 1 );
+    }
+
+    delete handle;
+    return 0;
+}
+
+void Compositor::_wait( WaitHandle* handle, const uint32_t value )
+{
     ChannelStatistics event( Statistic::CHANNEL_FRAME_WAIT_READY,
                              handle->channel );
     Config* config = handle->channel->getConfig();
     const uint32_t timeout = config->getTimeout();
 
-    ++handle->processed;
     if( timeout == LB_TIMEOUT_INDEFINITE )
-        handle->monitor.waitGE( handle->processed );
+        handle->monitor.waitGE( value );
     else
     {
         const int64_t time = config->getTime() + timeout;
         const int64_t aliveTimeout = co::Global::getKeepaliveTimeout();
 
-        while( !handle->monitor.timedWaitGE( handle->processed, aliveTimeout ))
+        while( !handle->monitor.timedWaitGE( value, aliveTimeout ))
         {
             // pings timed out nodes
             const bool pinged = config->getLocalNode()->pingIdleNodes();
@@ -491,21 +599,6 @@ Frame* Compositor::waitFrame( WaitHandle* handle )
             }
         }
     }
-
-    for( FramesIter i = handle->left.begin(); i != handle->left.end(); ++i )
-    {
-        Frame* frame = *i;
-        if( !frame->isReady( ))
-            continue;
-
-        frame->removeListener( handle->monitor );
-        handle->left.erase( i );
-        return frame;
-    }
-
-    LBASSERTINFO( false, "Unreachable code" );
-    delete handle;
-    return 0;
 }
 
 uint32_t Compositor::assembleFramesCPU( const Frames& frames, Channel* channel,
@@ -540,6 +633,238 @@ uint32_t Compositor::assembleFramesCPU( const Frames& frames, Channel* channel,
     return 1;
 }
 
+namespace
+{
+bool _canMergeStreaming( const Image* image, const Image* first )
+{
+    if( image->getStorageType() != Frame::TYPE_MEMORY ||
+        !image->hasPixelData( Frame::BUFFER_DEPTH ) ||
+        image->getZoom() != Zoom::NONE ||
+        image->getExternalFormat( Frame::BUFFER_DEPTH ) !=
+            EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT ||
+        !detail::kernels::canMergeDepth(
+            image->getPixelSize( Frame::BUFFER_COLOR )))
+    {
+        return false;
+    }
+
+    if( !first )
+        return true;
+
+    const Frame::Buffer buffers[] = { Frame::BUFFER_COLOR,
+                                      Frame::BUFFER_DEPTH };
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = buffers[i];
+        if( image->getInternalFormat( buffer ) !=
+                first->getInternalFormat( buffer ) ||
+            image->getExternalFormat( buffer ) !=
+                first->getExternalFormat( buffer ) ||
+            image->getPixelSize( buffer ) != first->getPixelSize( buffer ))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Clear the part of area not in covered, depth to the far plane
+void _clearStreaming( StreamingBuffers* buffers, const size_t width,
+                      const size_t pixelSize, const PixelViewport& area,
+                      const PixelViewport& covered )
+{
+    for( int32_t y = area.y; y < area.getYEnd(); ++y )
+    {
+        int32_t ranges[4] = { area.x, area.getXEnd(), 0, 0 };
+        if( covered.hasArea() && y >= covered.y && y < covered.getYEnd( ))
+        {
+            ranges[1] = covered.x;
+            ranges[2] = covered.getXEnd();
+            ranges[3] = area.getXEnd();
+        }
+
+        for( unsigned i = 0; i < 4; i += 2 )
+        {
+            if( ranges[i+1] <= ranges[i] )
+                continue;
+
+            const size_t start = y * width + ranges[i];
+            const size_t nPixels = ranges[i+1] - ranges[i];
+            bzero( buffers->color.getData() + start * pixelSize,
+                   nPixels * pixelSize );
+            memset( buffers->depth.getData() + start * sizeof( uint32_t ),
+                    0xFF, nPixels * sizeof( uint32_t ));
+        }
+    }
+}
+
+// Move the rows of area to the start of the buffer, in place
+void _compactStreaming( lunchbox::Bufferb& buffer, const size_t width,
+                        const size_t pixelSize, const PixelViewport& area )
+{
+    const size_t rowSize = area.w * pixelSize;
+    uint8_t* data = buffer.getData();
+    for( int32_t y = 0; y < area.h; ++y )
+    {
+        // destination never overtakes the source, rows are moved in order
+        const size_t source = (( area.y + y ) * width + area.x ) * pixelSize;
+        memmove( data + y * rowSize, data + source, rowSize );
+    }
+}
+}
+
+bool Compositor::_useStreamingAssembly( const Frames& frames )
+{
+    // Streaming assembly is used for depth compositing of ready frames which
+    // qualify for CPU assembly, if all their images can be merged by it.
+    const Image* first = 0;
+    for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i )
+    {
+        const Frame* frame = *i;
+        if( frame->getBuffers() != ( Frame::BUFFER_COLOR |
+                                     Frame::BUFFER_DEPTH ))
+        {
+            return false;
+        }
+
+        const Images& images = frame->getImages();
+        for( ImagesCIter j = images.begin(); j != images.end(); ++j )
+        {
+            const Image* image = *j;
+            if( !image->hasPixelData( Frame::BUFFER_COLOR ))
+                continue;
+            if( !_canMergeStreaming( image, first ))
+                return false;
+            if( !first )
+                first = image;
+        }
+    }
+    return true;
+}
+
+uint32_t Compositor::assembleFramesStreaming( const Frames& frames,
+                                              Channel* channel )
+{
+    if( frames.empty( ))
+        return 0;
+
+    LBVERB << "Streaming CPU assembly" << std::endl;
+
+    // The final image region is only known once all frames are ready. Merge
+    // into staging buffers covering the channel, clearing only the region
+    // covered by the inputs, which becomes the result image. The first image
+    // is held back until a second one arrives, a single image is assembled
+    // directly as decided by _useCPUAssembly.
+    if( !_streamingBuffers )
+        _streamingBuffers = new StreamingBuffers;
+    StreamingBuffers* buffers = _streamingBuffers.get();
+    const PixelViewport& channelPVP = channel->getPixelViewport();
+    const PixelViewport destPVP( 0, 0, channelPVP.w, channelPVP.h );
+    PixelViewport area; // union of all input images
+    PixelViewport covered; // cleared part of the staging buffers
+    area.invalidate();
+    covered.invalidate();
+
+    const Image* first = 0;
+    Vector2i firstOffset;
+    size_t pixelSize = 0;
+    size_t nImages = 0;
+
+    Images images;
+    WaitHandle* handle = startWaitImages( frames, channel );
+    for( Frame* frame = waitImages( handle, images ); frame;
+         frame = waitImages( handle, images ))
+    {
+        detail::tiles::Inputs inputs;
+        for( ImagesCIter i = images.begin(); i != images.end(); ++i )
+        {
+            const Image* image = *i;
+            if( !image->hasPixelData( Frame::BUFFER_COLOR ))
+                continue;
+
+            if( !_canMergeStreaming( image, first ))
+            {
+                LBVERB << "Image not supported by streaming assembly"
+                       << std::endl;
+                delete handle;
+                if( _useCPUAssembly( frames, channel ))
+                    return assembleFramesCPU( frames, channel );
+                return assembleFramesUnsorted( frames, channel, 0 );
+            }
+
+            const Vector2i& offset = frame->getOffset();
+            PixelViewport pvp = image->getPixelViewport() + offset;
+            pvp.intersect( destPVP );
+            if( pvp.hasArea( ))
+                area.merge( pvp );
+
+            if( ++nImages == 1 )
+            {
+                first = image;
+                firstOffset = offset;
+                continue;
+            }
+            if( nImages == 2 )
+            {
+                pixelSize = first->getPixelSize( Frame::BUFFER_COLOR );
+                const size_t nPixels = destPVP.getArea();
+                buffers->color.resize( nPixels * pixelSize );
+                buffers->depth.resize( nPixels * sizeof( uint32_t ));
+                inputs.push_back( detail::tiles::Input( first, firstOffset,
+                                                     detail::tiles::OP_DEPTH ));
+            }
+            inputs.push_back( detail::tiles::Input( image, offset,
+                                                    detail::tiles::OP_DEPTH ));
+        }
+
+        if( inputs.empty( ))
+            continue;
+
+        _clearStreaming( buffers, destPVP.w, pixelSize, area, covered );
+        covered = area;
+
+        uint32_t* destDepth = reinterpret_cast< uint32_t* >(
+            buffers->depth.getData( ));
+        detail::tiles::merge( inputs, buffers->color.getData(), destDepth,
+                              destPVP, pixelSize );
+    }
+
+    if( nImages < 2 )
+        return nImages == 0 ? 0 : assembleFramesUnsorted( frames, channel, 0 );
+    if( !covered.hasArea( ))
+        return 0;
+
+    _compactStreaming( buffers->color, destPVP.w, pixelSize, covered );
+    _compactStreaming( buffers->depth, destPVP.w, sizeof( uint32_t ), covered);
+
+    if( !_resultImage )
+        _resultImage = new Image;
+    Image* result = _resultImage.get();
+    result->setPixelViewport( covered );
+
+    const Frame::Buffer resultBuffers[] = { Frame::BUFFER_COLOR,
+                                            Frame::BUFFER_DEPTH };
+    lunchbox::Bufferb* datas[] = { &buffers->color, &buffers->depth };
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = resultBuffers[i];
+        PixelData pixels;
+        pixels.internalFormat = first->getInternalFormat( buffer );
+        pixels.externalFormat = first->getExternalFormat( buffer );
+        pixels.pixelSize      = first->getPixelSize( buffer );
+        pixels.pvp            = covered;
+        pixels.pixels         = datas[i]->getData();
+        result->setPixelData( buffer, pixels, false /* copy */ );
+    }
+
+    // assemble result on dest channel
+    ImageOp operation;
+    operation.channel = channel;
+    operation.buffers = Frame::BUFFER_COLOR | Frame::BUFFER_DEPTH;
+    assembleImage( result, operation );
+    return 1;
+}
+
 const Image* Compositor::mergeFramesCPU( const Frames& frames,
                                          const bool blendAlpha,
                                          const uint32_t timeout )
@@ -711,26 +1036,7 @@ bool Compositor::mergeFramesCPU( const Frames& frames,
 
     // check output buffers
     const uint32_t area = outPVP.getArea();
-    uint32_t nChannels = 0;
-
-    switch ( colorInternalFormat )
-    {
-        case EQ_COMPRESSOR_DATATYPE_RGBA:
-        case EQ_COMPRESSOR_DATATYPE_RGBA16F:
-        case EQ_COMPRESSOR_DATATYPE_RGBA32F:
-        case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
-            nChannels = 4;
-            break;
-        case EQ_COMPRESSOR_DATATYPE_RGB:
-        case EQ_COMPRESSOR_DATATYPE_RGB16F:
-        case EQ_COMPRESSOR_DATATYPE_RGB32F:
-            nChannels = 3;
-            break;
-        default:
-            LBASSERT( false );
-    }
-
-    if( colorBufferSize < area * nChannels )
+    if( colorBufferSize < area * colorPixelSize )
     {
         LBWARN << "Color output buffer to small" << std::endl;
         return false;
@@ -765,6 +1071,15 @@ void Compositor::_mergeFrames( const Frames& frames, const bool blendAlpha,
                                void* colorBuffer, void* depthBuffer,
                                const PixelViewport& destPVP )
 {
+#ifndef EQ_USE_PARACOMP
+    if( detail::tiles::isEnabled( ))
+    {
+        _mergeFramesTiled( frames, blendAlpha, colorBuffer, depthBuffer,
+                           destPVP );
+        return;
+    }
+#endif
+
     for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i)
     {
         const Frame* frame = *i;
@@ -789,6 +1104,46 @@ void Compositor::_mergeFrames( const Frames& frames, const bool blendAlpha,
     }
 }
 
+void Compositor::_mergeFramesTiled( const Frames& frames,
+                                    const bool blendAlpha,
+                                    void* colorBuffer, void* depthBuffer,
+                                    const PixelViewport& destPVP )
+{
+    LBVERB << "CPU-tiled assembly" << std::endl;
+
+    detail::tiles::Inputs inputs;
+    size_t pixelSize = 0;
+    for( Frames::const_iterator i = frames.begin(); i != frames.end(); ++i)
+    {
+        const Frame* frame = *i;
+        const Images& images = frame->getImages();
+        for( Images::const_iterator j = images.begin(); j != images.end(); ++j )
+        {
+            const Image* image = *j;
+
+            if( !image->hasPixelData( Frame::BUFFER_COLOR ))
+                continue;
+
+            detail::tiles::Operation operation = detail::tiles::OP_COPY;
+            if( image->hasPixelData( Frame::BUFFER_DEPTH ))
+                operation = detail::tiles::OP_DEPTH;
+            else if( blendAlpha && image->hasAlpha( ))
+                operation = detail::tiles::OP_BLEND;
+
+            pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
+            inputs.push_back( detail::tiles::Input( image, frame->getOffset(),
+                                                    operation ));
+        }
+    }
+
+    if( inputs.empty( ))
+        return;
+
+    detail::tiles::merge( inputs, reinterpret_cast< uint8_t* >( colorBuffer ),
+                          reinterpret_cast< uint32_t* >( depthBuffer ),
+                          destPVP, pixelSize );
+}
+
 void Compositor::_mergeDBImage( void* destColor, void* destDepth,
                                 const PixelViewport& destPVP,
                                 const Image* image,
@@ -798,7 +1153,7 @@ void Compositor::_mergeDBImage( void* destColor, void* destDepth,
 
     LBVERB << "CPU-DB assembly" << std::endl;
 
-    uint32_t* destC = reinterpret_cast< uint32_t* >( destColor );
+    uint8_t* destC = reinterpret_cast< uint8_t* >( destColor );
     uint32_t* destD = reinterpret_cast< uint32_t* >( destDepth );
 
     const PixelViewport&  pvp    = image->getPixelViewport();
@@ -817,33 +1172,45 @@ void Compositor::_mergeDBImage( void* destColor, void* destDepth,
     const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
     const int32_t         destY  = offset.y() + pvp.y - destPVP.y;
 
-    const uint32_t* color = reinterpret_cast< const uint32_t* >
-        ( image->getPixelPointer( Frame::BUFFER_COLOR ));
+    const uint8_t* color = image->getPixelPointer( Frame::BUFFER_COLOR );
     const uint32_t* depth = reinterpret_cast< const uint32_t* >
         ( image->getPixelPointer( Frame::BUFFER_DEPTH ));
+    const size_t pixelSize = image->getPixelSize( Frame::BUFFER_COLOR );
+    LBASSERT( detail::kernels::canMergeDepth( pixelSize ));
 
-#pragma omp parallel for
-    for( int32_t y = 0; y < pvp.h; ++y )
+    // only visit the active pixels, if known
+    const detail::ActivePixels& active = image->getActivePixels();
+    if( active.isValid() && active.getWidth() == uint32_t( pvp.w ) &&
+        active.getHeight() == uint32_t( pvp.h ))
     {
-        const uint32_t skip =  (destY + y) * destPVP.w + destX;
-        uint32_t* destColorIt = destC + skip;
-        uint32_t* destDepthIt = destD + skip;
-        const uint32_t* colorIt = color + y * pvp.w;
-        const uint32_t* depthIt = depth + y * pvp.w;
-
-        for( int32_t x = 0; x < pvp.w; ++x )
+#pragma omp parallel for
+        for( int32_t y = 0; y < pvp.h; ++y )
         {
-            if( *destDepthIt > *depthIt )
+            const uint32_t* spans = active.getSpans( y );
+            const uint32_t nSpans = active.getNSpans( y );
+            const size_t skip = (destY + y) * destPVP.w + destX;
+            const size_t row = y * pvp.w;
+
+            for( uint32_t i = 0; i < nSpans; ++i )
             {
-                *destColorIt = *colorIt;
-                *destDepthIt = *depthIt;
+                const uint32_t x = spans[ 2*i ];
+                detail::kernels::mergeDepth( destC + (skip + x) * pixelSize,
+                                             destD + skip + x,
+                                             color + (row + x) * pixelSize,
+                                             depth + row + x,
+                                             spans[ 2*i + 1 ] - x, pixelSize );
             }
-
-            ++destColorIt;
-            ++destDepthIt;
-            ++colorIt;
-            ++depthIt;
         }
+        return;
+    }
+
+#pragma omp parallel for
+    for( int32_t y = 0; y < pvp.h; ++y )
+    {
+        const uint32_t skip =  (destY + y) * destPVP.w + destX;
+        detail::kernels::mergeDepth( destC + skip * pixelSize, destD + skip,
+                                     color + y * pvp.w * pixelSize,
+                                     depth + y * pvp.w, pvp.w, pixelSize );
     }
 }
 
@@ -871,12 +1238,14 @@ void Compositor::_merge2DImage( void* destColor, void* destDepth,
 #pragma omp parallel for
     for( int32_t y = 0; y < pvp.h; ++y )
     {
-        const size_t skip = ( (destY + y) * destPVP.w + destX ) * pixelSize;
-        memcpy( destC + skip, color + y * pvp.w * pixelSize, rowLength);
+        const size_t skip = (destY + y) * destPVP.w + destX;
+        memcpy( destC + skip * pixelSize, color + y * pvp.w * pixelSize,
+                rowLength );
         // clear depth, for depth-assembly into existing FB
         if( destD )
         {
-            bzero( destD + skip, rowLength );
+            bzero( destD + skip * sizeof( uint32_t ),
+                   pvp.w * sizeof( uint32_t ));
         }
     }
 }
@@ -888,13 +1257,14 @@ void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
 {
     LBVERB << "CPU-Blend assembly"<< std::endl;
 
-    int32_t* destColor = reinterpret_cast< int32_t* >( dest );
+    uint8_t* destColor = reinterpret_cast< uint8_t* >( dest );
 
     const PixelViewport&  pvp    = image->getPixelViewport();
     const int32_t         destX  = offset.x() + pvp.x - destPVP.x;
     const int32_t         destY  = offset.y() + pvp.y - destPVP.y;
+    const size_t      pixelSize  = image->getPixelSize( Frame::BUFFER_COLOR );
 
-    LBASSERT( image->getPixelSize( Frame::BUFFER_COLOR ) == 4 );
+    LBASSERT( detail::kernels::canBlend( pixelSize ));
     LBASSERT( image->hasPixelData( Frame::BUFFER_COLOR ));
     LBASSERT( image->hasAlpha( ));
 
@@ -910,8 +1280,7 @@ void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
     }
 #endif
 
-    const int32_t* color = reinterpret_cast< const int32_t* >
-                               ( image->getPixelPointer( Frame::BUFFER_COLOR ));
+    const uint8_t* color = image->getPixelPointer( Frame::BUFFER_COLOR );
 
     // Blending of two slices, none of which is on final image (i.e. result
     // could be blended on to something else) should be performed with:
@@ -922,27 +1291,15 @@ void Compositor::_mergeBlendImage( void* dest, const eq::PixelViewport& destPVP,
     // because we accumulate light which is go through (= 1-Alpha) and we
     // already have colors as Alpha*Color
 
-    int32_t* destColorStart = destColor + destY*destPVP.w + destX;
-    const uint32_t step = sizeof( int32_t );
+    uint8_t* destColorStart = destColor +
+                              ( destY*destPVP.w + destX ) * pixelSize;
 
 #pragma omp parallel for
     for( int32_t y = 0; y < pvp.h; ++y )
     {
-        const unsigned char* src =
-            reinterpret_cast< const uint8_t* >( color + pvp.w * y );
-        unsigned char*       dst =
-            reinterpret_cast< uint8_t* >( destColorStart + destPVP.w * y );
-
-        for( int32_t x = 0; x < pvp.w; ++x )
-        {
-            dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
-            dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
-            dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
-            dst[3] =                   src[3]*dst[3] >> 8;
-
-            src += step;
-            dst += step;
-        }
+        detail::kernels::blend( destColorStart + destPVP.w * y * pixelSize,
+                                color + pvp.w * y * pixelSize, pvp.w,
+                                pixelSize );
     }
 }
 
@@ -127,6 +127,29 @@ namespace eq
                                            Channel* channel,
                                            const bool blendAlpha = false );
 
+        /**
+         * Assemble depth-compositing frames using the CPU, merging each image
+         * as soon as it has been received.
+         *
+         * Unlike assembleFramesCPU(), which waits for all frames before
+         * merging, this overlaps the compositing with the receipt of the
+         * remaining images. The images are merged into a main memory image
+         * covering the union of the input images, which is assembled on the
+         * given channel. All images have to be main memory images with color
+         * and depth information in the same format, otherwise the frames are
+         * assembled as decided by assembleFrames() without streaming. A
+         * single image is assembled using assembleFramesUnsorted().
+         * assembleFrames() uses it instead of assembleFramesCPU() when all
+         * images of the ready frames can be merged by it.
+         *
+         * @param frames the frames to assemble.
+         * @param channel the destination channel.
+         * @return the number of different subpixel steps assembled (0 or 1).
+         * @version 1.5.1
+         */
+        static uint32_t assembleFramesStreaming( const Frames& frames,
+                                                 Channel* channel );
+
         /**
          * Merge the provided frames in the given order into one image in main
          * memory.
@@ -266,12 +289,40 @@ namespace eq
          * @version 1.3.1
          */
         static Frame* waitFrame( WaitHandle* handle );
+
+        /**
+         * Start waiting on the images of a set of input frames.
+         * @version 1.5.1
+         */
+        static WaitHandle* startWaitImages( const Frames& frames,
+                                            Channel* channel );
+
+        /**
+         * Wait for newly received images from a set of pending frames.
+         *
+         * Before the first call, a wait handle is acquired using
+         * startWaitImages(). Each call returns one frame together with the
+         * images received for it since the previous call, which may happen
+         * before the frame is ready. When all images of all frames have been
+         * returned, 0 is returned and the wait handle is invalidated. If the
+         * wait times out, an exception is thrown and the wait handle in
+         * invalidated.
+         *
+         * @param handle the wait handle acquires using startWaitImages().
+         * @param images the return value for the new images of the frame.
+         * @return One frame with new images, or 0 if all frames have been
+         *         processed.
+         * @version 1.5.1
+         */
+        static Frame* waitImages( WaitHandle* handle, Images& images );
         //@}
 
       private:
         typedef std::pair< const Frame*, const Image* > FrameImage;
 
         static bool _isSubPixelDecomposition( const Frames& frames );
+        static bool _useStreamingAssembly( const Frames& frames );
+        static void _wait( WaitHandle* handle, const uint32_t value );
         static const Frames _extractOneSubPixel( Frames& frames );
 
         static bool _collectOutputData(
@@ -295,6 +346,11 @@ namespace eq
                                   void* colorBuffer, void* depthBuffer,
                                   const PixelViewport& destPVP );
 
+        static void _mergeFramesTiled( const Frames& frames,
+                                       const bool blendAlpha,
+                                       void* colorBuffer, void* depthBuffer,
+                                       const PixelViewport& destPVP );
+
         static void _mergeDBImage( void* destColor, void* destDepth,
                                    const PixelViewport& destPVP,
                                    const Image* image,
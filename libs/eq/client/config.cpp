@@ -38,6 +38,8 @@
 #include "server.h"
 #include "view.h"
 #include "window.h"
+#include "detail/statisticsBatch.h"
+#include "detail/statisticsTrace.h"
 
 #include <eq/fabric/commands.h>
 #include <eq/fabric/configVisitor.h>
@@ -87,11 +89,13 @@ public:
             , finishedFrame( 0 )
             , running( false )
     {
+        trace.data = 0;
         lunchbox::Log::setClock( &clock );
     }
 
     ~Config()
     {
+        delete trace.data;
         appNode = 0;
         lunchbox::Log::setClock( 0 );
     }
@@ -134,6 +138,9 @@ public:
 
     /** true while the config is initialized and no window has exited. */
     bool running;
+
+    /** The statistics trace output, written outside the statistics lock. */
+    lunchbox::Lockable< StatisticsTrace* > trace;
 };
 }
 
@@ -185,8 +192,8 @@ void Config::attach( const UUID& id, const uint32_t instanceID )
     registerCommand( fabric::CMD_CONFIG_EVENT_OLD, ConfigFunc( 0, 0 ),
                      &_impl->eventQueue );
 #endif
-    registerCommand( fabric::CMD_CONFIG_EVENT, ConfigFunc( 0, 0 ),
-                     &_impl->eventQueue );
+    registerCommand( fabric::CMD_CONFIG_EVENT,
+                     ConfigFunc( this, &Config::_cmdEvent ), 0 );
     registerCommand( fabric::CMD_CONFIG_SYNC_CLOCK,
                      ConfigFunc( this, &Config::_cmdSyncClock ), 0 );
     registerCommand( fabric::CMD_CONFIG_SWAP_OBJECT,
@@ -321,7 +328,22 @@ bool Config::init( const uint128_t& initID )
     localNode->enableSendOnRegister();
 
     if( _impl->running )
+    {
+        const char* traceFile = getenv( "EQ_STATISTICS_TRACE" );
+        if( traceFile )
+        {
+            lunchbox::ScopedWrite mutex( _impl->trace );
+            detail::StatisticsTrace*& trace = _impl->trace.data;
+            delete trace;
+            trace = new detail::StatisticsTrace( this, traceFile );
+            if( !trace->isOpen( ))
+            {
+                delete trace;
+                trace = 0;
+            }
+        }
         handleEvents();
+    }
     else
         LBWARN << "Config initialization failed: " << getError() << std::endl
                << "    Consult client log for further information" << std::endl;
@@ -345,6 +367,11 @@ bool Config::exit()
 
     bool ret = false;
     localNode->waitRequest( requestID, ret );
+    {
+        lunchbox::ScopedWrite mutex( _impl->trace );
+        delete _impl->trace.data;
+        _impl->trace.data = 0;
+    }
 
 #ifndef EQ_2_0_API
     _impl->lastEvent.clear();
@@ -717,30 +744,7 @@ bool Config::_handleEvent( const Event& event )
                 return false;
             }
 
-            lunchbox::ScopedFastWrite mutex( _impl->statistics );
-
-            for( std::deque<FrameStatistics>::iterator i =
-                     _impl->statistics->begin();
-                 i != _impl->statistics->end(); ++i )
-            {
-                FrameStatistics& frameStats = *i;
-                if( frameStats.first == frame )
-                {
-                    SortedStatistics& sortedStats = frameStats.second;
-                    Statistics&       statistics  = sortedStats[ originator ];
-                    statistics.push_back( statistic );
-                    return false;
-                }
-            }
-
-            _impl->statistics->push_back( FrameStatistics( ));
-            FrameStatistics& frameStats = _impl->statistics->back();
-            frameStats.first = frame;
-
-            SortedStatistics& sortedStats = frameStats.second;
-            Statistics&       statistics  = sortedStats[ originator ];
-            statistics.push_back( statistic );
-
+            _addStatistics( originator, Statistics( 1, statistic ));
             return false;
         }
 
@@ -788,6 +792,42 @@ bool Config::_needsLocalSync() const
     return true;
 }
 
+void Config::_addStatistics( const uint32_t originator,
+                             const Statistics& statistics )
+{
+    if( statistics.empty( ))
+        return;
+
+    const uint32_t frame = statistics.front().frameNumber;
+    if( frame == 0 ) // Not frame-related
+        return;
+
+    {
+        // file I/O, not under the statistics lock taken by the app thread
+        lunchbox::ScopedWrite mutex( _impl->trace );
+        if( _impl->trace.data )
+            _impl->trace.data->write( originator, statistics );
+    }
+
+    // see _updateStatistics()
+    const uint32_t finished = _impl->finishedFrame.get();
+    if( frame < finished && finished - frame > 2 ) // already discarded
+        return;
+
+    lunchbox::ScopedFastWrite mutex( _impl->statistics );
+
+    // keep the frames sorted, statistics arrive out of order
+    std::deque< FrameStatistics >& frames = _impl->statistics.data;
+    std::deque< FrameStatistics >::iterator i = frames.begin();
+    while( i != frames.end() && i->first < frame )
+        ++i;
+    if( i == frames.end() || i->first != frame )
+        i = frames.insert( i, FrameStatistics( frame, SortedStatistics( )));
+
+    Statistics& stats = i->second[ originator ];
+    stats.insert( stats.end(), statistics.begin(), statistics.end( ));
+}
+
 void Config::_updateStatistics( const uint32_t finishedFrame )
 {
     // keep statistics for three frames
@@ -806,7 +846,7 @@ void Config::getStatistics( std::vector< FrameStatistics >& statistics )
     for( std::deque<FrameStatistics>::const_iterator i =
              _impl->statistics->begin(); i != _impl->statistics->end(); ++i )
     {
-        if( (*i).first <= _impl->finishedFrame.get( ))
+        if( (*i).first <= _impl->finishedFrame.get() && !(*i).second.empty( ))
             statistics.push_back( *i );
     }
 }
@@ -1117,15 +1157,43 @@ bool Config::_cmdFrameFinish( co::ICommand& cmd )
     return true;
 }
 
+bool Config::_cmdEvent( co::ICommand& cmd )
+{
+    EventICommand command( cmd );
+    if( command.getEventType() != Event::STATISTICS )
+    {
+        _impl->eventQueue.push( cmd );
+        return true;
+    }
+
+    // batches carry no Event, keep them away from application event handlers
+    const uint32_t originator = command.get< uint32_t >();
+    Statistics statistics;
+    if( !detail::StatisticsBatch::read( command, statistics ))
+    {
+        LBWARN << "Dropping malformed statistics batch from " << originator
+               << std::endl;
+        return true;
+    }
+
+    LBLOG( LOG_STATS ) << statistics.size() << " statistics from "
+                       << originator << std::endl;
+    if( originator != 0 )
+        _addStatistics( originator, statistics );
+    return true;
+}
+
 bool Config::_cmdSyncClock( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
     const int64_t time = command.get< int64_t >();
+    const int64_t sendTime = command.get< int64_t >();
 
     LBVERB << "sync global clock to " << time << ", drift "
            << time - _impl->clock.getTime64() << std::endl;
 
     _impl->clock.set( time );
+    send( getServer(), fabric::CMD_CONFIG_SYNC_CLOCK_REPLY ) << sendTime;
     return true;
 }
 
@@ -473,6 +473,10 @@ namespace detail { class Config; }
          */
         void _updateStatistics( const uint32_t finishedFrame );
 
+        /** Store statistics of one frame and originator for visualization. */
+        void _addStatistics( const uint32_t originator,
+                             const Statistics& statistics );
+
         /** Release all deregistered buffered objects after their latency is
             done. */
         void _releaseObjects();
@@ -481,6 +485,7 @@ namespace detail { class Config; }
         void _exitMessagePump();
 
         /** The command functions. */
+        bool _cmdEvent( co::ICommand& command );
         bool _cmdSyncClock( co::ICommand& command );
         bool _cmdCreateNode( co::ICommand& command );
         bool _cmdDestroyNode( co::ICommand& command );
@@ -0,0 +1,174 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "activePixels.h"
+
+#include <lunchbox/debug.h>
+
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+const uint32_t _background = 0xffffffffu; // far plane depth
+}
+
+void ActivePixels::_beginRows( const uint32_t width, const uint32_t height )
+{
+    _data.clear();
+    _data.push_back( width );
+    _data.push_back( height );
+    _data.resize( size_t( height ) + 3, 0 );
+    _nPixels = 0;
+}
+
+void ActivePixels::compute( const uint32_t* depth, const uint32_t width,
+                            const uint32_t height )
+{
+    _beginRows( width, height );
+
+    uint32_t nSpans = 0;
+    for( uint32_t y = 0; y < height; ++y )
+    {
+        const uint32_t* row = depth + size_t( y ) * width;
+        _data[ y + 2 ] = nSpans;
+
+        uint32_t x = 0;
+        while( x < width )
+        {
+            while( x < width && row[x] == _background )
+                ++x;
+            if( x == width )
+                break;
+
+            const uint32_t start = x;
+            while( x < width && row[x] != _background )
+                ++x;
+
+            _data.push_back( start );
+            _data.push_back( x );
+            _nPixels += x - start;
+            ++nSpans;
+        }
+    }
+    _data[ height + 2 ] = nSpans;
+}
+
+void ActivePixels::clear( const uint32_t width, const uint32_t height )
+{
+    _beginRows( width, height );
+}
+
+void ActivePixels::pack( const uint8_t* pixels, const size_t pixelSize,
+                         uint8_t* out ) const
+{
+    LBASSERT( isValid( ));
+    const size_t rowSize = getWidth() * pixelSize;
+    const uint32_t height = getHeight();
+
+    for( uint32_t y = 0; y < height; ++y )
+    {
+        const uint8_t* row = pixels + y * rowSize;
+        const uint32_t* spans = getSpans( y );
+        const uint32_t nSpans = getNSpans( y );
+
+        for( uint32_t i = 0; i < nSpans; ++i )
+        {
+            const size_t size = ( spans[2*i+1] - spans[2*i] ) * pixelSize;
+            memcpy( out, row + spans[2*i] * pixelSize, size );
+            out += size;
+        }
+    }
+}
+
+void ActivePixels::unpack( const uint8_t* in, const size_t pixelSize,
+                           uint8_t* pixels ) const
+{
+    LBASSERT( isValid( ));
+    const size_t rowSize = getWidth() * pixelSize;
+    const uint32_t height = getHeight();
+
+    for( uint32_t y = 0; y < height; ++y )
+    {
+        uint8_t* row = pixels + y * rowSize;
+        const uint32_t* spans = getSpans( y );
+        const uint32_t nSpans = getNSpans( y );
+
+        for( uint32_t i = 0; i < nSpans; ++i )
+        {
+            const size_t size = ( spans[2*i+1] - spans[2*i] ) * pixelSize;
+            memcpy( row + spans[2*i] * pixelSize, in, size );
+            in += size;
+        }
+    }
+}
+
+bool ActivePixels::setData( const void* data, const uint64_t size )
+{
+    invalidate();
+    if( size < 3 * sizeof( uint32_t ) || size % sizeof( uint32_t ) != 0 )
+        return false;
+
+    // copy first, received data is not necessarily aligned
+    _data.resize( size / sizeof( uint32_t ));
+    memcpy( &_data.front(), data, size );
+
+    const uint64_t n = _data.size();
+    const uint32_t width = _data[0];
+    const uint32_t height = _data[1];
+    if( n < uint64_t( height ) + 3 || _data[2] != 0 ||
+        n != uint64_t( height ) + 3 + 2 * uint64_t( _data[ height + 2 ] ))
+    {
+        invalidate();
+        return false;
+    }
+
+    uint64_t nPixels = 0;
+    for( uint32_t y = 0; y < height; ++y )
+    {
+        if( _data[ y + 3 ] < _data[ y + 2 ] )
+        {
+            invalidate();
+            return false;
+        }
+
+        const uint32_t* spans = getSpans( y );
+        const uint32_t nSpans = getNSpans( y );
+        uint32_t last = 0;
+        for( uint32_t i = 0; i < nSpans; ++i )
+        {
+            const uint32_t start = spans[2*i];
+            const uint32_t end = spans[2*i+1];
+            if( start < last || end <= start || end > width )
+            {
+                invalidate();
+                return false;
+            }
+            nPixels += end - start;
+            last = end;
+        }
+    }
+
+    _nPixels = nPixels;
+    return true;
+}
+
+}
+}
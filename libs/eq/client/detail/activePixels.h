@@ -0,0 +1,122 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_ACTIVEPIXELS_H
+#define EQ_DETAIL_ACTIVEPIXELS_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Per-row spans of the active pixels of a depth buffer.
+ *
+ * Pixels at the far plane (depth 0xffffffff) are background, all others are
+ * active. The spans are computed once after the depth buffer is read back or
+ * received, and allow the CPU compositor and the image transmission to process
+ * only the covered pixels of sort-last images.
+ *
+ * The spans are stored in a single serializable array: width, height, h+1
+ * span offsets and one [start, end) pixel pair per span.
+ */
+class ActivePixels
+{
+public:
+    ActivePixels() : _nPixels( 0 ) {}
+
+    /** Compute the spans of a width x height depth buffer. */
+    EQ_API void compute( const uint32_t* depth, const uint32_t width,
+                         const uint32_t height );
+
+    /** Set the spans of a cleared, all-background depth buffer. */
+    EQ_API void clear( const uint32_t width, const uint32_t height );
+
+    /** Invalidate the spans, e.g., after the depth buffer was modified. */
+    void invalidate() { _data.clear(); _nPixels = 0; }
+
+    /** @return true if the spans describe the current depth buffer. */
+    bool isValid() const { return !_data.empty(); }
+
+    /** @return the width of the described depth buffer. */
+    uint32_t getWidth() const { return isValid() ? _data[0] : 0; }
+
+    /** @return the height of the described depth buffer. */
+    uint32_t getHeight() const { return isValid() ? _data[1] : 0; }
+
+    /** @return the number of active pixels. */
+    uint64_t getNPixels() const { return _nPixels; }
+
+    /** @return true if less than half of the pixels are active. */
+    bool isSparse() const
+    {
+        return isValid() &&
+               _nPixels * 2 < uint64_t( getWidth( )) * getHeight();
+    }
+
+    /** @return the number of spans in the given row. */
+    uint32_t getNSpans( const uint32_t y ) const
+        { return _data[ y + 3 ] - _data[ y + 2 ]; }
+
+    /**
+     * @return the [start, end) pairs of the spans in the given row, the end
+     *         of the spans if the row has none.
+     */
+    const uint32_t* getSpans( const uint32_t y ) const
+        { return &_data.front() + getHeight() + 3 + 2 * _data[ y + 2 ]; }
+
+    /**
+     * Copy the active pixels into a contiguous buffer.
+     *
+     * @param pixels the full width x height input pixels.
+     * @param pixelSize the size of one pixel in bytes.
+     * @param out the output buffer of getNPixels() * pixelSize bytes.
+     */
+    EQ_API void pack( const uint8_t* pixels, const size_t pixelSize,
+                      uint8_t* out ) const;
+
+    /** Scatter packed active pixels into a full width x height buffer. */
+    EQ_API void unpack( const uint8_t* in, const size_t pixelSize,
+                        uint8_t* pixels ) const;
+
+    /** @return the serialized spans, or 0 if none are set. */
+    const void* getData() const { return _data.empty() ? 0 : &_data[0]; }
+
+    /** @return the size of the serialized spans in bytes. */
+    uint64_t getDataSize() const { return _data.size() * sizeof( uint32_t ); }
+
+    /**
+     * Set the spans from their serialized form.
+     *
+     * @return true on success, false if the data is malformed.
+     */
+    EQ_API bool setData( const void* data, const uint64_t size );
+
+private:
+    std::vector< uint32_t > _data;
+    uint64_t _nPixels;
+
+    void _beginRows( const uint32_t width, const uint32_t height );
+};
+}
+}
+
+#endif // EQ_DETAIL_ACTIVEPIXELS_H
@@ -89,6 +89,31 @@ public:
 
     /** The number of the last finished frame. */
     lunchbox::Monitor< uint32_t > finishedFrame;
+
+    /** Chooses the image compressors for each destination node. */
+    CompressorSelector compressorSelector;
+
+    /** The bands of banded image transmissions, reused to keep their
+        compressor instances and pixel buffers across frames. */
+    Image transmitBands[2];
+
+    /** The render contexts of the last tasks, by task and eye. */
+    typedef std::map< std::pair< uint32_t, uint32_t >,
+                      RenderContext > RenderContexts;
+    RenderContexts renderContexts;
+
+    /** @return the delta-encoded render context of a task command. */
+    RenderContext getRenderContext( co::DataIStream& is )
+    {
+        uint32_t taskID = 0;
+        Eye eye = EYE_CYCLOP;
+        is >> taskID >> eye;
+
+        RenderContext& context = renderContexts[ std::make_pair( taskID,
+                                                                 eye ) ];
+        context.deserialize( is );
+        return context;
+    }
 };
 
 }
@@ -0,0 +1,519 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compositorKernels.h"
+
+#include <lunchbox/debug.h>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#  define EQ_USE_SSE2
+#  include <emmintrin.h>
+#endif
+
+#ifdef EQ_USE_AVX2
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace kernels
+{
+namespace
+{
+#ifdef EQ_USE_AVX2
+/** @return true if the CPU and the operating system support AVX2 and F16C. */
+bool _hasAVX2()
+{
+    uint32_t info[4] = { 0, 0, 0, 0 }; // eax, ebx, ecx, edx
+#  ifdef _MSC_VER
+    __cpuid( reinterpret_cast< int* >( info ), 0 );
+#  else
+    __cpuid( 0, info[0], info[1], info[2], info[3] );
+#  endif
+    if( info[0] < 7 )
+        return false;
+
+#  ifdef _MSC_VER
+    __cpuid( reinterpret_cast< int* >( info ), 1 );
+#  else
+    __cpuid( 1, info[0], info[1], info[2], info[3] );
+#  endif
+    const uint32_t osxsave = 1u << 27;
+    const uint32_t avx = 1u << 28;
+    const uint32_t f16c = 1u << 29;
+    if(( info[2] & ( osxsave | avx | f16c )) != ( osxsave | avx | f16c ))
+        return false;
+
+    // the operating system saves the SSE and AVX registers
+#  ifdef _MSC_VER
+    const uint64_t xcr0 = _xgetbv( 0 );
+#  else
+    uint32_t xcr0Low = 0;
+    uint32_t xcr0High = 0;
+    __asm__( ".byte 0x0f, 0x01, 0xd0" // xgetbv, unknown to old assemblers
+             : "=a" ( xcr0Low ), "=d" ( xcr0High ) : "c" ( 0 ));
+    const uint64_t xcr0 = ( uint64_t( xcr0High ) << 32 ) | xcr0Low;
+#  endif
+    if(( xcr0 & 0x6 ) != 0x6 )
+        return false;
+
+#  ifdef _MSC_VER
+    __cpuidex( reinterpret_cast< int* >( info ), 7, 0 );
+#  else
+    __cpuid_count( 7, 0, info[0], info[1], info[2], info[3] );
+#  endif
+    const uint32_t avx2Bit = 1u << 5;
+    return ( info[1] & avx2Bit ) != 0;
+}
+#endif
+
+ISA _isa = getBestISA();
+
+//----------------------------------------------------------------------
+// half float conversion
+//----------------------------------------------------------------------
+inline float _toFloat( const uint32_t bits )
+{
+    float value;
+    ::memcpy( &value, &bits, sizeof( float ));
+    return value;
+}
+
+inline uint32_t _toBits( const float value )
+{
+    uint32_t bits;
+    ::memcpy( &bits, &value, sizeof( float ));
+    return bits;
+}
+
+inline float _halfToFloat( const uint16_t half )
+{
+    const uint32_t sign = uint32_t( half & 0x8000u ) << 16;
+    uint32_t exponent = ( half >> 10 ) & 0x1fu;
+    uint32_t mantissa = half & 0x3ffu;
+
+    if( exponent == 0x1fu ) // Inf, NaN
+        return _toFloat( sign | 0x7f800000u | ( mantissa << 13 ));
+
+    if( exponent == 0 )
+    {
+        if( mantissa == 0 ) // +-0
+            return _toFloat( sign );
+
+        // denormal: renormalize
+        exponent = 1;
+        while( !( mantissa & 0x400u ))
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        mantissa &= 0x3ffu;
+    }
+    return _toFloat( sign | (( exponent + 112 ) << 23 ) | ( mantissa << 13 ));
+}
+
+/** Round-to-nearest-even float to half conversion. */
+inline uint16_t _floatToHalf( const float value )
+{
+    static const uint32_t f32Infinity = 255u << 23;
+    static const uint32_t f16Max = ( 127u + 16u ) << 23;
+    static const uint32_t denormMagic = (( 127u - 15u ) + ( 23u - 10u ) + 1u )
+                                        << 23;
+    uint32_t bits = _toBits( value );
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if( bits >= f16Max ) // overflow to Inf, or NaN
+        half = bits > f32Infinity ? 0x7e00u : 0x7c00u;
+    else if( bits < ( 113u << 23 )) // denormal or zero
+        half = _toBits( _toFloat( bits ) + _toFloat( denormMagic )) -
+               denormMagic;
+    else
+    {
+        const uint32_t mantissaOdd = ( bits >> 13 ) & 1u;
+        bits += ( uint32_t( 15 - 127 ) << 23 ) + 0xfffu;
+        bits += mantissaOdd;
+        half = bits >> 13;
+    }
+    return uint16_t( half | ( sign >> 16 ));
+}
+
+//----------------------------------------------------------------------
+// scalar implementation
+//----------------------------------------------------------------------
+template< size_t size >
+inline void _mergeDepthScalar( uint8_t* destColor, uint32_t* destDepth,
+                               const uint8_t* color, const uint32_t* depth,
+                               const size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; ++i )
+    {
+        if( destDepth[i] > depth[i] )
+        {
+            destDepth[i] = depth[i];
+            ::memcpy( destColor + i * size, color + i * size, size );
+        }
+    }
+}
+
+inline void _blendRGBA8Scalar( uint8_t* dst, const uint8_t* src,
+                               const size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; ++i )
+    {
+        dst[0] = LB_MIN( src[0] + (src[3]*dst[0] >> 8), 255 );
+        dst[1] = LB_MIN( src[1] + (src[3]*dst[1] >> 8), 255 );
+        dst[2] = LB_MIN( src[2] + (src[3]*dst[2] >> 8), 255 );
+        dst[3] =                   src[3]*dst[3] >> 8;
+
+        src += 4;
+        dst += 4;
+    }
+}
+
+inline void _blendRGBA16FScalar( uint8_t* dest, const uint8_t* color,
+                                 const size_t nPixels )
+{
+    uint16_t* dst = reinterpret_cast< uint16_t* >( dest );
+    const uint16_t* src = reinterpret_cast< const uint16_t* >( color );
+
+    for( size_t i = 0; i < nPixels; ++i )
+    {
+        const float alpha = _halfToFloat( src[3] );
+        for( size_t j = 0; j < 3; ++j )
+            dst[j] = _floatToHalf( _halfToFloat( src[j] ) +
+                                   alpha * _halfToFloat( dst[j] ));
+        dst[3] = _floatToHalf( alpha * _halfToFloat( dst[3] ));
+
+        src += 4;
+        dst += 4;
+    }
+}
+
+inline void _blendRGBA32FScalar( uint8_t* dest, const uint8_t* color,
+                                 const size_t nPixels )
+{
+    float* dst = reinterpret_cast< float* >( dest );
+    const float* src = reinterpret_cast< const float* >( color );
+
+    for( size_t i = 0; i < nPixels; ++i )
+    {
+        const float alpha = src[3];
+        dst[0] = src[0] + alpha * dst[0];
+        dst[1] = src[1] + alpha * dst[1];
+        dst[2] = src[2] + alpha * dst[2];
+        dst[3] =          alpha * dst[3];
+
+        src += 4;
+        dst += 4;
+    }
+}
+
+//----------------------------------------------------------------------
+// SSE2 implementation
+//----------------------------------------------------------------------
+#ifdef EQ_USE_SSE2
+inline __m128i _select( const __m128i mask, const __m128i a, const __m128i b )
+{
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ));
+}
+
+/** @return the mask of the pixels where the source is closer. */
+inline __m128i _mergeDepthBlockSSE2( uint32_t* destDepth,
+                                     const uint32_t* depth )
+{
+    // no unsigned compare in SSE2: flip the sign bit and compare signed
+    const __m128i bias = _mm_set1_epi32( int( 0x80000000u ));
+    __m128i* destDepthIt = reinterpret_cast< __m128i* >( destDepth );
+    const __m128i dst = _mm_loadu_si128( destDepthIt );
+    const __m128i src =
+        _mm_loadu_si128( reinterpret_cast< const __m128i* >( depth ));
+    const __m128i mask = _mm_cmpgt_epi32( _mm_xor_si128( dst, bias ),
+                                          _mm_xor_si128( src, bias ));
+    _mm_storeu_si128( destDepthIt, _select( mask, src, dst ));
+    return mask;
+}
+
+inline void _selectColorSSE2( uint8_t* destColor, const uint8_t* color,
+                              const __m128i mask )
+{
+    __m128i* dstIt = reinterpret_cast< __m128i* >( destColor );
+    const __m128i dst = _mm_loadu_si128( dstIt );
+    const __m128i src =
+        _mm_loadu_si128( reinterpret_cast< const __m128i* >( color ));
+    _mm_storeu_si128( dstIt, _select( mask, src, dst ));
+}
+
+template< size_t size >
+void _mergeDepthSSE2( uint8_t* destColor, uint32_t* destDepth,
+                      const uint8_t* color, const uint32_t* depth,
+                      const size_t nPixels )
+{
+    const size_t nBlocks = nPixels / 4;
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        const __m128i mask = _mergeDepthBlockSSE2( destDepth, depth );
+        switch( size )
+        {
+          case 4:
+            _selectColorSSE2( destColor, color, mask );
+            break;
+
+          case 8:
+            _selectColorSSE2( destColor, color,
+                              _mm_unpacklo_epi32( mask, mask ));
+            _selectColorSSE2( destColor + 16, color + 16,
+                              _mm_unpackhi_epi32( mask, mask ));
+            break;
+
+          case 16:
+            _selectColorSSE2( destColor, color,
+                              _mm_shuffle_epi32( mask, 0x00 ));
+            _selectColorSSE2( destColor + 16, color + 16,
+                              _mm_shuffle_epi32( mask, 0x55 ));
+            _selectColorSSE2( destColor + 32, color + 32,
+                              _mm_shuffle_epi32( mask, 0xaa ));
+            _selectColorSSE2( destColor + 48, color + 48,
+                              _mm_shuffle_epi32( mask, 0xff ));
+            break;
+
+          default:
+            LBUNREACHABLE;
+        }
+
+        destColor += 4 * size;
+        destDepth += 4;
+        color += 4 * size;
+        depth += 4;
+    }
+
+    _mergeDepthScalar< size >( destColor, destDepth, color, depth,
+                               nPixels - nBlocks * 4 );
+}
+
+inline __m128i _blendRGBA8BlockSSE2( const __m128i src, const __m128i dst )
+{
+    const __m128i rgbMask = _mm_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1 );
+    const __m128i alpha = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16( src, _MM_SHUFFLE( 3, 3, 3, 3 )),
+        _MM_SHUFFLE( 3, 3, 3, 3 ));
+
+    // src * dst <= 255*255 fits into 16 bit, shift is logical
+    const __m128i scaled = _mm_srli_epi16( _mm_mullo_epi16( alpha, dst ), 8 );
+    return _mm_add_epi16( scaled, _mm_and_si128( src, rgbMask ));
+}
+
+void _blendRGBA8SSE2( uint8_t* dest, const uint8_t* color,
+                      const size_t nPixels )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const size_t nBlocks = nPixels / 4;
+
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        __m128i* dstIt = reinterpret_cast< __m128i* >( dest );
+        const __m128i src =
+            _mm_loadu_si128( reinterpret_cast< const __m128i* >( color ));
+        const __m128i dst = _mm_loadu_si128( dstIt );
+
+        const __m128i low =
+            _blendRGBA8BlockSSE2( _mm_unpacklo_epi8( src, zero ),
+                                  _mm_unpacklo_epi8( dst, zero ));
+        const __m128i high =
+            _blendRGBA8BlockSSE2( _mm_unpackhi_epi8( src, zero ),
+                                  _mm_unpackhi_epi8( dst, zero ));
+        // saturates color channels at 255
+        _mm_storeu_si128( dstIt, _mm_packus_epi16( low, high ));
+
+        dest += 16;
+        color += 16;
+    }
+
+    _blendRGBA8Scalar( dest, color, nPixels - nBlocks * 4 );
+}
+
+void _blendRGBA32FSSE2( uint8_t* dest, const uint8_t* color,
+                        const size_t nPixels )
+{
+    const __m128 rgbMask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ));
+    float* dst = reinterpret_cast< float* >( dest );
+    const float* src = reinterpret_cast< const float* >( color );
+
+    for( size_t i = 0; i < nPixels; ++i )
+    {
+        const __m128 source = _mm_loadu_ps( src );
+        const __m128 alpha = _mm_shuffle_ps( source, source,
+                                             _MM_SHUFFLE( 3, 3, 3, 3 ));
+        const __m128 scaled = _mm_mul_ps( alpha, _mm_loadu_ps( dst ));
+        const __m128 sum = _mm_add_ps( source, scaled );
+
+        // alpha = src.a * dst.a, without adding src.a
+        _mm_storeu_ps( dst, _mm_or_ps( _mm_and_ps( rgbMask, sum ),
+                                       _mm_andnot_ps( rgbMask, scaled )));
+        src += 4;
+        dst += 4;
+    }
+}
+#endif // EQ_USE_SSE2
+}
+
+ISA getBestISA()
+{
+#ifdef EQ_USE_AVX2
+    static const bool hasAVX2 = _hasAVX2();
+    if( hasAVX2 )
+        return ISA_AVX2;
+#endif
+#ifdef EQ_USE_SSE2
+    return ISA_SSE2; // compiled with SSE2: every CPU running this supports it
+#else
+    return ISA_SCALAR;
+#endif
+}
+
+ISA getISA()
+{
+    return _isa;
+}
+
+void setISA( const ISA isa )
+{
+    _isa = LB_MIN( isa, getBestISA( ));
+}
+
+void mergeDepth( uint8_t* destColor, uint32_t* destDepth,
+                 const uint8_t* color, const uint32_t* depth,
+                 size_t nPixels, const size_t pixelSize )
+{
+    LBASSERT( canMergeDepth( pixelSize ));
+#ifdef EQ_USE_AVX2
+    if( _isa == ISA_AVX2 )
+    {
+        // the rest of the pixels is merged by the next best implementation
+        const size_t nDone = avx2::mergeDepth( destColor, destDepth, color,
+                                               depth, nPixels, pixelSize );
+        destColor += nDone * pixelSize;
+        destDepth += nDone;
+        color += nDone * pixelSize;
+        depth += nDone;
+        nPixels -= nDone;
+    }
+#endif
+#ifdef EQ_USE_SSE2
+    if( _isa >= ISA_SSE2 )
+    {
+        switch( pixelSize )
+        {
+          case 4:
+            _mergeDepthSSE2< 4 >( destColor, destDepth, color, depth, nPixels );
+            return;
+          case 8:
+            _mergeDepthSSE2< 8 >( destColor, destDepth, color, depth, nPixels );
+            return;
+          case 16:
+            _mergeDepthSSE2< 16 >( destColor, destDepth, color, depth,
+                                   nPixels );
+            return;
+        }
+    }
+#endif
+
+    switch( pixelSize )
+    {
+      case 4:
+        _mergeDepthScalar< 4 >( destColor, destDepth, color, depth, nPixels );
+        return;
+      case 8:
+        _mergeDepthScalar< 8 >( destColor, destDepth, color, depth, nPixels );
+        return;
+      case 16:
+        _mergeDepthScalar< 16 >( destColor, destDepth, color, depth, nPixels );
+        return;
+      default:
+        LBUNIMPLEMENTED;
+    }
+}
+
+void blend( uint8_t* dest, const uint8_t* color, size_t nPixels,
+            const size_t pixelSize )
+{
+    LBASSERT( canBlend( pixelSize ));
+#ifdef EQ_USE_AVX2
+    if( _isa == ISA_AVX2 )
+    {
+        // the rest of the pixels is blended by the next best implementation
+        size_t nDone = 0;
+        switch( pixelSize )
+        {
+          case 4:
+            nDone = avx2::blendRGBA8( dest, color, nPixels );
+            break;
+          case 8:
+            nDone = avx2::blendRGBA16F( dest, color, nPixels );
+            break;
+          case 16:
+            nDone = avx2::blendRGBA32F( dest, color, nPixels );
+            break;
+        }
+        dest += nDone * pixelSize;
+        color += nDone * pixelSize;
+        nPixels -= nDone;
+    }
+#endif
+#ifdef EQ_USE_SSE2
+    if( _isa >= ISA_SSE2 )
+    {
+        switch( pixelSize )
+        {
+          case 4:
+            _blendRGBA8SSE2( dest, color, nPixels );
+            return;
+          case 16:
+            _blendRGBA32FSSE2( dest, color, nPixels );
+            return;
+        }
+    }
+#endif
+
+    switch( pixelSize )
+    {
+      case 4:
+        _blendRGBA8Scalar( dest, color, nPixels );
+        return;
+      case 8:
+        _blendRGBA16FScalar( dest, color, nPixels );
+        return;
+      case 16:
+        _blendRGBA32FScalar( dest, color, nPixels );
+        return;
+      default:
+        LBUNIMPLEMENTED;
+    }
+}
+
+}
+}
+}
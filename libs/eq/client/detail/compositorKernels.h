@@ -0,0 +1,112 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_COMPOSITORKERNELS_H
+#define EQ_DETAIL_COMPOSITORKERNELS_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Row-based pixel kernels used by the CPU compositor.
+ *
+ * All kernels operate on one contiguous run of pixels, which allows the
+ * compositor to parallelize and tile the work freely. Each kernel has a
+ * portable scalar implementation and, where available, SIMD implementations
+ * producing bit-identical results for finite values. The SSE2 kernels are used
+ * if the build targets SSE2. The AVX2 kernels are compiled separately, if the
+ * compiler supports AVX2 on x86_64, and are used only if CPUID reports AVX2,
+ * F16C and operating system support for the AVX registers. The instruction set
+ * can be forced to a lesser one for verification.
+ */
+namespace kernels
+{
+/** The instruction set used by the compositing kernels. */
+enum ISA
+{
+    ISA_SCALAR, //!< Portable C++ implementation
+    ISA_SSE2,   //!< SSE2 implementation, x86 and x86_64 only
+    ISA_AVX2    //!< AVX2 and F16C implementation, x86_64 only
+};
+
+/** @return the best instruction set supported by the build and the CPU. */
+EQ_API ISA getBestISA();
+
+/** @return the instruction set currently used by the kernels. */
+EQ_API ISA getISA();
+
+/** Select the instruction set, clamped to getBestISA(). Not thread-safe. */
+EQ_API void setISA( const ISA isa );
+
+/**
+ * Depth-composite a row of pixels.
+ *
+ * Each destination pixel is replaced by the source pixel if the source depth
+ * is smaller than the destination depth. Depth values are 32 bit unsigned
+ * integers, color pixels have a size of 4 (RGBA8, RGB10_A2), 8 (RGBA16F) or
+ * 16 (RGBA32F) bytes.
+ */
+EQ_API void mergeDepth( uint8_t* destColor, uint32_t* destDepth,
+                        const uint8_t* color, const uint32_t* depth,
+                        const size_t nPixels, const size_t pixelSize );
+
+/**
+ * Blend a row of premultiplied RGBA pixels onto the destination.
+ *
+ * The result corresponds to
+ * glBlendFuncSeparate( GL_ONE, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA ). 8 bit
+ * channels saturate at 255, floating point channels are not clamped. The
+ * pixel size selects the format: 4 (RGBA8), 8 (RGBA16F) or 16 (RGBA32F).
+ */
+EQ_API void blend( uint8_t* dest, const uint8_t* color, const size_t nPixels,
+                   const size_t pixelSize );
+
+#ifdef EQ_USE_AVX2
+/**
+ * @internal
+ * The AVX2 kernels of compositorKernelsAVX2.cpp, which process whole blocks of
+ * pixels and return the number of processed pixels.
+ */
+namespace avx2
+{
+size_t mergeDepth( uint8_t* destColor, uint32_t* destDepth,
+                   const uint8_t* color, const uint32_t* depth,
+                   const size_t nPixels, const size_t pixelSize );
+size_t blendRGBA8( uint8_t* dest, const uint8_t* color, const size_t nPixels );
+size_t blendRGBA16F( uint8_t* dest, const uint8_t* color,
+                     const size_t nPixels );
+size_t blendRGBA32F( uint8_t* dest, const uint8_t* color,
+                     const size_t nPixels );
+}
+#endif
+
+/** @return true if blend() supports the given pixel size. */
+inline bool canBlend( const size_t pixelSize )
+    { return pixelSize == 4 || pixelSize == 8 || pixelSize == 16; }
+
+/** @return true if mergeDepth() supports the given pixel size. */
+inline bool canMergeDepth( const size_t pixelSize )
+    { return pixelSize == 4 || pixelSize == 8 || pixelSize == 16; }
+}
+}
+}
+
+#endif // EQ_DETAIL_COMPOSITORKERNELS_H
@@ -0,0 +1,218 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// Compiled with AVX2 and F16C code generation, only called after the CPU
+// support has been detected by compositorKernels.cpp.
+
+#ifdef EQ_USE_AVX2
+
+#include "compositorKernels.h"
+
+#include <immintrin.h>
+
+namespace eq
+{
+namespace detail
+{
+namespace kernels
+{
+namespace avx2
+{
+namespace
+{
+/** @return the mask of the pixels where the source is closer. */
+inline __m256i _mergeDepthBlock( uint32_t* destDepth, const uint32_t* depth )
+{
+    // no unsigned compare in AVX2: flip the sign bit and compare signed
+    const __m256i bias = _mm256_set1_epi32( int( 0x80000000u ));
+    __m256i* destDepthIt = reinterpret_cast< __m256i* >( destDepth );
+    const __m256i dst = _mm256_loadu_si256( destDepthIt );
+    const __m256i src =
+        _mm256_loadu_si256( reinterpret_cast< const __m256i* >( depth ));
+    const __m256i mask = _mm256_cmpgt_epi32( _mm256_xor_si256( dst, bias ),
+                                             _mm256_xor_si256( src, bias ));
+    _mm256_storeu_si256( destDepthIt, _mm256_blendv_epi8( dst, src, mask ));
+    return mask;
+}
+
+inline void _selectColor( uint8_t* destColor, const uint8_t* color,
+                          const __m256i mask )
+{
+    __m256i* dstIt = reinterpret_cast< __m256i* >( destColor );
+    const __m256i dst = _mm256_loadu_si256( dstIt );
+    const __m256i src =
+        _mm256_loadu_si256( reinterpret_cast< const __m256i* >( color ));
+    _mm256_storeu_si256( dstIt, _mm256_blendv_epi8( dst, src, mask ));
+}
+
+/** Repeat each of the 8 pixel masks for the 32 bit words of its color. */
+template< size_t size >
+inline void _selectColors( uint8_t* destColor, const uint8_t* color,
+                           const __m256i mask )
+{
+    const size_t nWords = size / 4;
+    for( size_t i = 0; i < nWords; ++i )
+    {
+        int words[8];
+        for( size_t j = 0; j < 8; ++j )
+            words[j] = int(( i * 8 + j ) / nWords );
+        const __m256i index = _mm256_setr_epi32( words[0], words[1], words[2],
+                                                 words[3], words[4], words[5],
+                                                 words[6], words[7] );
+        _selectColor( destColor + i * 32, color + i * 32,
+                      _mm256_permutevar8x32_epi32( mask, index ));
+    }
+}
+
+template< size_t size >
+size_t _mergeDepth( uint8_t* destColor, uint32_t* destDepth,
+                    const uint8_t* color, const uint32_t* depth,
+                    const size_t nPixels )
+{
+    const size_t nBlocks = nPixels / 8;
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        const __m256i mask = _mergeDepthBlock( destDepth, depth );
+        if( size == 4 )
+            _selectColor( destColor, color, mask );
+        else
+            _selectColors< size >( destColor, color, mask );
+
+        destColor += 8 * size;
+        destDepth += 8;
+        color += 8 * size;
+        depth += 8;
+    }
+    return nBlocks * 8;
+}
+
+inline __m256i _blendRGBA8Block( const __m256i src, const __m256i dst )
+{
+    const __m256i rgbMask = _mm256_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1,
+                                              0, -1, -1, -1, 0, -1, -1, -1 );
+    const __m256i alpha = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16( src, _MM_SHUFFLE( 3, 3, 3, 3 )),
+        _MM_SHUFFLE( 3, 3, 3, 3 ));
+
+    // src * dst <= 255*255 fits into 16 bit, shift is logical
+    const __m256i scaled = _mm256_srli_epi16( _mm256_mullo_epi16( alpha, dst ),
+                                              8 );
+    return _mm256_add_epi16( scaled, _mm256_and_si256( src, rgbMask ));
+}
+
+/** Blend premultiplied float pixels, two per register. */
+inline __m256 _blendFloat( const __m256 src, const __m256 dst )
+{
+    const __m256 alpha = _mm256_shuffle_ps( src, src,
+                                            _MM_SHUFFLE( 3, 3, 3, 3 ));
+    // separate multiply and add, a fused multiply-add rounds differently
+    const __m256 scaled = _mm256_mul_ps( alpha, dst );
+    const __m256 sum = _mm256_add_ps( src, scaled );
+
+    // alpha = src.a * dst.a, without adding src.a
+    return _mm256_blend_ps( sum, scaled, 0x88 );
+}
+}
+
+size_t mergeDepth( uint8_t* destColor, uint32_t* destDepth,
+                   const uint8_t* color, const uint32_t* depth,
+                   const size_t nPixels, const size_t pixelSize )
+{
+    switch( pixelSize )
+    {
+      case 4:
+        return _mergeDepth< 4 >( destColor, destDepth, color, depth, nPixels );
+      case 8:
+        return _mergeDepth< 8 >( destColor, destDepth, color, depth, nPixels );
+      case 16:
+        return _mergeDepth< 16 >( destColor, destDepth, color, depth,
+                                  nPixels );
+      default:
+        return 0;
+    }
+}
+
+size_t blendRGBA8( uint8_t* dest, const uint8_t* color, const size_t nPixels )
+{
+    // unpack and pack operate per 128 bit lane, which keeps the pixel order
+    const __m256i zero = _mm256_setzero_si256();
+    const size_t nBlocks = nPixels / 8;
+
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        __m256i* dstIt = reinterpret_cast< __m256i* >( dest );
+        const __m256i src =
+            _mm256_loadu_si256( reinterpret_cast< const __m256i* >( color ));
+        const __m256i dst = _mm256_loadu_si256( dstIt );
+
+        const __m256i low =
+            _blendRGBA8Block( _mm256_unpacklo_epi8( src, zero ),
+                              _mm256_unpacklo_epi8( dst, zero ));
+        const __m256i high =
+            _blendRGBA8Block( _mm256_unpackhi_epi8( src, zero ),
+                              _mm256_unpackhi_epi8( dst, zero ));
+        // saturates color channels at 255
+        _mm256_storeu_si256( dstIt, _mm256_packus_epi16( low, high ));
+
+        dest += 32;
+        color += 32;
+    }
+    return nBlocks * 8;
+}
+
+size_t blendRGBA16F( uint8_t* dest, const uint8_t* color,
+                     const size_t nPixels )
+{
+    const size_t nBlocks = nPixels / 2;
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        __m128i* dstIt = reinterpret_cast< __m128i* >( dest );
+        const __m256 src = _mm256_cvtph_ps(
+            _mm_loadu_si128( reinterpret_cast< const __m128i* >( color )));
+        const __m256 dst = _mm256_cvtph_ps( _mm_loadu_si128( dstIt ));
+
+        _mm_storeu_si128( dstIt, _mm256_cvtps_ph( _blendFloat( src, dst ),
+                                                  _MM_FROUND_TO_NEAREST_INT ));
+        dest += 16;
+        color += 16;
+    }
+    return nBlocks * 2;
+}
+
+size_t blendRGBA32F( uint8_t* dest, const uint8_t* color,
+                     const size_t nPixels )
+{
+    float* dst = reinterpret_cast< float* >( dest );
+    const float* src = reinterpret_cast< const float* >( color );
+
+    const size_t nBlocks = nPixels / 2;
+    for( size_t i = 0; i < nBlocks; ++i )
+    {
+        _mm256_storeu_ps( dst, _blendFloat( _mm256_loadu_ps( src ),
+                                            _mm256_loadu_ps( dst )));
+        src += 8;
+        dst += 8;
+    }
+    return nBlocks * 2;
+}
+}
+}
+}
+}
+
+#endif // EQ_USE_AVX2
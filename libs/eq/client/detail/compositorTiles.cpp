@@ -0,0 +1,240 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compositorTiles.h"
+
+#include "activePixels.h"
+#include "compositorKernels.h"
+#include "workerPool.h"
+
+#include <eq/client/image.h>
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace tiles
+{
+namespace
+{
+// Tiles are bands of full destination rows, with as many rows as needed for
+// 64 KB of destination color and depth. This keeps one tile in the L2 cache
+// while all input images are merged into it, and the kernels run on rows as
+// long as the input images.
+const size_t _tileSize = 64 * 1024;
+
+bool _enabled = true;
+
+/** An input image, positioned relative to the destination. */
+struct Source
+{
+    Operation operation;
+    const uint8_t* color;
+    const uint32_t* depth;
+    const ActivePixels* active; //!< 0 if the active pixels are unknown
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+};
+typedef std::vector< Source > Sources;
+
+class MergeTask : public WorkerPool::Task
+{
+public:
+    MergeTask( const Sources& sources, uint8_t* destColor, uint32_t* destDepth,
+               const PixelViewport& destPVP, const size_t pixelSize,
+               const int32_t tileHeight )
+        : _sources( sources ), _destColor( destColor ), _destDepth( destDepth )
+        , _width( destPVP.w ), _height( destPVP.h ), _pixelSize( pixelSize )
+        , _tileHeight( tileHeight )
+    {}
+
+    size_t getNTiles() const
+        { return ( _height + _tileHeight - 1 ) / _tileHeight; }
+
+    virtual void execute( const size_t index )
+    {
+        const int32_t tileY = int32_t( index ) * _tileHeight;
+        const int32_t tileEndY = std::min( tileY + _tileHeight, _height );
+
+        for( Sources::const_iterator i = _sources.begin();
+             i != _sources.end(); ++i )
+        {
+            const Source& source = *i;
+            const int32_t startX = std::max( 0, source.x );
+            const int32_t endX = std::min( _width, source.x + source.w );
+            const int32_t startY = std::max( tileY, source.y );
+            const int32_t endY = std::min( tileEndY, source.y + source.h );
+
+            for( int32_t y = startY; y < endY; ++y )
+                _mergeRow( source, y - source.y, startX - source.x,
+                           endX - source.x );
+        }
+    }
+
+private:
+    const Sources& _sources;
+    uint8_t* const _destColor;
+    uint32_t* const _destDepth;
+    const int32_t _width;
+    const int32_t _height;
+    const size_t _pixelSize;
+    const int32_t _tileHeight;
+
+    /** Merge the pixels [startX, endX) of the given source row. */
+    void _mergeRow( const Source& source, const int32_t y,
+                    const int32_t startX, const int32_t endX )
+    {
+        if( startX >= endX )
+            return;
+
+        const size_t row = size_t( y ) * source.w;
+        const size_t dest = size_t( source.y + y ) * _width + source.x;
+
+        switch( source.operation )
+        {
+        case OP_DEPTH:
+            if( !source.active )
+            {
+                _mergeDepth( source, row, dest, startX, endX );
+                return;
+            }
+            {
+                const uint32_t* spans = source.active->getSpans( y );
+                const uint32_t nSpans = source.active->getNSpans( y );
+                for( uint32_t i = 0; i < nSpans; ++i )
+                {
+                    const int32_t spanStart = int32_t( spans[ 2*i ] );
+                    const int32_t spanEnd = int32_t( spans[ 2*i + 1 ] );
+                    if( spanStart >= endX )
+                        break;
+
+                    _mergeDepth( source, row, dest,
+                                 std::max( spanStart, startX ),
+                                 std::min( spanEnd, endX ));
+                }
+            }
+            return;
+
+        case OP_BLEND:
+            kernels::blend( _destColor + ( dest + startX ) * _pixelSize,
+                            source.color + ( row + startX ) * _pixelSize,
+                            endX - startX, _pixelSize );
+            return;
+
+        case OP_COPY:
+            memcpy( _destColor + ( dest + startX ) * _pixelSize,
+                    source.color + ( row + startX ) * _pixelSize,
+                    ( endX - startX ) * _pixelSize );
+            // clear depth, for depth-assembly into existing FB
+            if( _destDepth )
+                memset( _destDepth + dest + startX, 0,
+                        ( endX - startX ) * sizeof( uint32_t ));
+            return;
+        }
+    }
+
+    void _mergeDepth( const Source& source, const size_t row,
+                      const size_t dest, const int32_t startX,
+                      const int32_t endX )
+    {
+        if( startX >= endX )
+            return;
+
+        kernels::mergeDepth( _destColor + ( dest + startX ) * _pixelSize,
+                             _destDepth + dest + startX,
+                             source.color + ( row + startX ) * _pixelSize,
+                             source.depth + row + startX, endX - startX,
+                             _pixelSize );
+    }
+};
+}
+
+bool isEnabled()
+{
+    return _enabled;
+}
+
+void setEnabled( const bool enable )
+{
+    _enabled = enable;
+}
+
+void merge( const Inputs& inputs, uint8_t* destColor, uint32_t* destDepth,
+            const PixelViewport& destPVP, const size_t pixelSize )
+{
+    LBASSERT( destColor );
+    if( !destPVP.hasArea( ))
+        return;
+
+    Sources sources;
+    sources.reserve( inputs.size( ));
+    for( Inputs::const_iterator i = inputs.begin(); i != inputs.end(); ++i )
+    {
+        const Input& input = *i;
+        const Image* image = input.image;
+        const PixelViewport& pvp = image->getPixelViewport();
+        LBASSERT( image->getPixelSize( Frame::BUFFER_COLOR ) == pixelSize );
+
+        Source source;
+        source.operation = input.operation;
+        source.color = image->getPixelPointer( Frame::BUFFER_COLOR );
+        source.depth = 0;
+        source.active = 0;
+        source.x = input.offset.x() + pvp.x - destPVP.x;
+        source.y = input.offset.y() + pvp.y - destPVP.y;
+        source.w = pvp.w;
+        source.h = pvp.h;
+
+        if( input.operation == OP_DEPTH )
+        {
+            LBASSERT( destDepth );
+            LBASSERT( kernels::canMergeDepth( pixelSize ));
+            source.depth = reinterpret_cast< const uint32_t* >(
+                image->getPixelPointer( Frame::BUFFER_DEPTH ));
+
+            const ActivePixels& active = image->getActivePixels();
+            if( active.isValid() && active.getWidth() == uint32_t( pvp.w ) &&
+                active.getHeight() == uint32_t( pvp.h ))
+            {
+                source.active = &active;
+            }
+        }
+        else if( input.operation == OP_BLEND )
+        {
+            LBASSERT( kernels::canBlend( pixelSize ));
+        }
+        sources.push_back( source );
+    }
+
+    const size_t rowSize = destPVP.w * ( pixelSize + sizeof( uint32_t ));
+    const int32_t tileHeight = int32_t( std::max( _tileSize / rowSize,
+                                                  size_t( 1 )));
+
+    MergeTask task( sources, destColor, destDepth, destPVP, pixelSize,
+                    tileHeight );
+    WorkerPool::getShared().execute( task, task.getNTiles( ));
+}
+
+}
+}
+}
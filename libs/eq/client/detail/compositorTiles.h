@@ -0,0 +1,85 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_COMPOSITORTILES_H
+#define EQ_DETAIL_COMPOSITORTILES_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Tiled, multi-threaded CPU compositing.
+ *
+ * The destination pixel viewport is partitioned into cache-sized tiles of
+ * full rows, which are processed in parallel by the shared, work-stealing
+ * worker pool. Each tile applies all overlapping input images in the order of
+ * the input list, which produces the same result as merging one image after
+ * another.
+ */
+namespace tiles
+{
+/** The merge operation applied for one input image. */
+enum Operation
+{
+    OP_DEPTH, //!< depth-composite color and depth
+    OP_BLEND, //!< blend premultiplied color
+    OP_COPY   //!< copy color and clear depth
+};
+
+/** One input image of a tiled merge. */
+struct Input
+{
+    Input( const Image* image_, const Vector2i& offset_,
+           const Operation operation_ )
+        : image( image_ ), offset( offset_ ), operation( operation_ ) {}
+
+    const Image* image;
+    Vector2i offset;
+    Operation operation;
+};
+typedef std::vector< Input > Inputs;
+
+/** @return true if the CPU compositor uses tiled merging (default). */
+EQ_API bool isEnabled();
+
+/** Enable or disable tiled merging, e.g., for benchmarks. Not thread-safe. */
+EQ_API void setEnabled( const bool enable );
+
+/**
+ * Merge the input images into the destination buffers.
+ *
+ * @param inputs the input images, in merge order.
+ * @param destColor the destination color buffer.
+ * @param destDepth the destination depth buffer, may be 0 if no input uses
+ *                  OP_DEPTH.
+ * @param destPVP the pixel viewport of the destination buffers.
+ * @param pixelSize the size of one color pixel in bytes.
+ */
+EQ_API void merge( const Inputs& inputs, uint8_t* destColor,
+                   uint32_t* destDepth, const PixelViewport& destPVP,
+                   const size_t pixelSize );
+}
+}
+}
+
+#endif // EQ_DETAIL_COMPOSITORTILES_H
@@ -0,0 +1,300 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compressorSelector.h"
+
+#include "../image.h"
+#include "../log.h"
+
+#include <co/compressorInfo.h>
+#include <co/global.h>
+#include <co/plugin.h>
+#include <co/pluginRegistry.h>
+#include <co/plugins/compressor.h>
+#include <lunchbox/debug.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <limits>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+static const float _weight = .3f; //!< weight of a new sample
+static const float _defaultBandwidth = 128.f * 1024.f; //!< bytes/ms, 1 GBit/s
+
+float _average( const float value, const float sample, const bool first )
+{
+    return first ? sample : value + _weight * ( sample - value );
+}
+
+void _findCandidates( const uint32_t tokenType, const float quality,
+                      std::vector< uint32_t >& names )
+{
+    names.push_back( EQ_COMPRESSOR_NONE );
+
+    const co::PluginRegistry& registry = co::Global::getPluginRegistry();
+    const co::Plugins& plugins = registry.getPlugins();
+    for( co::Plugins::const_iterator i = plugins.begin();
+         i != plugins.end(); ++i )
+    {
+        const co::CompressorInfos& infos = (*i)->getInfos();
+        for( co::CompressorInfosCIter j = infos.begin(); j != infos.end(); ++j )
+        {
+            const co::CompressorInfo& info = *j;
+            if( !( info.capabilities & EQ_COMPRESSOR_TRANSFER ) &&
+                info.tokenType == tokenType && info.quality >= quality )
+            {
+                names.push_back( info.name );
+            }
+        }
+    }
+}
+}
+
+/** The measured performance of one compressor. */
+struct CompressorSelector::Codec
+{
+    Codec() : speed( 0.f ), decompressSpeed( 0.f ), ratio( 1.f )
+            , nSamples( 0 ), nDecompressSamples( 0 ), lastSample( 0 ) {}
+
+    float speed; //!< raw bytes per ms
+    float decompressSpeed; //!< raw bytes per ms, reported by the receiver
+    float ratio; //!< sent bytes per raw byte
+    uint32_t nSamples;
+    uint32_t nDecompressSamples;
+    uint32_t lastSample; //!< frame number of the last sample
+};
+
+/** The compressor selection for one buffer of one link. */
+struct CompressorSelector::Selection
+{
+    Selection() : tokenType( EQ_COMPRESSOR_DATATYPE_NONE ), quality( 0.f )
+                , current( EQ_COMPRESSOR_NONE ), nextEvaluation( 0 )
+                , decide( false ) {}
+
+    typedef std::map< uint32_t, Codec > Codecs;
+
+    uint32_t tokenType; //!< the pixel format of the candidates
+    float quality; //!< the minimum quality of the candidates
+    Codecs codecs; //!< all candidates with their measurements
+    uint32_t current; //!< the selected compressor
+    uint32_t nextEvaluation; //!< frame number of the next evaluation
+    std::vector< uint32_t > probes; //!< candidates to measure before deciding
+    bool decide; //!< select the best candidate on next use
+};
+
+/** The state of one destination node. */
+struct CompressorSelector::Link
+{
+    Link() : bandwidth( _defaultBandwidth ) {}
+
+    float bandwidth; //!< bytes per ms
+    Selection selections[2]; //!< color, depth
+};
+
+CompressorSelector::CompressorSelector( const uint32_t interval )
+        : _interval( LB_MAX( interval, 1u ))
+{}
+
+CompressorSelector::~CompressorSelector()
+{
+    for( Links::const_iterator i = _links.begin(); i != _links.end(); ++i )
+        delete i->second;
+    _links.clear();
+}
+
+void CompressorSelector::setInterval( const uint32_t interval )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    _interval = LB_MAX( interval, 1u );
+}
+
+CompressorSelector::Link& CompressorSelector::_getLink( const uint128_t& node )
+{
+    Links::iterator i = _links.find( node );
+    if( i != _links.end( ))
+        return *i->second;
+
+    Link* link = new Link;
+    _links[ node ] = link;
+    return *link;
+}
+
+uint32_t CompressorSelector::choose( const uint128_t& node, const Image& image,
+                                     const Frame::Buffer buffer,
+                                     const uint32_t frameNumber,
+                                     const int32_t bandwidth )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    Link& link = _getLink( node );
+    link.bandwidth = bandwidth > 0 ? float( bandwidth ) * 1.024f :
+                                     _defaultBandwidth;
+
+    Selection& selection =
+        link.selections[ buffer == Frame::BUFFER_COLOR ? 0 : 1 ];
+    const uint32_t tokenType = image.getExternalFormat( buffer );
+    const float quality = image.getQuality( buffer );
+    if( selection.tokenType != tokenType || selection.quality != quality )
+    {
+        selection = Selection();
+        selection.tokenType = tokenType;
+        selection.quality = quality;
+    }
+
+    if( selection.probes.empty() && !selection.decide &&
+        frameNumber >= selection.nextEvaluation )
+    {
+        _startEvaluation( selection, frameNumber );
+    }
+
+    if( !selection.probes.empty( ))
+    {
+        const uint32_t name = selection.probes.back();
+        selection.probes.pop_back();
+        selection.decide = selection.probes.empty();
+        return name;
+    }
+
+    if( selection.decide )
+    {
+        selection.current = _findBest( link, selection );
+        selection.decide = false;
+        LBLOG( LOG_ASSEMBLY ) << "Selected compressor 0x" << std::hex
+                              << selection.current << std::dec
+                              << " for buffer " << unsigned( buffer )
+                              << " to " << node << std::endl;
+    }
+    return selection.current;
+}
+
+void CompressorSelector::_startEvaluation( Selection& selection,
+                                           const uint32_t frameNumber ) const
+{
+    selection.nextEvaluation = frameNumber + _interval;
+
+    if( selection.codecs.empty( ))
+    {
+        std::vector< uint32_t > names;
+        _findCandidates( selection.tokenType, selection.quality, names );
+        for( std::vector< uint32_t >::const_iterator i = names.begin();
+             i != names.end(); ++i )
+        {
+            selection.codecs[ *i ] = Codec();
+        }
+        selection.probes = names;
+        return;
+    }
+
+    // the current compressor is measured continuously, probe the stalest other
+    uint32_t probe = selection.current;
+    uint32_t oldest = std::numeric_limits< uint32_t >::max();
+    for( Selection::Codecs::const_iterator i = selection.codecs.begin();
+         i != selection.codecs.end(); ++i )
+    {
+        if( i->first != selection.current && i->second.lastSample < oldest )
+        {
+            probe = i->first;
+            oldest = i->second.lastSample;
+        }
+    }
+    selection.probes.push_back( probe );
+}
+
+uint32_t CompressorSelector::_findBest( const Link& link,
+                                        const Selection& selection ) const
+{
+    uint32_t best = selection.current;
+    float bestCost = std::numeric_limits< float >::max();
+
+    for( Selection::Codecs::const_iterator i = selection.codecs.begin();
+         i != selection.codecs.end(); ++i )
+    {
+        const Codec& codec = i->second;
+        if( codec.nSamples == 0 || codec.speed <= 0.f )
+            continue;
+
+        // time per raw byte: compress, send and decompress
+        float cost = 1.f / codec.speed + codec.ratio / link.bandwidth;
+        if( i->first != EQ_COMPRESSOR_NONE )
+            cost += 1.f / ( codec.nDecompressSamples > 0 ?
+                            codec.decompressSpeed : codec.speed );
+        if( cost < bestCost )
+        {
+            best = i->first;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+void CompressorSelector::addCompressSample( const uint128_t& node,
+                                            const Frame::Buffer buffer,
+                                            const uint32_t name,
+                                            const uint64_t rawSize,
+                                            const uint64_t size,
+                                            const float time,
+                                            const uint32_t frameNumber )
+{
+    if( rawSize == 0 )
+        return;
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    Selection& selection =
+        _getLink( node ).selections[ buffer == Frame::BUFFER_COLOR ? 0 : 1 ];
+    Selection::Codecs::iterator i = selection.codecs.find( name );
+    if( i == selection.codecs.end( )) // not a candidate
+        return;
+
+    Codec& codec = i->second;
+    const bool first = codec.nSamples == 0;
+    // clamp to the timer resolution
+    const float speed = float( rawSize ) / LB_MAX( time, .001f );
+    codec.speed = _average( codec.speed, speed, first );
+    codec.ratio = _average( codec.ratio, float( size ) / float( rawSize ),
+                            first );
+    codec.lastSample = frameNumber;
+    ++codec.nSamples;
+}
+
+void CompressorSelector::addDecompressSample( const uint128_t& node,
+                                              const Frame::Buffer buffer,
+                                              const uint32_t name,
+                                              const uint64_t rawSize,
+                                              const float time )
+{
+    if( rawSize == 0 )
+        return;
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    Selection& selection =
+        _getLink( node ).selections[ buffer == Frame::BUFFER_COLOR ? 0 : 1 ];
+    Selection::Codecs::iterator i = selection.codecs.find( name );
+    if( i == selection.codecs.end( )) // not a candidate
+        return;
+
+    Codec& codec = i->second;
+    const float speed = float( rawSize ) / LB_MAX( time, .001f );
+    codec.decompressSpeed = _average( codec.decompressSpeed, speed,
+                                      codec.nDecompressSamples == 0 );
+    ++codec.nDecompressSamples;
+}
+
+}
+}
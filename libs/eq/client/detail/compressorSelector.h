@@ -0,0 +1,133 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_COMPRESSORSELECTOR_H
+#define EQ_DETAIL_COMPRESSORSELECTOR_H
+
+#include <eq/client/api.h>
+#include <eq/client/frame.h> // Frame::Buffer enum
+#include <eq/client/types.h>
+
+#include <lunchbox/lock.h>
+#include <lunchbox/nonCopyable.h>
+
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Selects the image compressor with the lowest transfer latency per link.
+ *
+ * The selector uses the configured bandwidth of the link to each destination
+ * node, since the time to hand data to a buffered connection does not measure
+ * the link. It keeps the compression speed and ratio of each compressor for
+ * each node and frame buffer, and the decompression speed reported by the
+ * node. The estimated latency per raw byte of a compressor is the time to
+ * compress, send and decompress it. Until the node reported a decompression,
+ * decompression is assumed to be as fast as compression. EQ_COMPRESSOR_NONE is
+ * a candidate with the cost of sending the data, packed into active pixels if
+ * sparse.
+ *
+ * Initially, each candidate is used for one transmission to measure it. Every
+ * interval frames, the candidate measured least recently is probed again for
+ * one transmission before the best one is selected. All estimates are
+ * exponentially weighted averages of the samples.
+ */
+class CompressorSelector : public lunchbox::NonCopyable
+{
+public:
+    /**
+     * Construct a new compressor selector.
+     *
+     * @param interval the number of frames between re-evaluations.
+     */
+    EQ_API explicit CompressorSelector( const uint32_t interval = 50 );
+
+    /** Destruct the selector. */
+    EQ_API ~CompressorSelector();
+
+    /** Set the number of frames between re-evaluations. */
+    EQ_API void setInterval( const uint32_t interval );
+
+    /**
+     * @return the compressor to use for an image buffer sent to a node.
+     *
+     * @param node the destination node.
+     * @param image the image to send.
+     * @param buffer the frame buffer attachment.
+     * @param frameNumber the current frame number.
+     * @param bandwidth the configured bandwidth of the link in KB/s, or 0 for
+     *                  the default of 1 GBit/s.
+     */
+    EQ_API uint32_t choose( const uint128_t& node, const Image& image,
+                            const Frame::Buffer buffer,
+                            const uint32_t frameNumber,
+                            const int32_t bandwidth );
+
+    /**
+     * Add the measurement of compressing an image buffer.
+     *
+     * @param node the destination node.
+     * @param buffer the frame buffer attachment.
+     * @param name the compressor, EQ_COMPRESSOR_NONE for packing.
+     * @param rawSize the uncompressed size in bytes.
+     * @param size the compressed size in bytes.
+     * @param time the compression time in milliseconds.
+     * @param frameNumber the current frame number.
+     */
+    EQ_API void addCompressSample( const uint128_t& node,
+                                   const Frame::Buffer buffer,
+                                   const uint32_t name, const uint64_t rawSize,
+                                   const uint64_t size, const float time,
+                                   const uint32_t frameNumber );
+
+    /**
+     * Add the measurement of decompressing an image buffer on a node.
+     *
+     * @param node the node which decompressed the buffer.
+     * @param buffer the frame buffer attachment.
+     * @param name the compressor.
+     * @param rawSize the uncompressed size in bytes.
+     * @param time the decompression time in milliseconds.
+     */
+    EQ_API void addDecompressSample( const uint128_t& node,
+                                     const Frame::Buffer buffer,
+                                     const uint32_t name,
+                                     const uint64_t rawSize, const float time );
+
+private:
+    struct Codec;
+    struct Selection;
+    struct Link;
+    typedef std::map< uint128_t, Link* > Links;
+
+    uint32_t _interval;
+    Links _links;
+    mutable lunchbox::Lock _lock;
+
+    Link& _getLink( const uint128_t& node );
+    void _startEvaluation( Selection& selection,
+                           const uint32_t frameNumber ) const;
+    uint32_t _findBest( const Link& link, const Selection& selection ) const;
+};
+}
+}
+
+#endif // EQ_DETAIL_COMPRESSORSELECTOR_H
@@ -0,0 +1,140 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "decompressPool.h"
+
+#include "workerPool.h"
+#include "../node.h"
+#include "../nodeStatistics.h"
+
+#include <lunchbox/debug.h>
+#include <lunchbox/thread.h>
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _MSC_VER
+#  define snprintf _snprintf
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Queue at most this many jobs per worker before throttling the caller
+const int32_t _maxQueuedPerWorker = 4;
+}
+
+class DecompressPool::Worker : public lunchbox::Thread
+{
+public:
+    Worker( DecompressPool& pool, const size_t index )
+        : _pool( pool ), _index( index ) {}
+
+protected:
+    virtual void run()
+    {
+        lunchbox::Thread::setName( std::string( "Dec " ) +
+                                   lunchbox::className( _pool._node ));
+        while( true )
+        {
+            Job* job = _pool._queue.pop();
+            if( !job )
+                return; // exit thread
+
+            --_pool._nQueued;
+            _pool._execute( job, _index );
+        }
+    }
+
+private:
+    DecompressPool& _pool;
+    const size_t _index;
+};
+
+DecompressPool::DecompressPool( Node* node, const size_t nThreads )
+        : _node( node )
+        , _nThreads( nThreads ? nThreads : WorkerPool::getNCores( ))
+        , _nQueued( 0 )
+{}
+
+DecompressPool::~DecompressPool()
+{
+    for( size_t i = 0; i < _workers.size(); ++i )
+        _queue.push( 0 ); // wake up to exit
+
+    for( std::vector< Worker* >::const_iterator i = _workers.begin();
+         i != _workers.end(); ++i )
+    {
+        Worker* worker = *i;
+        worker->join();
+        delete worker;
+    }
+    _workers.clear();
+}
+
+void DecompressPool::push( Job* job )
+{
+    if( _workers.empty( ))
+    {
+        for( size_t i = 0; i < _nThreads; ++i )
+        {
+            Worker* worker = new Worker( *this, i + 1 );
+            if( !worker->start( ))
+            {
+                LBWARN << "Could not start decompression thread" << std::endl;
+                delete worker;
+                break;
+            }
+            _workers.push_back( worker );
+        }
+    }
+
+    if( _workers.empty() ||
+        _nQueued >= int32_t( _workers.size( )) * _maxQueuedPerWorker )
+    {
+        _execute( job, 0 );
+        return;
+    }
+
+    ++_nQueued;
+    _queue.push( job );
+}
+
+void DecompressPool::_execute( Job* job, const size_t worker )
+{
+    {
+        NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS, _node,
+                              job->getFrameNumber( ));
+        if( worker > 0 ) // distinguish the workers, the caller is the node
+        {
+            char* name = event.event.statistic.resourceName;
+            const size_t length = strlen( name );
+            if( length < 28 )
+                snprintf( name + length, 32 - length, " %u",
+                          unsigned( worker ));
+            name[31] = 0;
+        }
+        job->run( event.event.statistic );
+    }
+    delete job;
+}
+
+}
+}
@@ -0,0 +1,94 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_DECOMPRESSPOOL_H
+#define EQ_DETAIL_DECOMPRESSPOOL_H
+
+#include <eq/client/types.h>
+
+#include <lunchbox/atomic.h>
+#include <lunchbox/mtQueue.h>
+#include <lunchbox/nonCopyable.h>
+
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Decompresses received image data on a pool of threads of a node.
+ *
+ * Jobs are queued by the node command thread and executed in arrival order
+ * by the first idle worker, so that the images from many source channels are
+ * decompressed in parallel. Each job is sampled as a NODE_FRAME_DECOMPRESS
+ * statistic of the executing worker. When too many jobs are queued, the
+ * caller executes the job itself, which throttles the receiving side.
+ */
+class DecompressPool : public lunchbox::NonCopyable
+{
+public:
+    /** A decompression job, deleted after its execution. */
+    class Job
+    {
+    public:
+        explicit Job( const uint32_t frameNumber )
+            : _frameNumber( frameNumber ) {}
+        virtual ~Job() {}
+
+        /**
+         * Decompress the data.
+         * @param statistic the NODE_FRAME_DECOMPRESS sample of the job.
+         */
+        virtual void run( Statistic& statistic ) = 0;
+
+        /** @return the frame number for the statistics. */
+        uint32_t getFrameNumber() const { return _frameNumber; }
+
+    private:
+        const uint32_t _frameNumber;
+    };
+
+    /**
+     * Construct a new decompression pool.
+     *
+     * @param node the node sampling the statistics.
+     * @param nThreads the number of worker threads, 0 for one per core.
+     */
+    explicit DecompressPool( Node* node, const size_t nThreads = 0 );
+
+    /** Execute all queued jobs and join the worker threads. */
+    ~DecompressPool();
+
+    /** Queue a job, or execute it directly if the queue is full. */
+    void push( Job* job );
+
+private:
+    class Worker;
+
+    Node* const _node;
+    const size_t _nThreads;
+    lunchbox::MTQueue< Job* > _queue;
+    lunchbox::a_int32_t _nQueued;
+    std::vector< Worker* > _workers;
+
+    void _execute( Job* job, const size_t worker );
+};
+}
+}
+
+#endif // EQ_DETAIL_DECOMPRESSPOOL_H
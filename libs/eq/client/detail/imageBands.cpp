@@ -0,0 +1,105 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "imageBands.h"
+
+#include <eq/client/image.h>
+#include <eq/client/pixelData.h>
+#include <eq/fabric/zoom.h>
+#include <co/plugins/compressor.h>
+
+namespace eq
+{
+namespace detail
+{
+namespace bands
+{
+namespace
+{
+static const Frame::Buffer _buffers[] = { Frame::BUFFER_COLOR,
+                                          Frame::BUFFER_DEPTH };
+
+/** Raw bytes per band. */
+static const uint64_t _bandSize = 1024 * 1024;
+static const int32_t _minBandRows = 16;
+}
+
+uint32_t getNBands( const Image& image, const uint32_t compressors[2] )
+{
+    if( compressors[0] == EQ_COMPRESSOR_NONE &&
+        compressors[1] == EQ_COMPRESSOR_NONE )
+    {
+        return 1; // nothing to overlap with the send
+    }
+    if( image.getZoom() != Zoom::NONE )
+        return 1;
+
+    // bands reference rows of the pixel data, which needs to match the image
+    const PixelViewport& pvp = image.getPixelViewport();
+    uint64_t rowSize = 0;
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        if( !image.hasPixelData( _buffers[i] ))
+            continue;
+
+        const PixelData& data = image.getPixelData( _buffers[i] );
+        if( !data.pixels || data.pvp.w != pvp.w || data.pvp.h != pvp.h )
+            return 1;
+        rowSize += uint64_t( pvp.w ) * data.pixelSize;
+    }
+    if( rowSize == 0 )
+        return 1;
+
+    const int32_t rows = LB_MAX( _minBandRows, int32_t( _bandSize / rowSize ));
+    return uint32_t( ( pvp.h + rows - 1 ) / rows );
+}
+
+void setBand( const Image& image, Image& band, const int32_t y,
+              const int32_t h )
+{
+    PixelViewport pvp = image.getPixelViewport();
+    pvp.y += y;
+    pvp.h = h;
+    band.setPixelViewport( pvp );
+    band.setAlphaUsage( image.getAlphaUsage( ));
+
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = _buffers[i];
+        if( !image.hasPixelData( buffer ))
+            continue;
+
+        const PixelData& data = image.getPixelData( buffer );
+        PixelData rows;
+        rows.internalFormat = data.internalFormat;
+        rows.externalFormat = data.externalFormat;
+        rows.pixelSize = data.pixelSize;
+        rows.pvp = data.pvp;
+        rows.pvp.y += y;
+        rows.pvp.h = h;
+        rows.pixels = reinterpret_cast< uint8_t* >( data.pixels ) +
+                      uint64_t( y ) * data.pvp.w * data.pixelSize;
+        rows.compressorName = EQ_COMPRESSOR_NONE;
+
+        band.setQuality( buffer, image.getQuality( buffer ));
+        band.setPixelData( buffer, rows, false /* reference */ );
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,64 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_IMAGEBANDS_H
+#define EQ_DETAIL_IMAGEBANDS_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Banded image transmission.
+ *
+ * Large, compressed images are transmitted in bands of full rows. The sender
+ * compresses the next band while the current one is sent, and the receivers
+ * decompress each band on arrival and assemble the bands into one image before
+ * the frame data becomes ready.
+ */
+namespace bands
+{
+/**
+ * @return the number of bands to transmit the image in.
+ *
+ * Images are sent whole, i.e., in one band, if no buffer is compressed since
+ * there is no compression to overlap with the send, if the image is zoomed,
+ * or if its pixel data does not cover the image pixel viewport.
+ *
+ * @param image the image to transmit.
+ * @param compressors the compressor names for the color and depth buffer.
+ */
+EQ_API uint32_t getNBands( const Image& image, const uint32_t compressors[2] );
+
+/**
+ * Set up an image referencing rows of the pixel data of another image.
+ *
+ * @param image the image to transmit.
+ * @param band the image to set up as the band.
+ * @param y the first row of the band, relative to the image.
+ * @param h the number of rows of the band.
+ */
+EQ_API void setBand( const Image& image, Image& band, const int32_t y,
+                     const int32_t h );
+}
+}
+}
+
+#endif // EQ_DETAIL_IMAGEBANDS_H
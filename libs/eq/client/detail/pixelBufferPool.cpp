@@ -0,0 +1,189 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pixelBufferPool.h"
+
+#include <lunchbox/debug.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#  include <malloc.h>
+#else
+#  include <sys/mman.h>
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+static const size_t _minCapacity = 64 * 1024;
+static const size_t _alignment = 64; // cache line, SIMD compositing kernels
+static const size_t _hugePageSize = 2 * 1024 * 1024;
+// huge-page alignment wastes at most 25% of the buffers using it
+static const size_t _minHugePageCapacity = 4 * _hugePageSize;
+static const uint64_t _defaultMaxCachedSize = 512ull * 1024 * 1024;
+
+void* _allocate( const size_t capacity )
+{
+    void* buffer = 0;
+#ifdef _WIN32
+    buffer = _aligned_malloc( capacity, _alignment );
+#else
+    const size_t alignment = capacity >= _minHugePageCapacity ?
+                             _hugePageSize : _alignment;
+    if( posix_memalign( &buffer, alignment, capacity ) != 0 )
+        buffer = 0;
+#  ifdef MADV_HUGEPAGE
+    else if( alignment == _hugePageSize )
+        madvise( buffer, capacity, MADV_HUGEPAGE ); // best effort
+#  endif
+#endif
+    if( !buffer )
+        throw std::bad_alloc();
+    return buffer;
+}
+
+void _free( void* buffer )
+{
+#ifdef _WIN32
+    _aligned_free( buffer );
+#else
+    free( buffer );
+#endif
+}
+}
+
+PixelBufferPool& PixelBufferPool::getInstance()
+{
+    // Never destroyed, since static images, e.g., the compositor result images,
+    // may release their buffers during static destruction.
+    static PixelBufferPool* instance = new PixelBufferPool;
+    return *instance;
+}
+
+PixelBufferPool::PixelBufferPool()
+        : _maxCachedSize( _defaultMaxCachedSize )
+{}
+
+PixelBufferPool::~PixelBufferPool()
+{
+    trim();
+}
+
+size_t PixelBufferPool::getCapacity( const size_t size )
+{
+    if( size <= _minCapacity )
+        return _minCapacity;
+
+    size_t power = _minCapacity;
+    while( power * 2 < size )
+        power *= 2;
+
+    // four size classes in ]power, 2*power], wasting at most 25%
+    const size_t step = power / 4;
+    return ( size + step - 1 ) / step * step;
+}
+
+void* PixelBufferPool::acquire( const size_t size )
+{
+    const size_t capacity = getCapacity( size );
+    {
+        lunchbox::ScopedMutex<> mutex( _lock );
+        BufferMap::iterator i = _cache.find( capacity );
+        if( i != _cache.end() && !i->second.empty( ))
+        {
+            void* buffer = i->second.back();
+            i->second.pop_back();
+            _stats.cachedSize -= capacity;
+            ++_stats.hits;
+            return buffer;
+        }
+        ++_stats.misses;
+        _stats.residentSize += capacity;
+    }
+
+    try
+    {
+        return _allocate( capacity );
+    }
+    catch( ... )
+    {
+        lunchbox::ScopedMutex<> mutex( _lock );
+        _stats.residentSize -= capacity;
+        throw;
+    }
+}
+
+void PixelBufferPool::release( void* buffer, const size_t size )
+{
+    if( !buffer )
+        return;
+
+    const size_t capacity = getCapacity( size );
+    {
+        lunchbox::ScopedMutex<> mutex( _lock );
+        if( _stats.cachedSize + capacity <= _maxCachedSize )
+        {
+            _cache[ capacity ].push_back( buffer );
+            _stats.cachedSize += capacity;
+            return;
+        }
+        LBASSERT( _stats.residentSize >= capacity );
+        _stats.residentSize -= capacity;
+    }
+    _free( buffer );
+}
+
+void PixelBufferPool::setMaxCachedSize( const uint64_t size )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    _maxCachedSize = size;
+}
+
+void PixelBufferPool::trim()
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    for( BufferMap::const_iterator i = _cache.begin(); i != _cache.end(); ++i )
+    {
+        const Buffers& buffers = i->second;
+        for( Buffers::const_iterator j = buffers.begin(); j != buffers.end();
+             ++j )
+        {
+            _free( *j );
+        }
+        _stats.residentSize -= buffers.size() * i->first;
+    }
+    _cache.clear();
+    _stats.cachedSize = 0;
+}
+
+PixelBufferPool::Statistics PixelBufferPool::sample()
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    const Statistics stats = _stats;
+    _stats.hits = 0;
+    _stats.misses = 0;
+    return stats;
+}
+
+}
+}
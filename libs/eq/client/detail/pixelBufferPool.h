@@ -0,0 +1,94 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_PIXELBUFFERPOOL_H
+#define EQ_DETAIL_PIXELBUFFERPOOL_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <lunchbox/lock.h>
+#include <lunchbox/nonCopyable.h>
+
+#include <map>
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * A process-wide cache of image pixel buffers.
+ *
+ * Requests are rounded up to a size class, with four classes per power of
+ * two, so that buffers can be reused when the image size changes slightly
+ * from frame to frame. Released buffers are kept for reuse up to a maximum
+ * cached size. Buffers of at least four huge pages are huge-page aligned and
+ * advised for transparent huge pages where available.
+ */
+class PixelBufferPool : public lunchbox::NonCopyable
+{
+public:
+    /** The usage counters of the pool. */
+    struct Statistics
+    {
+        Statistics() : hits( 0 ), misses( 0 ), residentSize( 0 )
+                     , cachedSize( 0 ) {}
+
+        uint64_t hits; //!< acquires served from the cache
+        uint64_t misses; //!< acquires which allocated a new buffer
+        uint64_t residentSize; //!< allocated bytes, used and cached
+        uint64_t cachedSize; //!< allocated bytes available for reuse
+    };
+
+    /** @return the pool of this process. */
+    EQ_API static PixelBufferPool& getInstance();
+
+    /** @return the size of the buffer returned for the given request. */
+    EQ_API static size_t getCapacity( const size_t size );
+
+    /** @return a buffer of getCapacity( size ) bytes. */
+    EQ_API void* acquire( const size_t size );
+
+    /** Return a buffer acquired with the given size to the pool. */
+    EQ_API void release( void* buffer, const size_t size );
+
+    /** Set the maximum size of the unused buffers kept for reuse. */
+    EQ_API void setMaxCachedSize( const uint64_t size );
+
+    /** Free all unused buffers. */
+    EQ_API void trim();
+
+    /** @return the counters, with the hits and misses since the last call. */
+    EQ_API Statistics sample();
+
+private:
+    PixelBufferPool();
+    ~PixelBufferPool();
+
+    typedef std::vector< void* > Buffers;
+    typedef std::map< size_t, Buffers > BufferMap;
+
+    lunchbox::Lock _lock;
+    BufferMap _cache; //!< unused buffers by capacity
+    uint64_t _maxCachedSize;
+    Statistics _stats;
+};
+}
+}
+
+#endif // EQ_DETAIL_PIXELBUFFERPOOL_H
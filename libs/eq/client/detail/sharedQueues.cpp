@@ -0,0 +1,84 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "sharedQueues.h"
+
+#include <co/localNode.h>
+#include <co/queueSlave.h>
+#include <lunchbox/scopedMutex.h>
+
+namespace eq
+{
+namespace detail
+{
+struct SharedQueues::Queue
+{
+    explicit Queue( const int32_t prefetch )
+        : slave( prefetch > 0 ? uint32_t( prefetch ) / 2 : // refill at half
+                                LB_UNDEFINED_UINT32,
+                 prefetch > 0 ? uint32_t( prefetch ) : LB_UNDEFINED_UINT32 )
+    {}
+
+    co::QueueSlave slave;
+    lunchbox::Lock lock; //!< serializes pop()
+};
+
+SharedQueues::SharedQueues()
+{}
+
+SharedQueues::~SharedQueues()
+{
+    LBASSERTINFO( _queues->empty(), "Shared queues were not flushed" );
+}
+
+co::ObjectICommand SharedQueues::pop( co::LocalNodePtr node,
+                                      const UUID& queueID,
+                                      const int32_t prefetch )
+{
+    LBASSERT( queueID != UUID::ZERO );
+    Queue* queue = 0;
+    {
+        lunchbox::ScopedWrite mutex( _queues );
+        Queue*& entry = _queues.data[ queueID ];
+        if( !entry )
+        {
+            entry = new Queue( prefetch );
+            LBCHECK( node->mapObject( &entry->slave, queueID ));
+        }
+        queue = entry;
+    }
+
+    lunchbox::ScopedWrite mutex( queue->lock );
+    return queue->slave.pop();
+}
+
+void SharedQueues::flush( co::LocalNodePtr node )
+{
+    lunchbox::ScopedWrite mutex( _queues );
+    for( QueueMap::const_iterator i = _queues->begin(); i != _queues->end();
+         ++i )
+    {
+        Queue* queue = i->second;
+        node->unmapObject( &queue->slave );
+        delete queue;
+    }
+    _queues->clear();
+}
+
+}
+}
@@ -0,0 +1,76 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef EQ_DETAIL_SHAREDQUEUES_H
+#define EQ_DETAIL_SHAREDQUEUES_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <co/objectICommand.h>
+#include <lunchbox/lockable.h>
+#include <lunchbox/nonCopyable.h>
+
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * The tile queues used by all channels of a node.
+ *
+ * Each queue is mapped once per node, and all channels popping from it share
+ * the tiles prefetched from the queue master. A channel done with its own tiles
+ * thereby takes over the tiles prefetched, but not yet rendered, by the other
+ * channels of the node. Tiles prefetched by another node are not shared, which
+ * bounds the imbalance between nodes by the prefetch window.
+ */
+class SharedQueues : public lunchbox::NonCopyable
+{
+public:
+    EQ_API SharedQueues();
+    EQ_API ~SharedQueues();
+
+    /**
+     * Pop the next item of a queue.
+     *
+     * The queue is mapped by the given node on first use. Concurrent callers
+     * are serialized per queue.
+     *
+     * @param node the node mapping the queue.
+     * @param queueID the identifier of the queue master.
+     * @param prefetch the number of items requested ahead, or AUTO for the
+     *                 Collage default. Only used when the queue is mapped.
+     * @return the next item, or an invalid command if the queue is empty.
+     */
+    EQ_API co::ObjectICommand pop( co::LocalNodePtr node, const UUID& queueID,
+                                   const int32_t prefetch );
+
+    /** Unmap and delete all queues. */
+    EQ_API void flush( co::LocalNodePtr node );
+
+private:
+    struct Queue;
+    typedef std::map< UUID, Queue* > QueueMap;
+    lunchbox::Lockable< QueueMap > _queues;
+};
+}
+}
+
+#endif // EQ_DETAIL_SHAREDQUEUES_H
@@ -0,0 +1,239 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_STATISTICSBATCH_H
+#define EQ_DETAIL_STATISTICSBATCH_H
+
+#include <eq/client/statistic.h>
+#include <eq/client/types.h>
+
+#include <lunchbox/debug.h>
+
+#include <cstring>
+#include <map>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * The compact wire format of the statistics of one entity and frame.
+ *
+ * Entities accumulate their statistics per frame and send them in one batch
+ * when the frame is finished, instead of one event per statistic. The resource
+ * names are interned in a table of the batch, and the start times are encoded
+ * relative to the previous statistic with the duration of the operation.
+ *
+ * The streams are template parameters to test the encoding without a
+ * connection.
+ */
+class StatisticsBatch
+{
+public:
+    /** Write the statistics, which all belong to the same frame. */
+    template< class O >
+    static void write( O& os, const Statistics& statistics );
+
+    /**
+     * Read statistics written by write() and append them.
+     *
+     * @return false if the batch is truncated, or has unknown statistic types
+     *         or resource names, the statistics are left unchanged then.
+     */
+    template< class I > static bool read( I& is, Statistics& statistics );
+
+private:
+    /** @return true if the statistic stores a time span. */
+    static bool _hasTimes( const Statistic::Type type )
+        { return type != Statistic::WINDOW_FPS && type != Statistic::PIPE_IDLE;}
+
+    /** type, name index, task, plugins, ratio and two 32 bit times */
+    static uint64_t _getMinSize() { return 1 + 2 + 4 + 2 * 4 + 4 + 2 * 4; }
+};
+
+template< class O >
+void StatisticsBatch::write( O& os, const Statistics& statistics )
+{
+    const uint32_t nStatistics = uint32_t( statistics.size( ));
+    os << nStatistics;
+    if( nStatistics == 0 )
+        return;
+
+    // intern resource names
+    typedef std::map< std::string, uint16_t > NameMap;
+    NameMap nameMap;
+    Strings names;
+    std::vector< uint16_t > indices;
+    indices.reserve( nStatistics );
+
+    for( StatisticsCIter i = statistics.begin(); i != statistics.end(); ++i )
+    {
+        const std::string name( i->resourceName,
+                                strnlen( i->resourceName, 32 ));
+        NameMap::const_iterator j = nameMap.find( name );
+        if( j == nameMap.end( ))
+        {
+            LBASSERT( names.size() < 0xffffu );
+            j = nameMap.insert( std::make_pair( name,
+                                                uint16_t( names.size( )))).first;
+            names.push_back( name );
+        }
+        indices.push_back( j->second );
+    }
+
+    const Statistic& first = statistics.front();
+    os << first.frameNumber << uint16_t( names.size( ));
+    for( StringsCIter i = names.begin(); i != names.end(); ++i )
+    {
+        // names have at most 31 characters
+        os << uint8_t( i->size( ));
+        for( std::string::const_iterator j = i->begin(); j != i->end(); ++j )
+            os << *j;
+    }
+    os << first.startTime;
+
+    int64_t time = first.startTime;
+    for( size_t i = 0; i < nStatistics; ++i )
+    {
+        const Statistic& statistic = statistics[i];
+        LBASSERTINFO( statistic.frameNumber == first.frameNumber,
+                      statistic.frameNumber << " != " << first.frameNumber );
+
+        os << uint8_t( statistic.type ) << indices[i] << statistic.task
+           << statistic.plugins[0] << statistic.plugins[1] << statistic.ratio;
+
+        if( _hasTimes( statistic.type ))
+        {
+            // time deltas within a frame fit easily into 32 bits
+            os << int32_t( statistic.startTime - time )
+               << int32_t( statistic.endTime - statistic.startTime );
+            time = statistic.startTime;
+        }
+        else
+            os << statistic.startTime << statistic.endTime;
+    }
+}
+
+template< class I >
+bool StatisticsBatch::read( I& is, Statistics& statistics )
+{
+    uint32_t nStatistics = 0;
+    is >> nStatistics;
+    if( nStatistics == 0 )
+        return true;
+
+    // frame number, name count, at least the name sizes and the start time
+    const uint64_t headerSize = 4 + 2 + 8;
+    if( uint64_t( nStatistics ) * _getMinSize() + headerSize >
+        is.getRemainingBufferSize( ))
+    {
+        LBWARN << "Truncated statistics batch of " << nStatistics
+               << " statistics" << std::endl;
+        return false;
+    }
+
+    uint32_t frameNumber = 0;
+    uint16_t nNames = 0;
+    is >> frameNumber >> nNames;
+    if( uint64_t( nNames ) + 8 > is.getRemainingBufferSize( ))
+    {
+        LBWARN << "Truncated name table of " << nNames << " names in "
+               << "statistics batch" << std::endl;
+        return false;
+    }
+
+    Strings names( nNames );
+    for( uint16_t i = 0; i < nNames; ++i )
+    {
+        uint8_t size = 0;
+        is >> size;
+        if( uint64_t( size ) + 8 > is.getRemainingBufferSize( ))
+        {
+            LBWARN << "Truncated name of " << unsigned( size )
+                   << " characters in statistics batch" << std::endl;
+            return false;
+        }
+
+        names[i].resize( size );
+        for( uint8_t j = 0; j < size; ++j )
+            is >> names[i][j];
+    }
+
+    int64_t time = 0;
+    is >> time;
+
+    Statistics batch;
+    batch.reserve( nStatistics );
+    for( uint32_t i = 0; i < nStatistics; ++i )
+    {
+        if( is.getRemainingBufferSize() < _getMinSize( ))
+        {
+            LBWARN << "Truncated statistics batch of " << nStatistics
+                   << " statistics" << std::endl;
+            return false;
+        }
+
+        Statistic statistic;
+        uint8_t type = 0;
+        uint16_t index = 0;
+        is >> type >> index >> statistic.task >> statistic.plugins[0]
+           >> statistic.plugins[1] >> statistic.ratio;
+
+        if( type == Statistic::NONE || type >= Statistic::ALL )
+        {
+            LBWARN << "Unknown statistic type " << unsigned( type )
+                   << " in statistics batch" << std::endl;
+            return false;
+        }
+        if( index >= names.size( ))
+        {
+            LBWARN << "Unknown name " << index << " of " << names.size()
+                   << " in statistics batch" << std::endl;
+            return false;
+        }
+
+        statistic.type = Statistic::Type( type );
+        statistic.frameNumber = frameNumber;
+        if( _hasTimes( statistic.type ))
+        {
+            int32_t start = 0;
+            int32_t duration = 0;
+            is >> start >> duration;
+            time += start;
+            statistic.startTime = time;
+            statistic.endTime = time + duration;
+        }
+        else if( is.getRemainingBufferSize() < 2 * 8 )
+        {
+            LBWARN << "Truncated statistics batch of " << nStatistics
+                   << " statistics" << std::endl;
+            return false;
+        }
+        else
+            is >> statistic.startTime >> statistic.endTime;
+
+        strncpy( statistic.resourceName, names[ index ].c_str(), 32 );
+        statistic.resourceName[31] = 0;
+        batch.push_back( statistic );
+    }
+    statistics.insert( statistics.end(), batch.begin(), batch.end( ));
+    return true;
+}
+}
+}
+
+#endif // EQ_DETAIL_STATISTICSBATCH_H
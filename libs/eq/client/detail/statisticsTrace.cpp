@@ -0,0 +1,244 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "statisticsTrace.h"
+
+#include "../channel.h"
+#include "../config.h"
+#include "../node.h"
+#include "../pipe.h"
+#include "../statistic.h"
+#include "../window.h"
+
+#include <lunchbox/debug.h>
+
+#include <cstring>
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+/** Maps the serial of all entities to the serial of their node. */
+class ProcessMapper : public ConfigVisitor
+{
+public:
+    ProcessMapper( std::map< uint32_t, uint32_t >& processes )
+            : _processes( processes ), _node( 0 ) {}
+
+    virtual VisitorResult visitPre( Node* node )
+        {
+            _node = node->getSerial();
+            _processes[ _node ] = _node;
+            return TRAVERSE_CONTINUE;
+        }
+    virtual VisitorResult visitPre( Pipe* pipe )
+        {
+            _processes[ pipe->getSerial() ] = _node;
+            return TRAVERSE_CONTINUE;
+        }
+    virtual VisitorResult visitPre( Window* window )
+        {
+            _processes[ window->getSerial() ] = _node;
+            return TRAVERSE_CONTINUE;
+        }
+    virtual VisitorResult visit( Channel* channel )
+        {
+            _processes[ channel->getSerial() ] = _node;
+            return TRAVERSE_CONTINUE;
+        }
+
+private:
+    std::map< uint32_t, uint32_t >& _processes;
+    uint32_t _node;
+};
+
+/** @return the statistic as a counter value, or false for time spans. */
+bool _getCounter( const Statistic& statistic, float& value )
+{
+    switch( statistic.type )
+    {
+      case Statistic::WINDOW_FPS:
+          value = statistic.currentFPS;
+          return true;
+      case Statistic::PIPE_IDLE:
+          value = statistic.totalTime > 0 ?
+                  float( statistic.idleTime ) / float( statistic.totalTime ) :
+                  0.f;
+          return true;
+      case Statistic::NODE_PIXEL_POOL:
+          value = float( statistic.plugins[0] ) * 1024.f; // bytes
+          return true;
+      default:
+          return false;
+    }
+}
+
+/** @return true if the value is neither infinite nor NaN, as needed by JSON. */
+bool _isFinite( const float value )
+{
+    return value - value == 0.f;
+}
+
+/** Write a string with the characters escaped for JSON. */
+void _writeString( std::ostream& os, const std::string& string )
+{
+    os << '"';
+    for( std::string::const_iterator i = string.begin(); i != string.end();
+         ++i )
+    {
+        const char c = *i;
+        if( c == '"' || c == '\\' )
+            os << '\\' << c;
+        else if( c >= 0 && c < ' ' )
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+}
+
+StatisticsTrace::StatisticsTrace( Config* config,
+                                  const std::string& filename )
+        : _config( config )
+        , _file( filename.c_str( ))
+        , _first( true )
+        , _time( 0 )
+{
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open statistics trace " << filename << std::endl;
+        return;
+    }
+
+    _file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    _beginEvent();
+    _file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+          << "\"args\":{\"name\":";
+    _writeString( _file, config->getName().empty() ? "config" :
+                                                     config->getName( ));
+    _file << "}}";
+    LBINFO << "Writing statistics trace to " << filename << std::endl;
+}
+
+StatisticsTrace::~StatisticsTrace()
+{
+    if( _file.is_open( ))
+        _file << "\n]}" << std::endl;
+}
+
+void StatisticsTrace::write( const uint32_t originator,
+                             const Statistics& statistics )
+{
+    if( !_file.is_open() || statistics.empty( ))
+        return;
+
+    const uint32_t pid = _getProcess( originator );
+    if( _namedThreads.insert( originator ).second )
+    {
+        const Statistic& first = statistics.front();
+        const std::string name( first.resourceName,
+                                strnlen( first.resourceName, 32 ));
+        _beginEvent();
+        _file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+              << ",\"tid\":" << originator << ",\"args\":{\"name\":";
+        _writeString( _file, name );
+        _file << "}}";
+    }
+
+    for( StatisticsCIter i = statistics.begin(); i != statistics.end(); ++i )
+    {
+        const Statistic& statistic = *i;
+        const std::string& name = Statistic::getName( statistic.type );
+        float value = 0.f;
+
+        if( _getCounter( statistic, value ))
+        {
+            if( !_isFinite( value ))
+                continue;
+
+            // counters have no time, place them at the latest sample
+            _beginEvent();
+            _file << "{\"name\":";
+            _writeString( _file, name );
+            _file << ",\"ph\":\"C\",\"ts\":" << _time * 1000 << ",\"pid\":"
+                  << pid << ",\"tid\":" << originator << ",\"args\":{\"value\":"
+                  << value << "}}";
+            continue;
+        }
+
+        // times are in ms, trace events in us
+        const int64_t duration = LB_MAX( statistic.endTime -
+                                         statistic.startTime, 0 );
+        _beginEvent();
+        _file << "{\"name\":";
+        _writeString( _file, name );
+        _file << ",\"ph\":\"X\",\"ts\":" << statistic.startTime * 1000
+              << ",\"dur\":" << duration * 1000 << ",\"pid\":" << pid
+              << ",\"tid\":" << originator << ",\"args\":{\"frame\":"
+              << statistic.frameNumber << ",\"task\":" << statistic.task;
+        if( _isFinite( statistic.ratio ))
+            _file << ",\"ratio\":" << statistic.ratio;
+        _file << "}}";
+        _time = LB_MAX( _time, statistic.endTime );
+    }
+}
+
+uint32_t StatisticsTrace::_getProcess( const uint32_t originator )
+{
+    ProcessMap::const_iterator i = _processes.find( originator );
+    if( i == _processes.end( ))
+    {
+        _mapProcesses();
+        i = _processes.find( originator );
+        if( i == _processes.end( )) // config or unknown entity
+            i = _processes.insert( std::make_pair( originator, 0 )).first;
+    }
+    return i->second;
+}
+
+void StatisticsTrace::_mapProcesses()
+{
+    ProcessMapper mapper( _processes );
+    _config->accept( mapper );
+
+    const Nodes& nodes = _config->getNodes();
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        const Node* node = *i;
+        if( !_namedProcesses.insert( node->getSerial( )).second )
+            continue;
+
+        _beginEvent();
+        _file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+              << node->getSerial() << ",\"args\":{\"name\":";
+        _writeString( _file, node->getName().empty() ? "node" :
+                                                       node->getName( ));
+        _file << "}}";
+    }
+}
+
+void StatisticsTrace::_beginEvent()
+{
+    _file << ( _first ? "\n" : ",\n" );
+    _first = false;
+}
+
+}
+}
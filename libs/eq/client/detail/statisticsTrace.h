@@ -0,0 +1,86 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_STATISTICSTRACE_H
+#define EQ_DETAIL_STATISTICSTRACE_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <lunchbox/nonCopyable.h>
+
+#include <fstream>
+#include <map>
+#include <set>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * Writes the statistics received by the application node as a Chrome trace.
+ *
+ * The trace uses the JSON trace event format, which is read by
+ * chrome://tracing and the Perfetto UI. Each node is a process and each entity
+ * sampling statistics a thread of its node, both identified by their serial.
+ * Timed statistics are complete events, the pipe idle, FPS and pixel pool
+ * samples are counters. All times are taken from the config clock, which the
+ * server synchronizes on all nodes at the start of each frame, compensating
+ * the latency of each node measured by the previous synchronization.
+ *
+ * Enabled by setting EQ_STATISTICS_TRACE to the name of the output file.
+ */
+class StatisticsTrace : public lunchbox::NonCopyable
+{
+public:
+    /** Open the trace file, check isOpen() for success. */
+    EQ_API StatisticsTrace( Config* config, const std::string& filename );
+
+    /** Finish and close the trace file. */
+    EQ_API ~StatisticsTrace();
+
+    /** @return true if the trace file is open. */
+    bool isOpen() const { return _file.is_open(); }
+
+    /**
+     * Append the statistics of one entity, identified by its serial.
+     *
+     * Not thread-safe. Ratios and counter values which are not finite are
+     * omitted, since JSON has no representation for them.
+     */
+    EQ_API void write( const uint32_t originator,
+                       const Statistics& statistics );
+
+private:
+    Config* const _config;
+    std::ofstream _file;
+    bool _first; //!< no event written yet
+    int64_t _time; //!< the latest time written, for counters
+
+    typedef std::map< uint32_t, uint32_t > ProcessMap;
+    ProcessMap _processes; //!< entity serial to node serial
+    std::set< uint32_t > _namedProcesses;
+    std::set< uint32_t > _namedThreads;
+
+    uint32_t _getProcess( const uint32_t originator );
+    void _mapProcesses();
+    void _beginEvent();
+};
+}
+}
+
+#endif // EQ_DETAIL_STATISTICSTRACE_H
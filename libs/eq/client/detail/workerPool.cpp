@@ -0,0 +1,283 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "workerPool.h"
+
+#include <lunchbox/debug.h>
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/spinLock.h>
+#include <lunchbox/thread.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace eq
+{
+namespace detail
+{
+namespace
+{
+// Created on first use and destroyed by exitShared(), not during static
+// destruction when the worker threads can't be joined safely anymore.
+WorkerPool* _sharedPool = 0;
+lunchbox::Lock _sharedPoolLock;
+}
+
+/** The not yet executed indices [begin, end) of one thread. */
+struct WorkerPool::Range
+{
+    Range() : begin( 0 ), end( 0 ) {}
+
+    lunchbox::SpinLock lock;
+    size_t begin;
+    size_t end;
+    char pad[ 64 ]; // avoid false sharing between threads
+};
+
+/** A task being executed, with the indices not yet executed per thread. */
+struct WorkerPool::Job : public lunchbox::NonCopyable
+{
+    explicit Job( Task& task_ )
+        : task( task_ ), ranges( 0 ), nRanges( 0 ), exhausted( false )
+        , active( 0 ) {}
+    ~Job() { delete [] ranges; }
+
+    /** Split the indices [0, n) into one contiguous block per thread. */
+    void split( const size_t n, const size_t nThreads )
+    {
+        ranges = new Range[ nThreads ];
+        nRanges = nThreads;
+        for( size_t i = 0; i < nThreads; ++i )
+        {
+            ranges[ i ].begin = n * i / nThreads;
+            ranges[ i ].end = n * ( i + 1 ) / nThreads;
+        }
+    }
+
+    Task& task;
+    Range* ranges;
+    size_t nRanges;
+    bool exhausted; //!< no work left to join, protected by the pool lock
+    lunchbox::Monitor< uint32_t > active; //!< workers working on this job
+};
+
+class WorkerPool::Worker : public lunchbox::Thread
+{
+public:
+    Worker( WorkerPool& pool, const size_t index )
+        : _pool( pool ), _index( index ) {}
+
+    virtual void run() { _pool._run( _index ); }
+
+private:
+    WorkerPool& _pool;
+    const size_t _index;
+};
+
+WorkerPool::WorkerPool( const size_t nThreads )
+        : _nThreads( nThreads ? nThreads : getNCores( ))
+        , _exit( false )
+        , _generation( 0 )
+{}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        LBASSERT( _jobs.empty( ));
+        _exit = true;
+    }
+    ++_generation;
+
+    for( std::vector< Worker* >::const_iterator i = _workers.begin();
+         i != _workers.end(); ++i )
+    {
+        Worker* worker = *i;
+        worker->join();
+        delete worker;
+    }
+    _workers.clear();
+}
+
+size_t WorkerPool::getNCores()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    const long nCores = sysconf( _SC_NPROCESSORS_ONLN );
+    return nCores > 0 ? size_t( nCores ) : 1;
+#endif
+}
+
+WorkerPool& WorkerPool::getShared()
+{
+    lunchbox::ScopedWrite mutex( _sharedPoolLock );
+    if( !_sharedPool )
+        _sharedPool = new WorkerPool;
+    return *_sharedPool;
+}
+
+void WorkerPool::exitShared()
+{
+    lunchbox::ScopedWrite mutex( _sharedPoolLock );
+    delete _sharedPool;
+    _sharedPool = 0;
+}
+
+void WorkerPool::execute( Task& task, const size_t n )
+{
+    if( _nThreads < 2 || n < 2 )
+    {
+        for( size_t i = 0; i < n; ++i )
+            task.execute( i );
+        return;
+    }
+
+    Job job( task );
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        if( _workers.empty( ))
+            _startWorkers();
+
+        job.split( n, _workers.size() + 1 );
+        _jobs.push_back( &job );
+    }
+    ++_generation;
+
+    // The caller works on its own job only, and leaves it once all indices
+    // are taken. Workers which joined the job may still execute their last
+    // indices, and no worker joins after the job left the queue.
+    _work( job, 0 );
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        _jobs.remove( &job );
+    }
+    job.active.waitEQ( 0 );
+}
+
+void WorkerPool::_startWorkers()
+{
+    for( size_t i = 1; i < _nThreads; ++i )
+    {
+        Worker* worker = new Worker( *this, i );
+        if( !worker->start( ))
+        {
+            LBWARN << "Could not start compositing worker thread"
+                   << std::endl;
+            delete worker;
+            break;
+        }
+        _workers.push_back( worker );
+    }
+}
+
+void WorkerPool::_run( const size_t self )
+{
+    for( ;; )
+    {
+        Job* job = 0;
+        uint32_t generation = 0;
+        {
+            lunchbox::ScopedWrite mutex( _lock );
+            if( _exit )
+                return;
+
+            // read under the lock: a job queued later increments it
+            generation = _generation.get();
+            for( Jobs::const_iterator i = _jobs.begin(); i != _jobs.end(); ++i )
+            {
+                if( !(*i)->exhausted )
+                {
+                    job = *i;
+                    ++job->active;
+                    break;
+                }
+            }
+        }
+
+        if( !job )
+        {
+            _generation.waitNE( generation );
+            continue;
+        }
+
+        _work( *job, self );
+        {
+            lunchbox::ScopedWrite mutex( _lock );
+            job->exhausted = true;
+        }
+        --job->active; // the job may be gone after this
+    }
+}
+
+void WorkerPool::_work( Job& job, const size_t self )
+{
+    for( ;; )
+    {
+        size_t index = 0;
+        if( _pop( job, self, index ))
+            job.task.execute( index );
+        else if( !_steal( job, self ))
+            return;
+    }
+}
+
+bool WorkerPool::_pop( Job& job, const size_t self, size_t& index )
+{
+    Range& range = job.ranges[ self ];
+    lunchbox::ScopedFastWrite mutex( range.lock );
+    if( range.begin == range.end )
+        return false;
+
+    index = range.begin++;
+    return true;
+}
+
+bool WorkerPool::_steal( Job& job, const size_t self )
+{
+    for( size_t i = 1; i < job.nRanges; ++i )
+    {
+        Range& victim = job.ranges[ ( self + i ) % job.nRanges ];
+        size_t begin = 0;
+        size_t end = 0;
+        {
+            lunchbox::ScopedFastWrite mutex( victim.lock );
+            const size_t nLeft = victim.end - victim.begin;
+            if( nLeft == 0 )
+                continue;
+
+            end = victim.end;
+            begin = end - ( nLeft + 1 ) / 2;
+            victim.end = begin;
+        }
+
+        Range& range = job.ranges[ self ];
+        lunchbox::ScopedFastWrite mutex( range.lock );
+        range.begin = begin;
+        range.end = end;
+        return true;
+    }
+    return false;
+}
+
+}
+}
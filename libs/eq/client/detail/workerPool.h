@@ -0,0 +1,112 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQ_DETAIL_WORKERPOOL_H
+#define EQ_DETAIL_WORKERPOOL_H
+
+#include <eq/client/api.h>
+#include <eq/client/types.h>
+
+#include <lunchbox/lock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/nonCopyable.h>
+
+#include <list>
+#include <vector>
+
+namespace eq
+{
+namespace detail
+{
+/**
+ * A persistent pool of threads executing index-parallel tasks.
+ *
+ * The indices of a task are split into one contiguous block per thread, the
+ * calling thread included. A thread which finished its block steals the upper
+ * half of the remaining block of another thread, which balances uneven work
+ * items while keeping neighboring indices on the same thread.
+ *
+ * The worker threads are started on first use. Concurrent callers share the
+ * pool: their tasks are queued, and each idle worker joins the oldest task which
+ * has work left while the callers work on their own task.
+ */
+class WorkerPool : public lunchbox::NonCopyable
+{
+public:
+    /** A task executed by the pool. */
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+
+        /** Execute the work item with the given index. */
+        virtual void execute( const size_t index ) = 0;
+    };
+
+    /**
+     * Construct a new worker pool.
+     *
+     * @param nThreads the number of threads including the calling thread, 0
+     *                 for one thread per processor core.
+     */
+    EQ_API explicit WorkerPool( const size_t nThreads = 0 );
+
+    /** Destruct the pool and join all worker threads. */
+    EQ_API ~WorkerPool();
+
+    /** @return the number of threads including the calling thread. */
+    size_t getNThreads() const { return _nThreads; }
+
+    /** Execute the task for all indices in [0, n) and wait for completion. */
+    EQ_API void execute( Task& task, const size_t n );
+
+    /** @return the number of processor cores of this machine. */
+    EQ_API static size_t getNCores();
+
+    /**
+     * @return the pool shared by all users within this process, with one
+     *         thread per processor core. Created on first use.
+     */
+    EQ_API static WorkerPool& getShared();
+
+    /** Destroy the shared pool. Called by eq::exit(). */
+    EQ_API static void exitShared();
+
+private:
+    class Worker;
+    struct Range;
+    struct Job;
+    typedef std::list< Job* > Jobs;
+
+    const size_t _nThreads;
+    std::vector< Worker* > _workers;
+    Jobs _jobs; //!< queued tasks, oldest first
+    bool _exit;
+
+    lunchbox::Lock _lock; //!< protects _workers, _jobs and _exit
+    lunchbox::Monitor< uint32_t > _generation; //!< incremented for each job
+
+    void _startWorkers();
+    void _run( const size_t self );
+    void _work( Job& job, const size_t self );
+    bool _pop( Job& job, const size_t self, size_t& index );
+    bool _steal( Job& job, const size_t self );
+};
+}
+}
+
+#endif // EQ_DETAIL_WORKERPOOL_H
@@ -59,6 +59,7 @@ public:
         _names[Event::EXIT] = "exit";
         _names[Event::MAGELLAN_AXIS] = "magellan axis";
         _names[Event::MAGELLAN_BUTTON] = "magellan button";
+        _names[Event::STATISTICS] = "statistics";
         _names[Event::UNKNOWN] = "unknown";
         _names[Event::USER] = "user-specific";
     }
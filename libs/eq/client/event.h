@@ -228,6 +228,21 @@ namespace eq
             MAGELLAN_AXIS,        //!< SpaceMouse movement data in magellan
             MAGELLAN_BUTTON,      //!< SpaceMouse button data in magellan
             UNKNOWN,              //!< Event type not known by the event handler
+            /**
+             * Statistics of one channel or node and frame.
+             *
+             * Only sent if the config attribute IATTR_STATISTICS_BATCH is ON,
+             * otherwise all statistics are delivered as STATISTIC events. If
+             * enabled, channel and node statistics are delivered only this
+             * way, and Channel::processEvent() does not see them as STATISTIC
+             * events.
+             *
+             * The config processes these events when they are received for
+             * the statistics overlay and traces. They are not queued, and
+             * Config::handleEvent() does not see them.
+             * @version 1.5.1
+             */
+            STATISTICS,
             /** User-defined events have to be of this type or higher */
             USER = UNKNOWN + 5, // some buffer for binary-compatible patches
             ALL // must be last
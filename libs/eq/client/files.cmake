@@ -86,7 +86,29 @@ set(CLIENT_HEADERS
   )
 
 set(CLIENT_SOURCES
+  detail/activePixels.h
+  detail/activePixels.cpp
   detail/channel.ipp
+  detail/compositorKernels.h
+  detail/compositorKernels.cpp
+  detail/compositorKernelsAVX2.cpp
+  detail/compositorTiles.h
+  detail/compositorTiles.cpp
+  detail/compressorSelector.h
+  detail/compressorSelector.cpp
+  detail/decompressPool.h
+  detail/decompressPool.cpp
+  detail/imageBands.h
+  detail/imageBands.cpp
+  detail/pixelBufferPool.h
+  detail/pixelBufferPool.cpp
+  detail/sharedQueues.h
+  detail/sharedQueues.cpp
+  detail/statisticsBatch.h
+  detail/statisticsTrace.h
+  detail/statisticsTrace.cpp
+  detail/workerPool.h
+  detail/workerPool.cpp
   canvas.cpp
   channel.cpp
   channelStatistics.cpp
@@ -26,26 +26,131 @@
 #include "log.h"
 #include "pixelData.h"
 #include "roiFinder.h"
+#include "detail/activePixels.h"
+#include "detail/decompressPool.h"
 
+#include <eq/fabric/commands.h>
 #include <eq/fabric/drawableConfig.h>
 #include <eq/util/objectManager.h>
 #include <co/commandFunc.h>
 #include <co/connectionDescription.h>
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
+#include <co/iCommand.h>
+#include <co/localNode.h>
+#include <co/objectOCommand.h>
+#include <lunchbox/clock.h>
 #include <lunchbox/monitor.h>
 #include <lunchbox/scopedMutex.h>
 
 #include <co/plugins/compressor.h>
 #include <algorithm>
+#include <cstring>
 
 namespace eq
 {
 
 typedef co::CommandFunc<FrameData> CmdFunc;
 
+namespace
+{
+/** Read the next size-prefixed chunk, @return false if it exceeds the data. */
+bool _readChunk( uint8_t*& data, const uint8_t* end, uint8_t*& chunk,
+                 uint64_t& size )
+{
+    if( uint64_t( end - data ) < sizeof( uint64_t ))
+        return false;
+    size = *reinterpret_cast< uint64_t* >( data );
+    data += sizeof( uint64_t );
+    if( size > uint64_t( end - data ))
+        return false;
+    chunk = data;
+    data += size;
+    return true;
+}
+}
+
+/** Decompresses one attachment of a received image. */
+class FrameData::DecompressJob : public detail::DecompressPool::Job
+{
+public:
+    DecompressJob( FrameData* frameData, Image* image, const uint64_t version,
+                   const ImageBand& band, const uint128_t& channelID,
+                   const Frame::Buffer buffer, const PixelData& pixels,
+                   const co::ICommand& command, const uint32_t frameNumber,
+                   lunchbox::a_int32_t* nLeft )
+        : detail::DecompressPool::Job( frameNumber )
+        , _frameData( frameData ), _image( image ), _version( version )
+        , _band( band ), _channelID( channelID ), _buffer( buffer )
+        , _command( command ), _nLeft( nLeft )
+    {
+        // PixelData is not copyable
+        _pixels.internalFormat = pixels.internalFormat;
+        _pixels.externalFormat = pixels.externalFormat;
+        _pixels.pixelSize = pixels.pixelSize;
+        _pixels.pvp = pixels.pvp;
+        _pixels.compressedData = pixels.compressedData;
+        _pixels.compressedSize = pixels.compressedSize;
+        _pixels.compressorName = pixels.compressorName;
+        _pixels.compressorFlags = pixels.compressorFlags;
+        _pixels.isCompressed = pixels.isCompressed;
+    }
+
+    virtual void run( Statistic& statistic )
+    {
+        lunchbox::Clock clock;
+        _image->setPixelData( _buffer, _pixels );
+        const float time = clock.getTimef();
+
+        const uint64_t rawSize = _image->getPixelDataSize( _buffer );
+        uint64_t size = 0;
+        for( size_t i = 0; i < _pixels.compressedSize.size(); ++i )
+            size += _pixels.compressedSize[ i ];
+        const unsigned index = _buffer == Frame::BUFFER_COLOR ? 0 : 1;
+        statistic.plugins[ index ] = _pixels.compressorName;
+        if( rawSize > 0 )
+            statistic.ratio = float( size ) / float( rawSize );
+        _sendSample( rawSize, time );
+
+        if( --(*_nLeft) > 0 )
+            return;
+
+        // last attachment of the image
+        delete _nLeft;
+        _frameData->_publishImage( _image, _version, _band, true );
+    }
+
+private:
+    FrameDataPtr _frameData;
+    Image* const _image;
+    const uint64_t _version;
+    const ImageBand _band;
+    const uint128_t _channelID; //!< the sender, receives the samples
+    const Frame::Buffer _buffer;
+    PixelData _pixels;
+    const co::ICommand _command; //!< keeps the compressed data alive
+    lunchbox::a_int32_t* const _nLeft; //!< attachments left for the image
+
+    /** Report the decompression speed to the compressor selection. */
+    void _sendSample( const uint64_t rawSize, const float time )
+    {
+        co::NodePtr sender = _command.getNode();
+        co::LocalNodePtr localNode = _frameData->getLocalNode();
+        if( !sender || !localNode || _channelID == UUID::ZERO )
+            return;
+
+        co::ObjectOCommand( co::Connections( 1, sender->getConnection( )),
+                            fabric::CMD_CHANNEL_DECOMPRESS_SAMPLE,
+                            co::COMMANDTYPE_OBJECT, _channelID,
+                            EQ_INSTANCE_ALL )
+            << localNode->getNodeID() << uint32_t( _buffer )
+            << _pixels.compressorName << rawSize << time;
+    }
+};
+
 FrameData::FrameData()
-        : _version( co::VERSION_NONE.low( ))
+        : _zeroCopy( false )
+        , _version( co::VERSION_NONE.low( ))
         , _useAlpha( true )
         , _colorQuality( 1.f )
         , _depthQuality( 1.f )
@@ -141,10 +246,15 @@ void FrameData::Data::deserialize( co::DataIStream& is )
 
 void FrameData::clear()
 {
+    // the commands are released, do not keep references into their data
+    for( ImagesCIter i = _images.begin(); i != _images.end(); ++i )
+        (*i)->reset();
+
     _imageCacheLock.set();
     _imageCache.insert( _imageCache.end(), _images.begin(), _images.end( ));
     _imageCacheLock.unset();
     _images.clear();
+    _commands.clear();
 }
 
 void FrameData::flush()
@@ -185,6 +295,19 @@ Image* FrameData::newImage( const eq::Frame::Type type,
     return image;
 }
 
+void FrameData::_dropImage( Image* image,
+                            const co::ObjectVersion& frameDataVersion )
+{
+    LBWARN << "Dropping malformed image data for " << frameDataVersion
+           << std::endl;
+
+    // the command is released, do not keep references into its data
+    image->reset();
+    _imageCacheLock.set();
+    _imageCache.push_back( image );
+    _imageCacheLock.unset();
+}
+
 Image* FrameData::_allocImage( const eq::Frame::Type type,
                                const DrawableConfig& config,
                                const bool setQuality_ )
@@ -340,29 +463,88 @@ void FrameData::setReady()
 void FrameData::setReady( const co::ObjectVersion& frameData,
                           const FrameData::Data& data )
 {
-    clear();
     LBASSERT(  frameData.version.high() == 0 );
     LBASSERT( _readyVersion < frameData.version.low( ));
-    LBASSERT( _readyVersion == 0 ||
-              _readyVersion + 1 == frameData.version.low( ));
     LBASSERT( _version == frameData.version.low( ));
 
-    _images.swap( _pendingImages );
-    _data = data;
-    _setReady( frameData.version.low());
+    // applied by the last decompression if images are still in flight
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+    Pending& pending = _getPending( frameData.version.low( ));
+    pending.ready = true;
+    pending.data = data;
+    _applyPending();
+}
+
+FrameData::Pending& FrameData::_getPending( const uint64_t version )
+{
+    for( PendingVersions::iterator i = _pending.begin(); i != _pending.end();
+         ++i )
+    {
+        if( i->version == version )
+            return *i;
+    }
+    LBASSERT( _pending.empty() || _pending.back().version < version );
+    _pending.push_back( Pending( version ));
+    return _pending.back();
+}
 
-    LBLOG( LOG_ASSEMBLY ) << this << " applied v"
-                          << frameData.version.low() << std::endl;
+const Images* FrameData::_findPendingImages() const
+{
+    for( PendingVersions::const_iterator i = _pending.begin();
+         i != _pending.end(); ++i )
+    {
+        if( i->version == _version )
+            return &i->images;
+    }
+    return 0;
+}
+
+void FrameData::_applyPending()
+{
+    // publish the received images atomically with the ready version
+    while( !_pending.empty() && _pending.front().ready &&
+           _pending.front().nDecompressing == 0 )
+    {
+        Pending& pending = _pending.front();
+        LBASSERT( _readyVersion < pending.version );
+        LBASSERT( _readyVersion == 0 || _readyVersion + 1 == pending.version );
+
+        for( Assemblies::const_iterator i = pending.assemblies.begin();
+             i != pending.assemblies.end(); ++i )
+        {
+            LBWARN << "Dropping image with " << i->second.nLeft
+                   << " missing bands" << std::endl;
+            Image* image = i->second.image;
+            image->reset();
+            _imageCacheLock.set();
+            _imageCache.push_back( image );
+            _imageCacheLock.unset();
+        }
+
+        clear();
+        _images.swap( pending.images );
+        _commands.swap( pending.commands );
+        _data = pending.data;
+        _setReadyLocked( pending.version );
+
+        LBLOG( LOG_ASSEMBLY ) << this << " applied v" << pending.version
+                              << std::endl;
+        _pending.pop_front();
+    }
 }
 
 void FrameData::_setReady( const uint64_t version )
 {
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+    _setReadyLocked( version );
+}
 
+void FrameData::_setReadyLocked( const uint64_t version )
+{
     LBASSERTINFO( _readyVersion <= version,
                   "v" << _version << " ready " << _readyVersion << " new "
                       << version );
 
-    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
     if( _readyVersion >= version )
         return;
 
@@ -376,6 +558,12 @@ void FrameData::_setReady( const uint64_t version )
         Listener* listener = *i;
         ++(*listener);
     }
+    for( Listeners::iterator i = _imageListeners.begin();
+         i != _imageListeners.end(); ++i )
+    {
+        Listener* listener = *i;
+        ++(*listener);
+    }
 }
 
 void FrameData::addListener( lunchbox::Monitor<uint32_t>& listener )
@@ -397,11 +585,54 @@ void FrameData::removeListener( lunchbox::Monitor<uint32_t>& listener )
     _listeners->erase( i );
 }
 
+void FrameData::addImageListener( lunchbox::Monitor<uint32_t>& listener )
+{
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+
+    _imageListeners.push_back( &listener );
+    const Images* pending = _findPendingImages();
+    if( _readyVersion >= _version || ( pending && !pending->empty( )))
+        ++listener;
+}
+
+void FrameData::removeImageListener( lunchbox::Monitor<uint32_t>& listener )
+{
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+
+    Listeners::iterator i = std::find( _imageListeners.begin(),
+                                       _imageListeners.end(), &listener );
+    LBASSERT( i != _imageListeners.end( ));
+    _imageListeners.erase( i );
+}
+
+bool FrameData::getReceivedImages( Images& images ) const
+{
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+
+    if( _readyVersion >= _version )
+    {
+        images = _images;
+        return true;
+    }
+    const Images* pending = _findPendingImages();
+    if( pending )
+        images = *pending;
+    else
+        images.clear();
+    return false;
+}
+
 bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
                           const PixelViewport& pvp, const Zoom& zoom,
                           const uint32_t buffers_, const bool useAlpha,
-                          uint8_t* data )
+                          const ImageBand& band,
+                          const uint128_t& channelID,
+                          uint8_t* data, const uint64_t size,
+                          const co::ICommand& command,
+                          const uint32_t frameNumber,
+                          detail::DecompressPool* pool )
 {
+    const uint8_t* const end = data + size;
     Image* image = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
                                 false /* set quality */ );
 
@@ -409,13 +640,24 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
     image->setAlphaUsage( useAlpha );
 
     Frame::Buffer buffers[] = { Frame::BUFFER_COLOR, Frame::BUFFER_DEPTH };
+    PixelData pixelDatas[2];
+    unsigned compressed[2]; //!< indices of the compressed buffers
+    size_t nCompressed = 0;
+    bool referenced = false;
+
     for( unsigned i = 0; i < 2; ++i )
     {
         const Frame::Buffer buffer = buffers[i];
 
         if( buffers_ & buffer )
         {
-            PixelData pixelData;
+            if( uint64_t( end - data ) < sizeof( ImageHeader ))
+            {
+                _dropImage( image, frameDataVersion );
+                return false;
+            }
+
+            PixelData& pixelData = pixelDatas[i];
             const ImageHeader* header = reinterpret_cast<ImageHeader*>( data );
             pixelData.internalFormat  = header->internalFormat;
             pixelData.externalFormat  = header->externalFormat;
@@ -429,41 +671,273 @@ bool FrameData::addImage( const co::ObjectVersion& frameDataVersion,
             const uint32_t nChunks    = header->nChunks;
             data += sizeof( ImageHeader );
 
+            detail::ActivePixels activePixels;
+            const uint8_t* packed = 0;
+
             if( pixelData.isCompressed )
             {
+                if( nChunks > uint64_t( end - data ) / sizeof( uint64_t ))
+                {
+                    _dropImage( image, frameDataVersion );
+                    return false;
+                }
                 pixelData.compressedSize.resize( nChunks );
                 pixelData.compressedData.resize( nChunks );
 
                 for( uint32_t j = 0; j < nChunks; ++j )
                 {
-                    const uint64_t size = *reinterpret_cast< uint64_t*>( data );
-                    data += sizeof( uint64_t );
-
-                    pixelData.compressedSize[j] = size;
-                    pixelData.compressedData[j] = data;
-                    data += size;
+                    uint8_t* chunk = 0;
+                    uint64_t chunkSize = 0;
+                    if( !_readChunk( data, end, chunk, chunkSize ))
+                    {
+                        _dropImage( image, frameDataVersion );
+                        return false;
+                    }
+                    pixelData.compressedSize[j] = chunkSize;
+                    pixelData.compressedData[j] = chunk;
+                }
+            }
+            else if( nChunks == 2 ) // active pixel spans, packed pixels
+            {
+                uint8_t* spans = 0;
+                uint8_t* pixels = 0;
+                uint64_t spansSize = 0;
+                uint64_t pixelsSize = 0;
+                if( !_readChunk( data, end, spans, spansSize ) ||
+                    !_readChunk( data, end, pixels, pixelsSize ) ||
+                    !activePixels.setData( spans, spansSize ) ||
+                    pixelsSize != activePixels.getNPixels() *
+                                  pixelData.pixelSize ||
+                    pixelData.pvp.w != int32_t( activePixels.getWidth( )) ||
+                    pixelData.pvp.h != int32_t( activePixels.getHeight( )))
+                {
+                    _dropImage( image, frameDataVersion );
+                    return false;
                 }
+                packed = pixels;
             }
             else
             {
-                const uint64_t size = *reinterpret_cast< uint64_t*>( data );
-                data += sizeof( uint64_t );
-                pixelData.pixels = data;
-                data += size;
-                LBASSERT( size == pixelData.pvp.getArea()*pixelData.pixelSize );
+                uint8_t* pixels = 0;
+                uint64_t pixelsSize = 0;
+                if( !_readChunk( data, end, pixels, pixelsSize ) ||
+                    pixelsSize != uint64_t( pixelData.pvp.getArea( )) *
+                                  pixelData.pixelSize )
+                {
+                    _dropImage( image, frameDataVersion );
+                    return false;
+                }
+                pixelData.pixels = pixels;
             }
 
             image->setZoom( zoom );
             image->setQuality( buffer, header->quality );
-            image->setPixelData( buffer, pixelData );
+
+            if( pixelData.isCompressed && pool )
+            {
+                // decompressed in parallel below
+                compressed[ nCompressed ] = i;
+                ++nCompressed;
+                continue;
+            }
+
+            // Unpacked, uncompressed pixels are used in place if aligned,
+            // packed pixels are cleared here and unpacked below.
+            const bool reference = _zeroCopy && pixelData.pixels &&
+                ( reinterpret_cast< uintptr_t >( pixelData.pixels ) %
+                  sizeof( uint32_t )) == 0;
+            image->setPixelData( buffer, pixelData, !reference );
+            referenced = referenced || reference;
+
+            if( packed && activePixels.isValid( ))
+            {
+                activePixels.unpack( packed, pixelData.pixelSize,
+                                     image->getPixelPointer( buffer ));
+                if( buffer == Frame::BUFFER_DEPTH )
+                    image->setActivePixels( activePixels );
+            }
         }
     }
 
-    LBASSERT( _readyVersion < frameDataVersion.version.low( ));
-    _pendingImages.push_back( image );
+    const uint64_t version = frameDataVersion.version.low();
+    LBASSERT( _readyVersion < version );
+
+    if( band.nBands > 1 &&
+        !_startAssembly( version, band, *image, buffers_, pixelDatas ))
+    {
+        _dropImage( image, frameDataVersion );
+        return false;
+    }
+
+    // keep the received data until the frame is cleared, bands are copied
+    // into their image before the command is released
+    if( referenced && band.nBands <= 1 )
+    {
+        lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+        _getPending( version ).commands.push_back( command );
+    }
+
+    if( nCompressed == 0 )
+    {
+        _publishImage( image, version, band, false );
+        return true;
+    }
+
+    {
+        lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+        ++_getPending( version ).nDecompressing;
+    }
+    lunchbox::a_int32_t* nLeft =
+        new lunchbox::a_int32_t( int32_t( nCompressed ));
+    for( size_t i = 0; i < nCompressed; ++i )
+    {
+        const unsigned j = compressed[i];
+        pool->push( new DecompressJob( this, image, version, band, channelID,
+                                       buffers[j], pixelDatas[j], command,
+                                       frameNumber, nLeft ));
+    }
     return true;
 }
 
+bool FrameData::_startAssembly( const uint64_t version, const ImageBand& band,
+                                const Image& bandImage, const uint32_t buffers,
+                                const PixelData headers[2] )
+{
+    const PixelViewport& pvp = bandImage.getPixelViewport();
+    if( bandImage.getZoom() != Zoom::NONE || pvp.x != band.pvp.x ||
+        pvp.w != band.pvp.w || pvp.y < band.pvp.y ||
+        pvp.y + pvp.h > band.pvp.y + band.pvp.h )
+    {
+        return false;
+    }
+
+    {
+        lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+        const Assemblies& assemblies = _getPending( version ).assemblies;
+        if( assemblies.find( band.index ) != assemblies.end( ))
+            return true;
+    }
+
+    // Assemblies are only added by the command thread, allocate unlocked
+    Assembly assembly;
+    assembly.image = _allocImage( Frame::TYPE_MEMORY, DrawableConfig(),
+                                  false /* set quality */ );
+    assembly.image->setPixelViewport( band.pvp );
+    assembly.image->setAlphaUsage( bandImage.getAlphaUsage( ));
+    assembly.nLeft = band.nBands;
+
+    const Frame::Buffer frameBuffers[] = { Frame::BUFFER_COLOR,
+                                           Frame::BUFFER_DEPTH };
+    const int32_t y = pvp.y - band.pvp.y;
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = frameBuffers[i];
+        assembly.pixels[i] = 0;
+        if( !( buffers & buffer ))
+            continue;
+
+        // cleared, in case bands are missing
+        const PixelData& header = headers[i];
+        PixelData pixels;
+        pixels.internalFormat = header.internalFormat;
+        pixels.externalFormat = header.externalFormat;
+        pixels.pixelSize = header.pixelSize;
+        pixels.pvp = header.pvp;
+        pixels.pvp.y -= y;
+        pixels.pvp.h = band.pvp.h;
+        pixels.compressorName = EQ_COMPRESSOR_NONE;
+
+        assembly.image->setPixelData( buffer, pixels );
+        assembly.image->setQuality( buffer, bandImage.getQuality( buffer ));
+        assembly.pixels[i] = assembly.image->getPixelPointer( buffer );
+    }
+
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+    _getPending( version ).assemblies[ band.index ] = assembly;
+    return true;
+}
+
+Image* FrameData::_assembleBand( Image* bandImage, const uint64_t version,
+                                 const ImageBand& band )
+{
+    Assembly assembly;
+    {
+        lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+        const Assemblies& assemblies = _getPending( version ).assemblies;
+        Assemblies::const_iterator i = assemblies.find( band.index );
+        LBASSERT( i != assemblies.end( ));
+        assembly = i->second;
+    }
+
+    // The bands of an image write disjoint rows and copy concurrently
+    const Frame::Buffer frameBuffers[] = { Frame::BUFFER_COLOR,
+                                           Frame::BUFFER_DEPTH };
+    const int32_t y = bandImage->getPixelViewport().y - band.pvp.y;
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        const Frame::Buffer buffer = frameBuffers[i];
+        if( !assembly.pixels[i] || !bandImage->hasPixelData( buffer ))
+            continue;
+
+        const PixelData& rows = bandImage->getPixelData( buffer );
+        const PixelData& pixels = assembly.image->getPixelData( buffer );
+        if( rows.externalFormat != pixels.externalFormat ||
+            rows.pixelSize != pixels.pixelSize || rows.pvp.w != pixels.pvp.w ||
+            y < 0 || y + rows.pvp.h > pixels.pvp.h )
+        {
+            LBWARN << "Dropping band with mismatching pixel data" << std::endl;
+            continue;
+        }
+
+        const uint64_t rowSize = uint64_t( rows.pvp.w ) * rows.pixelSize;
+        memcpy( assembly.pixels[i] + uint64_t( y ) * rowSize, rows.pixels,
+                uint64_t( rows.pvp.h ) * rowSize );
+    }
+
+    bandImage->reset();
+    _imageCacheLock.set();
+    _imageCache.push_back( bandImage );
+    _imageCacheLock.unset();
+
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+    Assemblies& assemblies = _getPending( version ).assemblies;
+    Assemblies::iterator i = assemblies.find( band.index );
+    LBASSERT( i != assemblies.end( ));
+    if( --i->second.nLeft > 0 )
+        return 0;
+
+    Image* image = i->second.image;
+    assemblies.erase( i );
+    return image;
+}
+
+void FrameData::_publishImage( Image* image, const uint64_t version,
+                               const ImageBand& band, const bool decompressed )
+{
+    if( band.nBands > 1 )
+        image = _assembleBand( image, version, band );
+
+    lunchbox::ScopedMutex< lunchbox::SpinLock > mutex( _listeners );
+    Pending& pending = _getPending( version );
+    if( image ) // else more bands of the image are to come
+    {
+        pending.images.push_back( image );
+        for( Listeners::iterator i = _imageListeners.begin();
+             i != _imageListeners.end(); ++i )
+        {
+            Listener* listener = *i;
+            ++(*listener);
+        }
+    }
+
+    if( decompressed )
+    {
+        LBASSERT( pending.nDecompressing > 0 );
+        --pending.nDecompressing;
+        _applyPending();
+    }
+}
+
 std::ostream& operator << ( std::ostream& os, const FrameData& data )
 {
     return os << "frame data id " << data.getID() << "." << data.getInstanceID()
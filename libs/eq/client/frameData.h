@@ -27,13 +27,18 @@
 #include <eq/fabric/range.h>         // member
 #include <eq/fabric/subPixel.h>      // member
 
+#include <co/iCommand.h>             // member
 #include <co/object.h>               // base class
 #include <lunchbox/monitor.h>         // member
 #include <lunchbox/spinLock.h>        // member
 
+#include <deque>
+#include <map>
+
 namespace eq
 {
 namespace server { class FrameData; }
+namespace detail { class DecompressPool; }
 
     class ROIFinder;
 
@@ -68,6 +73,14 @@ namespace server { class FrameData; }
             float                   quality;
         };
 
+        /** @internal The image a transmitted band is assembled into. */
+        struct ImageBand
+        {
+            uint64_t                index;  //!< image index on the sender
+            fabric::PixelViewport   pvp;    //!< pixel viewport of the image
+            uint32_t                nBands; //!< 1 for images sent whole
+        };
+
         /** Construct a new frame data holder. @version 1.0 */
         EQ_API FrameData();
 
@@ -185,6 +198,26 @@ namespace server { class FrameData; }
          * @param name the compressor name.
          */
         void useCompressor( const Frame::Buffer buffer, const uint32_t name );
+
+        /** @return the compressor set for the buffer. @version 1.5.1 */
+        uint32_t getCompressor( const Frame::Buffer buffer ) const
+            { return buffer == Frame::BUFFER_COLOR ? _colorCompressor :
+                                                     _depthCompressor; }
+
+        /**
+         * Enable or disable zero-copy receive of uncompressed images.
+         *
+         * When enabled, the images of an input frame reference the received
+         * uncompressed pixel data in place, and the network buffers are kept
+         * until the frame data is cleared. Set it on the frame data of an
+         * input frame, it applies to the images received afterwards. Disabled
+         * by default.
+         * @version 1.5.1
+         */
+        void setZeroCopy( const bool enabled ) { _zeroCopy = enabled; }
+
+        /** @return true if received images are used in place. @version 1.5.1*/
+        bool isZeroCopy() const { return _zeroCopy; }
         //@}
 
         /** @name Operations */
@@ -206,7 +239,7 @@ namespace server { class FrameData; }
         EQ_API void clear();
 
         /** Flush the frame by deleting all images. @version 1.0 */
-        void flush();
+        EQ_API void flush();
 
         /** Delete data allocated by the given object manager on all images.*/
         void deleteGLObjects( ObjectManager* om );
@@ -264,7 +297,7 @@ namespace server { class FrameData; }
         void waitReady( const uint32_t timeout = LB_TIMEOUT_INDEFINITE ) const;
 
         /** @internal */
-        void setVersion( const uint64_t version );
+        EQ_API void setVersion( const uint64_t version );
 
         /**
          * Add a ready listener.
@@ -285,6 +318,33 @@ namespace server { class FrameData; }
          */
         void removeListener( lunchbox::Monitor<uint32_t>& listener );
 
+        /**
+         * Add an image listener.
+         *
+         * The listener value will be incremented for each image received for
+         * the current version, and when the frame data is ready.
+         *
+         * @param listener the listener.
+         * @internal
+         */
+        void addImageListener( lunchbox::Monitor<uint32_t>& listener );
+
+        /** Remove an image listener. @internal */
+        void removeImageListener( lunchbox::Monitor<uint32_t>& listener );
+
+        /**
+         * Get the images received so far for the current version.
+         *
+         * Received images are complete and can be used before the frame data
+         * is ready. They keep their order when the frame data becomes ready.
+         *
+         * @param images the return value for the received images.
+         * @return true if the frame data is ready, i.e., all images are
+         *         received.
+         * @internal
+         */
+        bool getReceivedImages( Images& images ) const;
+
         /**
          * Disable the usage of a frame buffer attachment for all images.
          *
@@ -317,13 +377,34 @@ namespace server { class FrameData; }
             EQ_API void deserialize( co::DataIStream& is );
         } _data;
 
-        /** @internal */
-        bool addImage( const co::ObjectVersion& frameDataVersion,
-                       const PixelViewport& pvp, const Zoom& zoom,
-                       const uint32_t buffers, const bool useAlpha,
-                       uint8_t* data );
-        void setReady( const co::ObjectVersion& frameData,
-                       const FrameData::Data& data ); //!< @internal
+        /**
+         * @internal
+         * Add a received image.
+         *
+         * Compressed attachments are decompressed by the given pool, if any,
+         * which keeps the command with the data alive until then. The
+         * decompression time is reported to the sending channel. The image is
+         * published to the image listeners once it is decompressed. Bands are
+         * copied into their image, which is published once all its bands are
+         * in.
+         *
+         * @return false if the data is malformed, the image is dropped.
+         */
+        EQ_API bool addImage( const co::ObjectVersion& frameDataVersion,
+                              const PixelViewport& pvp, const Zoom& zoom,
+                              const uint32_t buffers, const bool useAlpha,
+                              const ImageBand& band,
+                              const uint128_t& channelID,
+                              uint8_t* data, const uint64_t size,
+                              const co::ICommand& command,
+                              const uint32_t frameNumber,
+                              detail::DecompressPool* pool );
+        /**
+         * @internal
+         * Set a received version ready, once all its images are decompressed.
+         */
+        EQ_API void setReady( const co::ObjectVersion& frameData,
+                              const FrameData::Data& data );
 
     protected:
         virtual ChangeType getChangeType() const { return INSTANCE; }
@@ -337,7 +418,39 @@ namespace server { class FrameData; }
 
         ROIFinder* _roiFinder;
 
-        Images _pendingImages;
+        typedef std::vector< co::ICommand > Commands;
+        /** The received data referenced by _images. */
+        Commands _commands;
+
+        /** An image assembled from received bands. */
+        struct Assembly
+        {
+            Image* image;
+            uint8_t* pixels[2]; //!< color and depth, written by the bands
+            uint32_t nLeft; //!< bands not yet copied
+        };
+        typedef std::map< uint64_t, Assembly > Assemblies;
+
+        /** The images received for a version which is not applied yet. */
+        struct Pending
+        {
+            explicit Pending( const uint64_t version_ )
+                : version( version_ ), nDecompressing( 0 ), ready( false ) {}
+
+            uint64_t version;
+            Images images;
+            Commands commands; //!< The received data referenced by images
+            Assemblies assemblies; //!< Banded images by sender image index
+            uint32_t nDecompressing; //!< Images still being decompressed
+            bool ready; //!< Ready received, applied when all images are in
+            Data data;
+        };
+        typedef std::deque< Pending > PendingVersions;
+        /** Received versions in order, protected by the _listeners lock. */
+        PendingVersions _pending;
+        bool _zeroCopy;
+
+        class DecompressJob;
 
         uint64_t _version; //!< The current version
 
@@ -350,6 +463,7 @@ namespace server { class FrameData; }
         typedef std::vector< Listener* > Listeners;
         /** External monitors for readiness synchronization. */
         lunchbox::Lockable< Listeners, lunchbox::SpinLock > _listeners;
+        Listeners _imageListeners; //!< protected by _listeners lock
 
         bool _useAlpha;
         float _colorQuality;
@@ -366,12 +480,48 @@ namespace server { class FrameData; }
                             const DrawableConfig& config,
                             const bool setQuality );
 
+        /** Return an image with malformed received data to the cache. */
+        void _dropImage( Image* image,
+                         const co::ObjectVersion& frameDataVersion );
+
         /** Apply all received images of the given version. */
         void _applyVersion( const uint128_t& version );
 
         /** Set a specific version ready. */
         void _setReady( const uint64_t version );
 
+        /** Set a specific version ready, with the _listeners lock held. */
+        void _setReadyLocked( const uint64_t version );
+
+        /** @return the pending state of a version, with the lock held. */
+        Pending& _getPending( const uint64_t version );
+
+        /** @return the pending images of the current version, or 0. */
+        const Images* _findPendingImages() const;
+
+        /** Add a complete received image or band to the pending images. */
+        void _publishImage( Image* image, const uint64_t version,
+                            const ImageBand& band, const bool decompressed );
+
+        /**
+         * Set up the image the given received band is copied into, unless the
+         * band is not the first one of its image.
+         * @return false if the band does not fit its image.
+         */
+        bool _startAssembly( const uint64_t version, const ImageBand& band,
+                             const Image& bandImage, const uint32_t buffers,
+                             const PixelData headers[2] );
+
+        /**
+         * Copy a received band into its image.
+         * @return the image if this was the last band, 0 otherwise.
+         */
+        Image* _assembleBand( Image* bandImage, const uint64_t version,
+                              const ImageBand& band );
+
+        /** Apply all ready and complete versions, with the lock held. */
+        void _applyPending();
+
         LB_TS_VAR( _commandThread );
     };
 
@@ -393,6 +543,13 @@ template<> inline void byteswap( eq::FrameData::Data& value )
     byteswap( value.subpixel );
     byteswap( value.zoom );
 }
+
+template<> inline void byteswap( eq::FrameData::ImageBand& value )
+{
+    byteswap( value.index );
+    byteswap( value.pvp );
+    byteswap( value.nBands );
+}
 }
 
 #endif // EQ_FRAMEDATA_H
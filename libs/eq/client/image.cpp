@@ -40,6 +40,8 @@
 
 // Internal headers
 #include "../util/gpuCompressor.h"
+#include "detail/activePixels.h"
+#include "detail/pixelBufferPool.h"
 
 #include <fstream>
 
@@ -60,14 +62,17 @@ namespace
 struct Memory : public PixelData
 {
 public:
-    Memory() : state( INVALID ) {}
+    Memory() : state( INVALID ), localBuffer( 0 ), localSize( 0 )
+             , isExternal( false ) {}
+    ~Memory() { releaseLocalBuffer(); }
 
     void flush()
     {
         PixelData::reset();
         state = INVALID;
-        localBuffer.clear();
+        releaseLocalBuffer();
         hasAlpha = true;
+        isExternal = false;
     }
 
     void useLocalBuffer()
@@ -77,8 +82,48 @@ public:
         LBASSERT( pixelSize > 0 );
         LBASSERT( pvp.hasArea( ));
 
-        localBuffer.resize( pvp.getArea() * pixelSize );
-        pixels = localBuffer.getData();
+        // keep the buffer while the size class does not change
+        const size_t size = pvp.getArea() * pixelSize;
+        if( !localBuffer || detail::PixelBufferPool::getCapacity( size ) !=
+                            detail::PixelBufferPool::getCapacity( localSize ))
+        {
+            releaseLocalBuffer();
+            detail::PixelBufferPool& pool =
+                detail::PixelBufferPool::getInstance();
+            localBuffer = pool.acquire( size );
+        }
+        localSize = size;
+        pixels = localBuffer;
+        isExternal = false;
+    }
+
+    void releaseLocalBuffer()
+    {
+        if( pixels == localBuffer )
+            pixels = 0;
+        detail::PixelBufferPool::getInstance().release( localBuffer,
+                                                        localSize );
+        localBuffer = 0;
+        localSize = 0;
+    }
+
+    /** Forget referenced external pixels, which may be released. */
+    void releaseExternalBuffer()
+    {
+        if( !isExternal )
+            return;
+        pixels = 0;
+        state = INVALID;
+        isExternal = false;
+    }
+
+    /** Copy referenced external pixels before they are modified. */
+    void copyExternalBuffer()
+    {
+        LBASSERT( isExternal );
+        const void* data = pixels;
+        useLocalBuffer();
+        memcpy( pixels, data, pvp.getArea() * pixelSize );
     }
 
     enum State
@@ -91,10 +136,18 @@ public:
     State state;   //!< The current state of the memory
 
     /** During the call of setPixelData or writeImage, we have to
-        manage an internal buffer to copy the data */
-    lunchbox::Bufferb localBuffer;
+        manage an internal buffer to copy the data. Pooled across images. */
+    void* localBuffer;
+    size_t localSize; //!< The requested size of the local buffer
 
     bool hasAlpha; //!< The uncompressed pixels contain alpha
+
+    /** The pixels reference read-only memory owned by the caller. */
+    bool isExternal;
+
+private:
+    Memory( const Memory& );
+    Memory& operator = ( const Memory& );
 };
 
 /** @internal The individual parameters for a buffer. */
@@ -182,6 +235,9 @@ public:
     /** Alpha channel significance. */
     bool ignoreAlpha;
 
+    /** Active pixel spans of the depth pixel data, if valid. */
+    ActivePixels activePixels;
+
     Attachment& getAttachment( const eq::Frame::Buffer buffer )
     {
         switch( buffer )
@@ -214,6 +270,22 @@ public:
         { return getAttachment( buffer ).memory; }
     const Memory& getMemory( const eq::Frame::Buffer buffer ) const
         { return getAttachment( buffer ).memory; }
+
+    /** Compute the active pixel spans from the current depth pixel data. */
+    void updateActivePixels()
+    {
+        const Memory& memory = depth.memory;
+        if( memory.state != Memory::VALID || !memory.pvp.hasArea() ||
+            memory.externalFormat != EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT )
+        {
+            activePixels.invalidate();
+            return;
+        }
+
+        activePixels.compute(
+            reinterpret_cast< const uint32_t* >( memory.pixels ),
+            memory.pvp.w, memory.pvp.h );
+    }
 };
 }
 
@@ -238,6 +310,7 @@ void Image::flush()
 {
     _impl->color.flush();
     _impl->depth.flush();
+    _impl->activePixels.invalidate();
 }
 
 void Image::resetPlugins()
@@ -414,6 +487,7 @@ void Image::setAlphaUsage( const bool enabled )
     _impl->ignoreAlpha = !enabled;
     _impl->color.memory.isCompressed = false;
     _impl->depth.memory.isCompressed = false;
+    _impl->activePixels.invalidate();
 }
 
 void Image::setQuality( const Frame::Buffer buffer, const float quality )
@@ -461,7 +535,13 @@ const uint8_t* Image::getPixelPointer( const Frame::Buffer buffer ) const
 uint8_t* Image::getPixelPointer( const Frame::Buffer buffer )
 {
     LBASSERT( hasPixelData( buffer ));
-    return  reinterpret_cast< uint8_t* >( _impl->getMemory( buffer ).pixels );
+    if( buffer == Frame::BUFFER_DEPTH ) // may be modified
+        _impl->activePixels.invalidate();
+
+    Memory& memory = _impl->getMemory( buffer );
+    if( memory.isExternal )
+        memory.copyExternalBuffer();
+    return  reinterpret_cast< uint8_t* >( memory.pixels );
 }
 
 const PixelData& Image::getPixelData( const Frame::Buffer buffer ) const
@@ -529,6 +609,7 @@ bool Image::startReadback( const uint32_t buffers, const PixelViewport& pvp,
     _impl->pvp = pvp;
     _impl->color.memory.state = Memory::INVALID;
     _impl->depth.memory.state = Memory::INVALID;
+    _impl->activePixels.invalidate();
 
     bool needFinish = (buffers & Frame::BUFFER_COLOR) &&
                          _startReadback( Frame::BUFFER_COLOR, zoom, glObjects );
@@ -596,6 +677,7 @@ bool Image::startReadback( const Frame::Buffer buffer,
     _setExternalFormat( buffer, downloader->getExternalFormat(),
                         downloader->getTokenSize(), downloader->hasAlpha( ));
     attachment.memory.state = Memory::DOWNLOAD;
+    attachment.memory.isExternal = false;
 
     if( !memory.hasAlpha )
         flags |= EQ_COMPRESSOR_IGNORE_ALPHA;
@@ -611,7 +693,11 @@ bool Image::startReadback( const Frame::Buffer buffer,
     downloader->setGLEWContext( 0 );
 
     if( !needFinish )
+    {
         attachment.memory.state = Memory::VALID;
+        if( buffer == Frame::BUFFER_DEPTH )
+            _impl->updateActivePixels();
+    }
     return needFinish;
 }
 
@@ -681,6 +767,8 @@ void Image::_finishReadback( const Frame::Buffer buffer, const Zoom& zoom,
 
     downloader->setGLEWContext( 0 );
     memory.state = Memory::VALID;
+    if( buffer == Frame::BUFFER_DEPTH )
+        _impl->updateActivePixels();
 }
 
 bool Image::_readbackZoom( const Frame::Buffer buffer, const Zoom& zoom,
@@ -788,6 +876,8 @@ void Image::setPixelViewport( const PixelViewport& pvp )
     _impl->depth.memory.state = Memory::INVALID;
     _impl->color.memory.isCompressed = false;
     _impl->depth.memory.isCompressed = false;
+    _impl->color.memory.releaseExternalBuffer();
+    _impl->depth.memory.releaseExternalBuffer();
 }
 
 void Image::clearPixelData( const Frame::Buffer buffer )
@@ -804,6 +894,7 @@ void Image::clearPixelData( const Frame::Buffer buffer )
     {
       case EQ_COMPRESSOR_DATATYPE_DEPTH_UNSIGNED_INT:
         memset( memory.pixels, 0xFF, size );
+        _impl->activePixels.clear( memory.pvp.w, memory.pvp.h );
         break;
 
       case EQ_COMPRESSOR_DATATYPE_RGBA:
@@ -821,6 +912,16 @@ void Image::clearPixelData( const Frame::Buffer buffer )
 #endif
         break;
       }
+
+      case EQ_COMPRESSOR_DATATYPE_RGB10_A2:
+      case EQ_COMPRESSOR_DATATYPE_BGR10_A2:
+      case EQ_COMPRESSOR_DATATYPE_RGBA16F:
+      case EQ_COMPRESSOR_DATATYPE_BGRA16F:
+      case EQ_COMPRESSOR_DATATYPE_RGBA32F:
+      case EQ_COMPRESSOR_DATATYPE_BGRA32F:
+        bzero( memory.pixels, size );
+        break;
+
       default:
         LBWARN << "Unknown external format " << memory.externalFormat
                << ", initializing to 0" << std::endl;
@@ -835,9 +936,17 @@ void Image::validatePixelData( const Frame::Buffer buffer )
     memory.useLocalBuffer();
     memory.state = Memory::VALID;
     memory.isCompressed = false;
+    if( buffer == Frame::BUFFER_DEPTH )
+        _impl->activePixels.invalidate();
 }
 
 void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
+{
+    setPixelData( buffer, pixels, true );
+}
+
+void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels,
+                          const bool copy )
 {
     Memory& memory = _impl->getMemory( buffer );
     memory.externalFormat = pixels.externalFormat;
@@ -846,6 +955,7 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
     memory.pvp       = pixels.pvp;
     memory.state     = Memory::INVALID;
     memory.isCompressed = false;
+    memory.isExternal = false;
     memory.hasAlpha = false;
 
     co::CompressorInfos transferrers;
@@ -876,12 +986,24 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
 
     if( pixels.compressorName <= EQ_COMPRESSOR_NONE )
     {
+        if( pixels.pixels && !copy ) // reference, copied on first write
+        {
+            memory.pixels = pixels.pixels;
+            memory.isExternal = true;
+            memory.state = Memory::VALID;
+            if( buffer == Frame::BUFFER_DEPTH )
+                _impl->updateActivePixels();
+            return;
+        }
+
         validatePixelData( buffer ); // alloc memory for pixels
 
         if( pixels.pixels )
         {
             memcpy( memory.pixels, pixels.pixels, size );
             memory.state = Memory::VALID;
+            if( buffer == Frame::BUFFER_DEPTH )
+                _impl->updateActivePixels();
         }
         else
             // no data in pixels, clear image buffer
@@ -920,6 +1042,8 @@ void Image::setPixelData( const Frame::Buffer buffer, const PixelData& pixels )
                                        &pixels.compressedSize.front(),
                                        nBlocks, memory.pixels, outDims,
                                        pixels.compressorFlags );
+    if( buffer == Frame::BUFFER_DEPTH )
+        _impl->updateActivePixels();
 }
 
 /** Find and activate a compression engine */
@@ -1009,26 +1133,32 @@ const PixelData& Image::compressPixelData( const Frame::Buffer buffer )
         return memory;
     }
 
-    const co::CPUCompressor* compressor = attachment.compressor;
+    if( memory.compressorName == EQ_COMPRESSOR_AUTO )
+        memory.compressorName = _chooseCompressor( buffer );
 
-    if( compressor->isValid( attachment.compressor->getName( )) &&
-        compressor->getInfo().tokenType == getExternalFormat( buffer ) &&
-        memory.compressorName != EQ_COMPRESSOR_AUTO )
+    // reuses the compressor instance if it has the requested name
+    bool found = allocCompressor( buffer, memory.compressorName ) &&
+                 memory.compressorName != EQ_COMPRESSOR_NONE;
+    if( found && attachment.compressor->getInfo().tokenType !=
+                 getExternalFormat( buffer ))
     {
-        memory.compressorName = compressor->getName();
+        // selected for another pixel format, choose one for the current
+        LBLOG( LOG_PLUGIN ) << "Compressor 0x" << std::hex
+                            << memory.compressorName << " can't compress "
+                            << "token type 0x" << getExternalFormat( buffer )
+                            << std::dec << std::endl;
+        memory.compressorName = _chooseCompressor( buffer );
+        found = allocCompressor( buffer, memory.compressorName ) &&
+                memory.compressorName != EQ_COMPRESSOR_NONE &&
+                attachment.compressor->getInfo().tokenType ==
+                    getExternalFormat( buffer );
     }
-    else
-    {
-        if( memory.compressorName == EQ_COMPRESSOR_AUTO )
-            memory.compressorName = _chooseCompressor( buffer );
 
-        if( !allocCompressor( buffer, memory.compressorName ) ||
-            memory.compressorName == EQ_COMPRESSOR_NONE )
-        {
-            LBWARN << "No compressor found for token type 0x" << std::hex
-                   << getExternalFormat( buffer ) << std::dec << std::endl;
-            memory.compressorName = EQ_COMPRESSOR_NONE;
-        }
+    if( !found )
+    {
+        LBWARN << "No compressor found for token type 0x" << std::hex
+               << getExternalFormat( buffer ) << std::dec << std::endl;
+        memory.compressorName = EQ_COMPRESSOR_NONE;
     }
 
     LBASSERT( memory.compressorName != EQ_COMPRESSOR_AUTO );
@@ -1509,6 +1639,9 @@ bool Image::readImage( const std::string& filename, const Frame::Buffer buffer )
                 }
             }
     }
+
+    if( buffer == Frame::BUFFER_DEPTH )
+        _impl->updateActivePixels();
     return true;
 }
 
@@ -1568,6 +1701,17 @@ bool Image::getAlphaUsage() const
     return !_impl->ignoreAlpha;
 }
 
+const detail::ActivePixels& Image::getActivePixels() const
+{
+    return _impl->activePixels;
+}
+
+void Image::setActivePixels( const detail::ActivePixels& pixels )
+{
+    LBASSERT( hasPixelData( Frame::BUFFER_DEPTH ));
+    _impl->activePixels = pixels;
+}
+
 void Image::setOffset( int32_t x, int32_t y )
 {
     _impl->pvp.x = x;
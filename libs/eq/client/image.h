@@ -25,7 +25,7 @@
 
 namespace eq
 {
-namespace detail { class Image; }
+namespace detail { class Image; class ActivePixels; }
 
     /**
      * A holder for pixel data.
@@ -178,7 +178,11 @@ namespace detail { class Image; }
         EQ_API const uint8_t* getPixelPointer( const Frame::Buffer buffer )
             const;
 
-        /** @return a pointer to the raw pixel data. @version 1.0 */
+        /**
+         * @return a pointer to the raw, modifiable pixel data. Pixel data set
+         *         without copying is copied first.
+         * @version 1.0
+         */
         EQ_API uint8_t* getPixelPointer( const Frame::Buffer buffer );
 
         /** @return the total size of the pixel data in bytes. @version 1.0 */
@@ -237,6 +241,24 @@ namespace detail { class Image; }
         EQ_API void setPixelData( const Frame::Buffer buffer,
                                      const PixelData& data );
 
+        /**
+         * Set the pixel data of the given image buffer, optionally without
+         * copying uncompressed pixels.
+         *
+         * If copy is false, uncompressed pixels are used in place. They have
+         * to stay valid and unmodified until the pixel data of the buffer is
+         * set again or the image is reset. The pixels are copied before the
+         * first write access through the non-const getPixelPointer().
+         *
+         * @param buffer the image buffer to set.
+         * @param data the pixel data.
+         * @param copy true to copy uncompressed pixels, false to reference
+         *             them.
+         * @version 1.5.1
+         */
+        EQ_API void setPixelData( const Frame::Buffer buffer,
+                                  const PixelData& data, const bool copy );
+
         /**
          * Set alpha data preservation during download and compression.
          * @version 1.0
@@ -387,6 +409,16 @@ namespace detail { class Image; }
 
         /** @internal */
         EQ_API uint32_t getDownloaderName( const Frame::Buffer buffer ) const;
+
+        /**
+         * @internal
+         * @return the spans of active pixels of the depth buffer, computed
+         *         after readback or upon setting the depth pixel data.
+         */
+        EQ_API const detail::ActivePixels& getActivePixels() const;
+
+        /** @internal Set the active pixel spans of the depth buffer. */
+        EQ_API void setActivePixels( const detail::ActivePixels& pixels );
         //@}
 
     private:
@@ -25,6 +25,7 @@
 #include "nodeFactory.h"
 #include "os.h"
 #include "server.h"
+#include "detail/workerPool.h"
 
 #include <eq/client/version.h>
 #include <eq/fabric/init.h>
@@ -115,6 +116,7 @@ bool exit()
 #endif
 
     Global::_nodeFactory = 0;
+    detail::WorkerPool::exitShared();
 //    _exitErrors();
     _exitPlugins();
     const bool ret = fabric::exit();
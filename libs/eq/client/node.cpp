@@ -30,6 +30,11 @@
 #include "nodeStatistics.h"
 #include "pipe.h"
 #include "server.h"
+#include "statistic.h"
+#include "detail/decompressPool.h"
+#include "detail/pixelBufferPool.h"
+#include "detail/sharedQueues.h"
+#include "detail/statisticsBatch.h"
 
 #include <eq/fabric/commands.h>
 #include <eq/fabric/elementVisitor.h>
@@ -38,7 +43,9 @@
 #include <co/barrier.h>
 #include <co/connection.h>
 #include <co/objectICommand.h>
+#include <lunchbox/lockable.h>
 #include <lunchbox/scopedMutex.h>
+#include <lunchbox/spinLock.h>
 
 namespace eq
 {
@@ -47,6 +54,24 @@ typedef co::CommandFunc<Node> NodeFunc;
 typedef fabric::Node< Config, Node, Pipe, NodeVisitor > Super;
 /** @endcond */
 
+namespace detail
+{
+class Node
+{
+public:
+    explicit Node( eq::Node* node ) : decompressPool( node ) {}
+
+    /** Decompresses received frame data images. */
+    DecompressPool decompressPool;
+
+    /** The tile queues of all channels. */
+    SharedQueues queues;
+
+    /** Statistics of unfinished frames, sent batched on frame finish. */
+    lunchbox::Lockable< Statistics, lunchbox::SpinLock > statistics;
+};
+}
+
 Node::Node( Config* parent )
         : Super( parent )
 #pragma warning(push)
@@ -56,12 +81,17 @@ Node::Node( Config* parent )
         , _state( STATE_STOPPED )
         , _finishedFrame( 0 )
         , _unlockedFrame( 0 )
+#pragma warning(push)
+#pragma warning(disable: 4355)
+        , _impl( new detail::Node( this ))
+#pragma warning(pop)
 {
 }
 
 Node::~Node()
 {
     LBASSERT( getPipes().empty( ));
+    delete _impl;
 }
 
 void Node::attach( const UUID& id, const uint32_t instanceID )
@@ -175,6 +205,11 @@ void Node::releaseFrameData( FrameDataPtr data )
     _frameDatas->erase( i );
 }
 
+co::ObjectICommand Node::popTile( const UUID& queueID, const int32_t prefetch )
+{
+    return _impl->queues.pop( getClient(), queueID, prefetch );
+}
+
 void Node::waitInitialized() const
 {
     _state.waitGE( STATE_INIT_FAILED );
@@ -392,6 +427,8 @@ void Node::_flushObjects()
         _barriers->clear();
     }
 
+    _impl->queues.flush( client );
+
     lunchbox::ScopedMutex<> mutex( _frameDatas );
     for( FrameDataHashCIter i = _frameDatas->begin();
          i != _frameDatas->end(); ++i )
@@ -525,6 +562,7 @@ bool Node::_cmdConfigExit( co::ICommand& cmd )
     transmitter.getQueue().push( co::ICommand( )); // wake up to exit
     transmitter.join();
     _flushObjects();
+    detail::PixelBufferPool::getInstance().trim();
 
     getConfig()->send( getLocalNode(),
                        fabric::CMD_CONFIG_DESTROY_NODE ) << getID();
@@ -577,6 +615,8 @@ bool Node::_cmdFrameFinish( co::ICommand& cmd )
 
     _finishFrame( frameNumber );
     _frameFinish( frameID, frameNumber );
+    _samplePixelBufferPool( frameNumber );
+    _sendStatistics( frameNumber );
 
     const uint128_t version = commit();
     if( version != co::VERSION_NONE )
@@ -584,6 +624,62 @@ bool Node::_cmdFrameFinish( co::ICommand& cmd )
     return true;
 }
 
+void Node::_samplePixelBufferPool( const uint32_t frameNumber )
+{
+    const detail::PixelBufferPool::Statistics stats =
+        detail::PixelBufferPool::getInstance().sample();
+    const uint64_t nAcquired = stats.hits + stats.misses;
+
+    NodeStatistics event( Statistic::NODE_PIXEL_POOL, this, frameNumber );
+    event.event.statistic.ratio = nAcquired == 0 ? 1.f :
+                                  float( stats.hits ) / float( nAcquired );
+    event.event.statistic.plugins[0] = uint32_t( stats.residentSize >> 10 );
+    event.event.statistic.plugins[1] = uint32_t( stats.cachedSize >> 10 );
+}
+
+void Node::addStatistic( Event& event )
+{
+    Config* config = getConfig();
+    if( config->getIAttribute( Config::IATTR_STATISTICS_BATCH ) != ON )
+    {
+        config->sendEvent( event.type ) << event;
+        return;
+    }
+
+    lunchbox::ScopedFastWrite mutex( _impl->statistics );
+    _impl->statistics->push_back( event.statistic );
+}
+
+void Node::_sendStatistics( const uint32_t frameNumber )
+{
+    // group by frame, statistics may be sampled late for a previous frame
+    typedef std::map< uint32_t, Statistics > FrameMap;
+    FrameMap frames;
+    {
+        lunchbox::ScopedFastWrite mutex( _impl->statistics );
+        Statistics& statistics = _impl->statistics.data;
+        for( size_t i = 0; i < statistics.size(); )
+        {
+            if( statistics[i].frameNumber > frameNumber ) // not finished yet
+            {
+                ++i;
+                continue;
+            }
+            frames[ statistics[i].frameNumber ].push_back( statistics[i] );
+            statistics[i] = statistics.back();
+            statistics.pop_back();
+        }
+    }
+
+    Config* config = getConfig();
+    for( FrameMap::const_iterator i = frames.begin(); i != frames.end(); ++i )
+    {
+        EventOCommand event( config->sendEvent( Event::STATISTICS ));
+        event << getSerial();
+        detail::StatisticsBatch::write( event, i->second );
+    }
+}
+
 bool Node::_cmdFrameDrawFinish( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
@@ -622,8 +718,11 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
     const uint32_t buffers = command.get< uint32_t >();
     const uint32_t frameNumber = command.get< uint32_t >();
     const bool useAlpha = command.get< bool >();
+    const FrameData::ImageBand band = command.get< FrameData::ImageBand >();
+    const uint128_t channelID = command.get< uint128_t >();
+    const uint64_t size = command.getRemainingBufferSize();
     const uint8_t* data = reinterpret_cast< const uint8_t* >(
-                command.getRemainingBuffer( command.getRemainingBufferSize( )));
+                                          command.getRemainingBuffer( size ));
 
     LBLOG( LOG_ASSEMBLY )
         << "received image data for " << frameDataVersion << ", buffers "
@@ -634,14 +733,18 @@ bool Node::_cmdFrameDataTransmit( co::ICommand& cmd )
     FrameDataPtr frameData = getFrameData( frameDataVersion );
     LBASSERT( !frameData->isReady() );
 
-    NodeStatistics event( Statistic::NODE_FRAME_DECOMPRESS, this,
-                          frameNumber );
-
     // Note on the const_cast: since the PixelData structure stores non-const
     // pointers, we have to go non-const at some point, even though we do not
     // modify the data.
-    LBCHECK( frameData->addImage( frameDataVersion, pvp, zoom, buffers,
-                                  useAlpha, const_cast< uint8_t* >( data )));
+    // Compressed images are decompressed by the pool, which keeps the command
+    // and therefore the data alive until then, samples each decompression
+    // job and reports its speed to the sending channel. Uncompressed images may reference the data, in which case the frame
+    // data keeps the command. Bands are assembled into their image, which is
+    // published once complete. Malformed image data is dropped by the frame
+    // data.
+    frameData->addImage( frameDataVersion, pvp, zoom, buffers, useAlpha, band,
+                         channelID, const_cast< uint8_t* >( data ), size, cmd,
+                         frameNumber, &_impl->decompressPool );
     return true;
 }
 
@@ -658,8 +761,8 @@ bool Node::_cmdFrameDataReady( co::ICommand& cmd )
     FrameDataPtr frameData = getFrameData( frameDataVersion );
     LBASSERT( frameData );
     LBASSERT( !frameData->isReady() );
+    // ready once the images of the version are decompressed
     frameData->setReady( frameDataVersion, data );
-    LBASSERT( frameData->isReady() );
     return true;
 }
 
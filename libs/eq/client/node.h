@@ -31,6 +31,8 @@
 
 namespace eq
 {
+namespace detail { class Node; }
+
     /**
      * A Node represents a single computer in the cluster.
      *
@@ -88,6 +90,18 @@ namespace eq
         /** @internal Release the frame data instance. */
         void releaseFrameData( FrameDataPtr data );
 
+        /**
+         * @internal
+         * Pop the next tile of a queue shared by all channels of this node.
+         *
+         * @param queueID the identifier of the tile queue.
+         * @param prefetch the number of tiles requested ahead, used when the
+         *                 queue is first used on this node.
+         * @return the next tile, or an invalid command if the queue is empty.
+         */
+        co::ObjectICommand popTile( const UUID& queueID,
+                                    const int32_t prefetch );
+
         /** @internal Wait for the node to be initialized. */
         EQ_API void waitInitialized() const;
 
@@ -118,6 +132,12 @@ namespace eq
         /** @internal @return the number of the last finished frame. */
         uint32_t getFinishedFrame() const { return _finishedFrame; }
 
+        /**
+         * @internal Send a statistics event, or add it to the batch sent on
+         * its frame finish if Config::IATTR_STATISTICS_BATCH is ON.
+         */
+        EQ_API void addStatistic( Event& event );
+
         /** @internal */
         class TransmitThread : public lunchbox::Thread
         {
@@ -287,8 +307,7 @@ namespace eq
         /** All frame datas used by the node during rendering. */
         lunchbox::Lockable< FrameDataHash > _frameDatas;
 
-        struct Private;
-        Private* _private; // placeholder for binary-compatible changes
+        detail::Node* const _impl;
 
         void _setAffinity();
 
@@ -296,6 +315,12 @@ namespace eq
         void _frameFinish( const uint128_t& frameID,
                            const uint32_t frameNumber );
 
+        /** Send the pixel buffer pool statistics of the finished frame. */
+        void _samplePixelBufferPool( const uint32_t frameNumber );
+
+        /** Send the statistics of all frames up to the finished frame. */
+        void _sendStatistics( const uint32_t frameNumber );
+
         void _flushObjects();
 
         /** The command functions. */
@@ -63,14 +63,25 @@ namespace eq
             CONFIG_FINISH_FRAME, //!< Sampling of Config::finishFrame
             /** Sampling of synchronization time during Config::finishFrame */
             CONFIG_WAIT_FINISH_FRAME,
+            CHANNEL_TILES, //!< Sampling of the tile queue processing
+            CHANNEL_TILES_WAIT, //!< Sampling of waiting for queued tiles
+            NODE_PIXEL_POOL, //!< Pixel buffer pool usage of a frame
             ALL          // must be last
         };
 
         Type type; //!< The type of statistic
         uint32_t frameNumber; //!< The frame during when the sampling happened
         uint32_t task; //!< @internal
-        uint32_t plugins[2]; //!< color,depth plugins (readback, compression)
-        float ratio; //!< compression ratio (transfer, compression)
+        /**
+         * color,depth plugins (readback, compression), resident and cached KB
+         * (pool)
+         */
+        uint32_t plugins[2];
+        /**
+         * compression ratio (transfer, compression), hit rate (pool), number
+         * of tiles (tiles)
+         */
+        float ratio;
 
         union
         {
@@ -312,6 +312,8 @@ namespace fabric
             IATTR_HINT_STATISTICS,
             /** Use a send token for output frames (OFF, ON) */
             IATTR_HINT_SENDTOKEN,
+            /** Number of tiles requested ahead of rendering (AUTO, >0) */
+            IATTR_TILE_PREFETCH,
             IATTR_LAST,
             IATTR_ALL = IATTR_LAST + 5
         };
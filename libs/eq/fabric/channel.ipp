@@ -35,6 +35,7 @@ namespace
 static std::string _iAttributeStrings[] = {
     MAKE_ATTR_STRING( IATTR_HINT_STATISTICS ),
     MAKE_ATTR_STRING( IATTR_HINT_SENDTOKEN ),
+    MAKE_ATTR_STRING( IATTR_TILE_PREFETCH ),
 };
 }
 
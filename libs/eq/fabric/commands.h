@@ -99,6 +99,7 @@ namespace fabric
 #endif
         CMD_CONFIG_SYNC_CLOCK,
         CMD_CONFIG_SWAP_OBJECT,
+        CMD_CONFIG_SYNC_CLOCK_REPLY,
         CMD_CONFIG_CUSTOM = 45 // some buffer for binary-compatible patches
     };
 
@@ -186,6 +187,7 @@ namespace fabric
         CMD_CHANNEL_FRAME_TILES,
         CMD_CHANNEL_FINISH_READBACK,
         CMD_CHANNEL_DELETE_TRANSFER_CONTEXT,
+        CMD_CHANNEL_DECOMPRESS_SAMPLE,
         CMD_CHANNEL_CUSTOM = 45 // some buffer for binary-compatible patches
     };
 
@@ -138,6 +138,10 @@ namespace fabric
         enum IAttribute
         {
             IATTR_ROBUSTNESS, //!< Tolerate resource failures
+            IATTR_STATISTICS_BATCH, //!< Send statistics batched per frame
+            /** Minimum number of compound groups or nodes to update in
+                parallel */
+            IATTR_MIN_PARALLEL_UPDATES,
             IATTR_LAST,
             IATTR_ALL = IATTR_LAST + 5
         };
@@ -45,6 +45,8 @@ std::string _fAttributeStrings[] =
 std::string _iAttributeStrings[] =
 {
     MAKE_ATTR_STRING( IATTR_ROBUSTNESS ),
+    MAKE_ATTR_STRING( IATTR_STATISTICS_BATCH ),
+    MAKE_ATTR_STRING( IATTR_MIN_PARALLEL_UPDATES ),
 };
 }
 
@@ -896,9 +898,14 @@ std::ostream& operator << ( std::ostream& os,
     os << std::endl;
 
     os << "attributes" << std::endl << "{" << std::endl << lunchbox::indent
-       << "robustness "
+       << "robustness           "
        << IAttribute( config.getIAttribute( C::IATTR_ROBUSTNESS )) << std::endl
-       << "eye_base   " << config.getFAttribute( C::FATTR_EYE_BASE )
+       << "statistics_batch     "
+       << IAttribute( config.getIAttribute( C::IATTR_STATISTICS_BATCH ))
+       << std::endl
+       << "min_parallel_updates "
+       << config.getIAttribute( C::IATTR_MIN_PARALLEL_UPDATES ) << std::endl
+       << "eye_base             " << config.getFAttribute( C::FATTR_EYE_BASE )
        << std::endl
        << lunchbox::exdent << "}" << std::endl;
 
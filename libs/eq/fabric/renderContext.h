@@ -30,6 +30,8 @@
 #include <co/objectVersion.h>
 #include <eq/fabric/api.h>
 
+#include <cstring> // memcmp
+
 namespace eq
 {
 namespace fabric
@@ -41,6 +43,19 @@ namespace fabric
         EQFABRIC_API RenderContext();
         EQFABRIC_API void apply( const Tile& tile ); //!< @internal
 
+        /**
+         * @internal Write the fields which differ from the given base.
+         *
+         * The receiver applies them with deserialize() to the same base. Task
+         * commands use the last context of the same task and eye as the base,
+         * which leaves only the frame identifier for static configurations.
+         */
+        template< class O >
+        void serialize( O& os, const RenderContext& base ) const;
+
+        /** @internal Apply the fields written by serialize() to this base. */
+        template< class I > void deserialize( I& is );
+
         Frustumf       frustum;        //!< frustum for projection matrix
         Frustumf       ortho;          //!< ortho frustum for projection matrix
 
@@ -72,6 +87,110 @@ namespace fabric
 
     EQFABRIC_API std::ostream& operator << ( std::ostream& os,
                                              const RenderContext& ctx );
+
+namespace detail
+{
+/** Calls the functor with the transmitted fields of two contexts. */
+template< class C, class F > void forEachField( C& a, const RenderContext& b,
+                                                F& func )
+{
+    func( a.frustum, b.frustum );
+    func( a.ortho, b.ortho );
+    func( a.headTransform, b.headTransform );
+    func( a.orthoTransform, b.orthoTransform );
+    func( a.view, b.view );
+    func( a.frameID, b.frameID );
+    func( a.pvp, b.pvp );
+    func( a.pixel, b.pixel );
+    func( a.overdraw, b.overdraw );
+    func( a.vp, b.vp );
+    func( a.offset, b.offset );
+    func( a.range, b.range );
+    func( a.subpixel, b.subpixel );
+    func( a.zoom, b.zoom );
+    func( a.buffer, b.buffer );
+    func( a.taskID, b.taskID );
+    func( a.period, b.period );
+    func( a.phase, b.phase );
+    func( a.eye, b.eye );
+    func( a.bufferMask, b.bufferMask );
+}
+
+class DirtyFinder
+{
+public:
+    DirtyFinder() : dirty( 0 ), _bit( 1 ) {}
+
+    template< class T > void operator()( const T& value, const T& base )
+    {
+        if( ::memcmp( &value, &base, sizeof( T )) != 0 )
+            dirty |= _bit;
+        _bit <<= 1;
+    }
+
+    uint32_t dirty;
+private:
+    uint32_t _bit;
+};
+
+template< class O > class FieldWriter
+{
+public:
+    FieldWriter( O& os, const uint32_t dirty )
+        : _os( os ), _dirty( dirty ), _bit( 1 ) {}
+
+    template< class T > void operator()( const T& value, const T& )
+    {
+        if( _dirty & _bit )
+            _os << value;
+        _bit <<= 1;
+    }
+
+private:
+    O& _os;
+    const uint32_t _dirty;
+    uint32_t _bit;
+};
+
+template< class I > class FieldReader
+{
+public:
+    FieldReader( I& is, const uint32_t dirty )
+        : _is( is ), _dirty( dirty ), _bit( 1 ) {}
+
+    template< class T > void operator()( T& value, const T& )
+    {
+        if( _dirty & _bit )
+            _is >> value;
+        _bit <<= 1;
+    }
+
+private:
+    I& _is;
+    const uint32_t _dirty;
+    uint32_t _bit;
+};
+}
+
+template< class O >
+void RenderContext::serialize( O& os, const RenderContext& base ) const
+{
+    detail::DirtyFinder finder;
+    detail::forEachField( *this, base, finder );
+
+    os << finder.dirty;
+    detail::FieldWriter< O > writer( os, finder.dirty );
+    detail::forEachField( *this, base, writer );
+}
+
+template< class I > void RenderContext::deserialize( I& is )
+{
+    uint32_t dirty = 0;
+    is >> dirty;
+
+    detail::FieldReader< I > reader( is, dirty );
+    detail::forEachField( *this, *this, reader );
+}
 }
 }
 
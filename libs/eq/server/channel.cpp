@@ -301,6 +301,7 @@ void Channel::configInit( const uint128_t& initID, const uint32_t frameNumber )
     _state = STATE_INITIALIZING;
 
     LBLOG( LOG_INIT ) << "Init channel" << std::endl;
+    _renderContexts.clear(); // new client channel
     getWindow()->send( fabric::CMD_WINDOW_CREATE_CHANNEL ) << getID();
     send( fabric::CMD_CHANNEL_CONFIG_INIT ) << initID;
 }
@@ -372,8 +373,8 @@ bool Channel::update( const uint128_t& frameID, const uint32_t frameNumber )
 
     RenderContext context;
     _setupRenderContext( frameID, context );
-    send( fabric::CMD_CHANNEL_FRAME_START )
-            << context << getVersion() << frameNumber;
+    send( fabric::CMD_CHANNEL_FRAME_START, context )
+            << getVersion() << frameNumber;
     LBLOG( LOG_TASKS ) << "TASK channel " << getName() << " start frame  "
                        << frameNumber << std::endl;
 
@@ -397,7 +398,7 @@ bool Channel::update( const uint128_t& frameID, const uint32_t frameNumber )
         updated |= visitor.isUpdated();
     }
 
-    send( fabric::CMD_CHANNEL_FRAME_FINISH ) << context << frameNumber;
+    send( fabric::CMD_CHANNEL_FRAME_FINISH, context ) << frameNumber;
     LBLOG( LOG_TASKS ) << "TASK channel " << getName() << " finish frame  "
                            << frameNumber << std::endl;
     _lastDrawCompound = 0;
@@ -410,6 +411,18 @@ co::ObjectOCommand Channel::send( const uint32_t cmd )
     return getNode()->send( cmd, getID( ));
 }
 
+co::ObjectOCommand Channel::send( const uint32_t cmd,
+                                  const RenderContext& context )
+{
+    RenderContext& base = _renderContexts[ std::make_pair( context.taskID,
+                                                           context.eye ) ];
+    co::ObjectOCommand command = send( cmd );
+    command << context.taskID << context.eye;
+    context.serialize( command, base );
+    base = context;
+    return command;
+}
+
 //---------------------------------------------------------------------------
 // Listener interface
 //---------------------------------------------------------------------------
@@ -430,9 +443,9 @@ void Channel::removeListener(  ChannelListener* listener )
         _listeners.erase( i );
 }
 
-void Channel::_fireLoadData( const uint32_t frameNumber,
-                             const Statistics& statistics,
-                             const Viewport& region )
+void Channel::fireLoadData( const uint32_t frameNumber,
+                            const Statistics& statistics,
+                            const Viewport& region )
 {
     LB_TS_SCOPED( _serverThread );
 
@@ -475,7 +488,7 @@ bool Channel::_cmdFrameFinishReply( co::ICommand& cmd )
     const uint32_t frameNumber = command.get< uint32_t >();
     const Statistics statistics = command.get< Statistics >();
 
-    _fireLoadData( frameNumber, statistics, region );
+    fireLoadData( frameNumber, statistics, region );
     return true;
 }
 
@@ -507,7 +520,9 @@ void Channel::output( std::ostream& os ) const
         os << ( i==IATTR_HINT_STATISTICS ?
                 "hint_statistics   " :
                 i==IATTR_HINT_SENDTOKEN ?
-                    "hint_sendtoken    " : "ERROR" )
+                    "hint_sendtoken    " :
+                i==IATTR_TILE_PREFETCH ?
+                    "tile_prefetch     " : "ERROR" )
            << static_cast< fabric::IAttribute >( value ) << std::endl;
     }
 
@@ -26,10 +26,12 @@
 #include <eq/client/types.h>
 #include <eq/fabric/channel.h>       // base class
 #include <eq/fabric/pixelViewport.h> // member
+#include <eq/fabric/renderContext.h> // member
 #include <eq/fabric/viewport.h>      // member
 #include <lunchbox/monitor.h> // member
 
 #include <iostream>
+#include <map>
 #include <vector>
 
 namespace eq
@@ -167,6 +169,16 @@ namespace server
         bool update( const uint128_t& frameID, const uint32_t frameNumber );
 
         co::ObjectOCommand send( const uint32_t cmd );
+
+        /**
+         * Send a task command with the given render context.
+         *
+         * The context is delta-encoded against the last context sent for the
+         * same task and eye. The client channel keeps the same contexts to
+         * decode it.
+         */
+        co::ObjectOCommand send( const uint32_t cmd,
+                                 const RenderContext& context );
         //@}
 
         /** @name Channel listener interface. */
@@ -177,6 +189,11 @@ namespace server
         void removeListener( ChannelListener* listener );
         /** @return true if the channel has listeners */
         bool hasListeners() const { return !_listeners.empty(); }
+
+        /** @internal Notify all listeners of new load data. */
+        void fireLoadData( const uint32_t frameNumber,
+                           const Statistics& statistics,
+                           const Viewport& region );
         //@}
 
         bool omitOutput() const; //!< @internal
@@ -208,6 +225,11 @@ namespace server
         typedef std::vector< ChannelListener* > ChannelListeners;
         ChannelListeners _listeners;
 
+        /** The last render contexts sent, by task and eye. */
+        typedef std::map< std::pair< uint32_t, uint32_t >,
+                          RenderContext > RenderContexts;
+        RenderContexts _renderContexts;
+
         LB_TS_VAR( _serverThread );
 
         struct Private;
@@ -219,10 +241,6 @@ namespace server
         void _setupRenderContext( const uint128_t& frameID,
                                   RenderContext& context );
 
-        void _fireLoadData( const uint32_t frameNumber,
-                            const Statistics& statistics,
-                            const Viewport& region );
-
         /* command handler functions. */
         bool _cmdConfigInitReply( co::ICommand& command );
         bool _cmdConfigExitReply( co::ICommand& command );
@@ -41,6 +41,7 @@
 
 #include <eq/fabric/paths.h>
 #include <lunchbox/os.h>
+#include <lunchbox/scopedMutex.h>
 #include <lunchbox/stdExt.h>
 
 #include <algorithm>
@@ -161,6 +162,7 @@ void Compound::_addChild( Compound* child )
 {
     LBASSERT( child->_parent == this );
     _children.push_back( child );
+    getConfig()->invalidateCompoundGroups();
     _fireChildAdded( child );
 }
 
@@ -172,6 +174,7 @@ bool Compound::_removeChild( Compound* child )
 
     _fireChildRemove( child );
     _children.erase( i );
+    getConfig()->invalidateCompoundGroups();
     return true;
 }
 
@@ -206,6 +209,7 @@ ServerPtr Compound::getServer()
 void Compound::setChannel( Channel* channel )
 {
     _data.channel = channel;
+    getConfig()->invalidateCompoundGroups();
 
     // Update swap barrier
     if( !isDestination( ))
@@ -276,6 +280,7 @@ void Compound::addEqualizer( Equalizer* equalizer )
         equalizer->attach( this );
 
     _equalizers.push_back( equalizer );
+    getConfig()->invalidateCompoundGroups();
 }
 
 bool Compound::isInheritActive( const Eye eye ) const
@@ -1141,6 +1146,7 @@ void Compound::deregister()
         i != _inputTileQueues.end(); ++i )
     {
         TileQueue* queue = *i;
+        queue->flush();
         server->deregisterObject( queue );
     }
 
@@ -1187,8 +1193,12 @@ void Compound::update( const uint32_t frameNumber )
         }
         else
         {
-            getServer()->registerObject( barrier );
-            barrier->setAutoObsolete( getConfig()->getLatency() + 1 );
+            Config* config = getConfig();
+            {
+                lunchbox::ScopedWrite mutex( config->getRegistrationLock( ));
+                getServer()->registerObject( barrier );
+            }
+            barrier->setAutoObsolete( config->getLatency() + 1 );
         }
     }
 }
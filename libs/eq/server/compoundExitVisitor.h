@@ -48,6 +48,13 @@ namespace server
                     compound->deactivate( eyes );
                 }
 
+                const Equalizers& equalizers = compound->getEqualizers();
+                for( EqualizersCIter i = equalizers.begin();
+                     i != equalizers.end(); ++i )
+                {
+                    (*i)->exit();
+                }
+
                 const Frames& outputFrames = compound->getOutputFrames();
                 for( FramesCIter i = outputFrames.begin(); 
                      i != outputFrames.end(); ++i )
@@ -212,6 +212,7 @@ void CompoundUpdateOutputVisitor::_addTilesToQueue( TileQueue* queue,
     PixelViewport pvp = compound->getInheritPixelViewport();
     const double xFraction = 1.0 / pvp.w;
     const double yFraction = 1.0 / pvp.h;
+    std::vector< Tile > eyeTiles[ NUM_EYES ];
 
     for( std::vector< Vector2i >::const_iterator i = tiles.begin();
          i != tiles.end(); ++i )
@@ -243,9 +244,13 @@ void CompoundUpdateOutputVisitor::_addTilesToQueue( TileQueue* queue,
                                           false );
             compound->computeTileFrustum( tileItem.ortho, eye, tileItem.vp,
                                           true );
-            queue->addTile( tileItem, eye );
+            eyeTiles[ lunchbox::getIndexOfLastBit( eye )].push_back( tileItem );
         }
     }
+
+    for( unsigned i = 0; i < NUM_EYES; ++i )
+        if( !eyeTiles[i].empty( ))
+            queue->addTiles( eyeTiles[i], Eye( 1 << i ));
 }
 
 void CompoundUpdateOutputVisitor::_updateZoom( const Compound* compound,
@@ -44,8 +44,11 @@
 
 #include <co/objectICommand.h>
 
+#include <lunchbox/scopedMutex.h>
 #include <lunchbox/sleep.h>
 
+#include <map>
+
 #include "channelStopFrameVisitor.h"
 #include "configDeregistrator.h"
 #include "configRegistrator.h"
@@ -63,6 +66,7 @@ using fabric::OFF;
 
 Config::Config( ServerPtr parent )
         : Super( parent )
+        , _compoundGroupsValid( false )
         , _currentFrame( 0 )
         , _incarnation( 1 )
         , _finishedFrame( 0 )
@@ -113,6 +117,8 @@ void Config::attach( const UUID& id, const uint32_t instanceID )
                      ConfigFunc( this, &Config::_cmdStopFrames ), mainQ );
     registerCommand( fabric::CMD_CONFIG_FINISH_ALL_FRAMES,
                      ConfigFunc( this, &Config::_cmdFinishAllFrames ), mainQ );
+    registerCommand( fabric::CMD_CONFIG_SYNC_CLOCK_REPLY,
+                     ConfigFunc( this, &Config::_cmdSyncClockReply ), cmdQ );
 }
 
 namespace
@@ -144,6 +150,35 @@ private:
     const View* const    _view;
     Channel*             _result;
 };
+
+class NodeCollector : public CompoundVisitor
+{
+public:
+    virtual ~NodeCollector(){}
+
+    virtual VisitorResult visit( const Compound* compound )
+        {
+            const Channel* channel = compound->getChannel();
+            if( channel )
+                _nodes.push_back( channel->getNode( ));
+            return TRAVERSE_CONTINUE;
+        }
+
+    const std::vector< const Node* >& getNodes() const { return _nodes; }
+
+private:
+    std::vector< const Node* > _nodes;
+};
+
+size_t _findRoot( std::vector< size_t >& parents, size_t i )
+{
+    while( parents[i] != i )
+    {
+        parents[i] = parents[ parents[i] ];
+        i = parents[i];
+    }
+    return i;
+}
 }
 
 const Channel* Config::findChannel( const std::string& name ) const
@@ -158,6 +193,56 @@ Channel* Config::findChannel( const Segment* segment, const View* view )
     return finder.getResult();
 }
 
+const std::vector< Compounds >& Config::getCompoundGroups() const
+{
+    if( _compoundGroupsValid )
+        return _compoundGroups;
+
+    // union-find on the compound indices, joined by a common node
+    const size_t nCompounds = _compounds.size();
+    std::vector< size_t > parents( nCompounds );
+    std::map< const Node*, size_t > owners;
+
+    for( size_t i = 0; i < nCompounds; ++i )
+    {
+        parents[i] = i;
+
+        const Compound* compound = _compounds[i];
+        NodeCollector collector;
+        compound->accept( collector );
+
+        const std::vector< const Node* >& nodes = collector.getNodes();
+        for( std::vector< const Node* >::const_iterator j = nodes.begin();
+             j != nodes.end(); ++j )
+        {
+            std::pair< std::map< const Node*, size_t >::iterator, bool >
+                owner = owners.insert( std::make_pair( *j, i ));
+            if( owner.second )
+                continue;
+
+            const size_t a = _findRoot( parents, owner.first->second );
+            const size_t b = _findRoot( parents, i );
+            parents[ LB_MAX( a, b ) ] = LB_MIN( a, b );
+        }
+    }
+
+    std::vector< Compounds >& groups = _compoundGroups;
+    groups.clear();
+    std::vector< size_t > groupIndex( nCompounds, nCompounds );
+    for( size_t i = 0; i < nCompounds; ++i )
+    {
+        const size_t root = _findRoot( parents, i );
+        if( groupIndex[ root ] == nCompounds )
+        {
+            groupIndex[ root ] = groups.size();
+            groups.push_back( Compounds( ));
+        }
+        groups[ groupIndex[ root ]].push_back( _compounds[i] );
+    }
+    _compoundGroupsValid = true;
+    return groups;
+}
+
 Node* Config::findApplicationNode()
 {
     const Nodes& nodes = getNodes();
@@ -369,6 +454,7 @@ void Config::addCompound( Compound* compound )
 {
     LBASSERT( compound->_config == this );
     _compounds.push_back( compound );
+    invalidateCompoundGroups();
 }
 
 bool Config::removeCompound( Compound* compound )
@@ -379,6 +465,7 @@ bool Config::removeCompound( Compound* compound )
         return false;
 
     _compounds.erase( i );
+    invalidateCompoundGroups();
     return true;
 }
 
@@ -502,6 +589,7 @@ void Config::restore()
 {
     _currentFrame = 0;
     _finishedFrame = 0;
+    _pendingFinishes->clear();
     setApplicationNetNode( 0 );
     _workDir.clear();
     _renderClient.clear();
@@ -746,8 +834,11 @@ void Config::_syncClock()
             co::NodePtr netNode = node->getNode();
             LBASSERT( netNode->isConnected( ));
 
-            send( netNode,
-                  fabric::CMD_CONFIG_SYNC_CLOCK ) << getServer()->getTime();
+            // compensate the latency measured by the last sync, the reply
+            // echoes the send time to measure it again
+            const int64_t time = getServer()->getTime();
+            send( netNode, fabric::CMD_CONFIG_SYNC_CLOCK )
+                << time + node->getClockLatency() << time;
         }
     }
 }
@@ -761,6 +852,7 @@ bool Config::_init( const uint128_t& initID )
     _state = STATE_INITIALIZING;
     _currentFrame  = 0;
     _finishedFrame = 0;
+    _pendingFinishes->clear();
     _initID = initID;
 
     for( CompoundsCIter i = _compounds.begin(); i != _compounds.end(); ++i )
@@ -840,36 +932,90 @@ void Config::_startFrame( const uint128_t& frameID )
     LBLOG( lunchbox::LOG_ANY ) << "----- Start Frame ----- " << _currentFrame
                                << std::endl;
 
-    for( Compounds::const_iterator i = _compounds.begin();
-         i != _compounds.end(); ++i )
-    {
-        Compound* compound = *i;
-        compound->update( _currentFrame );
-    }
+    const lunchbox::Clock clock;
+    updateCompounds( _currentFrame );
+    const float updateTime = clock.getTimef();
 
     ConfigUpdateDataVisitor configDataVisitor;
     accept( configDataVisitor );
 
+    // count before the update, a node may finish the frame immediately
     const Nodes& nodes = getNodes();
-    co::NodePtr appNode = findApplicationNetNode();
-    for( Nodes::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    uint32_t nRunning = 0;
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+        if( (*i)->isRunning( ))
+            ++nRunning;
     {
-        Node* node = *i;
-        node->update( frameID, _currentFrame );
-        if( node->isRunning() && node->isApplicationNode( ))
-            appNode = 0; // release sent (see below)
+        lunchbox::ScopedWrite mutex( _pendingFinishes );
+        LBASSERT( _pendingFinishes->getStartedFrame() + 1 == _currentFrame );
+        _pendingFinishes->push( nRunning );
     }
 
-    if( appNode.isValid( )) // release appNode local sync
-        send( appNode,
+    updateFrameNodes( frameID, _currentFrame );
+    LBLOG( LOG_STATS ) << "Frame " << _currentFrame << " start took "
+                       << clock.getTimef() << " ms, " << updateTime
+                       << " ms compound update, " << nodes.size() << " nodes"
+                       << std::endl;
+
+    Node* appNode = findApplicationNode();
+    if( appNode && !appNode->isRunning( )) // release appNode local sync
+        send( appNode->getNode(),
               fabric::CMD_CONFIG_RELEASE_FRAME_LOCAL ) << _currentFrame;
 
     // Fix 2976899: Config::finishFrame deadlocks when no nodes are active
-    notifyNodeFrameFinished( _currentFrame );
+    if( nRunning == 0 )
+    {
+        lunchbox::ScopedWrite mutex( _pendingFinishes );
+        _finishFrames();
+    }
+}
+
+void Config::updateCompounds( const uint32_t frameNumber, const bool parallel )
+{
+    // Compound trees without a common node only modify their own compounds,
+    // equalizers, resources, frames, tile queues and barriers, update them
+    // concurrently. Within a group the update order is unchanged. The object
+    // map of the server is shared, registrations hold the registration lock.
+    const std::vector< Compounds >& groups = getCompoundGroups();
+    const int32_t nGroups = int32_t( groups.size( ));
+
+    const int32_t minParallel = getIAttribute( IATTR_MIN_PARALLEL_UPDATES );
+#pragma omp parallel for schedule( dynamic ) \
+    if( parallel && nGroups >= minParallel )
+    for( int32_t i = 0; i < nGroups; ++i )
+    {
+        const Compounds& compounds = groups[i];
+        for( CompoundsCIter j = compounds.begin(); j != compounds.end(); ++j )
+            (*j)->update( frameNumber );
+    }
+}
+
+void Config::updateFrameNodes( const uint128_t& frameID,
+                               const uint32_t frameNumber, const bool parallel )
+{
+    // Each node generates the tasks of its own resources into its own send
+    // buffer, which keeps the command order per node deterministic. Compounds,
+    // frames and barriers are only read here, and swap barriers are returned
+    // to the pool of the node owning them. No objects are registered.
+    const Nodes& nodes = getNodes();
+    const int32_t nNodes = int32_t( nodes.size( ));
+
+    const int32_t minParallel = getIAttribute( IATTR_MIN_PARALLEL_UPDATES );
+#pragma omp parallel for schedule( dynamic ) \
+    if( parallel && nNodes >= minParallel )
+    for( int32_t i = 0; i < nNodes; ++i )
+        nodes[i]->update( frameID, frameNumber );
 }
 
 void Config::_verifyFrameFinished( const uint32_t frameNumber )
 {
+    // all running nodes have finished at least the last finished frame
+    if( _finishedFrame.get() + getLatency() >= frameNumber )
+        return;
+
+    // serialized with the finish replies, which are ignored once the node
+    // has failed
+    lunchbox::ScopedWrite mutex( _pendingFinishes );
     const Nodes& nodes = getNodes();
     for( Nodes::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
     {
@@ -879,26 +1025,34 @@ void Config::_verifyFrameFinished( const uint32_t frameNumber )
         {
             NodeFailedVisitor nodeFailedVisitor;
             node->accept( nodeFailedVisitor );
+            LBASSERT( node->getState() == STATE_FAILED );
+
+            // the failed node will not finish its outstanding frames
+            _pendingFinishes->release( node->getFinishedFrame(), frameNumber );
         }
     }
+    _finishFrames();
 }
 
-void Config::notifyNodeFrameFinished( const uint32_t frameNumber )
+void Config::notifyNodeFrameFinished( Node* node, const uint32_t frameNumber )
 {
-    if( _finishedFrame >= frameNumber ) // node finish already done
+    lunchbox::ScopedWrite mutex( _pendingFinishes );
+
+    const uint32_t lastFrame = node->getFinishedFrame();
+    node->setFinishedFrame( frameNumber );
+    if( node->getState() == STATE_FAILED ) // released by _verifyFrameFinished
         return;
 
-    const Nodes& nodes = getNodes();
-    for( Nodes::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
-    {
-        const Node* node = *i;
-        if( node->isRunning() && node->getFinishedFrame() < frameNumber )
-        {
-            LBASSERT( _needsFinish || node->isActive( ));
-            return;
-        }
-    }
+    _pendingFinishes->release( lastFrame, frameNumber );
+    _finishFrames();
+}
+
+bool Config::_finishFrames()
+{
+    if( !_pendingFinishes->pop( ))
+        return false;
 
+    const uint32_t frameNumber = _pendingFinishes->getFinishedFrame();
     _finishedFrame = frameNumber;
 
     // All nodes have finished the frame. Notify the application's config that
@@ -909,6 +1063,10 @@ void Config::notifyNodeFrameFinished( const uint32_t frameNumber )
           fabric::CMD_CONFIG_FRAME_FINISH ) << frameNumber;
     LBLOG( LOG_TASKS ) << "TASK config frame finished  " << " frame "
                        << frameNumber << std::endl;
+    LBLOG( LOG_STATS ) << "Frame " << frameNumber << " finish sent "
+                       << _pendingFinishes->getFinishDelay()
+                       << " ms after the last node finish" << std::endl;
+    return true;
 }
 
 void Config::_flushAllFrames()
@@ -1064,6 +1222,27 @@ bool Config::_cmdFinishAllFrames( co::ICommand& cmd )
     return true;
 }
 
+bool Config::_cmdSyncClockReply( co::ICommand& cmd )
+{
+    co::ObjectICommand command( cmd );
+    const int64_t sendTime = command.get< int64_t >();
+    const int64_t latency = ( getServer()->getTime() - sendTime ) / 2;
+
+    co::NodePtr netNode = command.getNode();
+    const Nodes& nodes = getNodes();
+    for( Nodes::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        Node* node = *i;
+        if( node->getNode() != netNode )
+            continue;
+
+        LBVERB << "clock latency of " << node->getName() << " is " << latency
+               << " ms" << std::endl;
+        node->setClockLatency( LB_MAX( latency, 0 ));
+    }
+    return true;
+}
+
 bool Config::_cmdStopFrames( co::ICommand& cmd )
 {
     co::ObjectICommand command( cmd );
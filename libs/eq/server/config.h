@@ -21,12 +21,15 @@
 #define EQSERVER_CONFIG_H
 
 #include "api.h"
+#include "pendingFrames.h" // member
 #include "types.h"
 #include "server.h"        // used in inline method
 #include "state.h"         // enum
 #include "visitorResult.h" // enum
 
 #include <eq/fabric/config.h> // base class
+#include <lunchbox/lock.h> // member
+#include <lunchbox/lockable.h> // member
 #include <lunchbox/monitor.h> // member
 
 #include <iostream>
@@ -85,6 +88,55 @@ namespace server
         /** @return the vector of compounds. */
         const Compounds& getCompounds() const { return _compounds; }
 
+        /**
+         * @internal
+         * @return the root compounds, grouped into sets of compound trees
+         *         which use no common node. Different groups can be updated
+         *         concurrently. Each group is in the order of the compounds.
+         *         The groups are cached until the next compound tree change.
+         */
+        EQSERVER_API const std::vector< Compounds >& getCompoundGroups() const;
+
+        /**
+         * @internal
+         * Invalidate the cached compound groups after a compound was added,
+         * removed or adopted, or changed its channel or equalizers.
+         */
+        void invalidateCompoundGroups() { _compoundGroupsValid = false; }
+
+        /**
+         * @internal
+         * @return the lock to hold while registering or deregistering
+         *         distributed objects during the compound update, which runs
+         *         concurrently for different compound groups.
+         */
+        lunchbox::Lock& getRegistrationLock() const
+            { return _registrationLock; }
+
+        /**
+         * @internal
+         * Update all compounds for a new frame.
+         *
+         * @param frameNumber the number of the new frame.
+         * @param parallel update the compound groups concurrently, if there
+         *                 are at least IATTR_MIN_PARALLEL_UPDATES groups.
+         */
+        EQSERVER_API void updateCompounds( const uint32_t frameNumber,
+                                           const bool parallel = true );
+
+        /**
+         * @internal
+         * Generate and send the tasks of all nodes for a new frame.
+         *
+         * @param frameID the identifier of the new frame.
+         * @param frameNumber the number of the new frame.
+         * @param parallel generate the tasks of the nodes concurrently, if
+         *                 there are at least IATTR_MIN_PARALLEL_UPDATES nodes.
+         */
+        EQSERVER_API void updateFrameNodes( const uint128_t& frameID,
+                                            const uint32_t frameNumber,
+                                            const bool parallel = true );
+
         /** 
          * Find the first channel of a given name.
          * 
@@ -141,8 +193,16 @@ namespace server
         /** @return the working directory for the  render client. */
         const std::string& getWorkDir() const { return _workDir; }
 
-        /** Notify that a node of this config has finished a frame. */
-        void notifyNodeFrameFinished( const uint32_t frameNumber );
+        /**
+         * Notify that a node of this config has finished frames.
+         *
+         * Updates the node's finished frame. Failed nodes have already been
+         * released from their outstanding frames.
+         *
+         * @param node the node.
+         * @param frameNumber the last frame the node has finished now.
+         */
+        void notifyNodeFrameFinished( Node* node, const uint32_t frameNumber );
 
         // Used by Server::releaseConfig() to make sure config is exited
         bool exit();
@@ -198,6 +258,13 @@ namespace server
         /** The list of compounds. */
         Compounds _compounds;
 
+        /** The cached root compound groups, see getCompoundGroups(). */
+        mutable std::vector< Compounds > _compoundGroups;
+        mutable bool _compoundGroupsValid;
+
+        /** Serializes object registration by concurrent compound updates. */
+        mutable lunchbox::Lock _registrationLock;
+
         /** The name of the render client executable. */
         std::string _renderClient;
 
@@ -213,6 +280,12 @@ namespace server
         /** The last finished frame, or 0. */
         lunchbox::Monitor< uint32_t > _finishedFrame;
 
+        /**
+         * The number of running nodes which have not yet finished each frame
+         * after the last finished frame, oldest first.
+         */
+        lunchbox::Lockable< PendingFrames > _pendingFinishes;
+
         State _state;
 
         bool _needsFinish; //!< true after runtime changes
@@ -238,6 +311,7 @@ namespace server
         void _deleteEntities( const std::vector< T* >& entities );
         void _syncClock();
         void _verifyFrameFinished( const uint32_t frameNumber );
+        bool _finishFrames();
         bool _init( const uint128_t& initID );
 
         void _startFrame( const uint128_t& frameID );
@@ -261,6 +335,7 @@ namespace server
         bool _cmdStartFrame( co::ICommand& command );
         bool _cmdStopFrames( co::ICommand& command );
         bool _cmdFinishAllFrames( co::ICommand& command ); 
+        bool _cmdSyncClockReply( co::ICommand& command );
         bool _cmdCreateReply( co::ICommand& command );
         bool _cmdFreezeLoadBalancing( co::ICommand& command );
 
@@ -26,6 +26,7 @@
 #include "../node.h"
 #include "../pipe.h"
 #include "../segment.h"
+#include "../sortLast.h"
 #include "../window.h"
 #include "../equalizers/loadEqualizer.h"
 
@@ -321,6 +322,12 @@ Compound* Resources::_addMonoCompound( Compound* root, const Channels& channels,
     }
     else if( name == EQ_SERVER_CONFIG_LAYOUT_DB_DS )
         compound = _addDSCompound( root, multiProcessDB ? activeMP : activeMT );
+    else if( name == EQ_SERVER_CONFIG_LAYOUT_DB_BS )
+        compound = _addRadixKCompound( root,
+                                       multiProcessDB ? activeMP : activeMT, 2 );
+    else if( name == EQ_SERVER_CONFIG_LAYOUT_DB_RADIXK )
+        compound = _addRadixKCompound( root,
+                                       multiProcessDB ? activeMP : activeMT, 4 );
     else if( name == EQ_SERVER_CONFIG_LAYOUT_DB_2D )
     {
         LBASSERT( !multiProcess );
@@ -585,6 +592,33 @@ Compound* Resources::_addDB2DCompound( Compound* root,
     return compound;
 }
 
+Compound* Resources::_addRadixKCompound( Compound* root,
+                                         const Channels& channels,
+                                         const uint32_t radix )
+{
+    const Channel* channel = root->getChannel();
+    const Layout* layout = channel->getLayout();
+    const Segment* segment = channel->getSegment();
+    const Channel* outputChannel = segment ? segment->getChannel() : 0;
+
+    Compound* compound = new Compound( root );
+    compound->setName( layout->getName( ));
+
+    // sources without frames, SortLast generates the compositing tree
+    for( ChannelsCIter i = channels.begin(); i != channels.end(); ++i )
+    {
+        Compound* child = new Compound( compound );
+        if( *i != outputChannel )
+            child->setChannel( *i );
+    }
+
+    // a single source draws in place
+    if( channels.size() > 1 && !SortLast::addRadixK( compound, radix ))
+        LBWARN << "Radix-k compositing setup failed for " << channels.size()
+               << " channels" << std::endl;
+    return compound;
+}
+
 const Compounds& Resources::_addSources( Compound* compound,
                                          const Channels& channels )
 {
@@ -27,6 +27,8 @@
 #define EQ_SERVER_CONFIG_LAYOUT_DB_STATIC   "StaticDB"
 #define EQ_SERVER_CONFIG_LAYOUT_DB_DYNAMIC  "DynamicDB"
 #define EQ_SERVER_CONFIG_LAYOUT_DB_DS       "DBDirectSend"
+#define EQ_SERVER_CONFIG_LAYOUT_DB_BS       "DBBinarySwap"
+#define EQ_SERVER_CONFIG_LAYOUT_DB_RADIXK   "DBRadixK"
 #define EQ_SERVER_CONFIG_LAYOUT_DB_2D       "DB_2D"
 
 namespace eq
@@ -53,6 +55,9 @@ private:
     static Compound* _add2DCompound( Compound* root, const Channels& channels );
     static Compound* _addDBCompound( Compound* root, const Channels& channels );
     static Compound* _addDSCompound( Compound* root, const Channels& channels );
+    static Compound* _addRadixKCompound( Compound* root,
+                                         const Channels& channels,
+                                         const uint32_t radix );
     static Compound* _addDB2DCompound( Compound* root,
                                        const Channels& channels );
     static const Compounds& _addSources( Compound* compound, const Channels& );
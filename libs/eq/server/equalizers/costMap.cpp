@@ -0,0 +1,273 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "costMap.h"
+
+#include <lunchbox/debug.h>
+
+#include <cmath>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+/** Share of the mean cost mixed into each cell before fitting. */
+static const float _uniformShare = .1f;
+/** Weight of a new centroid motion sample. */
+static const float _velocityWeight = .5f;
+/** Maximum extrapolated motion, in normalized screen coordinates. */
+static const float _maxShift = .25f;
+
+float _getOverlap( const float start1, const float end1,
+                   const float start2, const float end2 )
+{
+    return LB_MAX( 0.f, LB_MIN( end1, end2 ) - LB_MAX( start1, start2 ));
+}
+}
+
+CostMap::CostMap( const Vector2i& size )
+        : _size( LB_MAX( size.x(), 1 ), LB_MAX( size.y(), 1 ))
+        , _fitted( _size.x() * _size.y(), 1.f )
+        , _predicted( _fitted )
+        , _frameNumber( 0 )
+        , _centroid( .5f, .5f )
+        , _velocity( Vector2f::ZERO )
+{}
+
+void CostMap::update( const uint32_t frameNumber, const Tiles& tiles )
+{
+    if( frameNumber <= _frameNumber )
+        return;
+
+    const size_t nCells = _fitted.size();
+    float mean = 0.f;
+    for( size_t i = 0; i < nCells; ++i )
+        mean += _fitted[i];
+    mean /= float( nCells );
+
+    // Keep every cell non-zero, so that a region which became expensive in an
+    // area which was empty before still receives its share of the tile time.
+    std::vector< float > base( nCells );
+    for( size_t i = 0; i < nCells; ++i )
+        base[i] = ( 1.f - _uniformShare ) * _fitted[i] + _uniformShare * mean;
+
+    const float cellW = 1.f / float( _size.x( ));
+    const float cellH = 1.f / float( _size.y( ));
+    std::vector< float > fitted( nCells, 0.f );
+    bool hasData = false;
+
+    for( Tiles::const_iterator i = tiles.begin(); i != tiles.end(); ++i )
+    {
+        const Tile& tile = *i;
+        if( !tile.vp.hasArea() || tile.time < 0.f )
+            continue;
+
+        hasData = true;
+        const float tileCost = _getCost( base, tile.vp );
+        const float tileArea = tile.vp.getArea();
+        const int32_t x0 = int32_t( tile.vp.x * _size.x( ));
+        const int32_t y0 = int32_t( tile.vp.y * _size.y( ));
+        const int32_t x1 = LB_MIN( int32_t( std::ceil( tile.vp.getXEnd() *
+                                                       _size.x( ))), _size.x());
+        const int32_t y1 = LB_MIN( int32_t( std::ceil( tile.vp.getYEnd() *
+                                                       _size.y( ))), _size.y());
+
+        for( int32_t y = LB_MAX( y0, 0 ); y < y1; ++y )
+        {
+            const float overlapY = _getOverlap( tile.vp.y, tile.vp.getYEnd(),
+                                                y * cellH, ( y + 1 ) * cellH );
+            for( int32_t x = LB_MAX( x0, 0 ); x < x1; ++x )
+            {
+                const float overlap = overlapY *
+                    _getOverlap( tile.vp.x, tile.vp.getXEnd(),
+                                 x * cellW, ( x + 1 ) * cellW );
+                if( overlap <= 0.f )
+                    continue;
+
+                const size_t cell = y * _size.x() + x;
+                if( tileCost > 0.f )
+                {
+                    const float share = base[ cell ] * overlap /
+                                        ( cellW * cellH );
+                    fitted[ cell ] += tile.time * share / tileCost;
+                }
+                else
+                    fitted[ cell ] += tile.time * overlap / tileArea;
+            }
+        }
+    }
+
+    if( !hasData )
+        return;
+
+    const Vector2f centroid = _getCentroid( fitted );
+    if( _frameNumber > 0 )
+    {
+        const Vector2f motion = ( centroid - _centroid ) /
+                                float( frameNumber - _frameNumber );
+        _velocity = _velocity * ( 1.f - _velocityWeight ) +
+                    motion * _velocityWeight;
+    }
+
+    _fitted.swap( fitted );
+    _centroid = centroid;
+    _frameNumber = frameNumber;
+}
+
+void CostMap::predict( const uint32_t frameNumber )
+{
+    const float lead = frameNumber > _frameNumber ?
+                       float( frameNumber - _frameNumber ) : 0.f;
+    Vector2f shift = _velocity * lead;
+    shift.x() = LB_MAX( LB_MIN( shift.x(), _maxShift ), -_maxShift );
+    shift.y() = LB_MAX( LB_MIN( shift.y(), _maxShift ), -_maxShift );
+
+    if( shift == Vector2f::ZERO )
+    {
+        _predicted = _fitted;
+        return;
+    }
+
+    // sample the fitted map at the cell centers moved back by the motion
+    const float cellW = 1.f / float( _size.x( ));
+    const float cellH = 1.f / float( _size.y( ));
+    for( int32_t y = 0; y < _size.y(); ++y )
+        for( int32_t x = 0; x < _size.x(); ++x )
+            _predicted[ y * _size.x() + x ] =
+                _sample( ( x + .5f ) * cellW - shift.x(),
+                         ( y + .5f ) * cellH - shift.y( ));
+}
+
+float CostMap::getCost( const Viewport& vp ) const
+{
+    return _getCost( _predicted, vp );
+}
+
+float CostMap::getSplit( const Viewport& vp, const bool vertical,
+                         const float ratio ) const
+{
+    const float start = vertical ? vp.x : vp.y;
+    const float end = vertical ? vp.getXEnd() : vp.getYEnd();
+    const float total = getCost( vp );
+    if( total <= 0.f )
+        return start + ( end - start ) * ratio;
+
+    // walk the cell boundaries until the cost of the slab exceeds the target
+    const int32_t nCells = vertical ? _size.x() : _size.y();
+    float target = total * ratio;
+    float pos = start;
+    Viewport slab = vp;
+
+    while( pos < end )
+    {
+        float next = float( int32_t( pos * nCells ) + 1 ) / float( nCells );
+        if( next <= pos ) // fp rounding on a cell boundary
+            next = pos + 1.f / float( nCells );
+        next = LB_MIN( next, end );
+        if( vertical )
+        {
+            slab.x = pos;
+            slab.w = next - pos;
+        }
+        else
+        {
+            slab.y = pos;
+            slab.h = next - pos;
+        }
+
+        const float cost = _getCost( _predicted, slab );
+        if( cost >= target )
+            return cost > 0.f ? pos + ( next - pos ) * target / cost : pos;
+
+        target -= cost;
+        pos = next;
+    }
+    return end;
+}
+
+float CostMap::_getCost( const std::vector< float >& cells,
+                         const Viewport& vp ) const
+{
+    const float cellW = 1.f / float( _size.x( ));
+    const float cellH = 1.f / float( _size.y( ));
+    const int32_t x0 = LB_MAX( int32_t( vp.x * _size.x( )), 0 );
+    const int32_t y0 = LB_MAX( int32_t( vp.y * _size.y( )), 0 );
+    const int32_t x1 = LB_MIN( int32_t( std::ceil( vp.getXEnd() * _size.x( ))),
+                               _size.x( ));
+    const int32_t y1 = LB_MIN( int32_t( std::ceil( vp.getYEnd() * _size.y( ))),
+                               _size.y( ));
+
+    float cost = 0.f;
+    for( int32_t y = y0; y < y1; ++y )
+    {
+        const float overlapY = _getOverlap( vp.y, vp.getYEnd(), y * cellH,
+                                            ( y + 1 ) * cellH ) / cellH;
+        for( int32_t x = x0; x < x1; ++x )
+        {
+            const float overlapX = _getOverlap( vp.x, vp.getXEnd(), x * cellW,
+                                                ( x + 1 ) * cellW ) / cellW;
+            cost += cells[ y * _size.x() + x ] * overlapX * overlapY;
+        }
+    }
+    return cost;
+}
+
+Vector2f CostMap::_getCentroid( const std::vector< float >& cells ) const
+{
+    Vector2f centroid( Vector2f::ZERO );
+    float total = 0.f;
+    for( int32_t y = 0; y < _size.y(); ++y )
+    {
+        for( int32_t x = 0; x < _size.x(); ++x )
+        {
+            const float cost = cells[ y * _size.x() + x ];
+            centroid.x() += cost * ( x + .5f ) / float( _size.x( ));
+            centroid.y() += cost * ( y + .5f ) / float( _size.y( ));
+            total += cost;
+        }
+    }
+
+    if( total <= 0.f )
+        return Vector2f( .5f, .5f );
+    return centroid / total;
+}
+
+float CostMap::_sample( const float x, const float y ) const
+{
+    // bilinear interpolation between cell centers, clamped at the border
+    const float fx = LB_MAX( LB_MIN( x * _size.x() - .5f,
+                                     float( _size.x() - 1 )), 0.f );
+    const float fy = LB_MAX( LB_MIN( y * _size.y() - .5f,
+                                     float( _size.y() - 1 )), 0.f );
+    const int32_t x0 = int32_t( fx );
+    const int32_t y0 = int32_t( fy );
+    const int32_t x1 = LB_MIN( x0 + 1, _size.x() - 1 );
+    const int32_t y1 = LB_MIN( y0 + 1, _size.y() - 1 );
+    const float ax = fx - x0;
+    const float ay = fy - y0;
+
+    const float top = ( 1.f - ax ) * _fitted[ y0 * _size.x() + x0 ] +
+                      ax * _fitted[ y0 * _size.x() + x1 ];
+    const float bottom = ( 1.f - ax ) * _fitted[ y1 * _size.x() + x0 ] +
+                         ax * _fitted[ y1 * _size.x() + x1 ];
+    return ( 1.f - ay ) * top + ay * bottom;
+}
+
+}
+}
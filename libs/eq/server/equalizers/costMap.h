@@ -0,0 +1,94 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_COSTMAP_H
+#define EQS_COSTMAP_H
+
+#include "../types.h"
+
+#include <eq/fabric/viewport.h> // member
+
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * A coarse screen-space grid of the rendering cost of a compound.
+     *
+     * Each measured tile time is distributed over the cells covered by the
+     * tile's viewport, proportionally to the cost previously estimated for
+     * these cells. Successive frames with different tilings thereby refine the
+     * cost distribution below the size of a tile, while the sum over each
+     * tile always matches its latest measurement. The motion of the cost
+     * centroid is tracked and used to extrapolate the map to the frame being
+     * balanced.
+     */
+    class CostMap
+    {
+    public:
+        /** A measured rendering time of a part of the screen. */
+        struct Tile
+        {
+            Tile( const Viewport& vp_, const float time_ )
+                : vp( vp_ ), time( time_ ) {}
+
+            Viewport vp;
+            float time;
+        };
+        typedef std::vector< Tile > Tiles;
+
+        /** Construct a uniform cost map with the given number of cells. */
+        explicit CostMap( const Vector2i& size );
+
+        /** @return the frame number of the last update. */
+        uint32_t getFrameNumber() const { return _frameNumber; }
+
+        /** Fit the map to the tile times measured in the given frame. */
+        void update( const uint32_t frameNumber, const Tiles& tiles );
+
+        /** Extrapolate the cost of the given frame from the last update. */
+        void predict( const uint32_t frameNumber );
+
+        /** @return the predicted cost of the given area. */
+        float getCost( const Viewport& vp ) const;
+
+        /**
+         * @return the position along the given axis splitting the predicted
+         *         cost of the viewport in the given ratio.
+         */
+        float getSplit( const Viewport& vp, const bool vertical,
+                        const float ratio ) const;
+
+    private:
+        const Vector2i _size;
+        std::vector< float > _fitted;    //!< cost per cell of the last update
+        std::vector< float > _predicted; //!< cost per cell of the next frame
+        uint32_t _frameNumber;
+        Vector2f _centroid; //!< of _fitted
+        Vector2f _velocity; //!< of the centroid per frame
+
+        float _getCost( const std::vector< float >& cells,
+                        const Viewport& vp ) const;
+        Vector2f _getCentroid( const std::vector< float >& cells ) const;
+        float _sample( const float x, const float y ) const;
+    };
+}
+}
+
+#endif // EQS_COSTMAP_H
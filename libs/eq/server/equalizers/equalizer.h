@@ -64,6 +64,9 @@ namespace server
 
         virtual uint32_t getType() const = 0;
 
+        /** Called when the attached compound tree is exited. */
+        virtual void exit() {}
+
     private:
         // override in sub-classes to handle dynamic compounds.
         virtual void notifyChildAdded( Compound* compound, Compound* child )
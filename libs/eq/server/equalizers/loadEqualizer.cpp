@@ -18,12 +18,15 @@
 
 #include "loadEqualizer.h"
 
+#include "costMap.h"
 #include "../compound.h"
 #include "../log.h"
 
 #include <eq/client/statistic.h>
 #include <lunchbox/debug.h>
 
+#include <sstream>
+
 namespace eq
 {
 namespace server
@@ -42,6 +45,10 @@ LoadEqualizer::LoadEqualizer( const Mode mode )
         , _boundary2i( 1, 1 )
         , _boundaryf( std::numeric_limits<float>::epsilon() )
         , _assembleOnlyLimit( std::numeric_limits< float >::max( ) )
+        , _costMapSize( Vector2i::ZERO )
+        , _costMap( 0 )
+        , _learning( false )
+        , _learnedFrame( 0 )
 {
     LBVERB << "New LoadEqualizer @" << (void*)this << std::endl;
 }
@@ -55,6 +62,12 @@ LoadEqualizer::LoadEqualizer( const LoadEqualizer& from )
         , _boundary2i( from._boundary2i )
         , _boundaryf( from._boundaryf )
         , _assembleOnlyLimit( from._assembleOnlyLimit )
+        , _costMapSize( from._costMapSize )
+        , _costMap( 0 )
+        , _learning( from._learning )
+        , _modelFile( from._modelFile )
+        , _resourceModel( from._resourceModel )
+        , _learnedFrame( 0 )
 {}
 
 LoadEqualizer::~LoadEqualizer()
@@ -64,6 +77,28 @@ LoadEqualizer::~LoadEqualizer()
     _tree = 0;
 
     _history.clear();
+    delete _costMap;
+    _costMap = 0;
+}
+
+void LoadEqualizer::setCostMapSize( const Vector2i& size )
+{
+    _costMapSize = size;
+    delete _costMap;
+    _costMap = 0;
+}
+
+void LoadEqualizer::setResourceModel( const std::string& filename )
+{
+    _modelFile = filename;
+    if( !_modelFile.empty( ))
+        _resourceModel.load( _modelFile );
+}
+
+void LoadEqualizer::exit()
+{
+    if( _learning && !_modelFile.empty() && _resourceModel.isDirty( ))
+        _resourceModel.save( _modelFile );
 }
 
 void LoadEqualizer::notifyUpdatePre( Compound* compound,
@@ -102,7 +137,7 @@ void LoadEqualizer::notifyUpdatePre( Compound* compound,
     }
 
     _update( _tree );
-    _computeSplit();
+    _computeSplit( frameNumber );
 }
 
 LoadEqualizer::Node* LoadEqualizer::_buildTree( const Compounds& compounds )
@@ -371,7 +406,8 @@ float LoadEqualizer::_getTotalResources( ) const
     {
        const Compound* compound = *i;
        if( compound->isActive( ))
-           resources += compound->getUsage();
+           resources += compound->getUsage() *
+                        _getSpeed( compound->getChannel( ));
     }
 
     return resources;
@@ -394,7 +430,8 @@ void LoadEqualizer::_updateLeaf( Node* node )
     const Channel* channel = compound->getChannel();
     LBASSERT( channel );
     const PixelViewport& pvp = channel->getPixelViewport();
-    node->resources = compound->isActive() ? compound->getUsage() : 0.f;
+    node->resources = compound->isActive() ?
+                      compound->getUsage() * _getSpeed( channel ) : 0.f;
     LBASSERT( node->resources >= 0.f );
 
     node->maxSize.x() = pvp.w;
@@ -484,21 +521,66 @@ void LoadEqualizer::_updateNode( Node* node )
     }
 }
 
-int64_t LoadEqualizer::_getTotalTime()
+float LoadEqualizer::_getTotalTime()
 {
     const LBFrameData& frameData = _history.front();
     LBDatas items = frameData.second;
     _removeEmpty( items );
 
-    int64_t totalTime = 0;
+    float totalTime = 0.f;
     for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
     {
         const Data& data = *i;
-        totalTime += data.time;
+        totalTime += float( data.time ) * _getSpeed( data.channel );
     }
     return totalTime;
 }
 
+float LoadEqualizer::_getSpeed( const Channel* channel ) const
+{
+    if( !channel || _resourceModel.isEmpty( ))
+        return 1.f;
+    return _resourceModel.getSpeed( _getResourceName( channel ));
+}
+
+std::string LoadEqualizer::_getResourceName( const Channel* channel ) const
+{
+    if( !channel->getName().empty( ))
+        return channel->getName();
+
+    std::ostringstream name;
+    name << "channel" << channel->getSerial();
+    return name.str();
+}
+
+void LoadEqualizer::_learn( const LBFrameData& frameData )
+{
+    if( !_learning || frameData.first <= _learnedFrame )
+        return;
+    _learnedFrame = frameData.first;
+
+    const PixelViewport& pvp = getCompound()->getChannel()->getPixelViewport();
+    ResourceModel::Samples samples;
+    const LBDatas& items = frameData.second;
+    for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
+    {
+        const Data& data = *i;
+        if( !data.channel || data.time <= 0 || !data.vp.hasArea() ||
+            !data.range.hasData( ))
+        {
+            continue;
+        }
+
+        ResourceModel::Sample sample;
+        sample.name = _getResourceName( data.channel );
+        sample.work = data.work;
+        sample.time = float( data.time );
+        sample.pixels = float( pvp.getArea( )) * data.vp.getArea();
+        samples.push_back( sample );
+    }
+    _resourceModel.learn( samples );
+}
+
 int64_t LoadEqualizer::_getAssembleTime( )
 {
     if( _damping >= 1.f )
@@ -517,11 +599,13 @@ int64_t LoadEqualizer::_getAssembleTime( )
     return assembleTime;
 }
 
-void LoadEqualizer::_computeSplit()
+void LoadEqualizer::_computeSplit( const uint32_t frameNumber )
 {
     LBASSERT( !_history.empty( ));
 
     const LBFrameData& frameData = _history.front();
+    _learn( frameData );
+
     const Compound* compound = getCompound();
     LBLOG( LOG_LB2 ) << "----- balance " << compound->getChannel()->getName()
                     << " using frame " << frameData.first << " tree "
@@ -531,6 +615,17 @@ void LoadEqualizer::_computeSplit()
     LBDatas items( frameData.second );
     _removeEmpty( items );
 
+    // normalize the times to the work of a resource of average speed
+    if( !_resourceModel.isEmpty( ))
+    {
+        for( LBDatas::iterator i = items.begin(); i != items.end(); ++i )
+        {
+            Data& data = *i;
+            const float time = float( data.time ) * _getSpeed( data.channel );
+            data.time = LB_MAX( int64_t( time + .5f ), data.time > 0 ? 1 : 0 );
+        }
+    }
+
     LBDatas sortedData[3] = { items, items, items };
 
     if( _mode == MODE_DB )
@@ -557,12 +652,34 @@ void LoadEqualizer::_computeSplit()
 #endif
     }
 
+    _updateCostMap( frameData.first, items, frameNumber );
+
     const float time = float( _getTotalTime( ));
     LBLOG( LOG_LB2 ) << "Render time " << time << " for "
                      << _tree->resources << " resources" << std::endl;
     _computeSplit( _tree, time, sortedData, Viewport(), Range( ));
 }
 
+void LoadEqualizer::_updateCostMap( const uint32_t frameNumber,
+                                    const LBDatas& items,
+                                    const uint32_t currentFrame )
+{
+    if( _mode == MODE_DB || _costMapSize.x() <= 0 || _costMapSize.y() <= 0 )
+        return;
+
+    if( !_costMap )
+        _costMap = new CostMap( _costMapSize );
+
+    if( frameNumber > 0 ) // not the initial fake data set
+    {
+        CostMap::Tiles tiles;
+        for( LBDatas::const_iterator i = items.begin(); i != items.end(); ++i )
+            tiles.push_back( CostMap::Tile( i->vp, float( i->time )));
+        _costMap->update( frameNumber, tiles );
+    }
+    _costMap->predict( currentFrame );
+}
+
 void LoadEqualizer::_removeEmpty( LBDatas& items )
 {
     for( LBDatas::iterator i = items.begin(); i != items.end(); )
@@ -591,7 +708,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
     Compound* compound = node->compound;
     if( compound )
     {
-        _assign( compound, vp, range );
+        _assign( compound, vp, range, time );
         return;
     }
 
@@ -601,6 +718,8 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
     const float leftTime = node->resources > 0 ?
                            time * node->left->resources / node->resources : 0.f;
     float timeLeft = LB_MIN( leftTime, time ); // correct for fp rounding error
+    const float leftShare = node->resources > 0 ?
+                            node->left->resources / node->resources : 0.f;
 
     switch( node->mode )
     {
@@ -610,6 +729,11 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 
             float splitPos = vp.x;
             const float end = vp.getXEnd();
+            if( _costMap )
+            {
+                splitPos = _costMap->getSplit( vp, true, leftShare );
+                timeLeft = 0.f; // use the predicted split
+            }
 
             while( timeLeft > std::numeric_limits< float >::epsilon() &&
                    splitPos < end )
@@ -702,7 +826,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             }
 
             LBLOG( LOG_LB2 ) << "Should split at X " << splitPos << std::endl;
-            if( _damping < 1.f )
+            if( _damping < 1.f && !_costMap )
                 splitPos = (1.f - _damping) * splitPos + _damping * node->split;
             LBLOG( LOG_LB2 ) << "Dampened split at X " << splitPos << std::endl;
 
@@ -770,6 +894,11 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             LBASSERT( range == Range::ALL );
             float splitPos = vp.y;
             const float end = vp.getYEnd();
+            if( _costMap )
+            {
+                splitPos = _costMap->getSplit( vp, false, leftShare );
+                timeLeft = 0.f; // use the predicted split
+            }
 
             while( timeLeft > std::numeric_limits< float >::epsilon() &&
                    splitPos < end )
@@ -863,7 +992,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
             }
 
             LBLOG( LOG_LB2 ) << "Should split at Y " << splitPos << std::endl;
-            if( _damping < 1.f )
+            if( _damping < 1.f && !_costMap )
                 splitPos = (1.f - _damping) * splitPos + _damping * node->split;
             LBLOG( LOG_LB2 ) << "Dampened split at Y " << splitPos << std::endl;
 
@@ -1034,7 +1163,7 @@ void LoadEqualizer::_computeSplit( Node* node, const float time,
 }
 
 void LoadEqualizer::_assign( Compound* compound, const Viewport& vp,
-                             const Range& range )
+                             const Range& range, const float work )
 {
     LBASSERTINFO( vp == Viewport::FULL || range == Range::ALL,
                   "Mixed 2D/DB load-balancing not implemented" );
@@ -1053,6 +1182,7 @@ void LoadEqualizer::_assign( Compound* compound, const Viewport& vp,
     data.range   = range;
     data.channel = compound->getChannel();
     data.taskID  = compound->getTaskID();
+    data.work    = work;
 
     const Compound* destCompound = getCompound();
     if( destCompound->getChannel() == compound->getChannel( ))
@@ -1118,6 +1248,17 @@ std::ostream& operator << ( std::ostream& os, const LoadEqualizer* lb )
     if( lb->getBoundaryf() != std::numeric_limits<float>::epsilon() )
         os << "    boundary " << lb->getBoundaryf() << std::endl;
 
+    if( lb->isLearning( ))
+        os << "    learn   ON" << std::endl;
+
+    if( !lb->getResourceModel().empty( ))
+        os << "    resource_model \"" << lb->getResourceModel() << "\""
+           << std::endl;
+
+    if( lb->getCostMapSize() != Vector2i::ZERO )
+        os << "    cost_map [ " << lb->getCostMapSize().x() << " "
+           << lb->getCostMapSize().y() << " ]" << std::endl;
+
     os << '}' << std::endl << lunchbox::enableFlush;
     return os;
 }
@@ -21,6 +21,7 @@
 
 #include "../channelListener.h" // base class
 #include "equalizer.h"          // base class
+#include "resourceModel.h"      // member
 
 #include <eq/client/types.h>
 #include <eq/fabric/range.h>    // member
@@ -33,6 +34,7 @@ namespace eq
 {
 namespace server
 {
+    class CostMap;
     class LoadEqualizer;
     std::ostream& operator << ( std::ostream& os, const LoadEqualizer* );
 
@@ -98,6 +100,47 @@ namespace server
         void setAssembleOnlyLimit( const float limit )
             { _assembleOnlyLimit = limit; }
 
+        /**
+         * Set the number of cells of the predictive cost map.
+         *
+         * With a cost map, the 2D modes keep a screen-space grid of the
+         * rendering cost fitted to the measured tile times, extrapolate it to
+         * the current frame using the motion of the load, and split the
+         * viewport by integrating the grid. Damping is not applied to these
+         * splits. A zero size, the default, disables the cost map. The DB mode
+         * does not use a cost map.
+         */
+        void setCostMapSize( const Vector2i& size );
+
+        /** @return the number of cells of the cost map. */
+        const Vector2i& getCostMapSize() const { return _costMapSize; }
+
+        /**
+         * Enable learning the relative speed of each channel.
+         *
+         * The speeds are learned from the measured render times and weight the
+         * share of the work of each channel. Without learned or loaded speeds,
+         * all channels are treated as equally fast.
+         */
+        void setLearning( const bool onOff ) { _learning = onOff; }
+
+        /** @return true if the resource speeds are learned. */
+        bool isLearning() const { return _learning; }
+
+        /**
+         * Set the file of the resource speeds.
+         *
+         * The speeds are loaded immediately to seed the splits. When learning
+         * is enabled, the updated speeds are saved to the file on config exit.
+         */
+        EQSERVER_API void setResourceModel( const std::string& filename );
+
+        /** @return the file of the resource speeds. */
+        const std::string& getResourceModel() const { return _modelFile; }
+
+        /** Save the learned resource speeds on config exit. */
+        virtual void exit();
+
         virtual uint32_t getType() const { return fabric::LOAD_EQUALIZER; }
 
     protected:
@@ -134,7 +177,8 @@ namespace server
         struct Data
         {
             Data() : channel( 0 ), taskID( 0 ), destTaskID( 0 )
-                   , time( -1 ), assembleTime( 0 ) {}
+                   , time( -1 ), assembleTime( 0 )
+                   , work( 0.f ) {}
             Channel*     channel;
             uint32_t     taskID;
             uint32_t     destTaskID;
@@ -142,6 +186,7 @@ namespace server
             eq::Range    range;
             int64_t      time;
             int64_t      assembleTime;
+            float        work; //!< assigned normalized time
         };
 
         typedef std::vector< Data > LBDatas;
@@ -152,6 +197,13 @@ namespace server
         Vector2i _boundary2i;  // default: 1 1
         float    _boundaryf;   // default: numeric_limits<float>::epsilon
         float    _assembleOnlyLimit; // default: numeric_limits<float>::max
+        Vector2i _costMapSize; // default: 0 0
+        CostMap* _costMap;     // created on first use
+
+        bool _learning;        // default: false
+        std::string _modelFile;
+        ResourceModel _resourceModel;
+        uint32_t _learnedFrame; //!< last frame used by _resourceModel
 
         //-------------------- Methods --------------------
         /** @return true if we have a valid LB tree */
@@ -164,8 +216,15 @@ namespace server
         /** Clear the tree, does not delete the nodes. */
         void _clearTree( Node* node );
 
-        /** get the total time used by the rendering. */
-        int64_t _getTotalTime();
+        /** get the total normalized time used by the rendering. */
+        float _getTotalTime();
+
+        /** @return the learned relative speed of the channel. */
+        float _getSpeed( const Channel* channel ) const;
+        std::string _getResourceName( const Channel* channel ) const;
+
+        /** Update the resource model from a complete history entry. */
+        void _learn( const LBFrameData& frameData );
 
         /** get the assembly time used by the compound which use
             the destination Channel. */
@@ -180,13 +239,15 @@ namespace server
         void   _updateNode( Node* node );
 
         /** Adjust the split of each node based on the front-most _history. */
-        void _computeSplit();
+        void _computeSplit( const uint32_t frameNumber );
+        void _updateCostMap( const uint32_t frameNumber, const LBDatas& items,
+                             const uint32_t currentFrame );
         void _removeEmpty( LBDatas& items );
 
         void _computeSplit( Node* node, const float time, LBDatas* sortedData,
                             const eq::Viewport& vp, const eq::Range& range );
         void _assign( Compound* compound, const Viewport& vp,
-                      const Range& range );
+                      const Range& range, const float work );
 
         /** Get the resource for all children compound. */
         float _getTotalResources( ) const;
@@ -0,0 +1,158 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "resourceModel.h"
+
+#include "../log.h"
+
+#include <lunchbox/debug.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+static const float _weight = .2f; //!< weight of a new sample
+static const float _maxChange = 2.f; //!< maximum speed change per sample
+static const char* _header = "# Equalizer resource model 2";
+
+float _average( const float value, const float sample, const bool first )
+{
+    return first ? sample : value + _weight * ( sample - value );
+}
+}
+
+ResourceModel::ResourceModel()
+        : _dirty( false )
+{}
+
+float ResourceModel::getSpeed( const std::string& name ) const
+{
+    const Resource* resource = find( name );
+    return resource ? resource->speed : 1.f;
+}
+
+const ResourceModel::Resource* ResourceModel::find( const std::string& name )
+    const
+{
+    Resources::const_iterator i = _resources.find( name );
+    return i == _resources.end() ? 0 : &i->second;
+}
+
+void ResourceModel::learn( const Samples& samples )
+{
+    // The work is measured in arbitrary units, scale the measured rates to keep
+    // the mean speed of the sampled resources.
+    float speeds = 0.f;
+    float rates = 0.f;
+    size_t nRates = 0;
+    for( Samples::const_iterator i = samples.begin(); i != samples.end(); ++i )
+    {
+        const Sample& sample = *i;
+        if( sample.work > 0.f && sample.time > 0.f )
+        {
+            speeds += getSpeed( sample.name );
+            rates += sample.work / sample.time;
+            ++nRates;
+        }
+    }
+    // a single resource has no relative speed
+    const float scale = nRates > 1 ? speeds / rates : 0.f;
+
+    for( Samples::const_iterator i = samples.begin(); i != samples.end(); ++i )
+    {
+        const Sample& sample = *i;
+        Resource& resource = _resources[ sample.name ];
+        const bool first = resource.nSamples == 0;
+
+        if( scale > 0.f && sample.work > 0.f && sample.time > 0.f )
+        {
+            float speed = sample.work / sample.time * scale;
+            speed = LB_MIN( speed, resource.speed * _maxChange );
+            speed = LB_MAX( speed, resource.speed / _maxChange );
+            resource.speed += _weight * ( speed - resource.speed );
+        }
+        if( sample.time > 0.f )
+            resource.pixelRate = _average( resource.pixelRate,
+                                           sample.pixels / sample.time, first );
+        ++resource.nSamples;
+
+        LBLOG( LOG_LB2 ) << "Resource " << sample.name << " speed "
+                         << resource.speed << ", " << resource.pixelRate
+                         << " pixels/ms" << std::endl;
+    }
+    _dirty = _dirty || !samples.empty();
+}
+
+bool ResourceModel::load( const std::string& filename )
+{
+    std::ifstream file( filename.c_str( ));
+    if( !file.is_open( ))
+        return false;
+
+    std::string line;
+    if( !std::getline( file, line ) || line != _header )
+    {
+        LBWARN << "Unknown resource model format in " << filename
+               << std::endl;
+        return false;
+    }
+
+    while( std::getline( file, line ))
+    {
+        std::istringstream is( line );
+        Resource resource;
+        std::string name;
+        is >> resource.speed >> resource.pixelRate >> resource.nSamples;
+        std::getline( is >> std::ws, name );
+        if( !is.fail() && !name.empty() && resource.speed > 0.f )
+            _resources[ name ] = resource;
+    }
+
+    LBINFO << "Loaded " << _resources.size() << " resources from " << filename
+           << std::endl;
+    _dirty = false;
+    return true;
+}
+
+bool ResourceModel::save( const std::string& filename )
+{
+    std::ofstream file( filename.c_str( ));
+    if( !file.is_open( ))
+    {
+        LBWARN << "Can't write resource model " << filename << std::endl;
+        return false;
+    }
+
+    file << _header << std::endl;
+    for( Resources::const_iterator i = _resources.begin();
+         i != _resources.end(); ++i )
+    {
+        const Resource& resource = i->second;
+        file << resource.speed << ' ' << resource.pixelRate << ' '
+             << resource.nSamples << ' ' << i->first << std::endl;
+    }
+    _dirty = false;
+    return true;
+}
+
+}
+}
@@ -0,0 +1,102 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_RESOURCEMODEL_H
+#define EQS_RESOURCEMODEL_H
+
+#include "../api.h"
+#include "../types.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * The learned rendering throughput of the channels of a load equalizer.
+     *
+     * The speed of a resource is the amount of work it renders per ms,
+     * relative to the other resources. Work is measured in the time units of
+     * the load equalizer's normalized cost, so a speed of two means that the
+     * resource renders twice as much as an average one in the same time.
+     * Speeds are learned by comparing the work assigned to each resource with
+     * the time it took, and are kept on a mean of one within each frame.
+     *
+     * The pixel rate is tracked alongside for analysis. The model can be
+     * saved and loaded to seed the speeds in the next session. Resources are
+     * identified by their channel names.
+     */
+    class ResourceModel
+    {
+    public:
+        /** The learned throughput of one resource. */
+        struct Resource
+        {
+            Resource() : speed( 1.f ), pixelRate( 0.f ), nSamples( 0 ) {}
+
+            float speed; //!< relative work per ms
+            float pixelRate; //!< rendered pixels per ms
+            uint32_t nSamples;
+        };
+
+        /** The measurement of one resource in one frame. */
+        struct Sample
+        {
+            Sample() : work( 0.f ), time( 0.f ), pixels( 0.f ) {}
+
+            std::string name;
+            float work; //!< assigned work, in normalized ms
+            float time; //!< measured render time in ms
+            float pixels; //!< rendered pixels
+        };
+        typedef std::vector< Sample > Samples;
+
+        EQSERVER_API ResourceModel();
+
+        /** @return the relative speed of the resource, one if unknown. */
+        EQSERVER_API float getSpeed( const std::string& name ) const;
+
+        /** @return the learned data of a resource, or 0 if unknown. */
+        EQSERVER_API const Resource* find( const std::string& name ) const;
+
+        /** Learn from the measurements of all resources of one frame. */
+        EQSERVER_API void learn( const Samples& samples );
+
+        /** @return true if no resource is known. */
+        bool isEmpty() const { return _resources.empty(); }
+
+        /** @return true if the model was changed since the last save. */
+        bool isDirty() const { return _dirty; }
+
+        /** Load a model saved before. @return true on success. */
+        EQSERVER_API bool load( const std::string& filename );
+
+        /** Save the model. @return true on success. */
+        EQSERVER_API bool save( const std::string& filename );
+
+    private:
+        typedef std::map< std::string, Resource > Resources;
+        Resources _resources;
+        bool _dirty;
+    };
+}
+}
+
+#endif // EQS_RESOURCEMODEL_H
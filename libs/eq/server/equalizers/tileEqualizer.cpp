@@ -18,8 +18,10 @@
  */
 
 #include "types.h"
+#include "channel.h"
 #include "compound.h"
 #include "config.h"
+#include "log.h"
 #include "tileQueue.h"
 #include "compoundVisitor.h"
 #include "server.h"
@@ -27,12 +29,31 @@
 
 #include "tileEqualizer.h"
 
+#include <eq/client/statistic.h>
+#include <lunchbox/scopedMutex.h>
+
 namespace eq
 {
 namespace server
 {
 namespace
 {
+/** Overhead per render time above which the tiles are enlarged. */
+static const float _maxOverhead = .1f;
+/** Overhead per render time below which the tiles are reduced. */
+static const float _minOverhead = .025f;
+/** Tiles per channel needed to balance the load. */
+static const size_t _minTilesPerChannel = 4;
+static const int32_t _minTileSize = 16;
+/** Weight of a new throughput measurement. */
+static const float _rateWeight = .5f;
+static const size_t _maxSizeChanges = 16;
+
+size_t _getNumTiles( const PixelViewport& pvp, const Vector2i& size )
+{
+    return size_t(( pvp.w + size.x() - 1 ) / size.x( )) *
+           size_t(( pvp.h + size.y() - 1 ) / size.y( ));
+}
 
 TileQueue* _findQueue( const std::string& name, const TileQueues& queues )
 {
@@ -57,8 +78,12 @@ public:
     /** Visit a leaf compound. */
     virtual VisitorResult visitLeaf( Compound* compound )
     {
-        if( _findQueue( _name, compound->getInputTileQueues( )))
+        TileQueue* queue = _findQueue( _name, compound->getInputTileQueues( ));
+        if( queue )
+        {
+            _queues.push_back( queue );
             return TRAVERSE_CONTINUE;
+        }
 
         // reset compound viewport to (0, 0, 1, 1) (#108)
         if( !compound->getViewport().hasArea() )
@@ -72,12 +97,16 @@ public:
         input->setAutoObsolete( compound->getConfig()->getLatency( ));
 
         compound->addInputTileQueue( input );
+        _queues.push_back( input );
         return TRAVERSE_CONTINUE;
     }
 
+    const TileQueues& getQueues() const { return _queues; }
+
 private:
     const eq::fabric::Vector2i& _tileSize;
     const std::string& _name;
+    TileQueues _queues;
 };
 
 class InputQueueDestroyer : public CompoundVisitor
@@ -114,6 +143,7 @@ TileEqualizer::TileEqualizer()
     : Equalizer()
     , _created( false )
     , _size( 64, 64 )
+    , _currentSize( _size )
     , _name( "TileEqualizer" )
 {
 }
@@ -122,10 +152,16 @@ TileEqualizer::TileEqualizer( const TileEqualizer& from )
     : Equalizer( from )
     , _created( from._created )
     , _size( from._size )
+    , _currentSize( from._size )
     , _name( from._name )
 {
 }
 
+TileEqualizer::~TileEqualizer()
+{
+    _clearSlots();
+}
+
 void TileEqualizer::_createQueues( Compound* compound )
 {
     _created = true;
@@ -144,10 +180,26 @@ void TileEqualizer::_createQueues( Compound* compound )
 
     InputQueueCreator creator( _size, name );
     compound->accept( creator );
+
+    const TileQueues& queues = creator.getQueues();
+    for( TileQueuesCIter i = queues.begin(); i != queues.end(); ++i )
+    {
+        TileQueue* queue = *i;
+        Channel* channel = queue->getChannel();
+        if( channel )
+            channel->addListener( this );
+        _slots.push_back( Slot( queue ));
+    }
+
+    _currentSize = _size;
+    _sizes.clear();
+    _sizes.push_back( SizeChange( 0, _size ));
 }
 
 void TileEqualizer::_destroyQueues( Compound* compound )
 {
+    _clearSlots();
+
     const std::string name = std::string( "queue." ) + _name;
     TileQueue* q = _findQueue( name, compound->getOutputTileQueues() );
     if ( q )
@@ -164,14 +216,218 @@ void TileEqualizer::_destroyQueues( Compound* compound )
     _created = false;
 }
 
+void TileEqualizer::_clearSlots()
+{
+    for( Slots::const_iterator i = _slots.begin(); i != _slots.end(); ++i )
+    {
+        Channel* channel = i->queue->getChannel();
+        if( channel )
+            channel->removeListener( this );
+    }
+    _slots.clear();
+}
+
 void TileEqualizer::notifyUpdatePre( Compound* compound, 
                                      const uint32_t frameNumber )
 {
+    // the queues are (de)registered during the concurrent compound update
     if( isActive() && !_created )
+    {
+        lunchbox::ScopedWrite mutex(
+            compound->getConfig()->getRegistrationLock( ));
         _createQueues( compound );
-    
+    }
+
     if( !isActive() && _created )
+    {
+        lunchbox::ScopedWrite mutex(
+            compound->getConfig()->getRegistrationLock( ));
         _destroyQueues( compound );
+    }
+
+    if( !_created )
+        return;
+
+    const std::string name = std::string( "queue." ) + _name;
+    TileQueue* output = _findQueue( name, compound->getOutputTileQueues( ));
+    if( !output )
+        return;
+
+    _updateTileSize( compound, frameNumber );
+    output->setTileSize( _currentSize );
+    _updateShares( output );
+}
+
+void TileEqualizer::notifyLoadData( Channel* channel,
+                                    const uint32_t frameNumber,
+                                    const Statistics& statistics,
+                                    const Viewport& region )
+{
+    const Vector2i* size = _getTileSize( frameNumber );
+    if( !size )
+        return;
+
+    for( Slots::iterator i = _slots.begin(); i != _slots.end(); ++i )
+    {
+        Slot& slot = *i;
+        if( slot.queue->getChannel() != channel ||
+            frameNumber <= slot.frameNumber )
+        {
+            continue;
+        }
+
+        const uint32_t taskID = slot.queue->getCompound()->getTaskID();
+        int64_t work = 0;
+        int64_t time = 0;
+        uint32_t nTiles = 0;
+        for( size_t j = 0; j < statistics.size(); ++j )
+        {
+            const Statistic& stat = statistics[j];
+            if( stat.task != taskID )
+                continue;
+
+            switch( stat.type )
+            {
+            case Statistic::CHANNEL_CLEAR:
+            case Statistic::CHANNEL_DRAW:
+            case Statistic::CHANNEL_READBACK:
+                work += stat.endTime - stat.startTime;
+                break;
+
+            case Statistic::CHANNEL_TILES:
+                time = stat.endTime - stat.startTime;
+                nTiles = uint32_t( stat.ratio + .5f );
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        if( nTiles == 0 || time <= 0 )
+            continue;
+
+        const float pixels = float( nTiles ) * size->x() * size->y();
+        const float rate = pixels / float( time );
+        slot.rate = slot.rate > 0.f ? slot.rate + _rateWeight * (rate-slot.rate)
+                                    : rate;
+        slot.frameNumber = frameNumber;
+        slot.nTiles = nTiles;
+        slot.work = float( work );
+        slot.overhead = float( LB_MAX( time - work, 0 ));
+
+        LBLOG( LOG_LB2 ) << channel->getName() << " rendered " << nTiles
+                         << " tiles of " << *size << " in " << time << "ms, "
+                         << slot.overhead << "ms overhead" << std::endl;
+    }
+}
+
+const Vector2i* TileEqualizer::_getTileSize( const uint32_t frameNumber ) const
+{
+    for( std::deque< SizeChange >::const_reverse_iterator i = _sizes.rbegin();
+         i != _sizes.rend(); ++i )
+    {
+        if( i->first <= frameNumber )
+            return &i->second;
+    }
+    return 0;
+}
+
+void TileEqualizer::_updateTileSize( const Compound* compound,
+                                     const uint32_t frameNumber )
+{
+    const PixelViewport& pvp = compound->getInheritPixelViewport();
+    if( !pvp.hasArea() || _slots.empty( ))
+        return;
+
+    // use only measurements of the current tile size
+    const uint32_t since = _sizes.back().first;
+    float work = 0.f;
+    float overhead = 0.f;
+    size_t nTiles = 0;
+    for( Slots::const_iterator i = _slots.begin(); i != _slots.end(); ++i )
+    {
+        const Slot& slot = *i;
+        if( slot.nTiles == 0 || slot.frameNumber < since )
+            continue;
+        work += slot.work;
+        overhead += slot.overhead;
+        nTiles += slot.nTiles;
+    }
+    if( nTiles == 0 )
+        return;
+
+    const Vector2i size = adaptTileSize( _currentSize, pvp, work, overhead,
+                                         _slots.size( ));
+    if( size == _currentSize )
+        return;
+
+    LBLOG( LOG_LB1 ) << "Tile size " << size << " for " << nTiles
+                     << " tiles with " << overhead << "ms overhead and "
+                     << work << "ms render time" << std::endl;
+    _currentSize = size;
+    _sizes.push_back( SizeChange( frameNumber, size ));
+    if( _sizes.size() > _maxSizeChanges )
+        _sizes.pop_front();
+}
+
+Vector2i TileEqualizer::adaptTileSize( const Vector2i& current,
+                                      const PixelViewport& pvp,
+                                      const float work, const float overhead,
+                                      const size_t nChannels )
+{
+    const size_t minTiles = nChannels * _minTilesPerChannel;
+    Vector2i size = current;
+    if( work > 0.f && overhead > work * _maxOverhead )
+    {
+        // enlarge the smaller dimension, unless too few tiles would be left
+        if( size.x() <= size.y( ))
+            size.x() = LB_MIN( size.x() * 2, pvp.w );
+        else
+            size.y() = LB_MIN( size.y() * 2, pvp.h );
+
+        if( _getNumTiles( pvp, size ) < minTiles )
+            return current;
+    }
+    else if( overhead < work * _minOverhead ||
+             _getNumTiles( pvp, size ) < minTiles )
+    {
+        if( size.x() >= size.y( ))
+            size.x() = LB_MAX( size.x() / 2, _minTileSize );
+        else
+            size.y() = LB_MAX( size.y() / 2, _minTileSize );
+    }
+    return size;
+}
+
+void TileEqualizer::_updateShares( TileQueue* output )
+{
+    float rates = 0.f;
+    size_t nRates = 0;
+    for( Slots::const_iterator i = _slots.begin(); i != _slots.end(); ++i )
+    {
+        if( i->rate > 0.f )
+        {
+            rates += i->rate;
+            ++nRates;
+        }
+    }
+
+    TileQueues queues;
+    std::vector< float > shares;
+    if( nRates == 0 ) // no measurements yet, use one shared queue
+    {
+        output->setShares( queues, shares );
+        return;
+    }
+
+    const float average = rates / float( nRates );
+    for( Slots::const_iterator i = _slots.begin(); i != _slots.end(); ++i )
+    {
+        queues.push_back( i->queue );
+        shares.push_back( i->rate > 0.f ? i->rate : average );
+    }
+    output->setShares( queues, shares );
 }
 
 std::ostream& operator << ( std::ostream& os, const TileEqualizer* lb )
@@ -19,7 +19,11 @@
 #ifndef EQS_TILEEQUALIZER_H
 #define EQS_TILEEQUALIZER_H
 
-#include "equalizer.h"
+#include "../channelListener.h" // base class
+#include "equalizer.h"          // base class
+
+#include <deque>
+#include <vector>
 
 namespace eq
 {
@@ -29,12 +33,21 @@ namespace server
 class TileEqualizer;
 std::ostream& operator << ( std::ostream& os, const TileEqualizer* );
 
-class TileEqualizer : public Equalizer
+/**
+ * Distributes the tiles of a compound to its leaf channels.
+ *
+ * The tile size is adapted each frame from the measured per-tile rendering
+ * time and queue overhead, starting from the configured size. Each channel
+ * preferably renders a consecutive range of tiles proportional to its measured
+ * throughput, so that it renders the same screen area in subsequent frames, and
+ * takes tiles from the neighboring ranges when its own range is done.
+ */
+class TileEqualizer : public Equalizer, protected ChannelListener
 {
 public:
     EQSERVER_API TileEqualizer();
     TileEqualizer( const TileEqualizer& from );
-    ~TileEqualizer() {};
+    virtual ~TileEqualizer();
 
     /** @sa CompoundListener::notifyUpdatePre */
     virtual void notifyUpdatePre( Compound* compound,
@@ -43,27 +56,79 @@ public:
     virtual void toStream( std::ostream& os ) const { os << this; }
     void setName( const std::string& name ) { _name = name; }
 
-    void setTileSize( const Vector2i& size ) { _size = size; }
+    void setTileSize( const Vector2i& size )
+        { _size = size; _currentSize = size; }
 
     const std::string& getName() const { return _name; }
 
     const Vector2i& getTileSize() const { return _size; }
 
+    /** @return the tile size used in the current frame. */
+    const Vector2i& getCurrentTileSize() const { return _currentSize; }
+
     virtual uint32_t getType() const { return fabric::TILE_EQUALIZER; }
 
+    /**
+     * @return the tile size for the next frame, given the current tile size,
+     *         the destination area and the render time and queue overhead
+     *         of all channels measured with the current size.
+     *
+     * The smaller dimension is doubled if the overhead exceeds 10% of the
+     * render time, unless fewer than four tiles per channel would be left. The
+     * larger dimension is halved, down to 16 pixels, if the overhead is below
+     * 2.5% of the render time or if there are too few tiles.
+     */
+    EQSERVER_API static Vector2i adaptTileSize( const Vector2i& current,
+                                                const PixelViewport& pvp,
+                                                const float work,
+                                                const float overhead,
+                                                const size_t nChannels );
+
 protected:
 
     virtual void notifyChildAdded( Compound* compound, Compound* child ) {}
     virtual void notifyChildRemove( Compound* compound, Compound* child ) {}
 
+    /** @sa ChannelListener::notifyLoadData */
+    virtual void notifyLoadData( Channel* channel, const uint32_t frameNumber,
+                                 const Statistics& statistics,
+                                 const Viewport& region );
+
 private:
-    
+    /** The measurements of one input queue. */
+    struct Slot
+    {
+        Slot( TileQueue* queue_ ) : queue( queue_ ), frameNumber( 0 )
+                                  , nTiles( 0 ), rate( 0.f ), work( 0.f )
+                                  , overhead( 0.f ) {}
+
+        TileQueue* queue;
+        uint32_t frameNumber; //!< of the last measurement
+        uint32_t nTiles; //!< rendered in the last measured frame
+        float rate; //!< averaged pixels per ms
+        float work; //!< render time in the last measured frame
+        float overhead; //!< non-render time in the last measured frame
+    };
+    typedef std::vector< Slot > Slots;
+
+    /** The tile size changes, with the first frame using the size. */
+    typedef std::pair< uint32_t, Vector2i > SizeChange;
+
     void _destroyQueues( Compound* compound );
     void _createQueues( Compound* compound );
+    void _clearSlots();
+
+    const Vector2i* _getTileSize( const uint32_t frameNumber ) const;
+    void _updateTileSize( const Compound* compound,
+                          const uint32_t frameNumber );
+    void _updateShares( TileQueue* output );
 
     bool _created;
     Vector2i _size;
+    Vector2i _currentSize;
     std::string _name;
+    Slots _slots;
+    std::deque< SizeChange > _sizes;
 };
 
 } //server
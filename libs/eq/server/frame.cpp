@@ -19,11 +19,13 @@
 #include "frame.h"
 
 #include "compound.h"
+#include "config.h"
 #include "frameData.h"
 #include "node.h"
 
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
+#include <lunchbox/scopedMutex.h>
 
 namespace eq
 {
@@ -134,6 +136,8 @@ void Frame::cycleData( const uint32_t frameNumber, const Compound* compound )
         {
             data = new FrameData;
 
+            lunchbox::ScopedWrite mutex(
+                compound->getConfig()->getRegistrationLock( ));
             getLocalNode()->registerObject( data );
             data->setAutoObsolete( 1 ); // current + in use by render nodes
         }
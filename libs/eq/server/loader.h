@@ -23,6 +23,9 @@
 #include "types.h"
 
 #include <iostream>
+#include <vector>
+
+int eqLoader_parse();
 
 namespace eq
 {
@@ -108,8 +111,13 @@ namespace server
         EQSERVER_API static void addDefaultObserver( ServerPtr server );
 
     private:
+        /** The radix-k of the compounds being parsed, 0 for none. */
+        std::vector< uint32_t > _radices;
+
         void _parseString( const char* config );
         void _parse();
+
+        friend int ::eqLoader_parse();
     };
 }
 }
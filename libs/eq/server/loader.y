@@ -39,6 +39,7 @@
 #include "pipe.h"
 #include "segment.h"
 #include "server.h"
+#include "sortLast.h"
 #include "view.h"
 #include "window.h"
 
@@ -102,6 +103,7 @@
 %token EQTOKEN_GLOBAL
 %token EQTOKEN_CHANNEL_IATTR_HINT_STATISTICS
 %token EQTOKEN_CHANNEL_IATTR_HINT_SENDTOKEN
+%token EQTOKEN_CHANNEL_IATTR_TILE_PREFETCH
 %token EQTOKEN_COMPOUND_IATTR_STEREO_MODE
 %token EQTOKEN_COMPOUND_IATTR_STEREO_ANAGLYPH_LEFT_MASK
 %token EQTOKEN_COMPOUND_IATTR_STEREO_ANAGLYPH_RIGHT_MASK
@@ -114,6 +116,8 @@
 %token EQTOKEN_CONFIG_FATTR_EYE_BASE
 %token EQTOKEN_CONFIG_FATTR_FOCUS_DISTANCE
 %token EQTOKEN_CONFIG_IATTR_ROBUSTNESS
+%token EQTOKEN_CONFIG_IATTR_STATISTICS_BATCH
+%token EQTOKEN_CONFIG_IATTR_MIN_PARALLEL_UPDATES
 %token EQTOKEN_CONFIG_IATTR_FOCUS_MODE
 %token EQTOKEN_NODE_SATTR_LAUNCH_COMMAND
 %token EQTOKEN_NODE_CATTR_LAUNCH_COMMAND_QUOTE
@@ -153,6 +157,7 @@
 %token EQTOKEN_HINT_DECORATION
 %token EQTOKEN_HINT_STATISTICS
 %token EQTOKEN_HINT_SENDTOKEN
+%token EQTOKEN_TILE_PREFETCH
 %token EQTOKEN_HINT_SWAPSYNC
 %token EQTOKEN_HINT_DRAWABLE
 %token EQTOKEN_HINT_THREAD
@@ -229,6 +234,8 @@
 %token EQTOKEN_FOCUS_DISTANCE
 %token EQTOKEN_FOCUS_MODE
 %token EQTOKEN_ROBUSTNESS
+%token EQTOKEN_STATISTICS_BATCH
+%token EQTOKEN_MIN_PARALLEL_UPDATES
 %token EQTOKEN_THREAD_MODEL
 %token EQTOKEN_ASYNC
 %token EQTOKEN_DRAW_SYNC
@@ -251,6 +258,7 @@
 %token EQTOKEN_RANGE
 %token EQTOKEN_PERIOD
 %token EQTOKEN_PHASE
+%token EQTOKEN_RADIX
 %token EQTOKEN_PIXEL
 %token EQTOKEN_SUBPIXEL
 %token EQTOKEN_BANDWIDTH
@@ -283,6 +291,9 @@
 %token EQTOKEN_MODE
 %token EQTOKEN_2D
 %token EQTOKEN_ASSEMBLE_ONLY_LIMIT
+%token EQTOKEN_COST_MAP
+%token EQTOKEN_RESOURCE_MODEL
+%token EQTOKEN_LEARN
 %token EQTOKEN_DB
 %token EQTOKEN_BOUNDARY
 %token EQTOKEN_ZOOM
@@ -371,6 +382,16 @@ global:
          eq::server::Global::instance()->setConfigIAttribute(
              eq::server::Config::IATTR_ROBUSTNESS, $2 );
      }
+     | EQTOKEN_CONFIG_IATTR_STATISTICS_BATCH IATTR
+     {
+         eq::server::Global::instance()->setConfigIAttribute(
+             eq::server::Config::IATTR_STATISTICS_BATCH, $2 );
+     }
+     | EQTOKEN_CONFIG_IATTR_MIN_PARALLEL_UPDATES UNSIGNED
+     {
+         eq::server::Global::instance()->setConfigIAttribute(
+             eq::server::Config::IATTR_MIN_PARALLEL_UPDATES, $2 );
+     }
      | EQTOKEN_NODE_SATTR_LAUNCH_COMMAND STRING
      {
          eq::server::Global::instance()->setNodeSAttribute(
@@ -506,6 +527,11 @@ global:
          eq::server::Global::instance()->setChannelIAttribute(
              eq::server::Channel::IATTR_HINT_SENDTOKEN, $2 );
      }
+     | EQTOKEN_CHANNEL_IATTR_TILE_PREFETCH IATTR
+     {
+         eq::server::Global::instance()->setChannelIAttribute(
+             eq::server::Channel::IATTR_TILE_PREFETCH, $2 );
+     }
      | EQTOKEN_COMPOUND_IATTR_STEREO_MODE IATTR 
      { 
          eq::server::Global::instance()->setCompoundIAttribute( 
@@ -578,6 +604,10 @@ configAttribute:
                              eq::server::Config::FATTR_EYE_BASE, $2 ); }
     | EQTOKEN_ROBUSTNESS IATTR { config->setIAttribute( 
                                  eq::server::Config::IATTR_ROBUSTNESS, $2 ); }
+    | EQTOKEN_STATISTICS_BATCH IATTR { config->setIAttribute(
+                           eq::server::Config::IATTR_STATISTICS_BATCH, $2 ); }
+    | EQTOKEN_MIN_PARALLEL_UPDATES UNSIGNED { config->setIAttribute(
+                       eq::server::Config::IATTR_MIN_PARALLEL_UPDATES, $2 ); }
 
 node: appNode | renderNode
 renderNode: EQTOKEN_NODE '{' {
@@ -750,6 +780,9 @@ channelAttribute:
     | EQTOKEN_HINT_SENDTOKEN IATTR
         { channel->setIAttribute( eq::server::Channel::IATTR_HINT_SENDTOKEN,
                                   $2 ); }
+    | EQTOKEN_TILE_PREFETCH IATTR
+        { channel->setIAttribute( eq::server::Channel::IATTR_TILE_PREFETCH,
+                                  $2 ); }
 
 
 observer: EQTOKEN_OBSERVER '{' { observer = new eq::server::Observer( config );}
@@ -881,9 +914,21 @@ compound: EQTOKEN_COMPOUND '{'
                       eqCompound = new eq::server::Compound( eqCompound );
                   else
                       eqCompound = new eq::server::Compound( config );
+                  loader->_radices.push_back( 0 );
               }
           compoundFields 
-          '}' { eqCompound = eqCompound->getParent(); } 
+          '}'
+              {
+                  const uint32_t radix = loader->_radices.back();
+                  loader->_radices.pop_back();
+                  if( radix &&
+                      !eq::server::SortLast::addRadixK( eqCompound, radix ))
+                  {
+                      yyerror( "Can't generate radix-k compositing" );
+                      YYERROR;
+                  }
+                  eqCompound = eqCompound->getParent();
+              }
 
 compoundFields: /*null*/ | compoundFields compoundField
 compoundField: 
@@ -936,6 +981,7 @@ compoundField:
         { eqCompound->setRange( eq::Range( $3, $4 )); }
     | EQTOKEN_PERIOD UNSIGNED { eqCompound->setPeriod( $2 ); }
     | EQTOKEN_PHASE  UNSIGNED { eqCompound->setPhase( $2 ); }
+    | EQTOKEN_RADIX  UNSIGNED { loader->_radices.back() = $2; }
     | EQTOKEN_ZOOM '[' FLOAT FLOAT ']'
         { eqCompound->setZoom( eq::Zoom( $3, $4 )); }
     | EQTOKEN_PIXEL '[' UNSIGNED UNSIGNED UNSIGNED UNSIGNED ']'
@@ -1208,6 +1254,12 @@ loadEqualizerField:
                            { loadEqualizer->setAssembleOnlyLimit( $2 ); }
     | EQTOKEN_BOUNDARY FLOAT        { loadEqualizer->setBoundary( $2 ); }
     | EQTOKEN_MODE loadEqualizerMode    { loadEqualizer->setMode( $2 ); }
+    | EQTOKEN_COST_MAP '[' UNSIGNED UNSIGNED ']'
+                 { loadEqualizer->setCostMapSize( eq::Vector2i( $3, $4 )); }
+    | EQTOKEN_RESOURCE_MODEL STRING
+                                { loadEqualizer->setResourceModel( $2 ); }
+    | EQTOKEN_LEARN IATTR
+                    { loadEqualizer->setLearning( $2 == eq::fabric::ON ); }
 
 loadEqualizerMode: 
     EQTOKEN_2D           { $$ = eq::server::LoadEqualizer::MODE_2D; }
@@ -1411,6 +1463,7 @@ void Loader::_parse()
 
     loader::server = 0;
     config = 0;
+    _radices.clear();
 
     const std::string oldLocale = setlocale( LC_NUMERIC, "C" ); 
     const bool error = ( eqLoader_parse() != 0 );
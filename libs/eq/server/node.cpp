@@ -68,6 +68,7 @@ Node::Node( Config* parent )
     , _state( STATE_STOPPED )
     , _bufferedTasks( new co::BufferConnection )
     , _lastDrawPipe( 0 )
+    , _clockLatency( 0 )
 {
     const Global* global = Global::instance();
     for( int i=0; i < Node::SATTR_LAST; ++i )
@@ -704,7 +705,13 @@ co::ObjectOCommand Node::send( const uint32_t cmd, const UUID& id )
 
 void Node::flushSendBuffer()
 {
-    _bufferedTasks->sendBuffer( _node->getConnection( ));
+    if( _node ) // tasks are kept until the node is connected
+        _bufferedTasks->sendBuffer( _node->getConnection( ));
+}
+
+uint64_t Node::getSendBufferSize() const
+{
+    return _bufferedTasks->getSize();
 }
 
 //===========================================================================
@@ -736,9 +743,7 @@ bool Node::_cmdFrameFinishReply( co::ICommand& cmd )
     LBVERB << "handle frame finish reply " << command << std::endl;
 
     const uint32_t frameNumber = command.get< uint32_t >();
-
-    _finishedFrame = frameNumber;
-    getConfig()->notifyNodeFrameFinished( frameNumber );
+    getConfig()->notifyNodeFrameFinished( this, frameNumber );
 
     return true;
 }
@@ -30,6 +30,7 @@
 #include <co/bufferConnection.h>
 #include <co/connectionDescription.h>
 #include <co/node.h>
+#include <lunchbox/atomic.h>
 
 #include <vector>
 
@@ -96,6 +97,16 @@ namespace server
 
         /** @return the number of the last finished frame. @internal */
         uint32_t getFinishedFrame() const { return _finishedFrame; }
+
+        /** Set the last finished frame, under the config's lock. @internal */
+        void setFinishedFrame( const uint32_t frame ) { _finishedFrame = frame; }
+
+        /** @return the one-way latency of clock syncs in ms. @internal */
+        int64_t getClockLatency() const { return _clockLatency; }
+
+        /** Set the latency measured by the last clock sync. @internal */
+        void setClockLatency( const int64_t latency )
+            { _clockLatency = int32_t( latency ); }
         //@}
 
         /**
@@ -121,7 +132,7 @@ namespace server
         void configExit();
 
         /** Sync exit of this entity. */
-        bool syncConfigExit();
+        EQSERVER_API bool syncConfigExit();
 
         /**
          * Trigger the rendering of a new frame for this node.
@@ -173,6 +184,9 @@ namespace server
 
         void flushSendBuffer();
 
+        /** @internal @return the size of the tasks buffered but not sent. */
+        EQSERVER_API uint64_t getSendBufferSize() const;
+
         /**
          * Add a new description how this node can be reached.
          *
@@ -279,6 +293,9 @@ namespace server
         /** The last draw pipe for this entity */
         const Pipe* _lastDrawPipe;
 
+        /** Half the round trip time of the last clock sync. */
+        lunchbox::a_int32_t _clockLatency;
+
         struct Private;
         Private* _private; // placeholder for binary-compatible changes
 
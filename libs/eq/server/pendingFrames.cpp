@@ -0,0 +1,93 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pendingFrames.h"
+
+#include <lunchbox/debug.h>
+
+namespace eq
+{
+namespace server
+{
+
+PendingFrames::PendingFrames()
+        : _finishedFrame( 0 )
+        , _finishTime( 0 )
+{
+}
+
+void PendingFrames::clear()
+{
+    _finishedFrame = 0;
+    _finishTime = 0;
+    _frames.clear();
+}
+
+void PendingFrames::push( const uint32_t nNodes )
+{
+    _frames.push_back( Frame( nNodes ));
+    if( nNodes == 0 )
+        _frames.back().releaseTime = _clock.getTime64();
+}
+
+void PendingFrames::release( const uint32_t lastFrame,
+                             const uint32_t frameNumber )
+{
+    LBASSERTINFO( frameNumber <= getStartedFrame(),
+                  frameNumber << " > " << getStartedFrame( ));
+
+    for( uint32_t i = LB_MAX( lastFrame, _finishedFrame ); i < frameNumber;
+         ++i )
+    {
+        const size_t index = i - _finishedFrame;
+        if( index >= _frames.size( ))
+            break;
+
+        // each node is counted once per frame and releases it once
+        Frame& frame = _frames[ index ];
+        LBASSERTINFO( frame.count > 0, "frame " << i + 1 );
+        if( frame.count > 0 && --frame.count == 0 )
+            frame.releaseTime = _clock.getTime64();
+    }
+}
+
+bool PendingFrames::pop()
+{
+    const uint32_t finishedFrame = _finishedFrame;
+    while( !_frames.empty() && _frames.front().count == 0 )
+    {
+        _finishTime = _frames.front().releaseTime;
+        _frames.pop_front();
+        ++_finishedFrame;
+    }
+    return _finishedFrame != finishedFrame;
+}
+
+uint32_t PendingFrames::getCount( const uint32_t frameNumber ) const
+{
+    if( frameNumber <= _finishedFrame || frameNumber > getStartedFrame( ))
+        return 0;
+    return _frames[ frameNumber - _finishedFrame - 1 ].count;
+}
+
+float PendingFrames::getFinishDelay() const
+{
+    return _clock.getTimef() - float( _finishTime );
+}
+
+}
+}
@@ -0,0 +1,104 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_PENDINGFRAMES_H
+#define EQS_PENDINGFRAMES_H
+
+#include "api.h"
+#include "types.h"
+
+#include <lunchbox/clock.h> // member
+
+#include <deque>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Counts the running nodes which have not yet finished each started frame
+     * after the last finished frame.
+     *
+     * Not thread-safe, the config serializes the access.
+     */
+    class PendingFrames
+    {
+    public:
+        EQSERVER_API PendingFrames();
+
+        /** Forget all frames and restart with frame one. */
+        EQSERVER_API void clear();
+
+        /** Start the next frame, to be finished by the given nodes. */
+        EQSERVER_API void push( const uint32_t nNodes );
+
+        /**
+         * Release the frames finished by one node.
+         *
+         * Used both for finish replies and for failed nodes, which will not
+         * finish their outstanding frames.
+         *
+         * @param lastFrame the last frame the node had finished before.
+         * @param frameNumber the last frame the node has finished now.
+         */
+        EQSERVER_API void release( const uint32_t lastFrame,
+                                   const uint32_t frameNumber );
+
+        /**
+         * Remove the frames finished by all nodes.
+         *
+         * @return true if the last finished frame has advanced.
+         */
+        EQSERVER_API bool pop();
+
+        /** @return the last frame finished by all nodes, or 0. */
+        uint32_t getFinishedFrame() const { return _finishedFrame; }
+
+        /** @return the last started frame, or 0. */
+        uint32_t getStartedFrame() const
+            { return _finishedFrame + uint32_t( _frames.size( )); }
+
+        /** @return the number of unfinished nodes of a started frame. */
+        EQSERVER_API uint32_t getCount( const uint32_t frameNumber ) const;
+
+        /**
+         * @return the time in ms since the last node finished the last
+         *         finished frame.
+         */
+        EQSERVER_API float getFinishDelay() const;
+
+    private:
+        struct Frame
+        {
+            explicit Frame( const uint32_t nNodes )
+                : count( nNodes ), releaseTime( 0 ) {}
+
+            uint32_t count; //!< unfinished nodes
+            int64_t releaseTime; //!< when the count reached zero
+        };
+
+        lunchbox::Clock _clock;
+        uint32_t _finishedFrame;
+        int64_t _finishTime; //!< release time of the last finished frame
+
+        /** The frames after the last finished frame. */
+        std::deque< Frame > _frames;
+    };
+}
+}
+
+#endif // EQS_PENDINGFRAMES_H
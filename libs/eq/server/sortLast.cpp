@@ -0,0 +1,216 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sortLast.h"
+
+#include "compound.h"
+#include "frame.h"
+
+#include <eq/client/frame.h>
+#include <lunchbox/atomic.h>
+
+#include <sstream>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+lunchbox::a_int32_t _counter;
+
+/** Compute the part-th of n equal parts of [start, end]. */
+void _split( const float start, const float end, const uint32_t n,
+             const uint32_t part, float& partStart, float& partEnd )
+{
+    const float size = end - start;
+    partStart = start + size * float( part ) / float( n );
+    // last part - correct rounding 'error'
+    partEnd = ( part + 1 == n ) ? end :
+                                  start + size * float( part + 1 ) / float( n );
+}
+
+std::string _getFrameName( const std::string& prefix, const size_t round,
+                           const uint32_t from, const uint32_t to )
+{
+    std::ostringstream name;
+    name << prefix << ".round" << round << '.' << from << '.' << to;
+    return name.str();
+}
+}
+
+std::vector< uint32_t > SortLast::computeRounds( const uint32_t nSources,
+                                                 const uint32_t radix )
+{
+    std::vector< uint32_t > factors;
+    uint32_t n = nSources;
+    for( uint32_t factor = 2; factor * factor <= n; ++factor )
+    {
+        while( n % factor == 0 )
+        {
+            factors.push_back( factor );
+            n /= factor;
+        }
+    }
+    if( n > 1 )
+        factors.push_back( n );
+
+    // Greedily pack the prime factors, largest first, into rounds of at most
+    // radix sources. Factors larger than the radix form a direct-send round.
+    std::vector< uint32_t > rounds;
+    for( std::vector< uint32_t >::const_reverse_iterator i = factors.rbegin();
+         i != factors.rend(); ++i )
+    {
+        const uint32_t factor = *i;
+        bool packed = false;
+        for( size_t j = 0; j < rounds.size() && !packed; ++j )
+        {
+            if( rounds[ j ] * factor <= radix )
+            {
+                rounds[ j ] *= factor;
+                packed = true;
+            }
+        }
+        if( !packed )
+            rounds.push_back( factor );
+    }
+    return rounds;
+}
+
+bool SortLast::addRadixK( Compound* compound, const uint32_t radix )
+{
+    if( radix < 2 )
+    {
+        LBWARN << "Radix-k compositing needs a radix of at least two, not "
+               << radix << std::endl;
+        return false;
+    }
+
+    const Compounds children = compound->getChildren();
+    if( children.size() < 2 )
+    {
+        LBWARN << "Radix-k compositing needs at least two source compounds"
+               << std::endl;
+        return false;
+    }
+
+    bool hasRange = false;
+    for( CompoundsCIter i = children.begin(); i != children.end(); ++i )
+    {
+        const Compound* child = *i;
+        if( !child->isLeaf() || !child->getInputFrames().empty() ||
+            !child->getOutputFrames().empty( ))
+        {
+            LBWARN << "Radix-k compositing sources have to be leaf compounds "
+                   << "without frames" << std::endl;
+            return false;
+        }
+        if( child->getRange() != Range::ALL )
+            hasRange = true;
+    }
+
+    const uint32_t nSources = uint32_t( children.size( ));
+    const std::vector< uint32_t > rounds = computeRounds( nSources, radix );
+    const size_t nRounds = rounds.size();
+    const Channel* channel = compound->getChannel();
+
+    std::ostringstream prefixStream;
+    prefixStream << "Frame.radixK" << ++_counter;
+    const std::string& prefix = prefixStream.str();
+
+    for( uint32_t i = 0; i < nSources; ++i )
+    {
+        Compound* source = children[ i ];
+        if( !hasRange )
+        {
+            const float start = float( i ) / float( nSources );
+            const float end = ( i + 1 == nSources ) ?
+                                  1.f : float( i + 1 ) / float( nSources );
+            source->setRange( Range( start, end ));
+        }
+
+        // levels[r] assembles round r, levels[0] draws the source range
+        std::vector< Compound* > levels( nRounds + 1 );
+        levels[ nRounds ] = source;
+        for( size_t r = nRounds; r > 0; --r )
+        {
+            levels[ r - 1 ] = new Compound( levels[ r ] );
+            if( r > 1 ) // source or parent clears
+                levels[ r - 1 ]->setTasks( fabric::TASK_ASSEMBLE |
+                                           fabric::TASK_READBACK );
+        }
+
+        // The sources are indexed by a mixed-radix number, one digit per
+        // round. Group partners of a round differ only in the round's digit.
+        float start = 0.f;
+        float end = 1.f;
+        uint32_t stride = 1;
+        for( size_t r = 1; r <= nRounds; ++r )
+        {
+            const uint32_t k = rounds[ r - 1 ];
+            const uint32_t digit = ( i / stride ) % k;
+            const uint32_t first = i - digit * stride;
+
+            for( uint32_t j = 0; j < k; ++j )
+            {
+                if( j == digit ) // own part, stays in place
+                    continue;
+
+                const uint32_t partner = first + j * stride;
+                float partStart = 0.f;
+                float partEnd = 0.f;
+                _split( start, end, k, j, partStart, partEnd );
+
+                Frame* output = new Frame;
+                output->setName( _getFrameName( prefix, r, i, partner ));
+                output->setViewport(
+                    Viewport( 0.f, partStart, 1.f, partEnd - partStart ));
+                output->setBuffers( eq::Frame::BUFFER_COLOR |
+                                    eq::Frame::BUFFER_DEPTH );
+                levels[ r - 1 ]->addOutputFrame( output );
+
+                Frame* input = new Frame;
+                input->setName( _getFrameName( prefix, r, partner, i ));
+                levels[ r ]->addInputFrame( input );
+            }
+
+            _split( start, end, k, digit, start, end );
+            stride *= k;
+        }
+
+        // assembled color tile output, if not already in place
+        if( source->getChannel() == channel )
+            continue;
+
+        std::ostringstream tileName;
+        tileName << prefix << ".tile" << i;
+
+        Frame* output = new Frame;
+        output->setName( tileName.str( ));
+        output->setViewport( Viewport( 0.f, start, 1.f, end - start ));
+        output->setBuffers( eq::Frame::BUFFER_COLOR );
+        source->addOutputFrame( output );
+
+        Frame* input = new Frame;
+        input->setName( tileName.str( ));
+        compound->addInputFrame( input );
+    }
+    return true;
+}
+
+}
+}
@@ -0,0 +1,74 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQSERVER_SORTLAST_H
+#define EQSERVER_SORTLAST_H
+
+#include "api.h"
+#include "types.h"
+
+#include <vector>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Generates parallel sort-last compositing compounds.
+     *
+     * The generator expands a compound with N leaf source children into a
+     * radix-k compositing tree. The sources are split into rounds of groups of
+     * at most k members. In each round, every member of a group keeps 1/k-th
+     * of its current image region and exchanges the other parts with its group
+     * partners, which are depth-composited into the kept part. After the last
+     * round each source owns a disjoint, fully composited tile which is
+     * gathered on the destination channel.
+     *
+     * A radix of two yields binary-swap compositing for power-of-two source
+     * counts, a radix of N yields direct-send compositing. Source counts with
+     * prime factors larger than the radix use direct-send rounds for these
+     * factors.
+     */
+    class SortLast
+    {
+    public:
+        /**
+         * Expand the given compound into a radix-k compositing tree.
+         *
+         * All children of the compound have to be leaf compounds without
+         * frames. If none of them has a database range set, the range is
+         * divided evenly between them. Children without a channel, or with the
+         * destination channel, composite their final tile in place.
+         *
+         * @param compound the parent compound of the sources.
+         * @param radix the maximum number of sources exchanging data per round.
+         * @return true if the compound was expanded, false on error.
+         */
+        EQSERVER_API static bool addRadixK( Compound* compound,
+                                            const uint32_t radix );
+
+        /**
+         * @return the group sizes of each compositing round for the given
+         *         number of sources and radix. The product of all group sizes
+         *         is the number of sources.
+         */
+        EQSERVER_API static std::vector< uint32_t >
+        computeRounds( const uint32_t nSources, const uint32_t radix );
+    };
+}
+}
+#endif // EQSERVER_SORTLAST_H
@@ -18,10 +18,16 @@
 
 #include "tileQueue.h"
 
+#include "compound.h"
+#include "config.h"
+
 #include <eq/fabric/tile.h>
 #include <co/dataIStream.h>
 #include <co/dataOStream.h>
 #include <co/queueItem.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
 
 namespace eq
 {
@@ -57,7 +63,108 @@ void TileQueue::addTile( const Tile& tile, const fabric::Eye eye )
 {
     uint32_t index = lunchbox::getIndexOfLastBit(eye);
     LBASSERT( index < NUM_EYES );
-    _queueMaster[index]->_queue.push() << tile;
+    _push( _queueMaster[index], tile );
+}
+
+void TileQueue::addTiles( const std::vector< Tile >& tiles,
+                          const fabric::Eye eye )
+{
+    const uint32_t index = lunchbox::getIndexOfLastBit( eye );
+    LBASSERT( index < NUM_EYES );
+    LatencyQueue* shared = _queueMaster[ index ];
+    LBASSERT( shared );
+
+    const size_t nTiles = tiles.size();
+    const std::vector< size_t > ends = getRangeEnds( _shares, nTiles );
+    size_t begin = 0;
+    for( size_t i = 0; i < _inputs.size(); ++i )
+    {
+        const size_t end = ends[i];
+        LatencyQueue* queue = _inputs[i]->_queueMaster[ index ];
+        if( !queue )
+            queue = shared;
+
+        for( ; begin < end; ++begin )
+            _push( queue, tiles[ begin ] );
+    }
+
+    for( ; begin < nTiles; ++begin )
+        _push( shared, tiles[ begin ] );
+}
+
+void TileQueue::setShares( const TileQueues& inputs,
+                           const std::vector< float >& shares )
+{
+    LBASSERT( inputs.size() == shares.size( ));
+    _inputs = inputs;
+    _shares = shares;
+
+    if( !normalizeShares( _shares ))
+    {
+        _inputs.clear();
+        _shares.clear();
+    }
+}
+
+bool TileQueue::normalizeShares( std::vector< float >& shares )
+{
+    float sum = 0.f;
+    for( size_t i = 0; i < shares.size(); ++i )
+        sum += shares[i];
+
+    if( sum <= 0.f )
+        return false;
+
+    for( size_t i = 0; i < shares.size(); ++i )
+        shares[i] /= sum;
+    return true;
+}
+
+std::vector< size_t > TileQueue::getRangeEnds(
+    const std::vector< float >& shares, const size_t nTiles )
+{
+    std::vector< size_t > ends;
+    ends.reserve( shares.size( ));
+
+    float share = 0.f;
+    size_t begin = 0;
+    for( size_t i = 0; i < shares.size(); ++i )
+    {
+        share += shares[i];
+        const float end = share * nTiles + .5f;
+        if( end > float( begin ))
+            begin = LB_MIN( size_t( end ), nTiles );
+        ends.push_back( begin );
+    }
+    return ends;
+}
+
+std::vector< size_t > TileQueue::getQueueOrder( const size_t input,
+                                                const size_t nInputs )
+{
+    // own range first, then the ranges in order of their distance
+    std::vector< size_t > order;
+    if( input < nInputs )
+    {
+        order.push_back( input );
+        for( size_t i = 1; order.size() < nInputs; ++i )
+        {
+            if( input + i < nInputs )
+                order.push_back( input + i );
+            if( input >= i )
+                order.push_back( input - i );
+        }
+    }
+    else
+        for( size_t i = 0; i < nInputs; ++i )
+            order.push_back( i );
+    return order;
+}
+
+void TileQueue::_push( LatencyQueue* queue, const Tile& tile )
+{
+    queue->_queue.push() << tile;
+    ++queue->_nTiles;
 }
 
 void TileQueue::cycleData( const uint32_t frameNumber, const Compound* compound)
@@ -82,16 +189,22 @@ void TileQueue::cycleData( const uint32_t frameNumber, const Compound* compound)
         {
             queue = new LatencyQueue;
 
+            lunchbox::ScopedWrite mutex(
+                compound->getConfig()->getRegistrationLock( ));
             getLocalNode()->registerObject( &queue->_queue );
             queue->_queue.setAutoObsolete( 1 ); // current + in use by render nodes
         }
 
         queue->_queue.clear();
         queue->_frameNumber = frameNumber;
+        queue->_nTiles = 0;
 
         _queues.push_front( queue );
         _queueMaster[i] = queue;
     }
+
+    for( TileQueuesCIter i = _inputs.begin(); i != _inputs.end(); ++i )
+        (*i)->cycleData( frameNumber, (*i)->getCompound( ));
 }
 
 void TileQueue::setOutputQueue( TileQueue* queue, const Compound* compound )
@@ -144,6 +257,30 @@ const UUID TileQueue::getQueueMasterID( const Eye eye ) const
     return UUID::ZERO;
 }
 
+std::vector< UUID > TileQueue::getQueueMasterIDs( const Eye eye,
+                                                  const TileQueue* input ) const
+{
+    const uint32_t index = lunchbox::getIndexOfLastBit( eye );
+    const size_t nInputs = _inputs.size();
+    const size_t own = std::find( _inputs.begin(), _inputs.end(), input ) -
+                       _inputs.begin();
+
+    const std::vector< size_t > order = getQueueOrder( own, nInputs );
+
+    std::vector< UUID > ids;
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const LatencyQueue* queue = _inputs[ order[i] ]->_queueMaster[ index ];
+        if( queue && queue->_nTiles > 0 )
+            ids.push_back( queue->_queue.getID( ));
+    }
+
+    const LatencyQueue* shared = _queueMaster[ index ];
+    if( shared && ( shared->_nTiles > 0 || ids.empty( )))
+        ids.push_back( shared->_queue.getID( ));
+    return ids;
+}
+
 std::ostream& operator << ( std::ostream& os, const TileQueue* tileQueue )
 {
     if( !tileQueue )
@@ -63,6 +63,51 @@ namespace server
         /** Add a tile to the queue. */
         void addTile( const Tile& tile, const Eye eye );
 
+        /**
+         * Add all tiles of an eye pass to the queue.
+         *
+         * The tiles are split into consecutive ranges, one for each input queue
+         * with a share, in the order given. The remainder and the ranges of
+         * input queues without data for the eye pass go into the shared queue.
+         */
+        void addTiles( const std::vector< Tile >& tiles, const Eye eye );
+
+        /**
+         * Set the input queues preferably processing a share of the tiles.
+         *
+         * Each input queue first processes its own range of tiles, and then
+         * takes the remaining tiles from the ranges closest to its own. The
+         * input queues are cycled together with this output queue. Without
+         * shares, all tiles are in one queue shared by all input queues.
+         *
+         * @param inputs the input queues, in the order of their tile ranges.
+         * @param shares the relative size of each range.
+         */
+        void setShares( const TileQueues& inputs,
+                        const std::vector< float >& shares );
+
+        /**
+         * Normalize the given shares to a sum of one.
+         *
+         * @return false if the sum of the shares is not positive, in which
+         *         case the shares are unchanged.
+         */
+        EQSERVER_API static bool normalizeShares( std::vector< float >& shares );
+
+        /**
+         * @return the end index of the tile range of each normalized share,
+         *         rounded to the nearest tile and never decreasing.
+         */
+        EQSERVER_API static std::vector< size_t > getRangeEnds(
+            const std::vector< float >& shares, const size_t nTiles );
+
+        /**
+         * @return the indices of the tile ranges in the order processed by the
+         *         given input, or all ranges in order for a foreign input.
+         */
+        EQSERVER_API static std::vector< size_t > getQueueOrder(
+            const size_t input, const size_t nInputs );
+
         /**
          * Cycle the current tile queue.
          *
@@ -90,6 +135,13 @@ namespace server
 
         const UUID getQueueMasterID( const Eye eye ) const;
 
+        /**
+         * @return the identifiers of the queues to be processed by the given
+         *         input queue, in order.
+         */
+        std::vector< UUID > getQueueMasterIDs( const Eye eye,
+                                               const TileQueue* input ) const;
+
     protected:
         EQSERVER_API virtual ChangeType getChangeType() const
                                                             { return INSTANCE; }
@@ -101,6 +153,7 @@ namespace server
         struct LatencyQueue
         {
             uint32_t _frameNumber;
+            size_t _nTiles;
             co::QueueMaster _queue;
         };
 
@@ -121,6 +174,14 @@ namespace server
 
         /** The current output queue. */
         TileQueue* _outputQueue[ NUM_EYES ];
+
+        /** The input queues with a preferred range of tiles. */
+        TileQueues _inputs;
+
+        /** The normalized size of the range of each input queue. */
+        std::vector< float > _shares;
+
+        void _push( LatencyQueue* queue, const Tile& tile );
     };
 
     std::ostream& operator << ( std::ostream& os, const TileQueue* frame );
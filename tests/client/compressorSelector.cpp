@@ -0,0 +1,89 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the adaptive compressor selection with simulated links and plugins
+
+#include <test.h>
+
+#include <eq/client/detail/compressorSelector.h>
+#include <eq/client/image.h>
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <co/plugins/compressor.h>
+#include <lunchbox/file.h>
+
+#include <set>
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    const eq::Strings images = lunchbox::searchDirectory( "images", "*.rgb" );
+    TEST( !images.empty( ));
+
+    const eq::Frame::Buffer color = eq::Frame::BUFFER_COLOR;
+    eq::Image image;
+    TEST( image.readImage( "images/" + images.front(), color ));
+    const uint64_t size = image.getPixelDataSize( color );
+
+    // Links of 100 KB/s, 10 GB/s and twice 1 MB/s, compressors with 4:1 at
+    // 10 MB/s. On the third link, the receiver reports a decompression speed
+    // of 1 MB/s, which makes sending the raw data faster.
+    const eq::uint128_t nodes[] = { eq::uint128_t( 0, 1 ),
+                                    eq::uint128_t( 0, 2 ),
+                                    eq::uint128_t( 0, 3 ),
+                                    eq::uint128_t( 0, 4 ) };
+    const int32_t bandwidths[] = { 100, 10000000, 1000, 1000 };
+    const float decompressTimes[] = { 0.f, 0.f, size / 1000.f, 0.f };
+    uint32_t choices[] = { EQ_COMPRESSOR_AUTO, EQ_COMPRESSOR_AUTO,
+                           EQ_COMPRESSOR_AUTO, EQ_COMPRESSOR_AUTO };
+    std::set< uint32_t > candidates;
+
+    eq::detail::CompressorSelector selector( 1000 ); // no re-evaluation
+    for( uint32_t frame = 1; frame < 100; ++frame )
+    {
+        for( size_t i = 0; i < 4; ++i )
+        {
+            const uint32_t name = selector.choose( nodes[i], image, color,
+                                                   frame, bandwidths[i] );
+            candidates.insert( name );
+            choices[i] = name;
+
+            const bool compress = name != EQ_COMPRESSOR_NONE;
+            const uint64_t sent = compress ? size / 4 : size;
+            selector.addCompressSample( nodes[i], color, name, size, sent,
+                                        compress ? size / 10000.f : 0.f,
+                                        frame );
+            if( compress && decompressTimes[i] > 0.f )
+                selector.addDecompressSample( nodes[i], color, name, size,
+                                              decompressTimes[i] );
+        }
+    }
+
+    TEST( candidates.count( EQ_COMPRESSOR_NONE ));
+    TESTINFO( choices[1] == EQ_COMPRESSOR_NONE, choices[1] );
+    TESTINFO( choices[2] == EQ_COMPRESSOR_NONE, choices[2] );
+    if( candidates.size() > 1 ) // compressor plugins for the image format
+    {
+        TESTINFO( choices[0] != EQ_COMPRESSOR_NONE, choices[0] );
+        TESTINFO( choices[3] != EQ_COMPRESSOR_NONE, choices[3] );
+    }
+
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that the tile queues of a node are shared by all channels: items
+// prefetched for one channel are popped by the others, and each item is popped
+// exactly once.
+
+#include <test.h>
+
+#include <eq/client/detail/sharedQueues.h>
+
+#include <co/co.h>
+#include <co/queueMaster.h>
+#include <lunchbox/thread.h>
+
+#include <vector>
+
+#define NITEMS 1000
+#define PREFETCH 4
+
+namespace
+{
+class Popper : public lunchbox::Thread
+{
+public:
+    Popper( eq::detail::SharedQueues& queues, co::LocalNodePtr node,
+            const eq::UUID& queueID )
+        : _queues( queues ), _node( node ), _queueID( queueID ) {}
+
+    virtual void run()
+    {
+        for( ;; )
+        {
+            co::ObjectICommand command = _queues.pop( _node, _queueID,
+                                                      PREFETCH );
+            if( !command.isValid( ))
+                return;
+            items.push_back( command.get< uint32_t >( ));
+        }
+    }
+
+    std::vector< uint32_t > items;
+
+private:
+    eq::detail::SharedQueues& _queues;
+    co::LocalNodePtr _node;
+    const eq::UUID _queueID;
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    co::QueueMaster queue;
+    TEST( server->registerObject( &queue ));
+    for( uint32_t i = 0; i < NITEMS; ++i )
+        queue.push() << i;
+
+    {
+        eq::detail::SharedQueues queues;
+
+        // Two consecutive pops share the prefetched items. Separate slaves
+        // would each receive their own PREFETCH items.
+        co::ObjectICommand first = queues.pop( client, queue.getID(),
+                                               PREFETCH );
+        co::ObjectICommand second = queues.pop( client, queue.getID(),
+                                                PREFETCH );
+        TEST( first.isValid( ));
+        TEST( second.isValid( ));
+        TESTINFO( first.get< uint32_t >() == 0, "" );
+        TESTINFO( second.get< uint32_t >() == 1, "" );
+
+        // Concurrent poppers drain the queue, each item is popped once
+        Popper popper1( queues, client, queue.getID( ));
+        Popper popper2( queues, client, queue.getID( ));
+        TEST( popper1.start( ));
+        TEST( popper2.start( ));
+        popper1.join();
+        popper2.join();
+
+        std::vector< uint32_t > counts( NITEMS, 0 );
+        counts[0] = counts[1] = 1;
+        for( size_t i = 0; i < popper1.items.size(); ++i )
+            ++counts[ popper1.items[i] ];
+        for( size_t i = 0; i < popper2.items.size(); ++i )
+            ++counts[ popper2.items[i] ];
+        for( size_t i = 0; i < NITEMS; ++i )
+            TESTINFO( counts[i] == 1, "item " << i << " popped " << counts[i]
+                      << " times" );
+        TEST( popper1.items.size() + popper2.items.size() == NITEMS - 2 );
+
+        queues.flush( client );
+    }
+
+    server->deregisterObject( &queue );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    TESTINFO( client->getRefCount() == 1, client->getRefCount( ));
+    TESTINFO( server->getRefCount() == 1, server->getRefCount( ));
+
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
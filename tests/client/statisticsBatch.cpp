@@ -0,0 +1,198 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// Tests the wire format of the batched statistics
+
+#include <test.h>
+
+#include <eq/client/detail/statisticsBatch.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+/** A byte stream with the binary encoding of the data streams. */
+class Stream
+{
+public:
+    Stream() : _pos( 0 ) {}
+
+    template< class T > Stream& operator << ( const T& value )
+    {
+        const uint8_t* data = reinterpret_cast< const uint8_t* >( &value );
+        _data.insert( _data.end(), data, data + sizeof( T ));
+        return *this;
+    }
+
+    template< class T > Stream& operator >> ( T& value )
+    {
+        TEST( _pos + sizeof( T ) <= _data.size( ));
+        ::memcpy( &value, &_data[ _pos ], sizeof( T ));
+        _pos += sizeof( T );
+        return *this;
+    }
+
+    uint64_t getRemainingBufferSize() const { return _data.size() - _pos; }
+    size_t getSize() const { return _data.size(); }
+    bool isConsumed() const { return _pos == _data.size(); }
+
+    void truncate( const size_t size ) { _data.resize( size ); _pos = 0; }
+    uint8_t& operator[]( const size_t i ) { return _data[i]; }
+
+private:
+    std::vector< uint8_t > _data;
+    size_t _pos;
+};
+
+eq::Statistic _createStatistic( const eq::Statistic::Type type,
+                                const int64_t startTime, const int64_t endTime,
+                                const char* name )
+{
+    eq::Statistic statistic;
+    ::memset( &statistic, 0, sizeof( statistic ));
+    statistic.type = type;
+    statistic.frameNumber = 42;
+    statistic.task = 7;
+    statistic.plugins[0] = 0x100;
+    statistic.plugins[1] = 0x200;
+    statistic.ratio = .5f;
+    statistic.startTime = startTime;
+    statistic.endTime = endTime;
+    ::strncpy( statistic.resourceName, name, 32 );
+    return statistic;
+}
+
+bool _equal( const eq::Statistic& a, const eq::Statistic& b )
+{
+    return a.type == b.type && a.frameNumber == b.frameNumber &&
+           a.task == b.task && a.plugins[0] == b.plugins[0] &&
+           a.plugins[1] == b.plugins[1] && a.ratio == b.ratio &&
+           a.startTime == b.startTime && a.endTime == b.endTime &&
+           ::strncmp( a.resourceName, b.resourceName, 32 ) == 0;
+}
+}
+
+int main( int, char** )
+{
+    typedef eq::detail::StatisticsBatch Batch;
+
+    // an empty batch is only the count
+    {
+        Stream stream;
+        Batch::write( stream, eq::Statistics( ));
+        TEST( stream.getSize() == sizeof( uint32_t ));
+
+        eq::Statistics statistics;
+        TEST( Batch::read( stream, statistics ));
+        TEST( statistics.empty( ));
+        TEST( stream.isConsumed( ));
+    }
+
+    // time spans are delta encoded, also backwards and across 32 bit, the
+    // values of WINDOW_FPS and PIPE_IDLE are no time spans
+    const int64_t base = 0x100000000ll;
+    eq::Statistics statistics;
+    statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_DRAW,
+                                            base + 10, base + 15, "channel" ));
+    statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_READBACK,
+                                            base + 15, base + 17, "channel" ));
+    statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_CLEAR,
+                                            base + 5, base + 9, "channel" ));
+    eq::Statistic fps = _createStatistic( eq::Statistic::WINDOW_FPS, 0, 0,
+                                          "window" );
+    fps.currentFPS = 60.f;
+    fps.averageFPS = 58.5f;
+    statistics.push_back( fps );
+    statistics.push_back( _createStatistic( eq::Statistic::PIPE_IDLE,
+                                            -3, base, "pipe" ));
+    statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_TILES,
+                                            base + 20, base + 30, "channel" ));
+    // a name using all 31 characters
+    statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_ASSEMBLE,
+                base + 30, base + 31, "0123456789012345678901234567890" ));
+
+    Stream stream;
+    Batch::write( stream, statistics );
+    {
+        eq::Statistics received;
+        TEST( Batch::read( stream, received ));
+        TEST( stream.isConsumed( ));
+        TESTINFO( received.size() == statistics.size(), received.size( ));
+        for( size_t i = 0; i < statistics.size(); ++i )
+            TESTINFO( _equal( received[i], statistics[i] ),
+                      received[i] << " != " << statistics[i] );
+    }
+
+    // the names are interned: a batch of one name per statistic is larger
+    {
+        eq::Statistics unique = statistics;
+        unique[1].resourceName[0] = 'C';
+        unique[2].resourceName[0] = 'D';
+        unique[5].resourceName[0] = 'E';
+        Stream uniqueStream;
+        Batch::write( uniqueStream, unique );
+        TEST( uniqueStream.getSize() == stream.getSize() + 3 * 8 );
+    }
+
+    // a truncated batch is rejected at any size, the statistics are unchanged
+    const size_t size = stream.getSize();
+    for( size_t i = 0; i < size; ++i )
+    {
+        Stream truncated;
+        Batch::write( truncated, statistics );
+        truncated.truncate( i );
+        if( i < sizeof( uint32_t ))
+            continue; // the count itself is read by the stream
+
+        eq::Statistics received( 1 );
+        TESTINFO( !Batch::read( truncated, received ), i );
+        TEST( received.size() == 1 );
+    }
+
+    // an unknown name index is rejected
+    {
+        Stream corrupt;
+        Batch::write( corrupt, statistics );
+        // count, frame, name count, names, start time, type, then the index
+        const size_t index = 4 + 4 + 2 + ( 1 + 7 ) + ( 1 + 6 ) + ( 1 + 4 ) +
+                             ( 1 + 31 ) + 8 + 1;
+        TEST( corrupt[ index ] == 0 && corrupt[ index + 1 ] == 0 );
+        corrupt[ index ] = 4;
+
+        eq::Statistics received;
+        TEST( !Batch::read( corrupt, received ));
+        TEST( received.empty( ));
+    }
+
+    // an unknown statistic type is rejected
+    {
+        Stream corrupt;
+        Batch::write( corrupt, statistics );
+        const size_t type = 4 + 4 + 2 + ( 1 + 7 ) + ( 1 + 6 ) + ( 1 + 4 ) +
+                            ( 1 + 31 ) + 8;
+        TEST( corrupt[ type ] == eq::Statistic::CHANNEL_DRAW );
+        corrupt[ type ] = eq::Statistic::ALL;
+
+        eq::Statistics received;
+        TEST( !Batch::read( corrupt, received ));
+        TEST( received.empty( ));
+    }
+
+    return EXIT_SUCCESS;
+}
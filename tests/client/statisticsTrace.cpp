@@ -0,0 +1,163 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the Chrome trace output of the statistics
+
+#include <test.h>
+
+#include <eq/client/channel.h>
+#include <eq/client/client.h>
+#include <eq/client/config.h>
+#include <eq/client/detail/statisticsTrace.h>
+#include <eq/client/init.h>
+#include <eq/client/node.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/pipe.h>
+#include <eq/client/server.h>
+#include <eq/client/statistic.h>
+#include <eq/client/window.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+eq::Statistic _createStatistic( const eq::Statistic::Type type,
+                                const int64_t startTime, const int64_t endTime,
+                                const float ratio )
+{
+    eq::Statistic statistic;
+    ::memset( &statistic, 0, sizeof( statistic ));
+    statistic.type = type;
+    statistic.frameNumber = 1;
+    statistic.task = 2;
+    statistic.ratio = ratio;
+    statistic.startTime = startTime;
+    statistic.endTime = endTime;
+    ::strncpy( statistic.resourceName, "channel", 32 );
+    return statistic;
+}
+
+size_t _count( const std::string& string, const std::string& pattern )
+{
+    size_t n = 0;
+    for( size_t i = string.find( pattern ); i != std::string::npos;
+         i = string.find( pattern, i + 1 ))
+    {
+        ++n;
+    }
+    return n;
+}
+}
+
+int main( int argc, char **argv )
+{
+    eq::NodeFactory nodeFactory;
+    TEST( eq::init( argc, argv, &nodeFactory ));
+
+    eq::ClientPtr client = new eq::Client;
+    TEST( client->initLocal( argc, argv ));
+
+    eq::ServerPtr server = new eq::Server;
+    TEST( client->connectServer( server ));
+
+    eq::Config* config = new eq::Config( server );
+    eq::Node* node = new eq::Node( config );
+    node->setName( "renderNode" );
+    eq::Pipe* pipe = new eq::Pipe( node );
+    eq::Window* window = new eq::Window( pipe );
+    eq::Channel* channel = new eq::Channel( window );
+
+    const std::string filename( "statisticsTrace.json" );
+    const float inf = std::numeric_limits< float >::infinity();
+    const float nan = std::numeric_limits< float >::quiet_NaN();
+    {
+        eq::detail::StatisticsTrace trace( config, filename );
+        TEST( trace.isOpen( ));
+
+        eq::Statistics statistics;
+        statistics.push_back( _createStatistic( eq::Statistic::CHANNEL_DRAW,
+                                                10, 15, 1.f ));
+        statistics.push_back( _createStatistic(
+                                eq::Statistic::CHANNEL_READBACK, 15, 17, inf ));
+        statistics.push_back( _createStatistic(
+                          eq::Statistic::CHANNEL_FRAME_COMPRESS, 17, 16, nan ));
+        trace.write( channel->getSerial(), statistics );
+
+        statistics.clear();
+        eq::Statistic fps = _createStatistic( eq::Statistic::WINDOW_FPS, 0, 0,
+                                              0.f );
+        fps.currentFPS = 60.f;
+        statistics.push_back( fps );
+        fps.currentFPS = inf;
+        statistics.push_back( fps );
+        eq::Statistic idle = _createStatistic( eq::Statistic::PIPE_IDLE, 5, 10,
+                                               0.f );
+        statistics.push_back( idle );
+        trace.write( window->getSerial(), statistics );
+    }
+
+    std::ifstream file( filename.c_str( ));
+    TEST( file.is_open( ));
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string trace = stream.str();
+    file.close();
+    ::remove( filename.c_str( ));
+
+    // a complete JSON trace object
+    TESTINFO( trace.find( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" ) ==
+              0, trace );
+    TESTINFO( trace.rfind( "\n]}" ) == trace.size() - 4, trace );
+    TESTINFO( _count( trace, "{" ) == _count( trace, "}" ), trace );
+
+    // no literals JSON can't read
+    TESTINFO( trace.find( "inf" ) == std::string::npos, trace );
+    TESTINFO( trace.find( "nan" ) == std::string::npos, trace );
+
+    // the node is a named process, each entity a named thread of it
+    std::ostringstream process;
+    process << "\"pid\":" << node->getSerial() << ",\"args\":{\"name\":"
+            << "\"renderNode\"}";
+    TESTINFO( trace.find( process.str( )) != std::string::npos, trace );
+    TESTINFO( _count( trace, "\"thread_name\"" ) == 2, trace );
+
+    // time spans in us, the ratio only where finite, negative spans clamped
+    TESTINFO( _count( trace, "\"ph\":\"X\"" ) == 3, trace );
+    TESTINFO( trace.find( "\"ts\":10000,\"dur\":5000" ) != std::string::npos,
+              trace );
+    TESTINFO( trace.find( "\"ts\":17000,\"dur\":0" ) != std::string::npos,
+              trace );
+    TESTINFO( _count( trace, "\"ratio\":" ) == 1, trace );
+    TESTINFO( trace.find( "\"task\":2,\"ratio\":1}}" ) != std::string::npos,
+              trace );
+
+    // finite counters at the latest time
+    TESTINFO( _count( trace, "\"ph\":\"C\"" ) == 2, trace );
+    TESTINFO( trace.find( "\"ts\":17000,\"pid\"" ) != std::string::npos, trace );
+    TESTINFO( trace.find( "{\"value\":60}" ) != std::string::npos, trace );
+    TESTINFO( trace.find( "{\"value\":0.5}" ) != std::string::npos, trace );
+
+    server->releaseConfig( config );
+    TEST( client->disconnectServer( server ));
+    TEST( client->exitLocal( ));
+    TEST( eq::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that concurrent callers of the compositing worker pool are executed
+// in parallel, and that each index is executed exactly once.
+
+#include <test.h>
+
+#include <eq/client/detail/workerPool.h>
+
+#include <lunchbox/atomic.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/thread.h>
+
+#include <vector>
+
+#define TIMEOUT 10000 // ms
+
+namespace
+{
+/** Counts the executions of each index. */
+class CountTask : public eq::detail::WorkerPool::Task
+{
+public:
+    explicit CountTask( const size_t n ) : _counts( n, 0 ) {}
+
+    virtual void execute( const size_t index ) { ++_counts[ index ]; }
+
+    bool isComplete() const
+    {
+        for( size_t i = 0; i < _counts.size(); ++i )
+            if( _counts[ i ] != 1 )
+                return false;
+        return true;
+    }
+
+private:
+    std::vector< lunchbox::a_int32_t > _counts;
+};
+
+typedef lunchbox::Monitor< uint32_t > Monitor;
+
+/** Counts started indices, and blocks each until a monitor reaches a value. */
+class WaitTask : public eq::detail::WorkerPool::Task
+{
+public:
+    WaitTask( Monitor& started, Monitor& monitor, const uint32_t value )
+        : timeouts( 0 ), _started( started ), _monitor( monitor )
+        , _value( value ) {}
+
+    virtual void execute( const size_t )
+    {
+        ++_started;
+        if( !_monitor.timedWaitGE( _value, TIMEOUT ))
+            ++timeouts;
+    }
+
+    lunchbox::a_int32_t timeouts;
+
+private:
+    Monitor& _started;
+    Monitor& _monitor;
+    const uint32_t _value;
+};
+
+class Caller : public lunchbox::Thread
+{
+public:
+    Caller( eq::detail::WorkerPool& pool, eq::detail::WorkerPool::Task& task,
+            const size_t n )
+        : _pool( pool ), _task( task ), _n( n ) {}
+
+    virtual void run() { _pool.execute( _task, _n ); }
+
+private:
+    eq::detail::WorkerPool& _pool;
+    eq::detail::WorkerPool::Task& _task;
+    const size_t _n;
+};
+}
+
+int main( int, char** )
+{
+    eq::detail::WorkerPool pool( 4 );
+
+    // A single caller executes each index once
+    {
+        CountTask task( 1000 );
+        pool.execute( task, 1000 );
+        TEST( task.isComplete( ));
+    }
+
+    // Two callers share the pool: the first task occupies two threads until
+    // the second task finished. The two indices of the second task only
+    // complete if they are executed at the same time, which needs a worker
+    // next to the second caller.
+    {
+        Monitor firstStarted( 0 );
+        Monitor secondStarted( 0 );
+        Monitor secondDone( 0 );
+        WaitTask first( firstStarted, secondDone, 1 );
+        WaitTask second( secondStarted, secondStarted, 2 );
+
+        Caller firstCaller( pool, first, 2 );
+        TEST( firstCaller.start( ));
+        TEST( firstStarted.timedWaitGE( 2, TIMEOUT ));
+
+        Caller secondCaller( pool, second, 2 );
+        TEST( secondCaller.start( ));
+        secondCaller.join();
+        ++secondDone;
+        firstCaller.join();
+
+        TESTINFO( second.timeouts == 0, second.timeouts );
+        TESTINFO( first.timeouts == 0, first.timeouts );
+    }
+
+    // Concurrent callers each execute all of their indices once
+    {
+        const size_t sizes[] = { 1000, 1, 1000, 10000 };
+        std::vector< CountTask* > tasks;
+        std::vector< Caller* > callers;
+        for( size_t i = 0; i < 4; ++i )
+        {
+            tasks.push_back( new CountTask( sizes[ i ] ));
+            callers.push_back( new Caller( pool, *tasks[ i ], sizes[ i ] ));
+            TEST( callers[ i ]->start( ));
+        }
+        for( size_t i = 0; i < 4; ++i )
+        {
+            callers[ i ]->join();
+            TEST( tasks[ i ]->isComplete( ));
+            delete callers[ i ];
+            delete tasks[ i ];
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -18,21 +18,540 @@
 #include <test.h>
 
 #include <eq/client/compositor.h>
+#include <eq/client/detail/activePixels.h>
+#include <eq/client/detail/compositorKernels.h>
+#include <eq/client/detail/compositorTiles.h>
+#include <eq/client/detail/imageBands.h>
+#include <eq/client/detail/pixelBufferPool.h>
 #include <eq/client/frame.h>
 #include <eq/client/frameData.h>
 #include <eq/client/image.h>
 #include <eq/client/init.h>
 #include <eq/client/nodeFactory.h>
 #include <eq/fabric/drawableConfig.h>
+#include <co/iCommand.h>
+#include <co/objectVersion.h>
+#include <co/plugins/compressor.h>
 #include <lunchbox/clock.h>
+#include <lunchbox/rng.h>
 
 // Tests the functionality of the compositor and computes the performance.
 
+namespace kernels = eq::detail::kernels;
+namespace tiles = eq::detail::tiles;
+
+namespace
+{
+static const char* const _isaNames[] = { "scalar", "SSE2", "AVX2" };
+static const size_t _nPixels = 1920 * 1080 + 3; // also test unaligned rest
+
+template< class T > void _fillRandom( std::vector< T >& data, const size_t n,
+                                      lunchbox::RNG& rng )
+{
+    data.resize( n );
+    for( size_t i = 0; i < n; ++i )
+        data[i] = rng.get< T >();
+}
+
+// Runs all kernels with the given ISA on the given input, stores the output
+// and reports the throughput of each kernel.
+void _runKernels( const char* name, const kernels::ISA isa,
+                  const std::vector< uint8_t >& color,
+                  const std::vector< uint32_t >& depth,
+                  const std::vector< uint8_t >& destColor,
+                  const std::vector< uint32_t >& destDepth,
+                  std::vector< uint8_t > results[3][2],
+                  std::vector< uint32_t > depthResults[3] )
+{
+    kernels::setISA( isa );
+    TEST( kernels::getISA() == isa );
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < 3; ++i )
+    {
+        const size_t pixelSize = 4 << i;
+
+        results[i][0] = destColor;
+        depthResults[i] = destDepth;
+        clock.reset();
+        kernels::mergeDepth( &results[i][0][0], &depthResults[i][0],
+                             &color[0], &depth[0], _nPixels, pixelSize );
+        float time = clock.getTimef();
+        std::cout << name << ": " << _isaNames[ isa ] << " depth " << pixelSize
+                  << "B: " << time << " ms ("
+                  << 1000.0f * _nPixels * ( pixelSize + 4 ) / time / 1024.f /
+                     1024.f << " MB/s)" << std::endl;
+
+        results[i][1] = destColor;
+        clock.reset();
+        kernels::blend( &results[i][1][0], &color[0], _nPixels, pixelSize );
+        time = clock.getTimef();
+        std::cout << name << ": " << _isaNames[ isa ] << " blend " << pixelSize
+                  << "B: " << time << " ms ("
+                  << 1000.0f * _nPixels * pixelSize / time / 1024.f / 1024.f
+                  << " MB/s)" << std::endl;
+    }
+}
+
+// Verify that all compositing kernels produce the same output as the scalar
+// reference implementation.
+void _testKernels( const char* name )
+{
+    lunchbox::RNG rng;
+    std::vector< uint8_t > color;
+    std::vector< uint8_t > destColor;
+    std::vector< uint32_t > depth;
+    std::vector< uint32_t > destDepth;
+
+    _fillRandom( color, _nPixels * 16, rng );
+    _fillRandom( destColor, _nPixels * 16, rng );
+    _fillRandom( depth, _nPixels, rng );
+    _fillRandom( destDepth, _nPixels, rng );
+
+    // use positive, finite values for RGBA16F and RGBA32F blending, NaN
+    // payloads are not guaranteed to propagate identically
+    for( size_t i = 0; i < _nPixels * 8; ++i )
+    {
+        reinterpret_cast< uint16_t* >( &color[0] )[ i ] &= 0x3bff;
+        reinterpret_cast< uint16_t* >( &destColor[0] )[ i ] &= 0x3bff;
+    }
+
+    std::vector< uint8_t > reference[3][2];
+    std::vector< uint32_t > referenceDepth[3];
+    _runKernels( name, kernels::ISA_SCALAR, color, depth, destColor, destDepth,
+                 reference, referenceDepth );
+
+    for( int isa = kernels::ISA_SCALAR + 1; isa <= kernels::getBestISA();
+         ++isa )
+    {
+        std::vector< uint8_t > results[3][2];
+        std::vector< uint32_t > depthResults[3];
+        _runKernels( name, kernels::ISA( isa ), color, depth, destColor,
+                     destDepth, results, depthResults );
+
+        for( size_t i = 0; i < 3; ++i )
+        {
+            TESTINFO( results[i][0] == reference[i][0],
+                      _isaNames[ isa ] << " depth color " << ( 4 << i ));
+            TESTINFO( depthResults[i] == referenceDepth[i],
+                      _isaNames[ isa ] << " depth " << ( 4 << i ));
+            TESTINFO( results[i][1] == reference[i][1],
+                      _isaNames[ isa ] << " blend " << ( 4 << i ));
+        }
+    }
+    kernels::setISA( kernels::getBestISA( ));
+}
+
+// Verify that CPU compositing produces the same image for all ISAs
+void _testMergeISA( const eq::Frames& frames, const bool blendAlpha )
+{
+    kernels::setISA( kernels::ISA_SCALAR );
+    const eq::Image* result = eq::Compositor::mergeFramesCPU( frames,
+                                                              blendAlpha );
+    TEST( result );
+    const eq::Frame::Buffer buffer = eq::Frame::BUFFER_COLOR;
+    const std::vector< uint8_t > reference( result->getPixelPointer( buffer ),
+                                            result->getPixelPointer( buffer ) +
+                                            result->getPixelDataSize( buffer ));
+
+    kernels::setISA( kernels::getBestISA( ));
+    result = eq::Compositor::mergeFramesCPU( frames, blendAlpha );
+    TEST( result );
+    TEST( result->getPixelDataSize( buffer ) == reference.size( ));
+    TEST( memcmp( result->getPixelPointer( buffer ), &reference[0],
+                  reference.size( )) == 0 );
+}
+
+// Merge the frames with the tiled or the per-image compositor, return the
+// result color and the merge time
+float _mergeFrames( const eq::Frames& frames, const bool blendAlpha,
+                    const bool tiled, std::vector< uint8_t >& result )
+{
+    tiles::setEnabled( tiled );
+    lunchbox::Clock clock;
+    const eq::Image* image = eq::Compositor::mergeFramesCPU( frames,
+                                                             blendAlpha );
+    const float time = clock.getTimef();
+    tiles::setEnabled( true );
+
+    TEST( image );
+    const eq::Frame::Buffer buffer = eq::Frame::BUFFER_COLOR;
+    result.assign( image->getPixelPointer( buffer ),
+                   image->getPixelPointer( buffer ) +
+                   image->getPixelDataSize( buffer ));
+    return time;
+}
+
+// Verify that tiled compositing produces the same image as the per-image
+// compositing
+void _testTiles( const eq::Frames& frames, const bool blendAlpha )
+{
+    std::vector< uint8_t > reference;
+    std::vector< uint8_t > result;
+    _mergeFrames( frames, blendAlpha, false, reference );
+    _mergeFrames( frames, blendAlpha, true, result );
+    TEST( result == reference );
+}
+
+// Compare tiled with per-image DB compositing for 2 to 64 input images
+void _benchmarkTiles( const char* name, const eq::Images& sources )
+{
+    const eq::Frame::Buffer color = eq::Frame::BUFFER_COLOR;
+    const eq::Frame::Buffer depth = eq::Frame::BUFFER_DEPTH;
+    eq::Frame frame;
+    eq::FrameDataPtr frameData = new eq::FrameData;
+    frameData->setBuffers( color | depth );
+    frame.setFrameData( frameData );
+    const eq::Frames frames( 1, &frame );
+
+    const size_t nImages[] = { 2, 8, 32, 64 };
+    for( size_t i = 0; i < sizeof( nImages ) / sizeof( size_t ); ++i )
+    {
+        while( frameData->getImages().size() < nImages[i] )
+        {
+            const eq::Image* source =
+                sources[ frameData->getImages().size() % sources.size() ];
+            eq::Image* image = frameData->newImage( eq::Frame::TYPE_MEMORY,
+                                                    eq::DrawableConfig( ));
+            image->setPixelData( color, source->getPixelData( color ));
+            image->setPixelData( depth, source->getPixelData( depth ));
+        }
+
+        std::vector< uint8_t > reference;
+        std::vector< uint8_t > result;
+        _mergeFrames( frames, false, false, reference ); // warm up
+        const float timeImages = _mergeFrames( frames, false, false,
+                                               reference );
+        const float timeTiles = _mergeFrames( frames, false, true, result );
+        TEST( result == reference );
+
+        std::cout << name << ": DB " << nImages[i] << " images: per-image "
+                  << timeImages << " ms, tiled " << timeTiles << " ms"
+                  << std::endl;
+    }
+}
+
+// Verify that referenced pixel data is used in place and copied on write
+void _testZeroCopy( const eq::Image* source )
+{
+    const eq::Frame::Buffer depth = eq::Frame::BUFFER_DEPTH;
+    const eq::PixelData& pixels = source->getPixelData( depth );
+    const uint32_t size = source->getPixelDataSize( depth );
+
+    eq::Image image;
+    image.setPixelViewport( source->getPixelViewport( ));
+    image.setPixelData( depth, pixels, false );
+
+    const eq::Image& constImage = image;
+    TEST( constImage.getPixelPointer( depth ) == pixels.pixels );
+    TEST( constImage.getActivePixels().getNPixels() ==
+          source->getActivePixels().getNPixels( ));
+
+    uint8_t* copy = image.getPixelPointer( depth );
+    TEST( copy != pixels.pixels );
+    TEST( memcmp( copy, pixels.pixels, size ) == 0 );
+    image.flush();
+}
+
+// Serialize the uncompressed pixels of an image like Channel::_transmitImage
+void _serialize( const eq::Image& image, std::vector< uint8_t >& data )
+{
+    const eq::Frame::Buffer buffers[] = { eq::Frame::BUFFER_COLOR,
+                                          eq::Frame::BUFFER_DEPTH };
+    data.clear();
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        if( !image.hasPixelData( buffers[i] ))
+            continue;
+
+        const eq::PixelData& pixels = image.getPixelData( buffers[i] );
+        const eq::FrameData::ImageHeader header =
+            { pixels.internalFormat, pixels.externalFormat, pixels.pixelSize,
+              pixels.pvp, EQ_COMPRESSOR_NONE, 0, 1,
+              image.getQuality( buffers[i] ) };
+        const uint64_t size = image.getPixelDataSize( buffers[i] );
+        const uint8_t* bytes = reinterpret_cast< const uint8_t* >( &header );
+        data.insert( data.end(), bytes, bytes + sizeof( header ));
+        bytes = reinterpret_cast< const uint8_t* >( &size );
+        data.insert( data.end(), bytes, bytes + sizeof( size ));
+        bytes = image.getPixelPointer( buffers[i] );
+        data.insert( data.end(), bytes, bytes + size );
+    }
+}
+
+// Verify that an image sent in bands is reassembled into one image
+void _testBands( const eq::Image* source )
+{
+    namespace bands = eq::detail::bands;
+    const eq::Frame::Buffer buffers[] = { eq::Frame::BUFFER_COLOR,
+                                          eq::Frame::BUFFER_DEPTH };
+    const uint32_t none[2] = { EQ_COMPRESSOR_NONE, EQ_COMPRESSOR_NONE };
+    TEST( bands::getNBands( *source, none ) == 1 );
+
+    const eq::PixelViewport& pvp = source->getPixelViewport();
+    const int32_t nBands = 4;
+    const int32_t rows = ( pvp.h + nBands - 1 ) / nBands;
+    TEST( pvp.h > 3 * rows );
+
+    eq::FrameDataPtr frameData = new eq::FrameData;
+    const co::ObjectVersion version( lunchbox::uint128_t( 1 ),
+                                     lunchbox::uint128_t( 1 ));
+    frameData->setVersion( 1 );
+
+    eq::FrameData::ImageBand imageBand;
+    imageBand.index = 0;
+    imageBand.pvp = pvp;
+    imageBand.nBands = nBands;
+
+    // bands arrive in any order, the image is published once complete
+    std::vector< uint8_t > datas[ nBands ];
+    for( int32_t i = nBands - 1; i >= 0; --i )
+    {
+        const int32_t y = i * rows;
+        eq::Image band;
+        bands::setBand( *source, band, y, LB_MIN( rows, pvp.h - y ));
+        TEST( band.getPixelViewport().h == LB_MIN( rows, pvp.h - y ));
+
+        eq::Images received;
+        TEST( !frameData->getReceivedImages( received ));
+        TEST( received.empty( ));
+
+        _serialize( band, datas[i] );
+        TEST( frameData->addImage( version, band.getPixelViewport(),
+                                   eq::Zoom::NONE, eq::Frame::BUFFER_COLOR |
+                                   eq::Frame::BUFFER_DEPTH,
+                                   source->getAlphaUsage(), imageBand,
+                                   eq::uint128_t(), &datas[i].front(),
+                                   datas[i].size(),
+                                   co::ICommand(), 1, 0 ));
+        band.flush();
+    }
+
+    eq::Images received;
+    TEST( !frameData->getReceivedImages( received ));
+    TEST( received.size() == 1 );
+
+    eq::FrameData::Data data;
+    data.pvp = pvp;
+    data.buffers = eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH;
+    frameData->setReady( version, data );
+    TEST( frameData->isReady( ));
+
+    const eq::Images& images = frameData->getImages();
+    TEST( images.size() == 1 );
+    const eq::Image* image = images.front();
+    TEST( image->getPixelViewport() == pvp );
+    for( unsigned i = 0; i < 2; ++i )
+    {
+        TEST( image->hasPixelData( buffers[i] ));
+        const uint32_t size = source->getPixelDataSize( buffers[i] );
+        TEST( image->getPixelDataSize( buffers[i] ) == size );
+        TEST( memcmp( image->getPixelPointer( buffers[i] ),
+                      source->getPixelPointer( buffers[i] ), size ) == 0 );
+    }
+    frameData->flush();
+}
+
+// Verify that received uncompressed images are used in place with zero-copy
+// receive, stay valid until the frame data is cleared and are copied otherwise
+void _testZeroCopyReceive( const eq::Image* source )
+{
+    const eq::Frame::Buffer buffers[] = { eq::Frame::BUFFER_COLOR,
+                                          eq::Frame::BUFFER_DEPTH };
+    const eq::PixelViewport& pvp = source->getPixelViewport();
+    const co::ObjectVersion version( lunchbox::uint128_t( 1 ),
+                                     lunchbox::uint128_t( 1 ));
+    eq::FrameData::ImageBand imageBand;
+    imageBand.index = 0;
+    imageBand.pvp = pvp;
+    imageBand.nBands = 1;
+
+    eq::FrameData::Data data;
+    data.pvp = pvp;
+    data.buffers = eq::Frame::BUFFER_COLOR | eq::Frame::BUFFER_DEPTH;
+
+    std::vector< uint8_t > bytes;
+    _serialize( *source, bytes );
+    uint8_t* begin = &bytes.front();
+    const uint8_t* end = begin + bytes.size();
+
+    for( unsigned zeroCopy = 0; zeroCopy < 2; ++zeroCopy )
+    {
+        eq::FrameDataPtr frameData = new eq::FrameData;
+        TEST( !frameData->isZeroCopy( ));
+        frameData->setZeroCopy( zeroCopy );
+        frameData->setVersion( 1 );
+
+        TEST( frameData->addImage( version, pvp, eq::Zoom::NONE,
+                                   data.buffers, source->getAlphaUsage(),
+                                   imageBand, eq::uint128_t(), begin,
+                                   bytes.size(), co::ICommand(), 1, 0 ));
+        frameData->setReady( version, data );
+        TEST( frameData->isReady( ));
+
+        const eq::Images& images = frameData->getImages();
+        TEST( images.size() == 1 );
+        const eq::Image* image = images.front();
+        for( unsigned i = 0; i < 2; ++i )
+        {
+            const uint8_t* pixels = image->getPixelPointer( buffers[i] );
+            const bool inPlace = pixels >= begin && pixels < end;
+            TESTINFO( inPlace == bool( zeroCopy ), zeroCopy );
+
+            const uint32_t size = source->getPixelDataSize( buffers[i] );
+            TEST( image->getPixelDataSize( buffers[i] ) == size );
+            TEST( memcmp( pixels, source->getPixelPointer( buffers[i] ),
+                          size ) == 0 );
+        }
+
+        // cleared images are cached and no longer reference the received data
+        frameData->clear();
+        TEST( frameData->getImages().empty( ));
+        for( unsigned i = 0; i < 2; ++i )
+            TEST( !image->hasPixelData( buffers[i] ));
+        frameData->flush();
+    }
+}
+
+// Verify the size classes and the reuse of released pixel buffers
+void _testPixelBufferPool( const eq::Image* source )
+{
+    typedef eq::detail::PixelBufferPool Pool;
+    for( size_t size = 1; size < 64 * 1024 * 1024; size = size * 3 / 2 + 1 )
+    {
+        const size_t capacity = Pool::getCapacity( size );
+        TEST( capacity >= size );
+        TEST( capacity <= LB_MAX( size + size / 4, 64 * 1024 ));
+        TEST( Pool::getCapacity( capacity ) == capacity );
+    }
+
+    Pool& pool = Pool::getInstance();
+    const eq::Frame::Buffer color = eq::Frame::BUFFER_COLOR;
+    const eq::PixelData& sourcePixels = source->getPixelData( color );
+    const size_t size = source->getPixelDataSize( color );
+    eq::PixelData pixels; // not copyable
+    pixels.internalFormat = sourcePixels.internalFormat;
+    pixels.externalFormat = sourcePixels.externalFormat;
+    pixels.pixelSize = sourcePixels.pixelSize;
+    pixels.pvp = sourcePixels.pvp;
+    pixels.pixels = sourcePixels.pixels;
+    {
+        eq::Image image;
+        image.setPixelData( color, pixels );
+    }
+
+    // a slightly smaller image reuses the released buffer
+    pool.sample();
+    --pixels.pvp.w;
+    pixels.pixels = 0; // clear
+    const bool sameClass = Pool::getCapacity( size ) ==
+                   Pool::getCapacity( pixels.pvp.getArea() * pixels.pixelSize );
+    {
+        eq::Image image;
+        image.setPixelData( color, pixels );
+    }
+
+    const Pool::Statistics stats = pool.sample();
+    TESTINFO( stats.hits + stats.misses == 1, stats.hits << ", " <<
+              stats.misses );
+    TEST( !sameClass || stats.hits == 1 );
+    TEST( stats.cachedSize <= stats.residentSize );
+}
+
+// Verify the active pixel spans and the DB compositing using them
+void _testActivePixels( const char* name, const eq::Images& images,
+                        const eq::Frames& frames )
+{
+    const eq::Frame::Buffer color = eq::Frame::BUFFER_COLOR;
+    const eq::Frame::Buffer depth = eq::Frame::BUFFER_DEPTH;
+    std::vector< eq::detail::ActivePixels > spans;
+
+    for( eq::ImagesCIter i = images.begin(); i != images.end(); ++i )
+    {
+        const eq::Image* image = *i;
+        const eq::detail::ActivePixels& active = image->getActivePixels();
+        const eq::PixelViewport& pvp = image->getPixelViewport();
+        TEST( active.isValid( ));
+        TEST( active.getWidth() == uint32_t( pvp.w ));
+        TEST( active.getHeight() == uint32_t( pvp.h ));
+
+        const uint32_t* depthData = reinterpret_cast< const uint32_t* >(
+            image->getPixelPointer( depth ));
+        size_t nActive = 0;
+        for( size_t j = 0; j < size_t( pvp.getArea( )); ++j )
+            if( depthData[j] != 0xffffffffu )
+                ++nActive;
+        TESTINFO( active.getNPixels() == nActive,
+                  active.getNPixels() << " != " << nActive );
+
+        // pack/unpack of the active color pixels
+        const size_t pixelSize = image->getPixelSize( color );
+        const uint8_t* pixels = image->getPixelPointer( color );
+        std::vector< uint8_t > packed( nActive * pixelSize + 1 );
+        std::vector< uint8_t > unpacked( image->getPixelDataSize( color ), 0 );
+        active.pack( pixels, pixelSize, &packed[0] );
+        active.unpack( &packed[0], pixelSize, &unpacked[0] );
+
+        for( uint32_t y = 0; y < active.getHeight(); ++y )
+        {
+            const uint32_t* rowSpans = active.getSpans( y );
+            for( uint32_t j = 0; j < active.getNSpans( y ); ++j )
+            {
+                const size_t start = (y * pvp.w + rowSpans[2*j]) * pixelSize;
+                const size_t size = (rowSpans[2*j+1] - rowSpans[2*j]) *
+                                    pixelSize;
+                TEST( memcmp( pixels + start, &unpacked[ start ], size ) == 0);
+            }
+        }
+
+        // serialization
+        eq::detail::ActivePixels copy;
+        TEST( copy.setData( active.getData(), active.getDataSize( )));
+        TEST( copy.getNPixels() == active.getNPixels( ));
+        TEST( !copy.setData( active.getData(), active.getDataSize() - 4 ));
+
+        spans.push_back( active );
+        std::cout << name << ": " << nActive * 100 / pvp.getArea()
+                  << "% active pixels, " << active.getDataSize()
+                  << " bytes of spans" << std::endl;
+    }
+
+    // DB compositing with and without spans produces the same result
+    lunchbox::Clock clock;
+    const eq::Image* result = eq::Compositor::mergeFramesCPU( frames );
+    const float timeSpans = clock.getTimef();
+    TEST( result );
+    const std::vector< uint8_t > reference( result->getPixelPointer( color ),
+                                            result->getPixelPointer( color ) +
+                                            result->getPixelDataSize( color ));
+
+    for( eq::ImagesCIter i = images.begin(); i != images.end(); ++i )
+        (*i)->setActivePixels( eq::detail::ActivePixels( ));
+
+    clock.reset();
+    result = eq::Compositor::mergeFramesCPU( frames );
+    const float timeFull = clock.getTimef();
+    TEST( result );
+    TEST( result->getPixelDataSize( color ) == reference.size( ));
+    TEST( memcmp( result->getPixelPointer( color ), &reference[0],
+                  reference.size( )) == 0 );
+
+    std::cout << name << ": DB active pixels " << timeSpans
+              << " ms, all pixels " << timeFull << " ms" << std::endl;
+
+    for( size_t i = 0; i < images.size(); ++i )
+        images[i]->setActivePixels( spans[i] );
+}
+}
+
 int main( int argc, char **argv )
 {
     eq::NodeFactory nodeFactory;
     TEST( eq::init( 0, 0, &nodeFactory ));
 
+    // 0) kernel verification and performance
+    _testKernels( argv[0] );
+
     eq::Frame frame;
     eq::FrameDataPtr frameData = new eq::FrameData;
 
@@ -74,6 +593,7 @@ int main( int argc, char **argv )
          << 1000.0f * size / time / 1024.0f / 1024.0f << " MB/s)" << std::endl;
 
     result->writeImages( "Result_2D" );
+    _testTiles( frames, false );
 
     frames.push_back( &frame );
     frames.push_back( &frame );
@@ -131,6 +651,14 @@ int main( int argc, char **argv )
               << std::endl;
 
     result->writeImages( "Result_DB" );
+    _testMergeISA( frames, false );
+    _testActivePixels( argv[0], images, frames );
+    _testZeroCopy( images[2] );
+    _testBands( images[2] );
+    _testZeroCopyReceive( images[2] );
+    _testPixelBufferPool( images[2] );
+    _testTiles( frames, false );
+    _benchmarkTiles( argv[0], images );
 
     frames.push_back( &frame );
     frames.push_back( &frame );
@@ -179,6 +707,8 @@ int main( int argc, char **argv )
          << 1000.0f * size / time / 1024.0f / 1024.0f << " MB/s)" << std::endl;
 
     result->writeImages( "Result_Alpha" );
+    _testMergeISA( frames, true );
+    _testTiles( frames, true );
 
     frames.push_back( &frame );
     frames.push_back( &frame );
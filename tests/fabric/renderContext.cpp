@@ -0,0 +1,169 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the delta encoding of the render context
+
+#include <test.h>
+#include <eq/fabric/renderContext.h>
+
+#include <cstring>
+#include <vector>
+
+using eq::fabric::RenderContext;
+
+namespace
+{
+/** A byte stream with the binary encoding of the data streams. */
+class Stream
+{
+public:
+    Stream() : _pos( 0 ) {}
+
+    template< class T > Stream& operator << ( const T& value )
+    {
+        const uint8_t* data = reinterpret_cast< const uint8_t* >( &value );
+        _data.insert( _data.end(), data, data + sizeof( T ));
+        return *this;
+    }
+
+    template< class T > Stream& operator >> ( T& value )
+    {
+        TEST( _pos + sizeof( T ) <= _data.size( ));
+        ::memcpy( &value, &_data[ _pos ], sizeof( T ));
+        _pos += sizeof( T );
+        return *this;
+    }
+
+    size_t getSize() const { return _data.size(); }
+    bool isConsumed() const { return _pos == _data.size(); }
+
+private:
+    std::vector< uint8_t > _data;
+    size_t _pos;
+};
+
+uint32_t _getDirty( const RenderContext& a, const RenderContext& b )
+{
+    eq::fabric::detail::DirtyFinder finder;
+    eq::fabric::detail::forEachField( a, b, finder );
+    return finder.dirty;
+}
+
+/** Sends a context against the sender base and checks the received one. */
+size_t _transmit( const RenderContext& context, RenderContext& sender,
+                  RenderContext& receiver )
+{
+    Stream stream;
+    context.serialize( stream, sender );
+    sender = context;
+
+    receiver.deserialize( stream );
+    TEST( stream.isConsumed( ));
+    TESTINFO( _getDirty( receiver, context ) == 0,
+              receiver << " != " << context );
+    return stream.getSize();
+}
+}
+
+int main( int argc, char **argv )
+{
+    RenderContext sender;
+    RenderContext receiver;
+    RenderContext context;
+
+    // unchanged context: the dirty mask only
+    TEST( _transmit( context, sender, receiver ) == sizeof( uint32_t ));
+
+    // new frame: the frame identifier only
+    context.frameID = lunchbox::uint128_t( 1 );
+    TEST( _transmit( context, sender, receiver ) ==
+          sizeof( uint32_t ) + sizeof( context.frameID ));
+
+    // each field on its own, also back to its previous value
+    std::vector< RenderContext > contexts;
+    context.frustum = eq::fabric::Frustumf( -1.f, 1.f, -.5f, .5f, .1f, 10.f );
+    contexts.push_back( context );
+    context.ortho = context.frustum;
+    contexts.push_back( context );
+    context.headTransform( 0, 3 ) = 1.f;
+    contexts.push_back( context );
+    context.orthoTransform( 1, 3 ) = 2.f;
+    contexts.push_back( context );
+    context.view.version = lunchbox::uint128_t( 42 );
+    contexts.push_back( context );
+    context.pvp = eq::fabric::PixelViewport( 0, 0, 640, 480 );
+    contexts.push_back( context );
+    context.pixel = eq::fabric::Pixel( 1, 0, 2, 1 );
+    contexts.push_back( context );
+    context.overdraw = eq::fabric::Vector4i( 1, 2, 3, 4 );
+    contexts.push_back( context );
+    context.vp = eq::fabric::Viewport( 0.f, 0.f, .5f, 1.f );
+    contexts.push_back( context );
+    context.offset = eq::fabric::Vector2i( 320, 0 );
+    contexts.push_back( context );
+    context.range = eq::fabric::Range( .25f, .5f );
+    contexts.push_back( context );
+    context.subpixel = eq::fabric::SubPixel( 1, 4 );
+    contexts.push_back( context );
+    context.zoom = eq::fabric::Zoom( .5f, .5f );
+    contexts.push_back( context );
+    context.buffer = 0x0404; // GL_FRONT
+    contexts.push_back( context );
+    context.taskID = 3;
+    contexts.push_back( context );
+    context.period = 2;
+    contexts.push_back( context );
+    context.phase = 1;
+    contexts.push_back( context );
+    context.eye = eq::fabric::EYE_LEFT;
+    contexts.push_back( context );
+    context.bufferMask = eq::fabric::ColorMask( true, false, false );
+    contexts.push_back( context );
+    context.pvp = eq::fabric::PixelViewport( 0, 0, 320, 480 );
+    context.range = eq::fabric::Range::ALL;
+    context.frameID = lunchbox::uint128_t( 2 );
+    contexts.push_back( context );
+    context.pvp = eq::fabric::PixelViewport( 0, 0, 640, 480 );
+    context.range = eq::fabric::Range( .25f, .5f );
+    contexts.push_back( context );
+
+    for( size_t i = 0; i < contexts.size(); ++i )
+    {
+        const RenderContext& next = contexts[i];
+        const uint32_t dirty = _getDirty( next, sender );
+        const size_t size = _transmit( next, sender, receiver );
+        TESTINFO( dirty != 0 && size > sizeof( uint32_t ), i );
+        TESTINFO( size < sizeof( uint32_t ) + sizeof( RenderContext ), i );
+    }
+
+    // reset for a new client channel: full send of all fields, since each one
+    // differs from the default context
+    const RenderContext& last = contexts.back();
+    sender = RenderContext();
+    receiver = RenderContext();
+    TESTINFO( _getDirty( last, sender ) == ( 1u << 20 ) - 1,
+              _getDirty( last, sender ));
+    _transmit( last, sender, receiver );
+
+    // the receiver keeps its base for the following deltas
+    context = last;
+    context.frameID = lunchbox::uint128_t( 3 );
+    TEST( _transmit( context, sender, receiver ) ==
+          sizeof( uint32_t ) + sizeof( context.frameID ));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,281 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <loadSimulator.h>
+
+#include <eq/server/channel.h>
+#include <eq/server/compound.h>
+#include <eq/server/compoundVisitor.h>
+#include <eq/server/config.h>
+#include <eq/server/frame.h>
+#include <eq/server/frameData.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/node.h>
+#include <eq/server/pipe.h>
+#include <eq/server/server.h>
+#include <eq/server/window.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/init.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+
+using eq::server::LoadSimulator;
+
+namespace
+{
+static const unsigned _nChannels = 4; //!< per load-balanced wall
+
+// A config of independent walls, each using its own nodes, optionally
+// synchronizing the swap of all channels of a wall
+std::string _createConfig( const unsigned nWalls, const bool swapBarrier )
+{
+    const char* const barrier = swapBarrier ? "swapbarrier {} " : "";
+    std::ostringstream config;
+    config << "server{ config{ ";
+    for( unsigned i = 0; i < nWalls * _nChannels; ++i )
+        config << ( i == 0 ? "appNode" : "node" )
+               << "{ pipe { window { channel { name \"c" << i << "\" }}}} ";
+
+    for( unsigned i = 0; i < nWalls; ++i )
+    {
+        const unsigned first = i * _nChannels;
+        config << "compound { channel \"c" << first << "\" "
+               << "load_equalizer { mode 2D } compound { " << barrier << "} ";
+        for( unsigned j = 1; j < _nChannels; ++j )
+            config << "compound { channel \"c" << first + j
+                   << "\" outputframe {} " << barrier << "} ";
+        for( unsigned j = 1; j < _nChannels; ++j )
+            config << "inputframe { name \"frame.c" << first + j << "\" } ";
+        config << "} ";
+    }
+    config << "}}";
+    return config.str();
+}
+
+// Collects the data the channel tasks are generated from, per channel
+class TaskCollector : public eq::server::CompoundVisitor
+{
+public:
+    virtual VisitorResult visit( const eq::server::Compound* compound )
+    {
+        const eq::server::Channel* channel = compound->getChannel();
+        if( !channel || compound->getInheritTasks() == eq::fabric::TASK_NONE )
+            return TRAVERSE_CONTINUE;
+
+        std::ostringstream os;
+        os << "tasks " << compound->getInheritTasks() << " pvp "
+           << compound->getInheritPixelViewport() << " vp "
+           << compound->getInheritViewport() << " range "
+           << compound->getInheritRange() << std::endl;
+
+        const eq::server::Frames& outputs = compound->getOutputFrames();
+        for( eq::server::FramesCIter i = outputs.begin(); i != outputs.end();
+             ++i )
+        {
+            const eq::server::FrameData* data = (*i)->getMasterData();
+            os << "  output " << (*i)->getName() << " "
+               << (*i)->getInputFrames( eq::fabric::EYE_CYCLOP ).size();
+            if( data )
+                os << " offset " << data->getOffset() << " buffers "
+                   << data->getBuffers() << " zoom " << data->getZoom();
+            os << std::endl;
+        }
+
+        const eq::server::Frames& inputs = compound->getInputFrames();
+        for( eq::server::FramesCIter i = inputs.begin(); i != inputs.end();
+             ++i )
+        {
+            os << "  input " << (*i)->getName() << " "
+               << (*i)->hasData( eq::fabric::EYE_CYCLOP ) << std::endl;
+        }
+
+        _tasks[ channel->getName() ] += os.str();
+        return TRAVERSE_CONTINUE;
+    }
+
+    std::string getTasks() const
+    {
+        std::ostringstream os;
+        for( std::map< std::string, std::string >::const_iterator i =
+                 _tasks.begin(); i != _tasks.end(); ++i )
+        {
+            os << i->first << std::endl << i->second;
+        }
+        return os.str();
+    }
+
+private:
+    std::map< std::string, std::string > _tasks;
+};
+
+// Sets the state of all nodes, pipes and windows to generate their tasks
+void _setState( eq::server::Config* config, const eq::server::State state )
+{
+    const eq::server::Nodes& nodes = config->getNodes();
+    for( eq::server::NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        (*i)->setState( state );
+        const eq::server::Pipes& pipes = (*i)->getPipes();
+        for( eq::server::PipesCIter j = pipes.begin(); j != pipes.end(); ++j )
+        {
+            (*j)->setState( state );
+            const eq::server::Windows& windows = (*j)->getWindows();
+            for( eq::server::WindowsCIter k = windows.begin();
+                 k != windows.end(); ++k )
+            {
+                (*k)->setState( state );
+            }
+        }
+    }
+}
+
+// Runs the compound and node updates of a running config with swap barriers
+// and output frames, and returns the channel tasks and the size of the task
+// buffer of each node. The parallel update is used for any number of walls, the
+// time spent in the updates is returned in ms.
+std::string _update( const unsigned nWalls, const bool parallel, float& time )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer(
+                                   _createConfig( nWalls, true ).c_str( ));
+    TEST( server.isValid( ));
+    TEST( server->listen( ));
+
+    eq::server::Config* config = server->getConfigs().front();
+    config->setIAttribute( eq::server::Config::IATTR_MIN_PARALLEL_UPDATES, 1 );
+    const eq::server::Nodes& nodes = config->getNodes();
+    std::string tasks;
+    time = 0.f;
+    {
+        LoadSimulator simulator( config ); // activates all channels
+        server->init();
+        _setState( config, eq::server::STATE_RUNNING );
+
+        // swap barriers are mastered by the unconnected network nodes
+        for( eq::server::NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+            (*i)->setNode( new co::Node );
+
+        for( uint32_t i = 1; i <= 10; ++i )
+        {
+            const lunchbox::Clock clock;
+            config->updateCompounds( i, parallel );
+
+            // unconnected nodes keep their tasks buffered
+            config->updateFrameNodes( lunchbox::uint128_t( i ), i, parallel );
+            time += clock.getTimef();
+            std::ostringstream os;
+            for( size_t j = 0; j < nodes.size(); ++j )
+                os << "node " << j << " tasks "
+                   << nodes[j]->getSendBufferSize() << std::endl;
+            tasks += os.str();
+
+            TaskCollector collector;
+            const eq::server::Compounds& compounds = config->getCompounds();
+            for( eq::server::CompoundsCIter j = compounds.begin();
+                 j != compounds.end(); ++j )
+            {
+                (*j)->accept( collector );
+            }
+            tasks += collector.getTasks();
+        }
+
+        // deregister the swap barriers
+        for( eq::server::NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+        {
+            (*i)->setState( eq::server::STATE_EXIT_SUCCESS );
+            TEST( (*i)->syncConfigExit( ));
+            (*i)->setNode( 0 );
+        }
+        _setState( config, eq::server::STATE_STOPPED );
+        server->exit();
+    }
+
+    TEST( server->close( ));
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    return tasks;
+}
+
+LoadSimulator::Result _run( const unsigned nWalls,
+                            const LoadSimulator::Model& model )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer(
+                                  _createConfig( nWalls, false ).c_str( ));
+    TEST( server.isValid( ));
+    TEST( server->getConfigs().size() == 1 );
+
+    const eq::server::Config* config = server->getConfigs().front();
+    TESTINFO( config->getCompoundGroups().size() == nWalls,
+              config->getCompoundGroups().size( ));
+
+    LoadSimulator::Result result;
+    {
+        LoadSimulator simulator( server->getConfigs().front( ));
+        result = simulator.run( model, 100 );
+    }
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    return result;
+}
+}
+
+// Tests that the concurrent update of independent compounds and nodes is
+// deterministic and generates the same tasks as the serial update. Prints the
+// serial and parallel update times per number of walls, which is the benchmark
+// for the default Config::IATTR_MIN_PARALLEL_UPDATES.
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    LoadSimulator::Model* model = LoadSimulator::createModel( "hotspot",
+                                                              100.f );
+    TEST( model );
+
+    for( unsigned nWalls = 1; nWalls <= 64; nWalls *= 2 )
+    {
+        const LoadSimulator::Result first = _run( nWalls, *model );
+        const LoadSimulator::Result second = _run( nWalls, *model );
+        TESTINFO( first.nFrames == 100, first );
+        TESTINFO( first.frameTime == second.frameTime &&
+                  first.imbalance == second.imbalance,
+                  first << " vs " << second );
+
+        float serialTime = 0.f;
+        float parallelTime = 0.f;
+        const std::string serial = _update( nWalls, false, serialTime );
+        const std::string parallel = _update( nWalls, true, parallelTime );
+        TEST( !serial.empty( ));
+        TESTINFO( serial == parallel, serial << " vs " << std::endl
+                                             << parallel );
+
+        std::cout << nWalls << " walls: serial update " << serialTime / 10.f
+                  << " ms, parallel " << parallelTime / 10.f << " ms/frame"
+                  << std::endl;
+    }
+
+    delete model;
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <loadRecorder.h>
+#include <loadSimulator.h>
+
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+
+#include <lunchbox/init.h>
+
+#include <cmath>
+#include <cstdio>
+
+#define CONFIG "server{ config{ appNode{ pipe {                         \
+    window { channel { name \"c1\" }}                                  \
+    window { channel { name \"c2\" }}                                  \
+    window { channel { name \"c3\" }}}}                                \
+    compound { channel \"c1\"                                          \
+        load_equalizer { mode 2D }                                      \
+        compound {}                                                     \
+        compound { channel \"c2\" outputframe {}}                      \
+        compound { channel \"c3\" outputframe {}}                      \
+        inputframe { name \"frame.c2\" }                               \
+        inputframe { name \"frame.c3\" }}}}"
+
+using eq::server::LoadSimulator;
+
+// Records a simulated run and replays the record as a cost model
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    const std::string filename( "loadRecorder.eqr" );
+    const float frameTime = 100.f;
+    const uint32_t nFrames = 20;
+    LoadSimulator::Model* uniform = LoadSimulator::createModel( "uniform",
+                                                                frameTime );
+    TEST( uniform );
+
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( CONFIG );
+    TEST( server.isValid( ));
+    eq::server::Config* config = server->getConfigs().front();
+    {
+        LoadSimulator simulator( config );
+        eq::server::LoadRecorder recorder( config, filename );
+        simulator.run( *uniform, nFrames );
+    }
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+
+    LoadSimulator::Model* recorded = LoadSimulator::loadModel( filename );
+    TEST( recorded );
+
+    // each replayed frame costs as much as the recorded one, distributed like
+    // the uniform model, up to the rounding of the recorded task times
+    const eq::Viewport left( 0.f, 0.f, .5f, 1.f );
+    const eq::Range front( 0.f, .5f );
+    for( uint32_t i = 0; i < nFrames; ++i )
+    {
+        const float full = recorded->getTime( i, eq::Viewport::FULL,
+                                              eq::Range::ALL );
+        TESTINFO( std::abs( full - frameTime ) < 2.f, full );
+
+        const float half = recorded->getTime( i, left, eq::Range::ALL );
+        TESTINFO( std::abs( half - uniform->getTime( i, left,
+                                                     eq::Range::ALL )) < 2.f,
+                  half );
+        const float range = recorded->getTime( i, eq::Viewport::FULL, front );
+        TESTINFO( std::abs( range - frameTime * .5f ) < 2.f, range );
+    }
+
+    delete recorded;
+    delete uniform;
+    ::remove( filename.c_str( ));
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
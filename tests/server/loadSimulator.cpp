@@ -0,0 +1,161 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <loadSimulator.h>
+
+#include <eq/server/global.h>
+#include <eq/server/equalizers/resourceModel.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+
+#include <lunchbox/init.h>
+
+#include <cmath>
+#include <cstdio>
+
+#define CONFIG( costMap ) "server{ config{ appNode{ pipe {              \
+    window { channel { name \"c1\" }}                                  \
+    window { channel { name \"c2\" }}                                  \
+    window { channel { name \"c3\" }}}}                                \
+    compound { channel \"c1\"                                          \
+        load_equalizer { mode 2D " costMap " }                          \
+        compound {}                                                     \
+        compound { channel \"c2\" outputframe {}}                      \
+        compound { channel \"c3\" outputframe {}}                      \
+        inputframe { name \"frame.c2\" }                               \
+        inputframe { name \"frame.c3\" }}}}"
+
+using eq::server::LoadSimulator;
+
+namespace
+{
+LoadSimulator::Result _run( eq::server::ServerPtr server,
+                            const LoadSimulator::Model& model )
+{
+    LoadSimulator::Result result;
+    {
+        LoadSimulator simulator( server->getConfigs().front( ));
+        result = simulator.run( model, 200 );
+    }
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    return result;
+}
+
+LoadSimulator::Result _simulate( const std::string& filename,
+                                 const LoadSimulator::Model& model )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.loadFile( filename );
+    TESTINFO( server.isValid(), "Load of " << filename << " failed" );
+    TEST( server->getConfigs().size() == 1 );
+
+    eq::server::Loader::addOutputCompounds( server );
+    eq::server::Loader::addDestinationViews( server );
+    eq::server::Loader::addDefaultObserver( server );
+    eq::server::Loader::convertTo11( server );
+    eq::server::Loader::convertTo12( server );
+    return _run( server, model );
+}
+}
+
+// Tests the load equalizer with and without cost map in the simulator
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    LoadSimulator::Model* uniform = LoadSimulator::createModel( "uniform",
+                                                                100.f );
+    LoadSimulator::Model* center = LoadSimulator::createModel( "center",
+                                                               100.f );
+    TEST( uniform && center );
+    TEST( !LoadSimulator::createModel( "unknown", 100.f ));
+
+    const eq::Viewport left( 0.f, 0.f, .5f, 1.f );
+    const eq::Viewport middle( .25f, 0.f, .5f, 1.f );
+    TESTINFO( std::abs( uniform->getTime( 1, left, eq::Range::ALL ) - 50.f )
+              < .01f, uniform->getTime( 1, left, eq::Range::ALL ));
+    TEST( center->getTime( 1, middle, eq::Range::ALL ) >
+          center->getTime( 1, left, eq::Range::ALL ));
+    TESTINFO( std::abs( center->getTime( 1, eq::Viewport::FULL,
+                                         eq::Range::ALL ) - 100.f ) < .01f,
+              center->getTime( 1, eq::Viewport::FULL, eq::Range::ALL ));
+
+    const char* configs[] = { "configs/2-window.2D.lb.eqc",
+                              "configs/2-window.DB.lb.eqc" };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const LoadSimulator::Result result = _simulate( configs[i], *center );
+        TESTINFO( result.nFrames == 200, result );
+        TESTINFO( result.convergence < result.nFrames, configs[i] << ": "
+                  << result );
+        TESTINFO( result.steadyImbalance < .1f, configs[i] << ": " << result );
+        TESTINFO( result.steadyFrameTime < 75.f, configs[i] << ": " << result );
+    }
+
+    // the predictive cost map follows a moving load at least as well
+    LoadSimulator::Model* hotspot = LoadSimulator::createModel( "hotspot",
+                                                                100.f );
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( CONFIG( "" ));
+    TEST( server.isValid( ));
+    const LoadSimulator::Result linear = _run( server, *hotspot );
+
+    server = loader.parseServer( CONFIG( "cost_map [ 16 16 ]" ));
+    TEST( server.isValid( ));
+    const LoadSimulator::Result predicted = _run( server, *hotspot );
+    TESTINFO( predicted.steadyImbalance <= linear.steadyImbalance + .05f,
+              predicted << " vs " << linear );
+    TESTINFO( predicted.steadyFrameTime <= linear.steadyFrameTime * 1.05f,
+              predicted << " vs " << linear );
+
+    // the learned speeds balance channels of different speed
+    const std::string modelFile( "loadSimulator.erm" );
+    server = loader.parseServer(
+        CONFIG( "learn ON resource_model \"loadSimulator.erm\"" ));
+    TEST( server.isValid( ));
+    LoadSimulator::Result heterogeneous;
+    {
+        LoadSimulator simulator( server->getConfigs().front( ));
+        simulator.setSpeed( "c3", 2.f );
+        heterogeneous = simulator.run( *uniform, 200 );
+    }
+    eq::server::Global::clear();
+    server->deleteConfigs();
+
+    TESTINFO( heterogeneous.convergence < heterogeneous.nFrames,
+              heterogeneous );
+    TESTINFO( heterogeneous.steadyImbalance < .1f, heterogeneous );
+    // faster than an equal split, which takes 33 ms on the slow channels
+    TESTINFO( heterogeneous.steadyFrameTime < 30.f, heterogeneous );
+
+    eq::server::ResourceModel resources;
+    TEST( resources.load( modelFile ));
+    const float speedRatio = resources.getSpeed( "c3" ) /
+                             resources.getSpeed( "c2" );
+    TESTINFO( speedRatio > 1.5f && speedRatio < 2.5f, speedRatio );
+    ::remove( modelFile.c_str( ));
+
+    delete hotspot;
+    delete uniform;
+    delete center;
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
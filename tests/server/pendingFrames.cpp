@@ -0,0 +1,109 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <eq/server/pendingFrames.h>
+
+#include <lunchbox/init.h>
+
+using eq::server::PendingFrames;
+
+// Tests the bookkeeping of the node finishes per frame
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    PendingFrames frames;
+    TEST( frames.getFinishedFrame() == 0 );
+    TEST( frames.getStartedFrame() == 0 );
+    TEST( !frames.pop( ));
+
+    // three nodes, frames 1-3 started
+    frames.push( 3 );
+    frames.push( 3 );
+    frames.push( 3 );
+    TEST( frames.getStartedFrame() == 3 );
+    TEST( frames.getCount( 1 ) == 3 );
+
+    // node A finishes frame 1, node B frames 1 and 2 at once
+    frames.release( 0, 1 );
+    frames.release( 0, 2 );
+    TEST( frames.getCount( 1 ) == 1 );
+    TEST( frames.getCount( 2 ) == 2 );
+    TEST( frames.getCount( 3 ) == 3 );
+    TEST( !frames.pop( ));
+    TEST( frames.getFinishedFrame() == 0 );
+
+    // node C finishes frame 1: frame 1 is done
+    frames.release( 0, 1 );
+    TEST( frames.pop( ));
+    TESTINFO( frames.getFinishDelay() >= 0.f, frames.getFinishDelay( ));
+    TEST( frames.getFinishedFrame() == 1 );
+    TEST( frames.getStartedFrame() == 3 );
+    TEST( frames.getCount( 1 ) == 0 );
+    TEST( frames.getCount( 2 ) == 2 );
+
+    // node A finishes frame 2 and 3, node C frame 2
+    frames.release( 1, 3 );
+    frames.release( 1, 2 );
+    TEST( frames.pop( ));
+    TEST( frames.getFinishedFrame() == 2 );
+    TEST( frames.getCount( 3 ) == 2 );
+
+    // node B fails: it releases its outstanding frames, even started ones
+    frames.push( 3 );
+    frames.release( 2, 4 );
+    TEST( frames.getCount( 3 ) == 1 );
+    TEST( frames.getCount( 4 ) == 2 );
+    TEST( !frames.pop( ));
+
+    // the next frame starts with the two running nodes
+    frames.push( 2 );
+    frames.release( 2, 5 ); // node C catches up
+    TEST( frames.pop( ));
+    TEST( frames.getFinishedFrame() == 3 );
+    TEST( frames.getCount( 4 ) == 1 );
+    TEST( frames.getCount( 5 ) == 1 );
+
+    frames.release( 3, 5 ); // node A
+    TEST( frames.pop( ));
+    TEST( frames.getFinishedFrame() == 5 );
+    TEST( frames.getStartedFrame() == 5 );
+    TEST( !frames.pop( ));
+
+    // a frame without running nodes is finished right away
+    frames.push( 0 );
+    TEST( frames.pop( ));
+    TEST( frames.getFinishedFrame() == 6 );
+
+    // replies for finished frames do not release newer ones
+    frames.push( 1 );
+    frames.release( 3, 6 );
+    TEST( frames.getCount( 7 ) == 1 );
+    TEST( !frames.pop( ));
+    frames.release( 6, 7 );
+    TEST( frames.pop( ));
+    TEST( frames.getFinishedFrame() == 7 );
+
+    frames.clear();
+    TEST( frames.getFinishedFrame() == 0 );
+    TEST( frames.getStartedFrame() == 0 );
+
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
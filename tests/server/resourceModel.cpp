@@ -0,0 +1,108 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <eq/server/equalizers/resourceModel.h>
+
+#include <lunchbox/init.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using eq::server::ResourceModel;
+
+namespace
+{
+ResourceModel::Sample _makeSample( const std::string& name, const float work,
+                                   const float time )
+{
+    ResourceModel::Sample sample;
+    sample.name = name;
+    sample.work = work;
+    sample.time = time;
+    sample.pixels = work * 100.f;
+    return sample;
+}
+}
+
+// Tests learning, saving and loading of the resource speeds
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    ResourceModel model;
+    TEST( !model.find( "slow" ));
+    TEST( model.getSpeed( "slow" ) == 1.f );
+    TEST( !model.isDirty( ));
+
+    // a single resource has no relative speed
+    ResourceModel::Samples samples;
+    samples.push_back( _makeSample( "slow", 10.f, 5.f ));
+    model.learn( samples );
+    TEST( model.isDirty( ));
+    TESTINFO( model.getSpeed( "slow" ) == 1.f, model.getSpeed( "slow" ));
+    const ResourceModel::Resource* slow = model.find( "slow" );
+    TEST( slow );
+    TEST( slow->nSamples == 1 );
+    TESTINFO( std::abs( slow->pixelRate - 200.f ) < .01f, slow->pixelRate );
+
+    // 'fast' renders the same work in half the time
+    samples.push_back( _makeSample( "fast", 10.f, 2.5f ));
+    for( size_t i = 0; i < 100; ++i )
+        model.learn( samples );
+
+    const float slowSpeed = model.getSpeed( "slow" );
+    const float fastSpeed = model.getSpeed( "fast" );
+    TESTINFO( std::abs( fastSpeed / slowSpeed - 2.f ) < .01f,
+              slowSpeed << " " << fastSpeed );
+    TESTINFO( std::abs( slowSpeed + fastSpeed - 2.f ) < .01f,
+              slowSpeed << " " << fastSpeed );
+
+    // save and load
+    const std::string filename( "resourceModel.erm" );
+    TEST( model.save( filename ));
+    TEST( !model.isDirty( ));
+
+    ResourceModel loaded;
+    TEST( loaded.load( filename ));
+    TEST( !loaded.isDirty( ));
+    TESTINFO( std::abs( loaded.getSpeed( "slow" ) - slowSpeed ) < .001f,
+              loaded.getSpeed( "slow" ));
+    TESTINFO( std::abs( loaded.getSpeed( "fast" ) - fastSpeed ) < .001f,
+              loaded.getSpeed( "fast" ));
+    const ResourceModel::Resource* fast = loaded.find( "fast" );
+    TEST( fast );
+    TEST( fast->nSamples == model.find( "fast" )->nSamples );
+    TESTINFO( std::abs( fast->pixelRate - model.find( "fast" )->pixelRate ) <
+              .01f, fast->pixelRate );
+
+    // unknown files and formats are rejected
+    TEST( !loaded.load( "resourceModel.unknown" ));
+    {
+        std::ofstream file( filename.c_str( ));
+        file << "# Not a resource model" << std::endl;
+    }
+    ResourceModel invalid;
+    TEST( !invalid.load( filename ));
+    TEST( !invalid.find( "fast" ));
+
+    ::remove( filename.c_str( ));
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
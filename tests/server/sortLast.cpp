@@ -0,0 +1,253 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <eq/client/frame.h>
+#include <eq/server/compound.h>
+#include <eq/server/config.h>
+#include <eq/server/frame.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+#include <eq/server/sortLast.h>
+
+#include <lunchbox/init.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#define CONFIG "server{ config{ appNode{                               \
+    pipe { window { channel { name \"c1\" }}}                           \
+    pipe { window { channel { name \"c2\" }}}                           \
+    pipe { window { channel { name \"c3\" }}}                           \
+    pipe { window { channel { name \"c4\" }}}                           \
+    pipe { window { channel { name \"c5\" }}}                           \
+    pipe { window { channel { name \"c6\" }}}}                          \
+    compound { channel \"c1\" buffer [ COLOR DEPTH ] radix 2           \
+        compound {}                 compound { channel \"c2\" }        \
+        compound { channel \"c3\" } compound { channel \"c4\" }        \
+        compound { channel \"c5\" } compound { channel \"c6\" }}}}"
+
+namespace
+{
+typedef std::vector< uint32_t > Rounds;
+
+void _testRounds( const uint32_t nSources, const uint32_t radix )
+{
+    const Rounds& rounds = eq::server::SortLast::computeRounds( nSources,
+                                                                  radix );
+    uint32_t product = 1;
+    for( Rounds::const_iterator i = rounds.begin(); i != rounds.end(); ++i )
+    {
+        TESTINFO( *i > 1, nSources << ", " << radix );
+        product *= *i;
+    }
+    TESTINFO( product == nSources, nSources << ", " << radix );
+}
+
+typedef std::vector< const eq::server::Compound* > Levels;
+typedef std::pair< size_t, size_t > Endpoint; // source, round
+typedef std::map< std::string, Endpoint > Endpoints;
+
+// levels[r] assembles round r, levels[0] is the drawing leaf
+Levels _getLevels( const eq::server::Compound* source )
+{
+    Levels levels( 1, source );
+    while( !levels.front()->isLeaf( ))
+    {
+        LBASSERT( levels.front()->getChildren().size() == 1 );
+        levels.insert( levels.begin(),
+                       levels.front()->getChildren().front( ));
+    }
+    return levels;
+}
+
+bool _equal( const float a, const float b )
+{
+    return std::abs( a - b ) < 0.0001f;
+}
+
+// Tests that each source keeps the part of its region it does not send, that
+// each part is sent to the partner keeping it, and that the final tiles
+// partition the image and are gathered on the destination
+void _testAssignments( const eq::server::Compound* root,
+                       const Rounds& rounds )
+{
+    const eq::server::Compounds& sources = root->getChildren();
+    const size_t nSources = sources.size();
+    const size_t nRounds = rounds.size();
+
+    // regions[i][r] is the image part kept by source i after round r
+    std::vector< std::vector< eq::Viewport > > regions( nSources );
+    Endpoints outputs;
+    Endpoints inputs;
+    for( size_t i = 0; i < nSources; ++i )
+    {
+        const Levels& levels = _getLevels( sources[i] );
+        TESTINFO( levels.size() == nRounds + 1, levels.size( ));
+
+        regions[i].push_back( eq::Viewport::FULL );
+        for( size_t r = 1; r <= nRounds; ++r )
+        {
+            const eq::server::Frames& outFrames =
+                levels[ r - 1 ]->getOutputFrames();
+            const eq::server::Frames& inFrames = levels[r]->getInputFrames();
+            TEST( outFrames.size() == rounds[ r - 1 ] - 1 );
+            TEST( inFrames.size() == rounds[ r - 1 ] - 1 );
+
+            // the kept part is the gap left between the parts sent away
+            const eq::Viewport& region = regions[i].back();
+            const float partSize = region.h / float( rounds[ r - 1 ] );
+            std::vector< bool > sent( rounds[ r - 1 ], false );
+            for( eq::server::FramesCIter j = outFrames.begin();
+                 j != outFrames.end(); ++j )
+            {
+                const eq::Viewport& vp = (*j)->getViewport();
+                TEST( _equal( vp.h, partSize ));
+                const size_t part = size_t(( vp.y - region.y ) / partSize +.5f );
+                TEST( part < sent.size() && !sent[ part ] );
+                sent[ part ] = true;
+                TEST( outputs.insert( std::make_pair( (*j)->getName(),
+                                                Endpoint( i, r ))).second );
+            }
+            for( eq::server::FramesCIter j = inFrames.begin();
+                 j != inFrames.end(); ++j )
+            {
+                TEST( inputs.insert( std::make_pair( (*j)->getName(),
+                                                Endpoint( i, r ))).second );
+            }
+
+            const size_t kept = std::find( sent.begin(), sent.end(), false ) -
+                                sent.begin();
+            TEST( kept < sent.size( ));
+            regions[i].push_back( eq::Viewport( region.x, region.y +
+                                                kept * partSize, region.w,
+                                                partSize ));
+        }
+    }
+
+    // each part goes to the partner of the same round keeping that part
+    TEST( inputs.size() == outputs.size( ));
+    for( Endpoints::const_iterator i = outputs.begin(); i != outputs.end();
+         ++i )
+    {
+        const Endpoints::const_iterator j = inputs.find( i->first );
+        TESTINFO( j != inputs.end(), i->first );
+        TEST( j->second.first != i->second.first );
+        TEST( j->second.second == i->second.second );
+    }
+    for( size_t i = 0; i < nSources; ++i )
+    {
+        const Levels& levels = _getLevels( sources[i] );
+        for( size_t r = 1; r <= nRounds; ++r )
+        {
+            const eq::server::Frames& outFrames =
+                levels[ r - 1 ]->getOutputFrames();
+            for( eq::server::FramesCIter j = outFrames.begin();
+                 j != outFrames.end(); ++j )
+            {
+                const size_t partner = inputs[ (*j)->getName() ].first;
+                const eq::Viewport& vp = (*j)->getViewport();
+                TEST( _equal( vp.y, regions[ partner ][r].y ));
+                TEST( _equal( vp.h, regions[ partner ][r].h ));
+            }
+        }
+    }
+
+    // the final tiles are disjoint, cover the image and are gathered
+    float covered = 0.f;
+    for( size_t i = 0; i < nSources; ++i )
+    {
+        const eq::Viewport& tile = regions[i].back();
+        covered += tile.h;
+        for( size_t j = 0; j < i; ++j )
+        {
+            const eq::Viewport& other = regions[j].back();
+            TEST( tile.y + tile.h <= other.y + 0.0001f ||
+                  other.y + other.h <= tile.y + 0.0001f );
+        }
+
+        const eq::server::Frames& tiles = sources[i]->getOutputFrames();
+        if( i == 0 ) // in place on the destination channel
+        {
+            TEST( tiles.empty( ));
+            continue;
+        }
+        TEST( tiles.size() == 1 );
+        TEST( tiles.front()->getBuffers() == eq::Frame::BUFFER_COLOR );
+        TEST( _equal( tiles.front()->getViewport().y, tile.y ));
+        TEST( _equal( tiles.front()->getViewport().h, tile.h ));
+
+        bool gathered = false;
+        const eq::server::Frames& inFrames = root->getInputFrames();
+        for( eq::server::FramesCIter j = inFrames.begin();
+             j != inFrames.end(); ++j )
+        {
+            gathered = gathered ||
+                       (*j)->getName() == tiles.front()->getName();
+        }
+        TEST( gathered );
+    }
+    TEST( _equal( covered, 1.f ));
+}
+}
+
+// Tests the radix-k compound generator
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    for( uint32_t nSources = 1; nSources < 64; ++nSources )
+        for( uint32_t radix = 2; radix < 10; ++radix )
+            _testRounds( nSources, radix );
+
+    TEST( eq::server::SortLast::computeRounds( 8, 2 ) == Rounds( 3, 2 ));
+    TEST( eq::server::SortLast::computeRounds( 8, 8 ) == Rounds( 1, 8 ));
+    TEST( eq::server::SortLast::computeRounds( 5, 2 ) == Rounds( 1, 5 ));
+    TEST( eq::server::SortLast::computeRounds( 16, 4 ) == Rounds( 2, 4 ));
+
+    // six sources with radix two: one three-way and one two-way round
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.parseServer( CONFIG );
+    TEST( server.isValid( ));
+    TEST( server->getConfigs().size() == 1 );
+
+    const eq::server::Config* config = server->getConfigs().front();
+    TEST( config->getCompounds().size() == 1 );
+
+    const eq::server::Compound* root = config->getCompounds().front();
+    const eq::server::Compounds& sources = root->getChildren();
+    TEST( sources.size() == 6 );
+    // the first source composites its tile in place
+    TESTINFO( root->getInputFrames().size() == 5,
+              root->getInputFrames().size( ));
+
+    for( eq::server::CompoundsCIter i = sources.begin(); i != sources.end();
+         ++i )
+    {
+        TEST( (*i)->getRange() != eq::Range::ALL );
+    }
+    // three-way round first, then a two-way round
+    _testAssignments( root, eq::server::SortLast::computeRounds( 6, 2 ));
+
+    eq::server::Global::clear();
+    server->deleteConfigs(); // break server <-> config ref circle
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <test.h>
+
+#include <eq/server/tileQueue.h>
+#include <eq/server/equalizers/tileEqualizer.h>
+
+#include <lunchbox/init.h>
+
+using eq::server::TileQueue;
+using eq::server::TileEqualizer;
+
+namespace
+{
+std::vector< float > _makeShares( const float a, const float b, const float c )
+{
+    std::vector< float > shares;
+    shares.push_back( a );
+    shares.push_back( b );
+    shares.push_back( c );
+    return shares;
+}
+
+void _testShares()
+{
+    // shares are normalized to one
+    std::vector< float > shares = _makeShares( 1.f, 2.f, 1.f );
+    TEST( TileQueue::normalizeShares( shares ));
+    TESTINFO( shares[0] == .25f && shares[1] == .5f && shares[2] == .25f,
+              shares[0] << ", " << shares[1] << ", " << shares[2] );
+
+    // zero and negative sums are rejected and leave the shares unchanged
+    shares = _makeShares( 0.f, 0.f, 0.f );
+    TEST( !TileQueue::normalizeShares( shares ));
+    TEST( shares[0] == 0.f && shares[1] == 0.f && shares[2] == 0.f );
+
+    shares = _makeShares( 1.f, -2.f, 0.f );
+    TEST( !TileQueue::normalizeShares( shares ));
+    TEST( shares[0] == 1.f && shares[1] == -2.f );
+
+    shares.clear();
+    TEST( !TileQueue::normalizeShares( shares ));
+}
+
+void _testRanges()
+{
+    // exact ranges
+    std::vector< float > shares = _makeShares( 1.f, 2.f, 1.f );
+    TEST( TileQueue::normalizeShares( shares ));
+    std::vector< size_t > ends = TileQueue::getRangeEnds( shares, 8 );
+    TEST( ends.size() == 3 );
+    TESTINFO( ends[0] == 2 && ends[1] == 6 && ends[2] == 8,
+              ends[0] << ", " << ends[1] << ", " << ends[2] );
+
+    // rounded to the nearest tile, the last range ends with the last tile
+    shares = _makeShares( 1.f, 1.f, 1.f );
+    TEST( TileQueue::normalizeShares( shares ));
+    ends = TileQueue::getRangeEnds( shares, 10 );
+    TESTINFO( ends[0] == 3 && ends[1] == 7 && ends[2] == 10,
+              ends[0] << ", " << ends[1] << ", " << ends[2] );
+
+    // fewer tiles than inputs
+    ends = TileQueue::getRangeEnds( shares, 1 );
+    TESTINFO( ends[0] == 0 && ends[1] == 1 && ends[2] == 1,
+              ends[0] << ", " << ends[1] << ", " << ends[2] );
+
+    ends = TileQueue::getRangeEnds( shares, 0 );
+    TEST( ends[0] == 0 && ends[1] == 0 && ends[2] == 0 );
+
+    // a zero share gets an empty range
+    shares = _makeShares( 1.f, 0.f, 1.f );
+    TEST( TileQueue::normalizeShares( shares ));
+    ends = TileQueue::getRangeEnds( shares, 6 );
+    TESTINFO( ends[0] == 3 && ends[1] == 3 && ends[2] == 6,
+              ends[0] << ", " << ends[1] << ", " << ends[2] );
+
+    // a negative share does not move the ranges backwards
+    shares = _makeShares( -1.f, 2.f, 1.f );
+    TEST( TileQueue::normalizeShares( shares ));
+    ends = TileQueue::getRangeEnds( shares, 8 );
+    TESTINFO( ends[0] == 0 && ends[1] == 4 && ends[2] == 8,
+              ends[0] << ", " << ends[1] << ", " << ends[2] );
+
+    // shares not summing up to one leave the remainder to the shared queue
+    shares = _makeShares( .25f, .25f, 0.f );
+    ends = TileQueue::getRangeEnds( shares, 8 );
+    TEST( ends[0] == 2 && ends[1] == 4 && ends[2] == 4 );
+}
+
+void _testOrder()
+{
+    // own range first, then the nearest ones, the following one first
+    std::vector< size_t > order = TileQueue::getQueueOrder( 2, 5 );
+    TEST( order.size() == 5 );
+    TESTINFO( order[0] == 2 && order[1] == 3 && order[2] == 1 &&
+              order[3] == 4 && order[4] == 0,
+              order[0] << " " << order[1] << " " << order[2] << " " <<
+              order[3] << " " << order[4] );
+
+    order = TileQueue::getQueueOrder( 0, 4 );
+    TEST( order.size() == 4 );
+    TEST( order[0] == 0 && order[1] == 1 && order[2] == 2 && order[3] == 3 );
+
+    order = TileQueue::getQueueOrder( 3, 4 );
+    TEST( order.size() == 4 );
+    TEST( order[0] == 3 && order[1] == 2 && order[2] == 1 && order[3] == 0 );
+
+    order = TileQueue::getQueueOrder( 1, 4 );
+    TEST( order.size() == 4 );
+    TEST( order[0] == 1 && order[1] == 2 && order[2] == 0 && order[3] == 3 );
+
+    // each range is processed once by each input
+    for( size_t nInputs = 1; nInputs < 8; ++nInputs )
+    {
+        for( size_t input = 0; input < nInputs; ++input )
+        {
+            order = TileQueue::getQueueOrder( input, nInputs );
+            TEST( order.size() == nInputs );
+            std::vector< bool > seen( nInputs, false );
+            for( size_t i = 0; i < order.size(); ++i )
+            {
+                TEST( order[i] < nInputs );
+                TEST( !seen[ order[i] ] );
+                seen[ order[i] ] = true;
+            }
+        }
+    }
+
+    // inputs without a range process all ranges in order
+    order = TileQueue::getQueueOrder( 3, 3 );
+    TEST( order.size() == 3 );
+    TEST( order[0] == 0 && order[1] == 1 && order[2] == 2 );
+
+    TEST( TileQueue::getQueueOrder( 0, 0 ).empty( ));
+}
+
+void _testTileSize()
+{
+    const eq::PixelViewport pvp( 0, 0, 1024, 1024 );
+    const eq::Vector2i size( 64, 64 );
+
+    // balanced overhead keeps the size
+    TEST( TileEqualizer::adaptTileSize( size, pvp, 100.f, 5.f, 4 ) == size );
+
+    // high overhead enlarges the smaller dimension, x first
+    eq::Vector2i next = TileEqualizer::adaptTileSize( size, pvp, 100.f, 20.f,
+                                                      4 );
+    TESTINFO( next == eq::Vector2i( 128, 64 ), next );
+    next = TileEqualizer::adaptTileSize( next, pvp, 100.f, 20.f, 4 );
+    TESTINFO( next == eq::Vector2i( 128, 128 ), next );
+
+    // ... but never beyond the viewport
+    next = TileEqualizer::adaptTileSize( eq::Vector2i( 128, 512 ),
+                                         eq::PixelViewport( 0, 0, 200, 4096 ),
+                                         100.f, 20.f, 1 );
+    TESTINFO( next == eq::Vector2i( 200, 512 ), next );
+
+    // ... nor below four tiles per channel: 1024x1024 has 8 tiles of 512x256
+    next = TileEqualizer::adaptTileSize( eq::Vector2i( 256, 256 ), pvp,
+                                         100.f, 20.f, 2 );
+    TESTINFO( next == eq::Vector2i( 512, 256 ), next );
+    next = TileEqualizer::adaptTileSize( eq::Vector2i( 256, 256 ), pvp,
+                                         100.f, 20.f, 3 );
+    TESTINFO( next == eq::Vector2i( 256, 256 ), next );
+
+    // no render time measured does not enlarge
+    TEST( TileEqualizer::adaptTileSize( size, pvp, 0.f, 20.f, 4 ) == size );
+
+    // low overhead reduces the larger dimension, x first
+    next = TileEqualizer::adaptTileSize( size, pvp, 100.f, 1.f, 4 );
+    TESTINFO( next == eq::Vector2i( 32, 64 ), next );
+    next = TileEqualizer::adaptTileSize( next, pvp, 100.f, 1.f, 4 );
+    TESTINFO( next == eq::Vector2i( 32, 32 ), next );
+
+    // ... but not below the minimum size
+    next = TileEqualizer::adaptTileSize( eq::Vector2i( 16, 16 ), pvp,
+                                         100.f, 1.f, 4 );
+    TESTINFO( next == eq::Vector2i( 16, 16 ), next );
+
+    // too few tiles per channel reduce the size even with balanced overhead
+    next = TileEqualizer::adaptTileSize( eq::Vector2i( 512, 512 ), pvp,
+                                         100.f, 5.f, 4 );
+    TESTINFO( next == eq::Vector2i( 256, 512 ), next );
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( lunchbox::init( argc, argv ));
+
+    _testShares();
+    _testRanges();
+    _testOrder();
+    _testTileSize();
+
+    TEST( lunchbox::exit( ));
+    return EXIT_SUCCESS;
+}
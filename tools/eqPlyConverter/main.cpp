@@ -27,10 +27,32 @@
  */
 
 #include <eq/eq.h>
+#include <vertexBufferData.h>
 #include <vertexBufferRoot.h>
+#include <vertexData.h>
+
+#include <lunchbox/clock.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
 
 namespace
 {
+static const size_t _nCullViews = 360;
+
+/** Exposes the serialized kd-tree to compare the output of two builders. */
+class BenchmarkRoot : public mesh::VertexBufferRoot
+{
+public:
+    std::string toString()
+    {
+        std::ostringstream os;
+        toStream( os );
+        return os.str();
+    }
+};
+
 static bool _isPlyfile( const std::string& filename )
 {
     const size_t size = filename.length();
@@ -44,22 +66,203 @@ static bool _isPlyfile( const std::string& filename )
     }
     return true;
 }
+
+// Receives the bytes read by _touch, which can't be optimized away
+static volatile char _sink;
+
+// Reads one byte per page of the array, as the first upload of the model does
+template< class T > static void _touch( const mesh::DataArray< T >& array )
+{
+    const char* data = reinterpret_cast< const char* >( array.getData( ));
+    const size_t size = array.size() * sizeof( T );
+    for( size_t i = 0; i < size; i += 4096 )
+        _sink = data[i];
+}
+
+static void _touch( const mesh::VertexBufferData& data )
+{
+    _touch( data.vertices );
+    _touch( data.colors );
+    _touch( data.normals );
+    _touch( data.indices );
+    _touch( data.compactVertices );
+}
+
+// Returns a model name in the temporary directory, to keep the benchmark from
+// replacing the caches of the model
+static std::string _getTempFilename( const std::string& filename )
+{
+    const char* directory = getenv( "TMPDIR" );
+    if( !directory )
+        directory = getenv( "TEMP" );
+
+    std::ostringstream os;
+    os << ( directory ? directory : "/tmp" ) << '/'
+       << lunchbox::getFilename( filename ) << ".benchmark";
+    return os.str();
+}
+
+static bool _readPlyfile( const std::string& filename, mesh::VertexData& data )
+{
+    if( !data.readPlyFile( filename ))
+        return false;
+    data.calculateNormals();
+    data.scale( 2.0f );
+    return true;
+}
+
+// Compares the build time and output of the parallel and serial kd-tree setup,
+// verifies the LOD error bound, measures the culling time and the size and
+// load time of both vertex layouts
+static void _benchmark( const std::string& filename )
+{
+    mesh::VertexData serialData;
+    if( !_readPlyfile( filename, serialData ))
+    {
+        LBWARN << "Can't load model: " << filename << std::endl;
+        return;
+    }
+    mesh::VertexData parallelData = serialData;
+
+    BenchmarkRoot serial;
+    lunchbox::Clock clock;
+    serial.setupTreeSerial( serialData );
+    const float serialTime = clock.getTimef();
+
+    BenchmarkRoot parallel;
+    clock.reset();
+    parallel.setupTree( parallelData );
+    const float parallelTime = clock.getTimef();
+
+    const bool equal = serial.toString() == parallel.toString();
+    std::cout << filename << ": " << serialData.triangles.size()
+              << " triangles, serial " << serialTime << " ms, parallel "
+              << parallelTime << " ms, output "
+              << ( equal ? "equal" : "differs" ) << std::endl;
+
+    const size_t nLODErrors = parallel.countLODErrors();
+    std::cout << filename << ": LOD error bound ";
+    if( nLODErrors )
+        std::cout << "exceeded by " << nLODErrors << " vertices" << std::endl;
+    else
+        std::cout << "holds" << std::endl;
+
+    // cull from viewpoints around the model, without rendering
+    const mesh::VertexBufferCuller& culler = parallel.getCuller();
+    const eq::Frustumf frustum( -.5f, .5f, -.5f, .5f, 1.f, 100.f );
+    eq::Matrix4f view = eq::Matrix4f::IDENTITY;
+    view.set_translation( eq::Vector3f( 0.f, 0.f, -2.f ));
+    mesh::Range range;
+    range[0] = 0.f;
+    range[1] = 1.f;
+
+    // without and with LOD, one pixel error on a 1024 pixel high viewport
+    for( size_t j = 0; j < 2; ++j )
+    {
+        const float lodThreshold = j ? 2.f / 1024.f : 0.f;
+        mesh::DrawList drawList;
+        size_t nDrawn = 0;
+        size_t nVertices = 0;
+        clock.reset();
+        for( size_t i = 0; i < _nCullViews; ++i )
+        {
+            eq::Matrix4f model = eq::Matrix4f::IDENTITY;
+            model.pre_rotate_y( 2.f * float( M_PI ) * i / _nCullViews );
+
+            drawList.clear();
+            culler.cull( frustum.compute_matrix() * view * model, range, true,
+                         lodThreshold, drawList );
+            nDrawn += drawList.size();
+            for( mesh::DrawList::const_iterator k = drawList.begin();
+                 k != drawList.end(); ++k )
+            {
+                nVertices += (*k)->getNumberOfVertices();
+            }
+        }
+        std::cout << filename << ": cull" << ( j ? " with LOD " : " " )
+                  << clock.getTimef() / _nCullViews << " ms, "
+                  << nDrawn / _nCullViews << " of "
+                  << culler.getNumberOfNodes() << " nodes drawn, "
+                  << nVertices / _nCullViews << " indices" << std::endl;
+    }
+
+    // write and load the cache of the default and the compact vertex layout
+    const std::string tempName = _getTempFilename( filename );
+    for( size_t i = 0; i < 2; ++i )
+    {
+        const bool compact = ( i == 1 );
+        mesh::VertexData data = serialData;
+        BenchmarkRoot root;
+        if( compact )
+            root.useCompactVertices();
+        root.setupTree( data );
+
+        const std::string cacheName = root.getCacheFilename( tempName );
+        if( !root.writeToFile( tempName ))
+        {
+            LBWARN << "Can't write binary representation to " << cacheName
+                   << std::endl;
+            continue;
+        }
+
+        bool loaded = false;
+        float loadTime = 0.f;
+        size_t bufferObjectSize = 0;
+        {
+            mesh::VertexBufferRoot cached;
+            if( compact )
+                cached.useCompactVertices();
+            clock.reset();
+            if( cached.readFromFile( tempName ))
+            {
+                _touch( cached.getData( ));
+                loadTime = clock.getTimef();
+                bufferObjectSize = cached.getData().getBufferObjectSize();
+                loaded = true;
+            }
+        }
+        ::remove( cacheName.c_str( ));
+
+        if( !loaded )
+        {
+            LBWARN << "Can't load model: " << cacheName << std::endl;
+            continue;
+        }
+        std::cout << filename << ( compact ? ": compact " : ": default " )
+                  << root.toString().size() / 1024 << " KB cache, "
+                  << bufferObjectSize / 1024 << " KB buffer objects, load "
+                  << loadTime << " ms" << std::endl;
+    }
+}
 }
 
 int main( const int argc, char** argv )
 {
     eq::Strings filenames;
+    bool benchmark = false;
+    bool compact = false;
     for( int i=1; i < argc; ++i )
-        filenames.push_back( argv[i] );
+    {
+        if( std::string( argv[i] ) == "--benchmark" )
+            benchmark = true;
+        else if( std::string( argv[i] ) == "--compact" )
+            compact = true;
+        else
+            filenames.push_back( argv[i] );
+    }
 
     while( !filenames.empty( ))
     {
         const std::string filename = filenames.back();
         filenames.pop_back();
      
-        if( _isPlyfile( filename ))
+        if( _isPlyfile( filename ) && benchmark )
+            _benchmark( filename );
+        else if( _isPlyfile( filename ))
         {
             mesh::VertexBufferRoot* model = new mesh::VertexBufferRoot;
+            if( compact )
+                model->useCompactVertices();
             if( !model->readFromFile( filename.c_str( )))
                 LBWARN << "Can't load model: " << filename << std::endl;
 
@@ -0,0 +1,176 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "loadRecorder.h"
+
+#include <eq/server/channel.h>
+#include <eq/server/compound.h>
+#include <eq/server/compoundVisitor.h>
+#include <eq/server/config.h>
+#include <eq/server/log.h>
+
+#include <eq/client/statistic.h>
+#include <eq/fabric/task.h>
+
+#include <lunchbox/scopedMutex.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+class ChannelCollector : public CompoundVisitor
+{
+public:
+    virtual VisitorResult visit( Compound* compound )
+    {
+        Channel* channel = compound->getChannel();
+        if( channel &&
+            std::find( channels.begin(), channels.end(), channel ) ==
+            channels.end( ))
+        {
+            channels.push_back( channel );
+        }
+        return TRAVERSE_CONTINUE;
+    }
+
+    Channels channels;
+};
+
+class TaskRecorder : public CompoundVisitor
+{
+public:
+    TaskRecorder( std::ostream& os, const uint32_t frameNumber )
+        : _os( os ), _frameNumber( frameNumber ) {}
+
+    virtual VisitorResult visit( const Compound* compound )
+    {
+        const Channel* channel = compound->getChannel();
+        if( !channel || !compound->isActive() ||
+            !compound->testInheritTask( fabric::TASK_DRAW ))
+        {
+            return TRAVERSE_CONTINUE;
+        }
+
+        const Viewport& vp = compound->getInheritViewport();
+        const Range& range = compound->getInheritRange();
+        const Zoom& zoom = compound->getInheritZoom();
+        _os << "task " << _frameNumber << ' ' << channel->getSerial() << ' '
+            << compound->getTaskID() << ' ' << vp.x << ' ' << vp.y << ' '
+            << vp.w << ' ' << vp.h << ' ' << range.start << ' ' << range.end
+            << ' ' << zoom.x() << ' ' << zoom.y() << '\n';
+        return TRAVERSE_CONTINUE;
+    }
+
+private:
+    std::ostream& _os;
+    const uint32_t _frameNumber;
+};
+}
+
+LoadRecorder::LoadRecorder( Config* config, const std::string& filename )
+        : _config( config )
+        , _file( filename.c_str( ))
+        , _frameNumber( 0 )
+{
+    if( !_file.is_open( ))
+    {
+        LBWARN << "Can't open load record file " << filename << std::endl;
+        return;
+    }
+    _file << "# Equalizer load record 1\n";
+
+    ChannelCollector collector;
+    const Compounds& compounds = config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+    {
+        (*i)->accept( collector );
+        (*i)->addListener( this );
+    }
+
+    _channels = collector.channels;
+    for( ChannelsCIter i = _channels.begin(); i != _channels.end(); ++i )
+        (*i)->addListener( this );
+
+    LBINFO << "Recording load of " << _channels.size() << " channels to "
+           << filename << std::endl;
+}
+
+LoadRecorder::~LoadRecorder()
+{
+    if( !_file.is_open( ))
+        return;
+
+    for( ChannelsCIter i = _channels.begin(); i != _channels.end(); ++i )
+        (*i)->removeListener( this );
+    _channels.clear();
+
+    const Compounds& compounds = _config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+    {
+        (*i)->removeListener( this );
+        if( _frameNumber > 0 )
+            _recordTasks( *i, _frameNumber );
+    }
+    _file.close();
+}
+
+void LoadRecorder::notifyUpdatePre( Compound* compound,
+                                    const uint32_t frameNumber )
+{
+    // The compound tree still has the tasks of the previous frame
+    if( frameNumber > 1 )
+        _recordTasks( compound, frameNumber - 1 );
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    _frameNumber = LB_MAX( _frameNumber, frameNumber );
+}
+
+void LoadRecorder::_recordTasks( const Compound* compound,
+                                 const uint32_t frameNumber )
+{
+    std::ostringstream os;
+    TaskRecorder recorder( os, frameNumber );
+    compound->accept( recorder );
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    _file << os.str();
+    _file.flush();
+}
+
+void LoadRecorder::notifyLoadData( Channel* channel, const uint32_t frameNumber,
+                                   const Statistics& statistics,
+                                   const Viewport& region )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    for( StatisticsCIter i = statistics.begin(); i != statistics.end(); ++i )
+    {
+        const Statistic& statistic = *i;
+        _file << "stat " << frameNumber << ' ' << channel->getSerial() << ' '
+              << region.x << ' ' << region.y << ' ' << region.w << ' '
+              << region.h << ' ' << unsigned( statistic.type ) << ' '
+              << statistic.task << ' ' << statistic.startTime << ' '
+              << statistic.endTime << '\n';
+    }
+}
+
+}
+}
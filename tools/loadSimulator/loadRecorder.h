@@ -0,0 +1,83 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQS_LOADRECORDER_H
+#define EQS_LOADRECORDER_H
+
+#include <eq/server/channelListener.h>  // base class
+#include <eq/server/compoundListener.h> // base class
+#include <eq/server/types.h>
+
+#include <lunchbox/lock.h>
+#include <fstream>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Records the load data of a running config for an offline simulation.
+     *
+     * Each frame, the viewport, range and zoom of all rendering tasks and the
+     * statistics received from their channels are appended as text lines to
+     * the record file, which is replayed by the LoadSimulator. The tasks of a
+     * frame are recorded when the compounds are updated for the next frame,
+     * the tasks of the last frame upon destruction. The standalone eqServer
+     * records its first config if EQ_SERVER_LOAD_RECORD is set to the file
+     * name. The file is flushed after each frame.
+     *
+     * Format, one record per line:
+     *   task  frame channel taskID vp.x vp.y vp.w vp.h range.start range.end
+     *         zoom.x zoom.y
+     *   stat  frame channel region.x region.y region.w region.h type taskID
+     *         startTime endTime
+     * where channel is the serial of the channel within the recording.
+     */
+    class LoadRecorder : protected ChannelListener, protected CompoundListener
+    {
+    public:
+        /** Start recording all channels used by the config's compounds. */
+        LoadRecorder( Config* config, const std::string& filename );
+
+        /** Record the tasks of the last frame and close the record file. */
+        virtual ~LoadRecorder();
+
+    protected:
+        /** @sa ChannelListener::notifyLoadData */
+        virtual void notifyLoadData( Channel* channel,
+                                     const uint32_t frameNumber,
+                                     const Statistics& statistics,
+                                     const Viewport& region );
+
+        /** @sa CompoundListener::notifyUpdatePre */
+        virtual void notifyUpdatePre( Compound* compound,
+                                      const uint32_t frameNumber );
+
+    private:
+        Config* const _config;
+        Channels _channels;
+        std::ofstream _file;
+        lunchbox::Lock _lock; //!< compound trees are updated concurrently
+        uint32_t _frameNumber; //!< the last updated frame
+
+        void _recordTasks( const Compound* compound,
+                           const uint32_t frameNumber );
+    };
+}
+}
+
+#endif // EQS_LOADRECORDER_H
@@ -0,0 +1,675 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "loadSimulator.h"
+
+#include <eq/server/canvas.h>
+#include <eq/server/channel.h>
+#include <eq/server/compound.h>
+#include <eq/server/compoundUpdateDataVisitor.h>
+#include <eq/server/compoundVisitor.h>
+#include <eq/server/config.h>
+#include <eq/server/log.h>
+#include <eq/server/node.h>
+#include <eq/server/observer.h>
+#include <eq/server/pipe.h>
+#include <eq/server/window.h>
+#include <eq/server/equalizers/dfrEqualizer.h>
+#include <eq/server/equalizers/loadEqualizer.h>
+#include <eq/server/equalizers/treeEqualizer.h>
+
+#include <eq/client/statistic.h>
+#include <eq/fabric/task.h>
+#include <lunchbox/clock.h>
+
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace eq
+{
+namespace server
+{
+namespace
+{
+static const PixelViewport _defaultPVP( 0, 0, 1920, 1200 );
+static const size_t _nSamples = 64; //!< per axis for numerical integration
+
+float _getOverlap( const float start1, const float end1,
+                   const float start2, const float end2 )
+{
+    return LB_MAX( 0.f, LB_MIN( end1, end2 ) - LB_MAX( start1, start2 ));
+}
+
+/** Cost distributions given by a density function per axis. */
+class SyntheticModel : public LoadSimulator::Model
+{
+public:
+    enum Shape
+    {
+        UNIFORM,
+        CENTER,
+        HOTSPOT
+    };
+
+    SyntheticModel( const Shape shape, const float frameTime )
+        : _shape( shape ), _frameTime( frameTime ) {}
+
+    virtual float getTime( const uint32_t frameNumber, const Viewport& vp,
+                           const Range& range ) const
+    {
+        if( _shape == UNIFORM )
+            return _frameTime * vp.getArea() * ( range.end - range.start );
+
+        // the hotspot moves once across the screen every 200 frames
+        const float center = _shape == CENTER ? .5f :
+            .5f + .4f * std::sin( float( frameNumber ) * 0.0314159f );
+        const float rangeTime = _shape == CENTER ?
+            range.end - range.start : _integrate( range.start, range.end,
+                                                  center );
+        return _frameTime * _integrate( vp.x, vp.x + vp.w, center ) *
+               _integrate( vp.y, vp.y + vp.h, .5f ) * rangeTime;
+    }
+
+private:
+    const Shape _shape;
+    const float _frameTime;
+
+    float _getDensity( const float x, const float center ) const
+    {
+        const float peak = _shape == CENTER ? 4.f : 8.f;
+        const float width = _shape == CENTER ? .5f : .2f;
+        const float tent = 1.f - std::fabs( x - center ) / width;
+        return 1.f + ( peak - 1.f ) * LB_MAX( tent, 0.f );
+    }
+
+    float _sum( const float start, const float end, const float center ) const
+    {
+        const float step = ( end - start ) / float( _nSamples );
+        float sum = 0.f;
+        for( size_t i = 0; i < _nSamples; ++i )
+            sum += _getDensity( start + ( float( i ) + .5f ) * step, center );
+        return sum * step;
+    }
+
+    /** @return the fraction of the cost in [start, end] of [0, 1]. */
+    float _integrate( const float start, const float end,
+                      const float center ) const
+    {
+        if( end <= start )
+            return 0.f;
+        return _sum( start, end, center ) / _sum( 0.f, 1.f, center );
+    }
+};
+
+/** The tasks of a load record, replayed cyclically. */
+class RecordedModel : public LoadSimulator::Model
+{
+public:
+    struct Tile
+    {
+        Viewport vp;
+        Range range;
+        float time;
+    };
+    typedef std::vector< Tile > Tiles;
+
+    std::vector< Tiles > frames;
+
+    virtual float getTime( const uint32_t frameNumber, const Viewport& vp,
+                           const Range& range ) const
+    {
+        if( frames.empty( ))
+            return 0.f;
+
+        const Tiles& tiles = frames[ frameNumber % frames.size() ];
+        float time = 0.f;
+        for( std::vector< Tile >::const_iterator i = tiles.begin();
+             i != tiles.end(); ++i )
+        {
+            const Tile& tile = *i;
+            const float overlap =
+                _getOverlap( vp.x, vp.x + vp.w, tile.vp.x,
+                             tile.vp.x + tile.vp.w ) *
+                _getOverlap( vp.y, vp.y + vp.h, tile.vp.y,
+                             tile.vp.y + tile.vp.h ) *
+                _getOverlap( range.start, range.end, tile.range.start,
+                             tile.range.end );
+            if( overlap > 0.f )
+                time += tile.time * overlap / ( tile.vp.getArea() *
+                                          ( tile.range.end - tile.range.start ));
+        }
+        return time;
+    }
+};
+
+/** A recorded rendering task with the matching statistics. */
+struct RecordedTask
+{
+    RecordedTask()
+        : region( Viewport::FULL )
+        , startTime( std::numeric_limits< int64_t >::max( ))
+        , endTime( 0 ) {}
+
+    Viewport vp;
+    Range range;
+    Zoom zoom;
+    Viewport region;
+    int64_t startTime;
+    int64_t endTime;
+};
+typedef std::pair< uint32_t, uint32_t > TaskKey; //!< channel, task ID
+typedef std::map< TaskKey, RecordedTask > RecordedTasks;
+typedef std::map< uint32_t, RecordedTasks > RecordedFrames;
+
+/** The simulated work of one channel during one frame. */
+struct ChannelLoad
+{
+    ChannelLoad() : time( 0 ), busy( 0 ) {}
+
+    int64_t time; //!< end of the last task
+    int64_t busy; //!< time spent drawing
+    Statistics statistics;
+};
+typedef std::map< Channel*, ChannelLoad > ChannelLoads;
+
+/** Channel statistics waiting to be delivered to the equalizers. */
+struct Load
+{
+    uint32_t frameNumber;
+    Channel* channel;
+    Statistics statistics;
+};
+
+Statistic _makeStatistic( const Statistic::Type type,
+                          const uint32_t frameNumber, const uint32_t task,
+                          const int64_t startTime, const int64_t endTime )
+{
+    Statistic statistic;
+    statistic.type = type;
+    statistic.frameNumber = frameNumber;
+    statistic.task = task;
+    statistic.plugins[0] = 0;
+    statistic.plugins[1] = 0;
+    statistic.ratio = 1.f;
+    statistic.startTime = startTime;
+    statistic.endTime = endTime;
+    statistic.resourceName[0] = '\0';
+    return statistic;
+}
+
+class DrawSimulator : public CompoundVisitor
+{
+public:
+    DrawSimulator( const LoadSimulator::Model& model,
+                   const std::map< std::string, float >& speeds,
+                   const uint32_t frameNumber, const int64_t startTime,
+                   ChannelLoads& loads )
+        : _model( model ), _speeds( speeds ), _frameNumber( frameNumber )
+        , _startTime( startTime ), _endTime( startTime ), _loads( loads ) {}
+
+    virtual VisitorResult visit( Compound* compound )
+    {
+        Channel* channel = compound->getChannel();
+        if( !channel || !compound->isActive() ||
+            !compound->testInheritTask( fabric::TASK_DRAW ))
+        {
+            return TRAVERSE_CONTINUE;
+        }
+
+        const Zoom& zoom = compound->getInheritZoom();
+        std::map< std::string, float >::const_iterator speed =
+            _speeds.find( channel->getName( ));
+        const float time = _model.getTime( _frameNumber,
+                                           compound->getInheritViewport(),
+                                           compound->getInheritRange( )) *
+                           zoom.x() * zoom.y() /
+                           ( speed == _speeds.end() ? 1.f : speed->second );
+        const int64_t duration = LB_MAX( int64_t( time + .5f ), 1 );
+
+        ChannelLoad& load = _loads[ channel ];
+        const int64_t start = LB_MAX( load.time, _startTime );
+        load.time = start + duration;
+        load.busy += duration;
+        load.statistics.push_back(
+            _makeStatistic( Statistic::CHANNEL_DRAW, _frameNumber,
+                            compound->getTaskID(), start, load.time ));
+
+        _endTime = LB_MAX( _endTime, load.time );
+        return TRAVERSE_CONTINUE;
+    }
+
+    int64_t getEndTime() const { return _endTime; }
+
+private:
+    const LoadSimulator::Model& _model;
+    const std::map< std::string, float >& _speeds;
+    const uint32_t _frameNumber;
+    const int64_t _startTime;
+    int64_t _endTime;
+    ChannelLoads& _loads;
+};
+
+/** Assembles all input frames once all source channels are done drawing. */
+class AssembleSimulator : public CompoundVisitor
+{
+public:
+    AssembleSimulator( const float time, const uint32_t frameNumber,
+                       const int64_t startTime, ChannelLoads& loads )
+        : _time( time ), _frameNumber( frameNumber ), _startTime( startTime )
+        , _endTime( startTime ), _loads( loads ) {}
+
+    virtual VisitorResult visit( Compound* compound )
+    {
+        Channel* channel = compound->getChannel();
+        const Frames& inputFrames = compound->getInputFrames();
+        if( !channel || inputFrames.empty() || !compound->isActive() ||
+            !compound->testInheritTask( fabric::TASK_ASSEMBLE ))
+        {
+            return TRAVERSE_CONTINUE;
+        }
+
+        const float time = _time * float( inputFrames.size( ));
+        ChannelLoad& load = _loads[ channel ];
+        const int64_t start = LB_MAX( load.time, _startTime );
+        load.time = start + int64_t( time + .5f );
+        load.statistics.push_back(
+            _makeStatistic( Statistic::CHANNEL_ASSEMBLE, _frameNumber,
+                            compound->getTaskID(), start, load.time ));
+
+        _endTime = LB_MAX( _endTime, load.time );
+        return TRAVERSE_CONTINUE;
+    }
+
+    int64_t getEndTime() const { return _endTime; }
+
+private:
+    const float _time;
+    const uint32_t _frameNumber;
+    const int64_t _startTime;
+    int64_t _endTime;
+    ChannelLoads& _loads;
+};
+
+class DampingSetter : public CompoundVisitor
+{
+public:
+    DampingSetter( const float damping ) : _damping( damping ) {}
+
+    virtual VisitorResult visit( Compound* compound )
+    {
+        const Equalizers& equalizers = compound->getEqualizers();
+        for( EqualizersCIter i = equalizers.begin(); i != equalizers.end();
+             ++i )
+        {
+            Equalizer* equalizer = *i;
+            switch( equalizer->getType( ))
+            {
+            case fabric::LOAD_EQUALIZER:
+                static_cast< LoadEqualizer* >( equalizer )->setDamping(
+                    _damping );
+                break;
+            case fabric::TREE_EQUALIZER:
+                static_cast< TreeEqualizer* >( equalizer )->setDamping(
+                    _damping );
+                break;
+            case fabric::DFR_EQUALIZER:
+                static_cast< DFREqualizer* >( equalizer )->setDamping(
+                    _damping );
+                break;
+            default:
+                break;
+            }
+        }
+        return TRAVERSE_CONTINUE;
+    }
+
+private:
+    const float _damping;
+};
+}
+
+LoadSimulator::Model* LoadSimulator::createModel( const std::string& name,
+                                                  const float frameTime )
+{
+    if( name == "uniform" )
+        return new SyntheticModel( SyntheticModel::UNIFORM, frameTime );
+    if( name == "center" )
+        return new SyntheticModel( SyntheticModel::CENTER, frameTime );
+    if( name == "hotspot" )
+        return new SyntheticModel( SyntheticModel::HOTSPOT, frameTime );
+    return 0;
+}
+
+LoadSimulator::Model* LoadSimulator::loadModel( const std::string& filename )
+{
+    std::ifstream file( filename.c_str( ));
+    if( !file.is_open( ))
+    {
+        LBWARN << "Can't open load record " << filename << std::endl;
+        return 0;
+    }
+
+    RecordedFrames recorded;
+    std::string line;
+    while( std::getline( file, line ))
+    {
+        std::istringstream is( line );
+        std::string kind;
+        uint32_t frameNumber = 0;
+        TaskKey key;
+        is >> kind >> frameNumber >> key.first;
+
+        if( kind == "task" )
+        {
+            RecordedTask task;
+            float zoomX = 1.f, zoomY = 1.f;
+            is >> key.second >> task.vp.x >> task.vp.y >> task.vp.w
+               >> task.vp.h >> task.range.start >> task.range.end >> zoomX
+               >> zoomY;
+            if( !is || zoomX <= 0.f || zoomY <= 0.f )
+                continue;
+
+            task.zoom = Zoom( zoomX, zoomY );
+            RecordedTask& entry = recorded[ frameNumber ][ key ];
+            task.region = entry.region;
+            task.startTime = entry.startTime;
+            task.endTime = entry.endTime;
+            entry = task;
+        }
+        else if( kind == "stat" )
+        {
+            Viewport region;
+            unsigned type = 0;
+            int64_t startTime = 0, endTime = 0;
+            is >> region.x >> region.y >> region.w >> region.h >> type
+               >> key.second >> startTime >> endTime;
+            if( !is )
+                continue;
+
+            switch( type )
+            {
+            case Statistic::CHANNEL_CLEAR:
+            case Statistic::CHANNEL_DRAW:
+            case Statistic::CHANNEL_READBACK:
+            {
+                RecordedTask& task = recorded[ frameNumber ][ key ];
+                task.region = region;
+                task.startTime = LB_MIN( task.startTime, startTime );
+                task.endTime = LB_MAX( task.endTime, endTime );
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    RecordedModel* model = new RecordedModel;
+    for( RecordedFrames::const_iterator i = recorded.begin();
+         i != recorded.end(); ++i )
+    {
+        RecordedModel::Tiles tiles;
+        const RecordedTasks& tasks = i->second;
+        for( RecordedTasks::const_iterator j = tasks.begin(); j != tasks.end();
+             ++j )
+        {
+            const RecordedTask& task = j->second;
+            if( task.endTime <= task.startTime || !task.vp.hasArea() ||
+                task.range.end <= task.range.start )
+            {
+                continue;
+            }
+
+            RecordedModel::Tile tile;
+            tile.vp = task.vp;
+            if( task.region.hasArea( ))
+                tile.vp.apply( task.region );
+            tile.range = task.range;
+            tile.time = float( task.endTime - task.startTime ) /
+                        ( task.zoom.x() * task.zoom.y( ));
+            if( tile.vp.hasArea( ))
+                tiles.push_back( tile );
+        }
+        if( !tiles.empty( ))
+            model->frames.push_back( tiles );
+    }
+
+    if( model->frames.empty( ))
+    {
+        LBWARN << "No load data in " << filename << std::endl;
+        delete model;
+        return 0;
+    }
+    LBINFO << "Loaded " << model->frames.size() << " frames from "
+           << filename << std::endl;
+    return model;
+}
+
+LoadSimulator::LoadSimulator( Config* config )
+        : _config( config )
+        , _assembleTime( 0.f )
+        , _threshold( .1f )
+        , _frameNumber( 0 )
+        , _time( 1 )
+{
+    const Nodes& nodes = config->getNodes();
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        const Pipes& pipes = (*i)->getPipes();
+        for( PipesCIter j = pipes.begin(); j != pipes.end(); ++j )
+        {
+            Pipe* pipe = *j;
+            if( !pipe->getPixelViewport().hasArea( ))
+                pipe->setPixelViewport( _defaultPVP );
+
+            const Windows& windows = pipe->getWindows();
+            for( WindowsCIter k = windows.begin(); k != windows.end(); ++k )
+            {
+                const Channels& channels = (*k)->getChannels();
+                for( ChannelsCIter l = channels.begin(); l != channels.end();
+                     ++l )
+                {
+                    (*l)->setState( STATE_RUNNING );
+                }
+            }
+        }
+    }
+
+    const Compounds& compounds = config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->init();
+
+    const Observers& observers = config->getObservers();
+    for( ObserversCIter i = observers.begin(); i != observers.end(); ++i )
+        (*i)->init();
+
+    const Canvases& canvases = config->getCanvases();
+    for( CanvasesCIter i = canvases.begin(); i != canvases.end(); ++i )
+        (*i)->init();
+}
+
+LoadSimulator::~LoadSimulator()
+{
+    const Canvases& canvases = _config->getCanvases();
+    for( CanvasesCIter i = canvases.begin(); i != canvases.end(); ++i )
+        (*i)->exit();
+
+    const Compounds& compounds = _config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->exit(); // saves the learned resource models
+
+    const Nodes& nodes = _config->getNodes();
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        const Pipes& pipes = (*i)->getPipes();
+        for( PipesCIter j = pipes.begin(); j != pipes.end(); ++j )
+        {
+            const Windows& windows = (*j)->getWindows();
+            for( WindowsCIter k = windows.begin(); k != windows.end(); ++k )
+            {
+                const Channels& channels = (*k)->getChannels();
+                for( ChannelsCIter l = channels.begin(); l != channels.end();
+                     ++l )
+                {
+                    (*l)->setState( STATE_STOPPED );
+                }
+            }
+        }
+    }
+}
+
+void LoadSimulator::setDamping( const float damping )
+{
+    DampingSetter setter( damping );
+    const Compounds& compounds = _config->getCompounds();
+    for( CompoundsCIter i = compounds.begin(); i != compounds.end(); ++i )
+        (*i)->accept( setter );
+}
+
+LoadSimulator::Result LoadSimulator::run( const Model& model,
+                                          const uint32_t nFrames )
+{
+    const uint32_t latency = _config->getLatency();
+    const Compounds& compounds = _config->getCompounds();
+    std::deque< Load > pending;
+    std::vector< float > frameTimes;
+    std::vector< float > imbalances;
+    std::vector< float > updateTimes;
+
+    for( uint32_t i = 0; i < nFrames; ++i )
+    {
+        const uint32_t frameNumber = ++_frameNumber;
+
+        // deliver the load data of the frames finished with the config latency
+        while( !pending.empty() &&
+               pending.front().frameNumber + latency < frameNumber )
+        {
+            Load& load = pending.front();
+            load.channel->fireLoadData( load.frameNumber, load.statistics,
+                                        Viewport::FULL );
+            pending.pop_front();
+        }
+
+        // update the compounds concurrently like a running config
+        const lunchbox::Clock clock;
+        const std::vector< Compounds >& groups = _config->getCompoundGroups();
+        const int32_t nGroups = int32_t( groups.size( ));
+#pragma omp parallel for schedule( dynamic )
+        for( int32_t j = 0; j < nGroups; ++j )
+        {
+            const Compounds& group = groups[j];
+            for( CompoundsCIter k = group.begin(); k != group.end(); ++k )
+            {
+                CompoundUpdateDataVisitor updater( frameNumber );
+                (*k)->accept( updater );
+            }
+        }
+        updateTimes.push_back( clock.getTimef( ));
+
+        // run the tasks
+        ChannelLoads loads;
+        int64_t endTime = _time;
+        for( CompoundsCIter j = compounds.begin(); j != compounds.end(); ++j )
+        {
+            Compound* compound = *j;
+            DrawSimulator drawer( model, _speeds, frameNumber, _time, loads );
+            compound->accept( drawer );
+
+            AssembleSimulator assembler( _assembleTime, frameNumber,
+                                         drawer.getEndTime(), loads );
+            compound->accept( assembler );
+            endTime = LB_MAX( endTime, assembler.getEndTime( ));
+        }
+
+        int64_t maxBusy = 0;
+        int64_t sumBusy = 0;
+        size_t nChannels = 0;
+        for( ChannelLoads::iterator j = loads.begin(); j != loads.end(); ++j )
+        {
+            const ChannelLoad& load = j->second;
+            if( load.busy > 0 )
+            {
+                maxBusy = LB_MAX( maxBusy, load.busy );
+                sumBusy += load.busy;
+                ++nChannels;
+            }
+
+            Load data;
+            data.frameNumber = frameNumber;
+            data.channel = j->first;
+            data.statistics = load.statistics;
+            pending.push_back( data );
+        }
+
+        const float meanBusy = nChannels == 0 ? 0.f :
+                               float( sumBusy ) / float( nChannels );
+        imbalances.push_back( meanBusy > 0.f ?
+                              float( maxBusy ) / meanBusy - 1.f : 0.f );
+        frameTimes.push_back( float( endTime - _time ));
+        _time = endTime + 1;
+
+        LBLOG( LOG_LB1 ) << "Simulated frame " << frameNumber << " time "
+                         << frameTimes.back() << " imbalance "
+                         << imbalances.back() << std::endl;
+    }
+
+    Result result;
+    result.nFrames = nFrames;
+    if( nFrames == 0 )
+        return result;
+
+    const uint32_t steadyStart = nFrames / 2;
+    for( uint32_t i = 0; i < nFrames; ++i )
+    {
+        if( imbalances[i] > _threshold )
+            result.convergence = i + 1;
+
+        result.frameTime += frameTimes[i];
+        result.updateTime += updateTimes[i];
+        result.imbalance += imbalances[i];
+        if( i >= steadyStart )
+        {
+            result.steadyFrameTime += frameTimes[i];
+            result.steadyImbalance += imbalances[i];
+        }
+    }
+    const float nSteady = float( nFrames - steadyStart );
+    result.frameTime /= float( nFrames );
+    result.imbalance /= float( nFrames );
+    result.updateTime /= float( nFrames );
+    result.steadyFrameTime /= nSteady;
+    result.steadyImbalance /= nSteady;
+    return result;
+}
+
+std::ostream& operator << ( std::ostream& os,
+                            const LoadSimulator::Result& result )
+{
+    os << result.nFrames << " frames, converged after " << result.convergence
+       << ", frame time " << result.frameTime << " ms (steady "
+       << result.steadyFrameTime << " ms), imbalance " << result.imbalance
+       << " (steady " << result.steadyImbalance << "), update "
+       << result.updateTime << " ms";
+    return os;
+}
+
+}
+}
@@ -0,0 +1,146 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef EQSERVER_LOADSIMULATOR_H
+#define EQSERVER_LOADSIMULATOR_H
+
+#include <eq/server/types.h>
+
+#include <lunchbox/nonCopyable.h>
+#include <iostream>
+#include <map>
+
+namespace eq
+{
+namespace server
+{
+    /**
+     * Runs the load balancers of a loaded config without any render clients.
+     *
+     * The compounds are updated each frame like in a running config, but
+     * without sending any tasks. The cost of each rendering task is taken
+     * from a cost model, and the resulting channel statistics are fed back to
+     * the equalizers with the config's latency. The channels run their tasks
+     * in compound order, and are equally fast unless set otherwise using
+     * setSpeed(). Only the draw tasks and, if set, a constant assemble time
+     * per input frame are simulated.
+     */
+    class LoadSimulator : public lunchbox::NonCopyable
+    {
+    public:
+        /** The rendering cost of a part of the scene. */
+        class Model
+        {
+        public:
+            virtual ~Model() {}
+
+            /**
+             * @return the time in ms to render the given part of the frame
+             *         at full resolution.
+             */
+            virtual float getTime( const uint32_t frameNumber,
+                                   const Viewport& vp,
+                                   const Range& range ) const = 0;
+        };
+
+        /** The measurements of one simulation run. */
+        struct Result
+        {
+            Result() : nFrames( 0 ), convergence( 0 ), frameTime( 0.f )
+                     , imbalance( 0.f ), steadyFrameTime( 0.f )
+                     , steadyImbalance( 0.f ), updateTime( 0.f ) {}
+
+            uint32_t nFrames; //!< the number of simulated frames
+            /** The frames until the imbalance stays below the threshold. */
+            uint32_t convergence;
+            float frameTime; //!< average frame time in ms
+            /** Average of the ratio of the busiest to the mean channel. */
+            float imbalance;
+            float steadyFrameTime; //!< frameTime of the second half
+            float steadyImbalance; //!< imbalance of the second half
+            /** Average wall time in ms to update the compounds per frame. */
+            float updateTime;
+        };
+
+        /**
+         * Create a synthetic cost model.
+         *
+         * 'uniform' has the same cost everywhere, 'center' is four times more
+         * expensive in the center of the screen and 'hotspot' has an expensive
+         * region moving horizontally and through the database range.
+         *
+         * @param name the name of the model.
+         * @param frameTime the time to render the full frame in ms.
+         * @return the new model, or 0 if the name is unknown.
+         */
+        static Model* createModel( const std::string& name,
+                                   const float frameTime );
+
+        /**
+         * Load the cost model from a load record.
+         *
+         * The time of each recorded rendering task is distributed evenly over
+         * its viewport and range. The recorded frames are replayed cyclically.
+         *
+         * @return the new model, or 0 if the record can't be read.
+         * @sa LoadRecorder
+         */
+        static Model* loadModel( const std::string& filename );
+
+        /** Prepare the compounds of a stopped config for the simulation. */
+        explicit LoadSimulator( Config* config );
+
+        /** Reset the config to the stopped state. */
+        ~LoadSimulator();
+
+        /** Set the damping of all load, tree and DFR equalizers. */
+        void setDamping( const float damping );
+
+        /** Set the time in ms to assemble one input frame, default 0. */
+        void setAssembleTime( const float time ) { _assembleTime = time; }
+
+        /**
+         * Set the relative rendering speed of a channel, default 1.
+         *
+         * The draw time of the channel's tasks is divided by the speed.
+         * @param channel the name of the channel.
+         * @param speed the relative speed.
+         */
+        void setSpeed( const std::string& channel, const float speed )
+            { _speeds[ channel ] = speed; }
+
+        /** Set the imbalance below which the load is balanced, default .1. */
+        void setThreshold( const float threshold ) { _threshold = threshold; }
+
+        /** Simulate the given number of frames using the given cost model. */
+        Result run( const Model& model, const uint32_t nFrames );
+
+    private:
+        Config* const _config;
+        float _assembleTime;
+        float _threshold;
+        std::map< std::string, float > _speeds;
+        uint32_t _frameNumber;
+        int64_t _time;
+    };
+
+    std::ostream& operator << ( std::ostream& os,
+                                const LoadSimulator::Result& );
+}
+}
+
+#endif // EQSERVER_LOADSIMULATOR_H
@@ -0,0 +1,180 @@
+
+/* Copyright (c) 2012, Stefan Eilemann <eile@equalizergraphics.com>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Runs the load balancers of config files against a cost model, without any
+// render clients. Set EQ_SERVER_LOAD_RECORD for eqServer to record a model from
+// a real run.
+//
+// The reported update time is the average compound update time per frame, the
+// part of the server's frame start which grows with the number of channels.
+// Simulate configs of increasing channel counts to benchmark it. A running
+// server logs its full frame start time, including the task generation for all
+// nodes, with the statistics log topic (EQ_LOG_TOPICS=4096).
+
+#include "loadSimulator.h"
+
+#include <eq/server/config.h>
+#include <eq/server/global.h>
+#include <eq/server/loader.h>
+#include <eq/server/server.h>
+
+#include <eq/client/init.h>
+#include <eq/client/nodeFactory.h>
+#include <eq/client/version.h>
+
+#include <tclap/CmdLine.h>
+
+#include <iostream>
+
+using eq::server::LoadSimulator;
+
+namespace
+{
+eq::server::ServerPtr _load( const std::string& filename )
+{
+    eq::server::Loader loader;
+    eq::server::ServerPtr server = loader.loadFile( filename );
+    if( !server || server->getConfigs().empty( ))
+        return eq::server::ServerPtr();
+
+    eq::server::Loader::addOutputCompounds( server );
+    eq::server::Loader::addDestinationViews( server );
+    eq::server::Loader::addDefaultObserver( server );
+    eq::server::Loader::convertTo11( server );
+    eq::server::Loader::convertTo12( server );
+    return server;
+}
+
+// Runs once per damping, or once with the config's dampings if none is given
+bool _simulate( const std::string& filename, const LoadSimulator::Model& model,
+                const std::vector< float >& dampings, const unsigned nFrames,
+                const float assembleTime )
+{
+    const size_t nRuns = dampings.empty() ? 1 : dampings.size();
+    for( size_t i = 0; i < nRuns; ++i )
+    {
+        // equalizers keep their history, start each run with a fresh config
+        eq::server::ServerPtr server = _load( filename );
+        if( !server )
+        {
+            std::cerr << "Can't load " << filename << std::endl;
+            return false;
+        }
+
+        {
+            LoadSimulator simulator( server->getConfigs().front( ));
+            simulator.setAssembleTime( assembleTime );
+            std::cout << filename << " damping ";
+            if( dampings.empty( ))
+                std::cout << "of config";
+            else
+            {
+                simulator.setDamping( dampings[i] );
+                std::cout << dampings[i];
+            }
+            std::cout << ": " << simulator.run( model, nFrames ) << std::endl;
+        }
+
+        eq::server::Global::clear();
+        server->deleteConfigs(); // break server <-> config ref circle
+    }
+    return true;
+}
+}
+
+int main( int argc, char** argv )
+{
+    std::vector< std::string > configs;
+    std::vector< float > dampings;
+    std::string modelName;
+    unsigned nFrames = 0;
+    float frameTime = 0.f;
+    float assembleTime = 0.f;
+
+    try
+    {
+        TCLAP::CmdLine command( "eqLoadSimulator - offline load balancer "
+                                "simulation", ' ', eq::Version::getString( ));
+        TCLAP::ValueArg< std::string > modelArg( "m", "model",
+            "Cost model: uniform, center, hotspot or a load record file",
+                                                 false, "center", "string",
+                                                 command );
+        TCLAP::ValueArg< unsigned > framesArg( "n", "numFrames",
+                                 "Number of simulated frames (default 500)",
+                                               false, 500, "unsigned",
+                                               command );
+        TCLAP::ValueArg< float > timeArg( "t", "frameTime",
+                 "Time to render a full frame with synthetic models in ms",
+                                          false, 100.f, "float", command );
+        TCLAP::ValueArg< float > assembleArg( "a", "assembleTime",
+                                  "Time to assemble one input frame in ms",
+                                              false, 0.f, "float", command );
+        TCLAP::MultiArg< float > dampingArg( "d", "damping",
+  "Damping of the equalizers, may be given multiple times (default: config)",
+                                             false, "float", command );
+        TCLAP::UnlabeledMultiArg< std::string > configArg( "configs",
+                                                     "Config files (.eqc)",
+                                                     true, "filename",
+                                                     command );
+        command.parse( argc, argv );
+
+        configs = configArg.getValue();
+        modelName = modelArg.getValue();
+        nFrames = framesArg.getValue();
+        frameTime = timeArg.getValue();
+        assembleTime = assembleArg.getValue();
+        dampings = dampingArg.getValue();
+    }
+    catch( TCLAP::ArgException& exception )
+    {
+        std::cerr << "Command line parse error: " << exception.error()
+                  << " for argument " << exception.argId() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    eq::NodeFactory nodeFactory;
+    if( !eq::init( 0, 0, &nodeFactory ))
+    {
+        std::cerr << "Equalizer init failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LoadSimulator::Model* model = LoadSimulator::createModel( modelName,
+                                                              frameTime );
+    if( !model )
+        model = LoadSimulator::loadModel( modelName );
+
+    int result = EXIT_SUCCESS;
+    if( model )
+    {
+        for( std::vector< std::string >::const_iterator i = configs.begin();
+             i != configs.end(); ++i )
+        {
+            if( !_simulate( *i, *model, dampings, nFrames, assembleTime ))
+                result = EXIT_FAILURE;
+        }
+        delete model;
+    }
+    else
+    {
+        std::cerr << "Unknown model " << modelName << std::endl;
+        result = EXIT_FAILURE;
+    }
+
+    eq::exit();
+    return result;
+}
@@ -17,6 +17,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "../loadSimulator/loadRecorder.h"
+
 #include <eq/server/global.h>
 #include <eq/server/init.h>
 #include <eq/server/loader.h>
@@ -26,6 +28,7 @@
 #include <co/global.h>
 #include <co/init.h>
 
+#include <cstdlib>
 #include <iostream>
 
 #define CONFIG "server{ config{ appNode{ pipe {                            \
@@ -81,7 +84,14 @@ int main( const int argc, char** argv )
         return EXIT_FAILURE;
     }
 
+    eq::server::LoadRecorder* recorder = 0;
+    const char* recordFile = getenv( "EQ_SERVER_LOAD_RECORD" );
+    if( recordFile && !server->getConfigs().empty( ))
+        recorder = new eq::server::LoadRecorder( server->getConfigs().front(),
+                                                 recordFile );
+
     server->run();
+    delete recorder;
     server->exitLocal();
     server->deleteConfigs();
 